@@ -0,0 +1,250 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Минимальный харнесс микробенчмарков для заглушек.
+//
+// Каждый бенчмарк — функция, выполняющая ops одинаковых операций. Харнесс
+// делает несколько прогревочных прогонов, затем reps замеров и считает по
+// ним время одной операции: min, mean, p50, p90, p99.
+//
+// Параметры командной строки:
+//   --json PATH        сохранить результаты в JSON
+//   --compare PATH     сравнить с сохранённым JSON, регрессия — код выхода 1
+//   --threshold PCT    допустимое замедление p50 при сравнении (по умолчанию 15)
+//   --filter TEXT      запускать только бенчмарки, в имени которых есть TEXT
+//   --reps N, --warmup N
+//   --quick            3 замера без прогрева, для проверки что всё работает
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+    // Не даёт компилятору выбросить вычисление результата
+    template <typename T>
+    inline void doNotOptimize(const T &value) {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+    struct Result {
+        std::string name;
+        size_t ops;
+        size_t reps;
+        double min_ns;
+        double mean_ns;
+        double p50_ns;
+        double p90_ns;
+        double p99_ns;
+    };
+
+    // Перцентиль по отсортированным замерам, с линейной интерполяцией
+    inline double percentile(const std::vector<double> &sorted, double p) {
+        if (sorted.empty()) return 0;
+        double rank = p / 100.0 * (sorted.size() - 1);
+        size_t lo = static_cast<size_t>(rank);
+        size_t hi = std::min(lo + 1, sorted.size() - 1);
+        return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+    }
+
+    class Runner {
+    public:
+        Runner(int argc, char **argv)
+            : reps_(30), warmup_(3), threshold_(15.0) {
+            for (int i = 1; i < argc; i++) {
+                std::string arg = argv[i];
+                const char *value = i + 1 < argc ? argv[i + 1] : "";
+                if (arg == "--json") {
+                    json_path_ = value;
+                    i++;
+                } else if (arg == "--compare") {
+                    compare_path_ = value;
+                    i++;
+                } else if (arg == "--threshold") {
+                    threshold_ = atof(value);
+                    i++;
+                } else if (arg == "--filter") {
+                    filter_ = value;
+                    i++;
+                } else if (arg == "--reps") {
+                    reps_ = std::max(1, atoi(value));
+                    i++;
+                } else if (arg == "--warmup") {
+                    warmup_ = std::max(0, atoi(value));
+                    i++;
+                } else if (arg == "--quick") {
+                    reps_ = 3;
+                    warmup_ = 0;
+                } else {
+                    std::cerr << "Unknown option: " << arg << std::endl;
+                }
+            }
+        }
+
+        // fn(ops) выполняет ops операций
+        template <typename Fn>
+        void run(const char *name, size_t ops, Fn fn) {
+            run(name, ops, reps_, fn);
+        }
+
+        // Для долгих бенчмарков: не больше maxReps замеров и один прогрев
+        template <typename Fn>
+        void run(const char *name, size_t ops, int maxReps, Fn fn) {
+            if (!filter_.empty() && std::string(name).find(filter_) == std::string::npos) {
+                return;
+            }
+            int reps = std::min(reps_, maxReps);
+            int warmup = maxReps < reps_ ? std::min(warmup_, 1) : warmup_;
+            for (int i = 0; i < warmup; i++) fn(ops);
+
+            std::vector<double> samples;
+            samples.reserve(reps);
+            for (int i = 0; i < reps; i++) {
+                std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+                fn(ops);
+                std::chrono::nanoseconds elapsed =
+                    std::chrono::steady_clock::now() - start;
+                samples.push_back(static_cast<double>(elapsed.count()) / ops);
+            }
+            std::sort(samples.begin(), samples.end());
+
+            Result r;
+            r.name = name;
+            r.ops = ops;
+            r.reps = samples.size();
+            r.min_ns = samples.front();
+            double sum = 0;
+            for (size_t i = 0; i < samples.size(); i++) sum += samples[i];
+            r.mean_ns = sum / samples.size();
+            r.p50_ns = percentile(samples, 50);
+            r.p90_ns = percentile(samples, 90);
+            r.p99_ns = percentile(samples, 99);
+            results_.push_back(r);
+
+            char line[160];
+            snprintf(line, sizeof(line), "%-32s %10.1f %10.1f %10.1f %10.1f",
+                     name, r.p50_ns, r.p90_ns, r.p99_ns, r.min_ns);
+            std::cout << line << std::endl;
+        }
+
+        void header() const {
+            char line[160];
+            snprintf(line, sizeof(line), "%-32s %10s %10s %10s %10s",
+                     "benchmark (ns/op)", "p50", "p90", "p99", "min");
+            std::cout << line << std::endl;
+        }
+
+        // Сохраняет JSON и сравнивает с базой. Возвращает код выхода.
+        int finish() {
+            if (!json_path_.empty()) {
+                std::ofstream out(json_path_.c_str());
+                writeJson(out);
+                std::cout << "\nResults written to " << json_path_ << std::endl;
+            }
+            if (compare_path_.empty()) return 0;
+            return compare();
+        }
+
+    private:
+        int reps_;
+        int warmup_;
+        double threshold_;
+        std::string json_path_;
+        std::string compare_path_;
+        std::string filter_;
+        std::vector<Result> results_;
+
+        void writeJson(std::ostream &out) const {
+            out << "{\n  \"benchmarks\": [\n";
+            for (size_t i = 0; i < results_.size(); i++) {
+                const Result &r = results_[i];
+                char line[320];
+                snprintf(line, sizeof(line),
+                         "    {\"name\": \"%s\", \"ops\": %zu, \"reps\": %zu, "
+                         "\"min_ns\": %.2f, \"mean_ns\": %.2f, \"p50_ns\": %.2f, "
+                         "\"p90_ns\": %.2f, \"p99_ns\": %.2f}%s\n",
+                         r.name.c_str(), r.ops, r.reps, r.min_ns, r.mean_ns,
+                         r.p50_ns, r.p90_ns, r.p99_ns,
+                         i + 1 < results_.size() ? "," : "");
+                out << line;
+            }
+            out << "  ]\n}\n";
+        }
+
+        // Читает p50 из JSON, записанного writeJson()
+        static bool readBaseline(const std::string &path,
+                                 std::map<std::string, double> &p50) {
+            std::ifstream in(path.c_str());
+            if (!in) return false;
+            std::stringstream ss;
+            ss << in.rdbuf();
+            std::string text = ss.str();
+            const std::string name_key = "\"name\": \"";
+            const std::string p50_key = "\"p50_ns\": ";
+            size_t pos = 0;
+            while ((pos = text.find(name_key, pos)) != std::string::npos) {
+                pos += name_key.size();
+                size_t end = text.find('"', pos);
+                size_t obj_end = text.find('}', pos);
+                size_t value = text.find(p50_key, pos);
+                if (end == std::string::npos || value == std::string::npos ||
+                    value > obj_end) {
+                    break;
+                }
+                p50[text.substr(pos, end - pos)] =
+                    atof(text.c_str() + value + p50_key.size());
+                pos = obj_end;
+            }
+            return true;
+        }
+
+        int compare() const {
+            std::map<std::string, double> baseline;
+            if (!readBaseline(compare_path_, baseline)) {
+                std::cerr << "Cannot read baseline: " << compare_path_ << std::endl;
+                return 2;
+            }
+            std::cout << "\nComparison with " << compare_path_ << " (p50, threshold "
+                      << threshold_ << "%)" << std::endl;
+            int regressions = 0;
+            for (size_t i = 0; i < results_.size(); i++) {
+                const Result &r = results_[i];
+                std::map<std::string, double>::const_iterator it = baseline.find(r.name);
+                char line[160];
+                if (it == baseline.end() || it->second <= 0) {
+                    snprintf(line, sizeof(line), "%-32s %10s", r.name.c_str(), "new");
+                } else {
+                    double change = (r.p50_ns / it->second - 1.0) * 100.0;
+                    const char *verdict = "";
+                    if (change > threshold_) {
+                        verdict = "REGRESSION";
+                        regressions++;
+                    } else if (change < -threshold_) {
+                        verdict = "improved";
+                    }
+                    snprintf(line, sizeof(line), "%-32s %10.1f -> %10.1f %+7.1f%% %s",
+                             r.name.c_str(), it->second, r.p50_ns, change, verdict);
+                }
+                std::cout << line << std::endl;
+            }
+            if (regressions > 0) {
+                std::cout << regressions << " regression(s)" << std::endl;
+                return 1;
+            }
+            std::cout << "No regressions" << std::endl;
+            return 0;
+        }
+    };
+
+} // namespace bench
+
+#endif // BENCH_H
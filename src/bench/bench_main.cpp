@@ -0,0 +1,469 @@
+// Микробенчмарки заглушек: String, FakeSerial, LittleFS.
+// Запуск: make bench (см. bench.h для параметров)
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bench.h"
+#include "fake_serial.h"
+#include "littlefs_stub.h"
+#include "preferences_stub.h"
+#include "spi_stub.h"
+#include "wire_stub.h"
+
+FakeSerial Serial(false);
+
+static void benchString(bench::Runner &runner) {
+    runner.run("string/construct", 10000, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            String s("sensor temperature");
+            bench::doNotOptimize(s);
+        }
+    });
+
+    runner.run("string/concat_64", 1000, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            String s;
+            for (int j = 0; j < 16; j++) s += "abcd";
+            bench::doNotOptimize(s);
+        }
+    });
+
+    runner.run("string/from_int", 10000, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            String s(static_cast<long>(i * 7919));
+            bench::doNotOptimize(s);
+        }
+    });
+
+    runner.run("string/to_int", 10000, [](size_t ops) {
+        String s("1234567");
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += s.toInt();
+        bench::doNotOptimize(sum);
+    });
+
+    // Поля строки CSV-лога датчиков
+    runner.run("string/to_float", 10000, [](size_t ops) {
+        const String fields[] = {"23.45", "-4.5", "1013.25", "0.087"};
+        float sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += fields[i & 3].toFloat();
+        bench::doNotOptimize(sum);
+    });
+
+    runner.run("string/to_double", 10000, [](size_t ops) {
+        const String fields[] = {"55.751244", "37.618423", "-122.419416", "151.2"};
+        double sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += fields[i & 3].toDouble();
+        bench::doNotOptimize(sum);
+    });
+
+    runner.run("string/index_substring", 10000, [](size_t ops) {
+        String s("GET /api/v1/sensors?id=42 HTTP/1.1");
+        for (size_t i = 0; i < ops; i++) {
+            int start = s.indexOf('/');
+            int end = s.indexOf('?');
+            String path = s.substring(start, end);
+            bench::doNotOptimize(path);
+        }
+    });
+}
+
+// Типичная итерация loop(): разбор строки и сборка ответа из временных
+// String длиннее буфера SSO
+static void sketchIteration(const String &line, long value) {
+    String command = line.substring(0, 24);
+    String argument = line.substring(25);
+    String reply = String("response for command ") + command + ": " +
+                   String(value) + " (" + argument + ")";
+    bench::doNotOptimize(reply);
+}
+
+static void benchStringArena(bench::Runner &runner) {
+    static const String line("set_threshold_temperature 42.5 celsius,hysteresis=0.5");
+
+    runner.run("string/loop_1m_default", 1000000, 5, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            sketchIteration(line, static_cast<long>(i));
+        }
+    });
+
+    runner.run("string/loop_1m_arena", 1000000, 5, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            StringArenaFrame frame;
+            sketchIteration(line, static_cast<long>(i));
+        }
+    });
+}
+
+// Таблица маршрутов и раздача сообщений по темам: ключ приходит как
+// const char* (из разобранного запроса или пакета), таблица — по String
+static void benchStringHash(bench::Runner &runner) {
+    const int kRoutes = 200;
+    std::unordered_map<std::string, int> stdRoutes;
+    std::unordered_map<String, int> stringRoutes;
+    std::unordered_map<string_hash::StringKey, int> keyRoutes;
+    std::vector<std::string> paths;
+    char path[48];
+    for (int i = 0; i < kRoutes; i++) {
+        snprintf(path, sizeof(path), "/api/v1/device/%d/state", i);
+        paths.push_back(path);
+        stdRoutes[path] = i;
+        stringRoutes[String(path)] = i;
+        keyRoutes[string_hash::StringKey(path)] = i;
+    }
+
+    runner.run("route/std_string", 100000, [&](size_t ops) {
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += stdRoutes.find(paths[i % kRoutes].c_str())->second;
+        bench::doNotOptimize(sum);
+    });
+
+    runner.run("route/string_temp", 100000, [&](size_t ops) {
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += stringRoutes.find(String(paths[i % kRoutes].c_str()))->second;
+        bench::doNotOptimize(sum);
+    });
+
+    runner.run("route/string_key_ref", 100000, [&](size_t ops) {
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) {
+            sum += keyRoutes.find(string_hash::StringKey::ref(paths[i % kRoutes].c_str()))->second;
+        }
+        bench::doNotOptimize(sum);
+    });
+
+    // Тема ищется в трёх таблицах: обработчики, счётчики, последние значения
+    const char *topics[] = {"home/kitchen/temperature", "home/kitchen/humidity",
+                            "home/garage/door", "home/garden/soil/moisture"};
+    std::unordered_map<String, int> handlers, counters, retained;
+    std::unordered_map<string_hash::StringKey, int> keyHandlers, keyCounters, keyRetained;
+    for (int i = 0; i < 4; i++) {
+        handlers[topics[i]] = counters[topics[i]] = retained[topics[i]] = i;
+        keyHandlers[topics[i]] = keyCounters[topics[i]] = keyRetained[topics[i]] = i;
+    }
+
+    runner.run("topic/string_temp", 100000, [&](size_t ops) {
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) {
+            const char *topic = topics[i & 3];
+            sum += handlers.find(topic)->second + counters.find(topic)->second + retained.find(topic)->second;
+        }
+        bench::doNotOptimize(sum);
+    });
+
+    runner.run("topic/key_ref", 100000, [&](size_t ops) {
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) {
+            string_hash::StringKey topic = string_hash::StringKey::ref(topics[i & 3]);
+            sum += keyHandlers.find(topic)->second + keyCounters.find(topic)->second +
+                   keyRetained.find(topic)->second;
+        }
+        bench::doNotOptimize(sum);
+    });
+}
+
+static void benchRandom(bench::Runner &runner) {
+    runner.run("random/xorshift", 100000, [](size_t ops) {
+        stub_random::Generator gen(1);
+        stub_random::Scope scope(gen);
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += random(1000);
+        bench::doNotOptimize(sum);
+    });
+
+    runner.run("random/avr", 100000, [](size_t ops) {
+        stub_random::Generator gen(1, stub_random::kAvr);
+        stub_random::Scope scope(gen);
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += random(1000);
+        bench::doNotOptimize(sum);
+    });
+
+    // Прежняя реализация random(max) для сравнения
+    runner.run("random/libc_rand", 100000, [](size_t ops) {
+        srand(1);
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += rand() % 1000;
+        bench::doNotOptimize(sum);
+    });
+}
+
+// Опрос датчика в цикле: указатель регистра и чтение 6 байт
+static void benchWire(bench::Runner &runner) {
+    runner.run("wire/poll_register", 100000, [](size_t ops) {
+        stub_i2c::RegisterDevice sensors[32];
+        for (uint8_t i = 0; i < 32; i++) Wire.bus().attach(0x40 + i, &sensors[i]);
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) {
+            uint8_t address = static_cast<uint8_t>(0x40 + i % 32);
+            Wire.beginTransmission(address);
+            Wire.write(0xF7);
+            Wire.endTransmission(false);
+            Wire.requestFrom(address, 6);
+            while (Wire.available()) sum += Wire.read();
+        }
+        for (uint8_t i = 0; i < 32; i++) Wire.bus().detach(0x40 + i);
+        bench::doNotOptimize(sum);
+    });
+}
+
+// Кадр 240x320 RGB565 на дисплей: буфером целиком и по байту
+static void benchSpi(bench::Runner &runner) {
+    static const size_t kFrame = 240 * 320 * 2;
+    static const uint8_t kCs = 5;
+    std::vector<uint8_t> frame(kFrame, 0x5A);
+    stub_spi::Capture display;
+    display.reserve(kFrame);
+    SPI.attach(kCs, &display);
+    digitalWrite(kCs, LOW);
+
+    runner.run("spi/push_frame", 1, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            display.clear();
+            SPI.writeBytes(frame.data(), frame.size());
+        }
+        bench::doNotOptimize(display.data().size());
+    });
+
+    runner.run("spi/push_frame_bytewise", 1, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            display.clear();
+            for (size_t j = 0; j < kFrame; j++) SPI.transfer(frame[j]);
+        }
+        bench::doNotOptimize(display.data().size());
+    });
+
+    digitalWrite(kCs, HIGH);
+    SPI.detach(kCs);
+}
+
+// Чтение калибровки по хеш-индексу и сохранение счётчика со сборкой мусора
+static void benchPreferences(bench::Runner &runner) {
+    runner.run("nvs/get_int", 100000, [](size_t ops) {
+        stub_nvs::Partition partition;
+        stub_nvs::currentPtr() = &partition;
+        Preferences prefs;
+        prefs.begin("calib");
+        char key[16];
+        for (int i = 0; i < 100; i++) {
+            snprintf(key, sizeof(key), "c%d", i);
+            prefs.putInt(key, i);
+        }
+        long sum = 0;
+        for (size_t i = 0; i < ops; i++) sum += prefs.getInt("c50");
+        prefs.end();
+        stub_nvs::currentPtr() = nullptr;
+        bench::doNotOptimize(sum);
+    });
+
+    runner.run("nvs/put_counter", 10000, [](size_t ops) {
+        stub_nvs::Partition partition;
+        stub_nvs::currentPtr() = &partition;
+        Preferences prefs;
+        prefs.begin("state");
+        for (size_t i = 0; i < ops; i++) prefs.putUInt("boots", static_cast<uint32_t>(i));
+        prefs.end();
+        stub_nvs::currentPtr() = nullptr;
+        bench::doNotOptimize(partition.eraseCount());
+    });
+}
+
+static void benchSerial(bench::Runner &runner) {
+    runner.run("serial/print_cstr", 10000, [](size_t ops) {
+        Serial.clearOutput();
+        for (size_t i = 0; i < ops; i++) Serial.print("temperature: ");
+    });
+
+    runner.run("serial/println_int", 10000, [](size_t ops) {
+        Serial.clearOutput();
+        for (size_t i = 0; i < ops; i++) Serial.println(static_cast<int>(i));
+    });
+
+    runner.run("serial/println_float", 10000, [](size_t ops) {
+        Serial.clearOutput();
+        for (size_t i = 0; i < ops; i++) Serial.println(i * 0.25, 2);
+    });
+
+    runner.run("serial/write_64", 10000, [](size_t ops) {
+        uint8_t buf[64];
+        memset(buf, 'x', sizeof(buf));
+        Serial.clearOutput();
+        for (size_t i = 0; i < ops; i++) Serial.write(buf, sizeof(buf));
+    });
+}
+
+static void prepareVolume() {
+    std::vector<uint8_t> data(4096);
+    for (size_t i = 0; i < data.size(); i++) data[i] = static_cast<uint8_t>(i);
+    File f = LittleFS.open("/data/blob.bin", "w");
+    f.write(data.data(), data.size());
+    f.close();
+    for (int i = 0; i < 100; i++) {
+        String name = String("/list/entry_") + String(i) + ".txt";
+        f = LittleFS.open(name, "w");
+        f.print(name);
+        f.close();
+    }
+}
+
+// Ответ модема: строки протокола, в конце — искомая метка
+static std::string protocolInput(size_t lines) {
+    std::string input;
+    for (size_t i = 0; i < lines; i++) {
+        input += "+CREG: 0,1,\"00A1\",\"01B2C3\",7 ";
+        input += std::to_string(i);
+        input += "\r\n";
+    }
+    return input + "+CSQ: 17,0\r\n";
+}
+
+static void benchStream(bench::Runner &runner) {
+    static const size_t kLines = 100;
+    const std::string input = protocolInput(kLines);
+
+    runner.run("stream/read_until", kLines, [&input](size_t ops) {
+        Serial.pushInput(input.data(), input.size());
+        for (size_t i = 0; i < ops; i++) {
+            String line = Serial.readStringUntil('\n');
+            bench::doNotOptimize(line);
+        }
+        while (Serial.available()) Serial.read();
+    });
+
+    // То же побайтно через read(), как без Stream
+    runner.run("stream/read_until_naive", kLines, [&input](size_t ops) {
+        Serial.pushInput(input.data(), input.size());
+        for (size_t i = 0; i < ops; i++) {
+            String line;
+            int c;
+            while ((c = Serial.read()) >= 0 && c != '\n') line += static_cast<char>(c);
+            bench::doNotOptimize(line);
+        }
+        while (Serial.available()) Serial.read();
+    });
+
+    runner.run("stream/find", 1, [&input](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            Serial.pushInput(input.data(), input.size());
+            bool found = Serial.find("+CSQ: ");
+            bench::doNotOptimize(found);
+            while (Serial.available()) Serial.read();
+        }
+    });
+
+    // Поиск по байту со сбросом при несовпадении
+    runner.run("stream/find_naive", 1, [&input](size_t ops) {
+        const char *target = "+CSQ: ";
+        size_t len = strlen(target);
+        for (size_t i = 0; i < ops; i++) {
+            Serial.pushInput(input.data(), input.size());
+            size_t index = 0;
+            int c;
+            while (index < len && (c = Serial.read()) >= 0) {
+                index = c == target[index] ? index + 1 : (c == target[0] ? 1 : 0);
+            }
+            bench::doNotOptimize(index);
+            while (Serial.available()) Serial.read();
+        }
+    });
+}
+
+static void benchLittleFS(bench::Runner &runner, const std::string &prefix) {
+    std::string name;
+
+    name = prefix + "/open_close";
+    runner.run(name.c_str(), 1000, [](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            File f = LittleFS.open("/data/blob.bin", "r");
+            bench::doNotOptimize(f);
+        }
+    });
+
+    name = prefix + "/exists";
+    runner.run(name.c_str(), 1000, [](size_t ops) {
+        bool found = false;
+        for (size_t i = 0; i < ops; i++) found ^= LittleFS.exists("/data/blob.bin");
+        bench::doNotOptimize(found);
+    });
+
+    name = prefix + "/read_4k";
+    runner.run(name.c_str(), 200, [](size_t ops) {
+        uint8_t buf[256];
+        for (size_t i = 0; i < ops; i++) {
+            File f = LittleFS.open("/data/blob.bin", "r");
+            while (f.read(buf, sizeof(buf)) > 0) {
+            }
+        }
+        bench::doNotOptimize(buf);
+    });
+
+    name = prefix + "/read_byte_4k";
+    runner.run(name.c_str(), 50, [](size_t ops) {
+        int sum = 0;
+        for (size_t i = 0; i < ops; i++) {
+            File f = LittleFS.open("/data/blob.bin", "r");
+            int c;
+            while ((c = f.read()) >= 0) sum += c;
+        }
+        bench::doNotOptimize(sum);
+    });
+
+    name = prefix + "/write_4k";
+    runner.run(name.c_str(), 200, [](size_t ops) {
+        const char line[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcde\n";
+        for (size_t i = 0; i < ops; i++) {
+            File f = LittleFS.open("/data/out.txt", "w");
+            for (int j = 0; j < 64; j++) f.print(line);
+        }
+    });
+
+    name = prefix + "/list_100";
+    runner.run(name.c_str(), 50, [](size_t ops) {
+        size_t count = 0;
+        for (size_t i = 0; i < ops; i++) {
+            File dir = LittleFS.open("/list");
+            for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+                count += entry.size();
+            }
+        }
+        bench::doNotOptimize(count);
+    });
+
+    name = prefix + "/list_names_100";
+    runner.run(name.c_str(), 50, [](size_t ops) {
+        size_t count = 0;
+        for (size_t i = 0; i < ops; i++) {
+            File dir = LittleFS.open("/list");
+            while (dir.getNextFileName().length() > 0) count++;
+        }
+        bench::doNotOptimize(count);
+    });
+}
+
+int main(int argc, char **argv) {
+    bench::Runner runner(argc, argv);
+
+    system("rm -rf /tmp/arduinostub_bench");
+    if (!LittleFS.begin(false, "/tmp/arduinostub_bench")) return 1;
+    prepareVolume();
+    std::vector<uint8_t> image;
+    if (!LittleFS.exportImage(image)) return 1;
+    std::cout << std::endl;
+
+    runner.header();
+    benchString(runner);
+    benchStringArena(runner);
+    benchStringHash(runner);
+    benchRandom(runner);
+    benchWire(runner);
+    benchSpi(runner);
+    benchPreferences(runner);
+    benchSerial(runner);
+    benchStream(runner);
+    benchLittleFS(runner, "littlefs");
+    if (!LittleFS.mountImage(image.data(), image.size())) return 1;
+    benchLittleFS(runner, "littlefs_image");
+
+    return runner.finish();
+}
@@ -0,0 +1,36 @@
+// Время компиляции единицы трансляции скетча с заглушками.
+// Запуск: make bench_build (параметры — как у make bench, см. bench.h);
+// время в таблице — наносекунды на одну компиляцию.
+
+#include <cstdlib>
+#include <string>
+#include "bench.h"
+
+static std::string compiler() {
+    const char *cxx = getenv("CXX");
+    return cxx && *cxx ? cxx : "g++";
+}
+
+// Компилирует src в объектный файл без линковки
+static void benchCompile(bench::Runner &runner, const char *name, const char *src) {
+    std::string cmd = compiler() +
+        " -std=c++11 -I./src -I./src/hardware -DARDUINO_TEST_MODE -c " + src +
+        " -o target/build_bench.o";
+    if (system(cmd.c_str()) != 0) {
+        std::cerr << "Compilation failed: " << cmd << std::endl;
+        exit(1);
+    }
+    runner.run(name, 1, 5, [&cmd](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+            int rc = system(cmd.c_str());
+            bench::doNotOptimize(rc);
+        }
+    });
+}
+
+int main(int argc, char **argv) {
+    bench::Runner runner(argc, argv);
+    runner.header();
+    benchCompile(runner, "build/sketch_tu", "src/bench/build_tu.cpp");
+    return runner.finish();
+}
@@ -0,0 +1,24 @@
+// Типичная единица трансляции скетча для make bench_build:
+// Serial, LittleFS и String из заглушек
+#include "arduino_compat.h"
+#include "fake_serial.h"
+#include "littlefs_stub.h"
+
+extern FakeSerial Serial;
+
+void setup() {
+    Serial.begin(115200);
+    LittleFS.begin(true);
+    File f = LittleFS.open("/config.txt", "r");
+    char config[32] = {0};
+    if (f) f.read(reinterpret_cast<uint8_t *>(config), sizeof(config) - 1);
+    Serial.println(config);
+}
+
+void loop() {
+    String line = String(millis()) + "," + String(digitalRead(2));
+    File log = LittleFS.open("/log.csv", "a");
+    log.println(line);
+    log.close();
+    delay(1000);
+}
@@ -0,0 +1,167 @@
+// Пример скетча для фаззинга: команды по Serial, одна на строку.
+//
+//   SET <имя> <число>   переменная, до kVars штук, имя до 8 символов
+//   GET <имя>           значение переменной
+//   LED <0|1>           светодиод на пине 13
+//   PWM <пин> <0..255>  analogWrite
+//   DUMP                все переменные
+//
+// Строка копится в буфере на kLineSize байт; длинная строка отбрасывается
+// до перевода строки. Незаконченная строка сбрасывается, если байты не
+// приходят kLineTimeout мс.
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include "arduino_compat.h"
+#include "fake_serial.h"
+
+static const size_t kLineSize = 48;
+static const size_t kNameSize = 8;
+static const int kVars = 8;
+static const int kLedPin = 13;
+static const unsigned long kLineTimeout = 1000;
+
+struct Var {
+    char name[kNameSize + 1];
+    long value;
+    bool used;
+};
+
+static Var vars[kVars];
+static char line[kLineSize];
+static size_t lineLen;
+static bool overflow;
+static unsigned long lastByte;
+
+// Следующее слово строки; *cursor — за ним
+static char *nextToken(char **cursor) {
+    char *p = *cursor;
+    while (*p == ' ') p++;
+    if (!*p) return nullptr;
+    char *start = p;
+    while (*p && *p != ' ') p++;
+    if (*p) *p++ = '\0';
+    *cursor = p;
+    return start;
+}
+
+static bool parseLong(const char *text, long *value) {
+    if (!text) return false;
+    char *end;
+    errno = 0;
+    long v = strtol(text, &end, 10);
+    if (end == text || *end || errno == ERANGE) return false;
+    *value = v;
+    return true;
+}
+
+static Var *findVar(const char *name, bool create) {
+    Var *free = nullptr;
+    for (int i = 0; i < kVars; i++) {
+        if (vars[i].used && strcmp(vars[i].name, name) == 0) return &vars[i];
+        if (!vars[i].used && !free) free = &vars[i];
+    }
+    if (!create || !free) return nullptr;
+    strcpy(free->name, name);
+    free->value = 0;
+    free->used = true;
+    return free;
+}
+
+static void handleLine(char *text) {
+    char *cursor = text;
+    char *cmd = nextToken(&cursor);
+    if (!cmd) return;
+    char *arg1 = nextToken(&cursor);
+    char *arg2 = nextToken(&cursor);
+    long value;
+
+    if (strcmp(cmd, "SET") == 0) {
+        if (!arg1 || strlen(arg1) > kNameSize || !parseLong(arg2, &value)) {
+            Serial.println(F("ERR usage: SET <name> <number>"));
+            return;
+        }
+        Var *var = findVar(arg1, true);
+        if (!var) {
+            Serial.println(F("ERR no free slots"));
+            return;
+        }
+        var->value = value;
+        Serial.println(F("OK"));
+    } else if (strcmp(cmd, "GET") == 0) {
+        Var *var = arg1 && strlen(arg1) <= kNameSize ? findVar(arg1, false) : nullptr;
+        if (!var) {
+            Serial.println(F("ERR unknown"));
+            return;
+        }
+        Serial.print(var->name);
+        Serial.print('=');
+        Serial.println(var->value);
+    } else if (strcmp(cmd, "LED") == 0) {
+        if (!parseLong(arg1, &value) || (value != 0 && value != 1)) {
+            Serial.println(F("ERR usage: LED <0|1>"));
+            return;
+        }
+        digitalWrite(kLedPin, value ? HIGH : LOW);
+        Serial.println(F("OK"));
+    } else if (strcmp(cmd, "PWM") == 0) {
+        long pin;
+        if (!parseLong(arg1, &pin) || pin < 0 || pin > 255 || !parseLong(arg2, &value) ||
+            value < 0 || value > 255) {
+            Serial.println(F("ERR usage: PWM <pin> <0..255>"));
+            return;
+        }
+        analogWrite(static_cast<uint8_t>(pin), static_cast<int>(value));
+        Serial.println(F("OK"));
+    } else if (strcmp(cmd, "DUMP") == 0) {
+        for (int i = 0; i < kVars; i++) {
+            if (!vars[i].used) continue;
+            Serial.print(vars[i].name);
+            Serial.print('=');
+            Serial.println(vars[i].value);
+        }
+        Serial.println(F("OK"));
+    } else {
+        Serial.print(F("ERR unknown command "));
+        Serial.println(cmd);
+    }
+}
+
+void fuzzReset() {
+    memset(vars, 0, sizeof(vars));
+    lineLen = 0;
+    overflow = false;
+    lastByte = 0;
+}
+
+void setup() {
+    Serial.begin(115200);
+    pinMode(kLedPin, OUTPUT);
+}
+
+void loop() {
+    if (lineLen && millis() - lastByte > kLineTimeout) {
+        lineLen = 0;
+        Serial.println(F("ERR timeout"));
+    }
+    while (Serial.available() > 0) {
+        char c = static_cast<char>(Serial.read());
+        lastByte = millis();
+        if (c == '\r') continue;
+        if (c == '\n') {
+            if (overflow) {
+                Serial.println(F("ERR line too long"));
+            } else {
+                line[lineLen] = '\0';
+                handleLine(line);
+            }
+            lineLen = 0;
+            overflow = false;
+        } else if (lineLen + 1 < kLineSize) {
+            line[lineLen++] = c;
+        } else {
+            overflow = true;
+        }
+    }
+}
@@ -0,0 +1,190 @@
+// Запуск fuzz_serial.cpp без libFuzzer: для gcc и машин без clang.
+//
+//   fuzz_standalone [-runs=N] [-seed=S] [-max_len=N] файл|каталог...
+//
+// Без -runs каждый файл корпуса выполняется один раз — так же
+// воспроизводится падение: fuzz_standalone crash-input. С -runs=N
+// выполняется N входов, полученных случайными мутациями корпуса
+// (замена, вставка и удаление байт, копирование кусков, слова из
+// словаря). Обратной связи по покрытию здесь нет, это проверка
+// харнесса и санитайзеров, а не замена libFuzzer.
+//
+// Если вход уронил процесс (assert, сигнал, отчёт ASan/UBSan), он
+// сохраняется в crash-input в текущем каталоге.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+
+    typedef std::vector<uint8_t> Input;
+
+    // Текущий вход для обработчика падения
+    const uint8_t *currentData;
+    size_t currentSize;
+
+    void saveCurrent() {
+        int fd = open("crash-input", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return;
+        ssize_t written = write(fd, currentData, currentSize);
+        (void)written;
+        close(fd);
+        const char message[] = "== input saved to crash-input\n";
+        written = write(STDERR_FILENO, message, sizeof(message) - 1);
+    }
+
+    void onSignal(int sig) {
+        saveCurrent();
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+
+    const char *kDictionary[] = {"SET ", "GET ", "LED ", "PWM ", "DUMP", "\n", "\r\n",
+                                 " ", "0", "1", "255", "-1", "2147483648", "9999999999999999999"};
+
+    void readFile(const std::string &path, std::vector<Input> &corpus) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        corpus.push_back(Input(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+    }
+
+    void readPath(const std::string &path, std::vector<Input> &corpus) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            std::cerr << "No such file: " << path << std::endl;
+            return;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            readFile(path, corpus);
+            return;
+        }
+        DIR *dir = opendir(path.c_str());
+        while (dirent *entry = dir ? readdir(dir) : nullptr) {
+            if (entry->d_name[0] == '.') continue;
+            readPath(path + "/" + entry->d_name, corpus);
+        }
+        if (dir) closedir(dir);
+    }
+
+    // xorshift: воспроизводимые мутации для одного -seed
+    uint32_t nextRandom(uint32_t &state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    void mutate(Input &input, const std::vector<Input> &corpus, size_t maxLen, uint32_t &rng) {
+        int count = 1 + nextRandom(rng) % 4;
+        for (int i = 0; i < count; i++) {
+            size_t pos = input.empty() ? 0 : nextRandom(rng) % (input.size() + 1);
+            switch (nextRandom(rng) % 6) {
+            case 0:     // Случайный байт
+                if (pos < input.size()) input[pos] = static_cast<uint8_t>(nextRandom(rng));
+                break;
+            case 1:     // Вставка байта
+                input.insert(input.begin() + pos, static_cast<uint8_t>(nextRandom(rng)));
+                break;
+            case 2: {   // Удаление куска
+                size_t len = std::min<size_t>(input.size() - pos, 1 + nextRandom(rng) % 8);
+                input.erase(input.begin() + pos, input.begin() + pos + len);
+                break;
+            }
+            case 3: {   // Повтор куска
+                size_t len = std::min<size_t>(input.size() - pos, 1 + nextRandom(rng) % 16);
+                Input piece(input.begin() + pos, input.begin() + pos + len);
+                input.insert(input.begin() + pos, piece.begin(), piece.end());
+                break;
+            }
+            case 4: {   // Слово из словаря
+                const char *word = kDictionary[nextRandom(rng) % (sizeof(kDictionary) / sizeof(kDictionary[0]))];
+                input.insert(input.begin() + pos, word, word + strlen(word));
+                break;
+            }
+            default: {  // Кусок другого входа корпуса
+                const Input &other = corpus[nextRandom(rng) % corpus.size()];
+                if (other.empty()) break;
+                size_t from = nextRandom(rng) % other.size();
+                size_t len = std::min<size_t>(other.size() - from, 1 + nextRandom(rng) % 32);
+                input.insert(input.begin() + pos, other.begin() + from, other.begin() + from + len);
+                break;
+            }
+            }
+        }
+        if (input.size() > maxLen) input.resize(maxLen);
+    }
+
+    void runOne(const Input &input) {
+        currentData = input.data();
+        currentSize = input.size();
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+} // namespace
+
+int main(int argc, char **argv) {
+    unsigned long runs = 0;
+    uint32_t seed = 1;
+    size_t maxLen = 4096;
+    std::vector<Input> corpus;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 6, "-runs=") == 0) {
+            runs = strtoul(arg.c_str() + 6, nullptr, 10);
+        } else if (arg.compare(0, 6, "-seed=") == 0) {
+            seed = static_cast<uint32_t>(strtoul(arg.c_str() + 6, nullptr, 10));
+        } else if (arg.compare(0, 9, "-max_len=") == 0) {
+            maxLen = strtoul(arg.c_str() + 9, nullptr, 10);
+        } else {
+            readPath(arg, corpus);
+        }
+    }
+    if (corpus.empty()) corpus.push_back(Input());
+
+    const int signals[] = {SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL};
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) signal(signals[i], onSignal);
+#ifdef __SANITIZE_ADDRESS__
+    __sanitizer_set_death_callback(saveCurrent);
+#endif
+
+    LLVMFuzzerInitialize(&argc, &argv);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < corpus.size(); i++) runOne(corpus[i]);
+
+    uint32_t rng = seed ? seed : 1;
+    Input input;
+    input.reserve(maxLen);
+    for (unsigned long i = 0; i < runs; i++) {
+        input = corpus[nextRandom(rng) % corpus.size()];
+        mutate(input, corpus, maxLen, rng);
+        runOne(input);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long total = corpus.size() + runs;
+    std::cout << "Done " << total << " runs in " << seconds << " s, "
+              << static_cast<unsigned long>(total / (seconds > 0 ? seconds : 1)) << " exec/s"
+              << std::endl;
+    return 0;
+}
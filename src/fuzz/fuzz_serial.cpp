@@ -0,0 +1,70 @@
+// Фаззинг разбора команд скетча: вход фаззера приходит в Serial, и
+// скетч крутит loop(), пока не разберёт его.
+//
+// Совместим с libFuzzer (make fuzz, clang -fsanitize=fuzzer) и с
+// fuzz_main.cpp (make fuzz_standalone, любой компилятор). Скетч — файл
+// с setup() и loop() (FUZZ_SKETCH в Makefile); setup() выполняется один
+// раз в LLVMFuzzerInitialize.
+//
+// Одна итерация не создаёт объектов и не делает ввода-вывода: порт и
+// плата живут всё время фаззинга, буферы приёма и вывода очищаются с
+// сохранением памяти, эхо в stdout выключено. Часы платы на каждой
+// итерации начинаются с нуля и идут на kLoopMs между вызовами loop().
+// После последнего прочитанного байта loop() крутится ещё kIdleMs
+// виртуальных мс, так что срабатывают и таймауты скетча на millis()
+// (недописанная строка и т. п.). Скетчу с таймаутами длиннее
+// FUZZ_IDLE_MS (5 с) нужен свой: FUZZ_FLAGS+=-DFUZZ_IDLE_MS=30000.
+//
+// Глобальные переменные скетча между итерациями сохраняются, как на
+// устройстве, которое получает одну команду за другой. Чтобы каждый
+// вход разбирался с чистого листа (и падение воспроизводилось одним
+// файлом), скетч определяет необязательную функцию fuzzReset().
+
+#include <cstddef>
+#include <cstdint>
+#include "arduino_compat.h"
+#include "fake_serial.h"
+
+FakeSerial Serial(false);
+
+void setup();
+void loop();
+void fuzzReset() __attribute__((weak));
+
+#ifndef FUZZ_IDLE_MS
+#define FUZZ_IDLE_MS 5000
+#endif
+
+namespace {
+
+    const unsigned long kLoopMs = 10;
+    // Столько виртуальных мс без чтения из порта — вход разобран
+    const unsigned long kIdleMs = FUZZ_IDLE_MS;
+
+} // namespace
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc;
+    (void)argv;
+    setup();
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    stub_board::Board &board = stub_board::current();
+    board.clock = 0;
+    board.micros = 0;
+    Serial.clearInput();
+    Serial.clearOutput();
+    if (fuzzReset) fuzzReset();
+
+    Serial.pushInput(reinterpret_cast<const char *>(data), size);
+    unsigned long lastRead = 0;
+    while (board.clock - lastRead < kIdleMs) {
+        int before = Serial.available();
+        loop();
+        board.clock += kLoopMs;
+        if (Serial.available() < before) lastRead = board.clock;
+    }
+    return 0;
+}
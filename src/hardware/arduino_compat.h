@@ -16,9 +16,6 @@
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
-#include <iomanip>
-#include <iostream>
-#include <sstream>
 #include <string>
 
 // Заглушки для Arduino типов
@@ -56,6 +53,9 @@ typedef bool boolean;
 
 // Наша реализация String
 #include "arduino_string_stub.h"
+#include "stub_board.h"
+#include "stub_random.h"
+#include "stub_replay.h"
 
 // Заглушки для функций времени
 inline void delay(unsigned long ms) {
@@ -69,27 +69,28 @@ inline void delay(unsigned long ms) {
 
 inline void delayMicroseconds(unsigned int us) { (void)us; }
 
+// Часы платы потока (stub_board.h)
 inline unsigned long millis() {
-  static unsigned long counter = 0;
-  return counter += 100; // Имитируем прошедшее время
+  unsigned long &clock = stub_board::current().clock;
+  return stub_replay::millis(clock += 100); // Имитируем прошедшее время
 }
 
-inline unsigned long micros() { return millis() * 1000; }
-
-// Заглушка для random
-inline long random(long max) {
-  if (max <= 0)
-    return 0;
-  return rand() % max;
+inline unsigned long micros() {
+  return millis() * 1000 + stub_board::current().micros;
 }
 
+// random: генератор потока из stub_random.h (xorshift или как на AVR)
+inline long random(long max) { return stub_random::current().below(max); }
+
 inline long random(long min, long max) {
-  if (min >= max)
-    return min;
-  return min + (rand() % (max - min));
+  return stub_random::current().between(min, max);
 }
 
-inline void randomSeed(unsigned long seed) { srand(seed); }
+// Как в ядре Arduino: randomSeed(0) не меняет последовательность
+inline void randomSeed(unsigned long seed) {
+  if (seed != 0)
+    stub_random::current().seed(static_cast<uint32_t>(seed));
+}
 
 // Математические функции
 inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
@@ -110,46 +111,24 @@ template <typename T> inline T min(T a, T b) { return a < b ? a : b; }
 #define degrees(rad) ((rad) * RAD_TO_DEG)
 #define sq(x) ((x) * (x))
 
-// Макрос F() для совместимости (на ПК ничего не делает)
-#ifndef F
-#define F(str) (str)
-#endif
+// F(), PSTR(), PROGMEM, pgm_read_*() и функции *_P — stub_progmem.h,
+// подключается вместе с String
 
-// Для совместимости с PROGMEM (на ПК игнорируем)
-#define PROGMEM
-#define PGM_P const char *
-#define PGM_VOID_P const void *
-#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
-#define pgm_read_word(addr) (*(const unsigned short *)(addr))
-#define pgm_read_dword(addr) (*(const unsigned long *)(addr))
-#define pgm_read_float(addr) (*(const float *)(addr))
-#define pgm_read_ptr(addr) (*(const void **)(addr))
-#define PSTR(str) (str)
-#define strcpy_P(dest, src) strcpy(dest, src)
-#define strcat_P(dest, src) strcat(dest, src)
-#define strcmp_P(a, b) strcmp(a, b)
-#define strlen_P(str) strlen(str)
-
-// Заглушки для пинов (пустые функции)
+// Пины: уровни хранятся в плате потока (stub_board.h)
 inline void pinMode(uint8_t pin, uint8_t mode) {
   (void)pin;
   (void)mode;
 }
 
 inline void digitalWrite(uint8_t pin, uint8_t val) {
-  (void)pin;
-  (void)val;
+  stub_board::current().digital[pin] = val ? HIGH : LOW;
 }
 
 inline int digitalRead(uint8_t pin) {
-  (void)pin;
-  return LOW;
+  return stub_replay::digitalRead(pin, stub_board::current().digital[pin]);
 }
 
-inline int analogRead(uint8_t pin) {
-  (void)pin;
-  return 0;
-}
+inline int analogRead(uint8_t pin) { return stub_board::current().analog[pin]; }
 
 inline void analogWrite(uint8_t pin, int val) {
   (void)pin;
@@ -158,20 +137,21 @@ inline void analogWrite(uint8_t pin, int val) {
 
 inline void analogReference(uint8_t mode) { (void)mode; }
 
-// Заглушки для EEPROM (если нужно)
+// EEPROM платы потока; за пределами kEepromSize чтение даёт T()
 template <typename T> T EEPROM_read(int address) {
-  (void)address;
-  return T();
+  T value = T();
+  if (address >= 0 && address + sizeof(T) <= stub_board::kEepromSize)
+    memcpy(&value, stub_board::current().eeprom + address, sizeof(T));
+  return value;
 }
 
 template <typename T> void EEPROM_write(int address, T value) {
-  (void)address;
-  (void)value;
+  if (address >= 0 && address + sizeof(T) <= stub_board::kEepromSize)
+    memcpy(stub_board::current().eeprom + address, &value, sizeof(T));
 }
 
 template <typename T> void EEPROM_update(int address, T value) {
-  (void)address;
-  (void)value;
+  EEPROM_write(address, value);
 }
 
 #endif
@@ -0,0 +1,112 @@
+#include "arduino_print_stub.h"
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+size_t Print::printText(const char *str, size_t len, bool newline) {
+    if (!newline) return write(str, len);
+    char buf[kBufferSize];
+    if (len + 1 > sizeof(buf)) {
+        // Длинная строка: без копирования, перевод строки отдельно
+        size_t n = write(str, len);
+        return n + write("\n", 1);
+    }
+    memcpy(buf, str, len);
+    buf[len] = '\n';
+    return write(buf, len + 1);
+}
+
+size_t Print::printSigned(long long value, unsigned long long asUnsigned, int base,
+                          bool newline) {
+    if (base != DEC || value >= 0) return printNumber(asUnsigned, base, newline);
+    // Минус и модуль; -LLONG_MIN считаем в беззнаковых
+    char buf[kBufferSize];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    if (newline) *--p = '\n';
+    unsigned long long n = 0ULL - static_cast<unsigned long long>(value);
+    do {
+        *--p = static_cast<char>('0' + n % 10);
+        n /= 10;
+    } while (n);
+    *--p = '-';
+    return write(p, end - p);
+}
+
+size_t Print::printNumber(unsigned long long n, int base, bool newline) {
+    if (base == 0) {
+        // Как в Arduino: основание 0 — вывод самого байта
+        char buf[2] = {static_cast<char>(n), '\n'};
+        return write(buf, newline ? 2 : 1);
+    }
+    if (base < 2 || base > 36) base = DEC;
+    char buf[kBufferSize];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    if (newline) *--p = '\n';
+    if (base == DEC) {
+        // Отдельная ветка: деление на константу компилятор заменяет умножением
+        do {
+            *--p = static_cast<char>('0' + n % 10);
+            n /= 10;
+        } while (n);
+    } else if (base == HEX) {
+        do {
+            unsigned digit = static_cast<unsigned>(n & 0xF);
+            *--p = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+            n >>= 4;
+        } while (n);
+    } else {
+        do {
+            unsigned digit = static_cast<unsigned>(n % base);
+            *--p = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+            n /= base;
+        } while (n);
+    }
+    return write(p, end - p);
+}
+
+size_t Print::printFloat(double n, int digits, bool newline) {
+    char buf[kBufferSize];
+    int len;
+    if (std::isnan(n)) {
+        len = snprintf(buf, sizeof(buf), "nan");
+    } else if (std::isinf(n)) {
+        len = snprintf(buf, sizeof(buf), "inf");
+    } else if (n > 4294967040.0 || n < -4294967040.0) {
+        // Предел printFloat в ядре Arduino
+        len = snprintf(buf, sizeof(buf), "ovf");
+    } else {
+        // 10 цифр целой части, знак и точка: дробная часть до 60 знаков
+        if (digits < 0) digits = 0;
+        if (digits > 60) digits = 60;
+        len = snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    }
+    if (newline) buf[len++] = '\n';
+    return write(buf, len);
+}
+
+size_t Print::printf(const char *format, ...) {
+    char buf[kBufferSize];
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(buf, sizeof(buf), format, copy);
+    va_end(copy);
+    if (len < 0) {
+        va_end(args);
+        return 0;
+    }
+    if (static_cast<size_t>(len) < sizeof(buf)) {
+        va_end(args);
+        return write(buf, len);
+    }
+    // Не поместилось в буфер на стеке
+    std::vector<char> big(len + 1);
+    vsnprintf(big.data(), big.size(), format, args);
+    va_end(args);
+    return write(big.data(), len);
+}
@@ -0,0 +1,103 @@
+#ifndef ARDUINO_PRINT_STUB_H
+#define ARDUINO_PRINT_STUB_H
+
+// Print из ядра Arduino: print, println, printf для любого вывода.
+//
+// Наследник реализует только write(const uint8_t*, size_t). Число,
+// строка или printf форматируются в один буфер на стеке вместе с
+// переводом строки для println, и наследник получает ровно один
+// write() на вызов — одинаково для Serial, файлов и остальных портов.
+//
+// Как на Arduino: HEX и остальные основания — заглавными буквами, без
+// ведущих нулей; отрицательное число в недесятичном основании
+// печатается как беззнаковое той же ширины; база 0 — сам байт; nan,
+// inf, ovf для double. В отличие от Arduino println() пишет "\n", а не
+// "\r\n": на этом построены проверки вывода в тестах.
+// Реализация — arduino_print_stub.cpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "arduino_string_stub.h"
+
+#ifndef DEC
+#define DEC 10
+#endif
+#ifndef HEX
+#define HEX 16
+#endif
+#ifndef OCT
+#define OCT 8
+#endif
+#ifndef BIN
+#define BIN 2
+#endif
+
+class Print {
+public:
+    Print() : write_error_(0) {}
+    virtual ~Print() {}
+
+    // Единственная точка вывода наследника
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+
+    size_t write(const char *str) { return str ? write(str, strlen(str)) : 0; }
+
+    size_t write(const char *buffer, size_t size) {
+        return write(reinterpret_cast<const uint8_t *>(buffer), size);
+    }
+
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    int getWriteError() const { return write_error_; }
+    void clearWriteError() { write_error_ = 0; }
+
+    size_t print(const char *str) { return printText(str, str ? strlen(str) : 0, false); }
+    size_t print(const String &str) { return printText(str.c_str(), str.length(), false); }
+    size_t print(const __FlashStringHelper *str) { return print(stub_progmem::check(str, "print")); }
+    size_t print(char c) { return printText(&c, 1, false); }
+    size_t print(unsigned char n, int base = DEC) { return printNumber(n, base, false); }
+    size_t print(int n, int base = DEC) { return printSigned(n, static_cast<unsigned int>(n), base, false); }
+    size_t print(unsigned int n, int base = DEC) { return printNumber(n, base, false); }
+    size_t print(long n, int base = DEC) { return printSigned(n, static_cast<unsigned long>(n), base, false); }
+    size_t print(unsigned long n, int base = DEC) { return printNumber(n, base, false); }
+    size_t print(long long n, int base = DEC) { return printSigned(n, static_cast<unsigned long long>(n), base, false); }
+    size_t print(unsigned long long n, int base = DEC) { return printNumber(n, base, false); }
+    size_t print(double n, int digits = 2) { return printFloat(n, digits, false); }
+
+    size_t println(const char *str) { return printText(str, str ? strlen(str) : 0, true); }
+    size_t println(const String &str) { return printText(str.c_str(), str.length(), true); }
+    size_t println(const __FlashStringHelper *str) { return println(stub_progmem::check(str, "println")); }
+    size_t println(char c) { return printText(&c, 1, true); }
+    size_t println(unsigned char n, int base = DEC) { return printNumber(n, base, true); }
+    size_t println(int n, int base = DEC) { return printSigned(n, static_cast<unsigned int>(n), base, true); }
+    size_t println(unsigned int n, int base = DEC) { return printNumber(n, base, true); }
+    size_t println(long n, int base = DEC) { return printSigned(n, static_cast<unsigned long>(n), base, true); }
+    size_t println(unsigned long n, int base = DEC) { return printNumber(n, base, true); }
+    size_t println(long long n, int base = DEC) { return printSigned(n, static_cast<unsigned long long>(n), base, true); }
+    size_t println(unsigned long long n, int base = DEC) { return printNumber(n, base, true); }
+    size_t println(double n, int digits = 2) { return printFloat(n, digits, true); }
+    size_t println() { return write("\n", 1); }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+protected:
+    void setWriteError(int error = 1) { write_error_ = error; }
+
+private:
+    // Буфер форматирования: 64 двоичные цифры, перевод строки и запас
+    static const size_t kBufferSize = 80;
+
+    size_t printText(const char *str, size_t len, bool newline);
+    // value — число для DEC, asUnsigned — для остальных оснований
+    size_t printSigned(long long value, unsigned long long asUnsigned, int base, bool newline);
+    size_t printNumber(unsigned long long n, int base, bool newline);
+    size_t printFloat(double n, int digits, bool newline);
+
+    int write_error_;
+};
+
+#endif // ARDUINO_PRINT_STUB_H
@@ -0,0 +1,233 @@
+#include "arduino_stream_stub.h"
+
+#include <cstring>
+#include <vector>
+#include "stub_board.h"
+
+size_t Stream::inputView(const uint8_t *&data) {
+    int c = peek();
+    if (c < 0) return 0;
+    peeked_ = static_cast<uint8_t>(c);
+    data = &peeked_;
+    return 1;
+}
+
+void Stream::consumeInput(size_t n) {
+    while (n-- > 0) read();
+}
+
+size_t Stream::waitInput(const uint8_t *&data) {
+    size_t n = inputView(data);
+    if (n > 0) return n;
+    // Пока скетч ждёт, данные прийти не могут: часы платы сразу
+    // уходят на весь таймаут, и вход проверяется ещё раз
+    stub_board::current().clock += timeout_;
+    return inputView(data);
+}
+
+int Stream::timedPeek() {
+    const uint8_t *data;
+    return waitInput(data) > 0 ? data[0] : -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+    size_t count = 0;
+    const uint8_t *data;
+    while (count < length) {
+        size_t n = waitInput(data);
+        if (n == 0) break;
+        if (n > length - count) n = length - count;
+        memcpy(buffer + count, data, n);
+        consumeInput(n);
+        count += n;
+    }
+    return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length) {
+    size_t count = 0;
+    const uint8_t *data;
+    while (count < length) {
+        size_t n = waitInput(data);
+        if (n == 0) break;
+        if (n > length - count) n = length - count;
+        const void *end = memchr(data, terminator, n);
+        size_t take = end ? static_cast<const uint8_t *>(end) - data : n;
+        memcpy(buffer + count, data, take);
+        count += take;
+        if (end) {
+            consumeInput(take + 1);
+            break;
+        }
+        consumeInput(take);
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String ret;
+    const uint8_t *data;
+    size_t n;
+    while ((n = waitInput(data)) > 0) {
+        ret.concat(reinterpret_cast<const char *>(data), static_cast<unsigned int>(n));
+        consumeInput(n);
+    }
+    return ret;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String ret;
+    const uint8_t *data;
+    size_t n;
+    while ((n = waitInput(data)) > 0) {
+        const void *end = memchr(data, terminator, n);
+        size_t take = end ? static_cast<const uint8_t *>(end) - data : n;
+        ret.concat(reinterpret_cast<const char *>(data), static_cast<unsigned int>(take));
+        if (end) {
+            consumeInput(take + 1);
+            break;
+        }
+        consumeInput(take);
+    }
+    return ret;
+}
+
+int Stream::peekNextDigit(LookaheadMode lookahead, bool detectDecimal) {
+    while (true) {
+        int c = timedPeek();
+        if (c < 0 || c == '-' || (c >= '0' && c <= '9') || (detectDecimal && c == '.')) {
+            return c;
+        }
+        if (lookahead == SKIP_NONE) return -1;
+        if (lookahead == SKIP_WHITESPACE && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            return -1;
+        }
+        consumeInput(1);
+    }
+}
+
+long Stream::parseInt(LookaheadMode lookahead, char ignore) {
+    bool negative = false;
+    long value = 0;
+    int c = peekNextDigit(lookahead, false);
+    if (c < 0) return 0;
+    do {
+        if (static_cast<char>(c) == ignore) {
+            // Пропускаем разделитель
+        } else if (c == '-') {
+            negative = true;
+        } else if (c >= '0' && c <= '9') {
+            value = value * 10 + c - '0';
+        }
+        consumeInput(1);
+        c = timedPeek();
+    } while ((c >= '0' && c <= '9') || static_cast<char>(c) == ignore);
+    return negative ? -value : value;
+}
+
+float Stream::parseFloat(LookaheadMode lookahead, char ignore) {
+    bool negative = false;
+    bool fraction = false;
+    double value = 0.0;
+    double scale = 1.0;
+    int c = peekNextDigit(lookahead, true);
+    if (c < 0) return 0;
+    do {
+        if (static_cast<char>(c) == ignore) {
+            // Пропускаем разделитель
+        } else if (c == '-') {
+            negative = true;
+        } else if (c == '.') {
+            fraction = true;
+        } else if (c >= '0' && c <= '9') {
+            if (fraction) {
+                scale *= 0.1;
+                value += scale * (c - '0');
+            } else {
+                value = value * 10 + c - '0';
+            }
+        }
+        consumeInput(1);
+        c = timedPeek();
+    } while ((c >= '0' && c <= '9') || (c == '.' && !fraction) ||
+             static_cast<char>(c) == ignore);
+    return static_cast<float>(negative ? -value : value);
+}
+
+bool Stream::find(const char *target) {
+    return findMulti(target, strlen(target), nullptr, 0);
+}
+
+bool Stream::find(const char *target, size_t length) {
+    return findMulti(target, length, nullptr, 0);
+}
+
+bool Stream::findUntil(const char *target, const char *terminator) {
+    return findMulti(target, strlen(target), terminator,
+                     terminator ? strlen(terminator) : 0);
+}
+
+bool Stream::findUntil(const char *target, size_t targetLen,
+                       const char *terminator, size_t termLen) {
+    return findMulti(target, targetLen, terminator, termLen);
+}
+
+// Таблица префикс-функции КМП: fail[i] — длина наибольшего собственного
+// префикса pattern[0..i], который также его суффикс
+static void buildFailure(const char *pattern, size_t len, std::vector<size_t> &fail) {
+    fail.assign(len, 0);
+    size_t k = 0;
+    for (size_t i = 1; i < len; i++) {
+        while (k > 0 && pattern[i] != pattern[k]) k = fail[k - 1];
+        if (pattern[i] == pattern[k]) k++;
+        fail[i] = k;
+    }
+}
+
+static size_t advance(const char *pattern, const std::vector<size_t> &fail,
+                      size_t state, char c) {
+    while (state > 0 && c != pattern[state]) state = fail[state - 1];
+    return c == pattern[state] ? state + 1 : 0;
+}
+
+bool Stream::findMulti(const char *target, size_t targetLen,
+                       const char *terminator, size_t termLen) {
+    if (targetLen == 0) return true;
+    std::vector<size_t> targetFail, termFail;
+    buildFailure(target, targetLen, targetFail);
+    if (termLen > 0) buildFailure(terminator, termLen, termFail);
+
+    size_t targetState = 0, termState = 0;
+    const uint8_t *data;
+    size_t n;
+    while ((n = waitInput(data)) > 0) {
+        const char *chunk = reinterpret_cast<const char *>(data);
+        size_t i = 0;
+        while (i < n) {
+            // Вне частичного совпадения ищем первый символ через memchr
+            if (targetState == 0 && termLen == 0) {
+                const void *hit = memchr(chunk + i, target[0], n - i);
+                if (!hit) {
+                    i = n;
+                    break;
+                }
+                i = static_cast<const char *>(hit) - chunk;
+            }
+            char c = chunk[i++];
+            targetState = advance(target, targetFail, targetState, c);
+            if (targetState == targetLen) {
+                consumeInput(i);
+                return true;
+            }
+            if (termLen > 0) {
+                termState = advance(terminator, termFail, termState, c);
+                if (termState == termLen) {
+                    consumeInput(i);
+                    return false;
+                }
+            }
+        }
+        consumeInput(n);
+    }
+    return false;
+}
@@ -0,0 +1,94 @@
+#ifndef ARDUINO_STREAM_STUB_H
+#define ARDUINO_STREAM_STUB_H
+
+// Stream из ядра Arduino (вывод — от Print): readBytes, readBytesUntil, readString,
+// parseInt, parseFloat, find, findUntil, setTimeout.
+//
+// Наследник даёт available()/read()/peek() и, если может, непрерывный
+// кусок уже пришедших байт (inputView/consumeInput): тогда чтение и
+// поиск идут по нему целиком, через memcpy/memchr, а не по байту через
+// виртуальный read(). FakeSerial отдаёт свой буфер приёма, File — буфер
+// или содержимое файла в памяти.
+//
+// Когда данных нет, Stream не крутится в цикле до таймаута, а сразу
+// продвигает часы платы (stub_board.h) на setTimeout() и ещё раз
+// проверяет вход: millis() после таймаута такой же, как на плате.
+// Реализация — arduino_stream_stub.cpp.
+
+#include <cstddef>
+#include <cstdint>
+#include "arduino_print_stub.h"
+#include "arduino_string_stub.h"
+
+// Что пропускать перед числом в parseInt/parseFloat
+enum LookaheadMode {
+    SKIP_ALL,        // Всё, кроме цифр и знака минус
+    SKIP_NONE,       // Ничего: не число — сразу 0
+    SKIP_WHITESPACE  // Только пробелы, табуляции и переводы строк
+};
+
+#define NO_IGNORE_CHAR '\x01'
+
+class Stream : public Print {
+public:
+    Stream() : timeout_(1000), peeked_(0) {}
+    virtual ~Stream() {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    // Таймаут ожидания данных в миллисекундах часов платы
+    void setTimeout(unsigned long timeout) { timeout_ = timeout; }
+    unsigned long getTimeout() const { return timeout_; }
+
+    // Пропускает вход до target включительно; false — таймаут
+    bool find(const char *target);
+    bool find(const char *target, size_t length);
+    bool find(char target) { return find(&target, 1); }
+
+    // Как find, но false, если раньше встретился terminator
+    bool findUntil(const char *target, const char *terminator);
+    bool findUntil(const char *target, size_t targetLen,
+                   const char *terminator, size_t termLen);
+
+    long parseInt(LookaheadMode lookahead = SKIP_ALL, char ignore = NO_IGNORE_CHAR);
+    float parseFloat(LookaheadMode lookahead = SKIP_ALL, char ignore = NO_IGNORE_CHAR);
+
+    size_t readBytes(char *buffer, size_t length);
+    size_t readBytes(uint8_t *buffer, size_t length) {
+        return readBytes(reinterpret_cast<char *>(buffer), length);
+    }
+
+    // terminator не попадает в buffer, но снимается со входа
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    size_t readBytesUntil(char terminator, uint8_t *buffer, size_t length) {
+        return readBytesUntil(terminator, reinterpret_cast<char *>(buffer), length);
+    }
+
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    // Непрерывный кусок пришедших байт, 0 — данных пока нет. По
+    // умолчанию — один байт через peek().
+    virtual size_t inputView(const uint8_t *&data);
+
+    // Снимает n байт из inputView со входа
+    virtual void consumeInput(size_t n);
+
+private:
+    // inputView с ожиданием по часам платы; 0 — таймаут
+    size_t waitInput(const uint8_t *&data);
+    int timedPeek();
+    // Первый символ числа после пропуска по lookahead, -1 — таймаут
+    int peekNextDigit(LookaheadMode lookahead, bool detectDecimal);
+    // Общий поиск target с необязательным terminator (КМП)
+    bool findMulti(const char *target, size_t targetLen,
+                   const char *terminator, size_t termLen);
+
+    unsigned long timeout_;
+    uint8_t peeked_;
+};
+
+#endif // ARDUINO_STREAM_STUB_H
@@ -3,82 +3,199 @@
 
 #include <algorithm> // Для tolower/toupper
 #include <cstdlib>
+#include <cstdio>
 #include <cstring> // Добавляем для strncpy
-#include <sstream>
+#include <iosfwd>
 #include <string>
+#include <utility>
 
 #ifdef __AVR__
 // На Arduino используем родной String
 #include <WString.h>
 #else
 // На ПК создаем заглушку
+#include "avr_heap.h"
+#include "string_arena.h"
+#include "string_number.h"
+#include "stub_progmem.h"
+
 class String {
+public:
+  // Данные строки; память берётся через StringAllocator (string_arena.h)
+  typedef std::basic_string<char, std::char_traits<char>, StringAllocator<char> >
+      Storage;
+
 private:
-  std::string str_;
+  Storage str_;
+  // Блок в симулированной куче AVR (avr_heap.h), если она включена
+  size_t heap_block_;
+  unsigned int heap_capacity_;
+  uint32_t heap_epoch_;
+  // Строка недействительна, если ей не хватило памяти (как на AVR)
+  bool valid_;
+
+  // Аналог WString::reserve(): блок растёт ровно до len + 1 байт
+  bool heapReserve(unsigned int len) {
+    AvrHeap &heap = AvrHeap::instance();
+    if (!heap.active()) return true;
+    if (heap_epoch_ != heap.epoch()) {
+      // Блок из прошлой сессии кучи или строка создана до begin()
+      heap_block_ = AvrHeap::kNull;
+      heap_capacity_ = 0;
+      heap_epoch_ = heap.epoch();
+    }
+    if (heap_block_ != AvrHeap::kNull && heap_capacity_ >= len) return true;
+    size_t block = heap.realloc(heap_block_, len + 1);
+    if (block == AvrHeap::kNull) return false;
+    heap_block_ = block;
+    heap_capacity_ = len;
+    return true;
+  }
+
+  void heapRelease() {
+    AvrHeap &heap = AvrHeap::instance();
+    if (heap_block_ != AvrHeap::kNull && heap.active() &&
+        heap_epoch_ == heap.epoch()) {
+      heap.free(heap_block_);
+    }
+    heap_block_ = AvrHeap::kNull;
+    heap_capacity_ = 0;
+  }
+
+  void invalidate() {
+    heapRelease();
+    str_.clear();
+    valid_ = false;
+  }
+
+  // Аналог WString::copy(): при нехватке памяти строка недействительна
+  bool heapCopy(unsigned int len) {
+    if (!heapReserve(len)) {
+      invalidate();
+      return false;
+    }
+    valid_ = true;
+    return true;
+  }
+
+  void initHeap() {
+    heap_block_ = AvrHeap::kNull;
+    heap_capacity_ = 0;
+    heap_epoch_ = 0;
+    valid_ = true;
+  }
+
+  void assign(const char *str, size_t len) {
+    if (heapCopy(static_cast<unsigned int>(len))) {
+      str_.assign(str, len);
+      stub_counters::stringCopy(len);
+    }
+  }
+
+  void assign(const std::string &str) { assign(str.data(), str.size()); }
 
 public:
   // Конструкторы
-  String() : str_() {}
-  String(const char *str) : str_(str ? str : "") {}
-  String(const std::string &str) : str_(str) {}
-  String(const String &other) : str_(other.str_) {}
-  String(char c) : str_(1, c) {}
+  String() : str_() {
+    initHeap();
+    heapCopy(0);
+  }
+  String(const char *str) : str_() {
+    initHeap();
+    *this = str;
+  }
+  // Строка из флеша (F()); в строгом режиме адрес проверяется
+  String(const __FlashStringHelper *str) : str_() {
+    initHeap();
+    *this = str;
+  }
+  String(const std::string &str) : str_() {
+    initHeap();
+    assign(str);
+  }
+  String(const String &other) : str_() {
+    initHeap();
+    *this = other;
+  }
+  String(String &&other) noexcept
+      : str_(std::move(other.str_)), heap_block_(other.heap_block_),
+        heap_capacity_(other.heap_capacity_), heap_epoch_(other.heap_epoch_),
+        valid_(other.valid_) {
+    other.str_.clear();
+    other.heap_block_ = AvrHeap::kNull;
+    other.heap_capacity_ = 0;
+  }
+  String(char c) : str_() {
+    initHeap();
+    assign(&c, 1);
+  }
+
+  ~String() { heapRelease(); }
 
   // Конструкторы для чисел
   String(unsigned char value, unsigned char base = 10) {
+    initHeap();
     initFromNumber((unsigned long)value, base);
   }
 
   String(int value, unsigned char base = 10) {
+    initHeap();
     initFromNumber((long)value, base);
   }
 
   String(unsigned int value, unsigned char base = 10) {
+    initHeap();
     initFromNumber((unsigned long)value, base);
   }
 
-  String(long value, unsigned char base = 10) { initFromNumber(value, base); }
+  String(long value, unsigned char base = 10) {
+    initHeap();
+    initFromNumber(value, base);
+  }
 
   String(unsigned long value, unsigned char base = 10) {
+    initHeap();
     initFromNumber(value, base);
   }
 
   String(float value, unsigned char decimalPlaces = 2) {
-    std::stringstream ss;
-    ss.precision(decimalPlaces);
-    ss << std::fixed << value;
-    str_ = ss.str();
+    initHeap();
+    initFromDouble(value, decimalPlaces);
   }
 
   String(double value, unsigned char decimalPlaces = 2) {
-    std::stringstream ss;
-    ss.precision(decimalPlaces);
-    ss << std::fixed << value;
-    str_ = ss.str();
+    initHeap();
+    initFromDouble(value, decimalPlaces);
   }
 
 private:
+  // Как std::fixed с precision(decimalPlaces)
+  void initFromDouble(double value, unsigned char decimalPlaces) {
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    if (n < static_cast<int>(sizeof(buf))) {
+      assign(buf, n);
+      return;
+    }
+    std::string big(n, '\0');
+    snprintf(&big[0], n + 1, "%.*f", decimalPlaces, value);
+    assign(big);
+  }
+
   void initFromNumber(long value, unsigned char base) {
-    if (base == 10) {
-      str_ = std::to_string(value);
-    } else if (base == 16) {
-      std::stringstream ss;
-      ss << std::hex << value;
-      str_ = ss.str();
+    if (base == 16) {
+      initFromNumber(static_cast<unsigned long>(value), base);
     } else {
-      str_ = std::to_string(value);
+      assign(std::to_string(value));
     }
   }
 
   void initFromNumber(unsigned long value, unsigned char base) {
-    if (base == 10) {
-      str_ = std::to_string(value);
-    } else if (base == 16) {
-      std::stringstream ss;
-      ss << std::hex << value;
-      str_ = ss.str();
+    if (base == 16) {
+      char buf[20];
+      assign(buf, snprintf(buf, sizeof(buf), "%lx", value));
     } else {
-      str_ = std::to_string(value);
+      assign(std::to_string(value));
     }
   }
 
@@ -92,7 +209,15 @@ public:
     return static_cast<unsigned int>(str_.capacity());
   }
 
-  void reserve(unsigned int size) { str_.reserve(size); }
+  bool reserve(unsigned int size) {
+    if (!heapReserve(size)) return false;
+    str_.reserve(size);
+    valid_ = true;
+    return true;
+  }
+
+  // Ложь, если строке не хватило памяти в куче AVR
+  explicit operator bool() const { return valid_; }
 
   char charAt(unsigned int index) const {
     if (index < str_.length()) {
@@ -135,7 +260,9 @@ public:
   String substring(unsigned int beginIndex) const {
     if (beginIndex >= str_.length())
       return String("");
-    return String(str_.substr(beginIndex));
+    String out;
+    out.assign(str_.data() + beginIndex, str_.length() - beginIndex);
+    return out;
   }
 
   String substring(unsigned int beginIndex, unsigned int endIndex) const {
@@ -145,7 +272,9 @@ public:
       endIndex = static_cast<unsigned int>(str_.length());
     if (beginIndex >= endIndex)
       return String("");
-    return String(str_.substr(beginIndex, endIndex - beginIndex));
+    String out;
+    out.assign(str_.data() + beginIndex, endIndex - beginIndex);
+    return out;
   }
 
   void toCharArray(char *buf, unsigned int bufsize,
@@ -197,25 +326,23 @@ public:
     str_ = str_.substr(start, end - start + 1);
   }
 
+  // Разбор без strtol/strtod, результат тот же (string_number.h)
   long toInt() const {
     if (str_.empty())
       return 0;
-    char *end;
-    return std::strtol(str_.c_str(), &end, 10);
+    return string_number::parseLong(str_.c_str());
   }
 
   float toFloat() const {
     if (str_.empty())
       return 0.0f;
-    char *end;
-    return std::strtof(str_.c_str(), &end);
+    return string_number::parseFloat(str_.c_str());
   }
 
   double toDouble() const {
     if (str_.empty())
       return 0.0;
-    char *end;
-    return std::strtod(str_.c_str(), &end);
+    return string_number::parseDouble(str_.c_str());
   }
 
   bool equals(const String &rhs) const { return str_ == rhs.str_; }
@@ -224,24 +351,25 @@ public:
     if (str_.length() != rhs.str_.length())
       return false;
 
-    std::string s1 = str_;
-    std::string s2 = rhs.str_;
-    std::transform(s1.begin(), s1.end(), s1.begin(), ::tolower);
-    std::transform(s2.begin(), s2.end(), s2.begin(), ::tolower);
-
-    return s1 == s2;
+    for (size_t i = 0; i < str_.length(); i++) {
+      if (std::tolower(static_cast<unsigned char>(str_[i])) !=
+          std::tolower(static_cast<unsigned char>(rhs.str_[i])))
+        return false;
+    }
+    return true;
   }
 
   bool startsWith(const String &prefix) const {
     if (prefix.length() > length())
       return false;
-    return str_.substr(0, prefix.length()) == prefix.str_;
+    return str_.compare(0, prefix.length(), prefix.str_) == 0;
   }
 
   bool endsWith(const String &suffix) const {
     if (suffix.length() > length())
       return false;
-    return str_.substr(length() - suffix.length()) == suffix.str_;
+    return str_.compare(length() - suffix.length(), suffix.length(),
+                        suffix.str_) == 0;
   }
 
   int compareTo(const String &rhs) const { return str_.compare(rhs.str_); }
@@ -253,6 +381,19 @@ public:
 // Замена подстроки
 String& replace(const String& find, const String& repl) {
     if (find.length() == 0) return *this;
+
+    // Как в WString: буфер растёт до итоговой длины до замены
+    if (repl.length() > find.length()) {
+        size_t count = 0;
+        for (size_t p = str_.find(find.str_); p != std::string::npos;
+             p = str_.find(find.str_, p + find.length())) {
+            count++;
+        }
+        size_t len = str_.length() + count * (repl.length() - find.length());
+        if (count > 0 && !heapReserve(static_cast<unsigned int>(len))) {
+            return *this;
+        }
+    }
     
     size_t pos = 0;
     while ((pos = str_.find(find.str_, pos)) != std::string::npos) {
@@ -292,6 +433,7 @@ String& replace(unsigned int index, unsigned int count, const String& repl) {
     if (index + count > str_.length()) {
         count = static_cast<unsigned int>(str_.length()) - index;
     }
+    if (!heapReserve(length() - count + repl.length())) return *this;
     
     str_.replace(index, count, repl.str_);
     return *this;
@@ -303,35 +445,97 @@ String& replace(unsigned int index, unsigned int count, const char* repl) {
 
   // Операторы присваивания
   String &operator=(const String &rhs) {
-    if (this != &rhs) {
+    if (this == &rhs) return *this;
+    if (!rhs.valid_) {
+      invalidate();
+    } else if (heapCopy(rhs.length())) {
       str_ = rhs.str_;
+      stub_counters::stringCopy(rhs.length());
+    }
+    return *this;
+  }
+
+  // Перемещение как в WString: свой буфер остаётся, если он достаточен
+  String &operator=(String &&rhs) noexcept {
+    if (this == &rhs) return *this;
+    if (heap_block_ != AvrHeap::kNull && heap_capacity_ >= rhs.length() &&
+        rhs.valid_) {
+      str_.swap(rhs.str_);
+      rhs.str_.clear();
+      valid_ = true;
+      return *this;
     }
+    heapRelease();
+    str_ = std::move(rhs.str_);
+    rhs.str_.clear();
+    heap_block_ = rhs.heap_block_;
+    heap_capacity_ = rhs.heap_capacity_;
+    heap_epoch_ = rhs.heap_epoch_;
+    valid_ = rhs.valid_;
+    rhs.heap_block_ = AvrHeap::kNull;
+    rhs.heap_capacity_ = 0;
     return *this;
   }
 
   String &operator=(const char *rhs) {
-    str_ = rhs ? rhs : "";
+    if (!rhs) {
+      invalidate();
+    } else if (heapCopy(static_cast<unsigned int>(strlen(rhs)))) {
+      str_ = rhs;
+      stub_counters::stringCopy(str_.size());
+    }
     return *this;
   }
 
   String &operator=(char c) {
-    str_ = std::string(1, c);
+    assign(&c, 1);
     return *this;
   }
 
-  // Операторы конкатенации
+  String &operator=(const __FlashStringHelper *rhs) {
+    return *this = stub_progmem::check(rhs, "String");
+  }
+
+  // Операторы конкатенации. Если памяти не хватило, строка не меняется.
   String &operator+=(const String &rhs) {
-    str_ += rhs.str_;
+    if (rhs.valid_ && heapReserve(length() + rhs.length())) {
+      str_ += rhs.str_;
+      stub_counters::stringCopy(rhs.length());
+    }
     return *this;
   }
 
   String &operator+=(const char *rhs) {
-    str_ += (rhs ? rhs : "");
+    size_t len = rhs ? strlen(rhs) : 0;
+    if (rhs && heapReserve(length() + static_cast<unsigned int>(len))) {
+      str_.append(rhs, len);
+      stub_counters::stringCopy(len);
+    }
     return *this;
   }
 
+  // Как в ArduinoCore-API: добавить length байт, false — не хватило памяти
+  bool concat(const char *cstr, unsigned int length) {
+    if (!cstr || !heapReserve(this->length() + length)) return false;
+    str_.append(cstr, length);
+    stub_counters::stringCopy(length);
+    return true;
+  }
+
+  String &operator+=(const __FlashStringHelper *rhs) {
+    return *this += stub_progmem::check(rhs, "String::concat");
+  }
+
+  bool concat(const __FlashStringHelper *rhs) {
+    const char *str = stub_progmem::check(rhs, "String::concat");
+    return concat(str, static_cast<unsigned int>(strlen(str)));
+  }
+
   String &operator+=(char c) {
-    str_ += c;
+    if (heapReserve(length() + 1)) {
+      str_ += c;
+      stub_counters::stringCopy(1);
+    }
     return *this;
   }
 
@@ -368,7 +572,7 @@ String& replace(unsigned int index, unsigned int count, const char* repl) {
 
 
   // Для отладки
-  const std::string &getStdString() const { return str_; }
+  std::string getStdString() const { return std::string(str_.data(), str_.size()); }
 };
 
 // Внешние операторы
@@ -383,14 +587,16 @@ inline String operator+(char lhs, const String &rhs) {
 // Вспомогательные функции
 inline String StringFromCharArray(const char *str) { return String(str); }
 
-// Макрос F() - на ПК просто возвращает строку
-#define F(str) (str)
-
-// Поддержка вывода в std::ostream для удобства тестов (std::cout)
-inline std::ostream &operator<<(std::ostream &os, const String &s) {
+// Поддержка вывода в std::ostream для удобства тестов (std::cout).
+// Шаблон, чтобы заголовок не тянул <ostream>: нужен там, где выводят
+template <typename CharT, typename Traits>
+inline std::basic_ostream<CharT, Traits> &
+operator<<(std::basic_ostream<CharT, Traits> &os, const String &s) {
   return os << s.c_str();
 }
 
+// std::hash<String> и поиск в таблицах без временных строк
+#include "string_hash.h"
 
 #endif
 
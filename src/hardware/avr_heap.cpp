@@ -0,0 +1,17 @@
+#include "avr_heap.h"
+
+#include <ostream>
+
+void AvrHeap::printStats(std::ostream &os) const {
+    os << "AVR heap: " << stats_.used << "/" << stats_.heap_size
+       << " bytes used (peak " << stats_.peak_used << "), top "
+       << stats_.brk << " (peak " << stats_.peak_brk << ")" << std::endl;
+    os << "  free " << stats_.free_bytes << ", largest block "
+       << stats_.largest_free << ", fragmentation "
+       << static_cast<int>(stats_.fragmentation() * 100) << "%" << std::endl;
+    os << "  malloc " << stats_.allocations << ", realloc "
+       << stats_.reallocations << ", free " << stats_.frees
+       << ", failed " << stats_.failed;
+    if (stats_.failed) os << " (last " << stats_.last_failed_size << " bytes)";
+    os << std::endl;
+}
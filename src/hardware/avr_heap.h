@@ -0,0 +1,282 @@
+#ifndef AVR_HEAP_H
+#define AVR_HEAP_H
+
+// Симуляция кучи AVR для учёта памяти String.
+//
+// На ATmega328 под кучу остаётся то, что не заняли статические данные и
+// стек, обычно около килобайта. Заглушка String хранит данные в
+// std::string, а параллельно занимает блоки в этой симулированной куче
+// так же, как WString на устройстве: reserve() делает realloc() ровно под
+// длину строки плюс '\0', без запаса.
+//
+// Алгоритм повторяет malloc/realloc/free из avr-libc:
+//   - у каждого блока 2 байта заголовка, минимальный размер данных 2 байта
+//   - malloc ищет в списке свободных блоков точное совпадение, иначе
+//     наименьший подходящий блок; если остаток больше 4 байт, блок
+//     делится, и выдаётся его верхняя часть
+//   - если подходящего блока нет, куча растёт вверх (__brkval)
+//   - free сливает соседние свободные блоки, верхний блок возвращается
+//     в __brkval
+//   - realloc уменьшает блок на месте, расширяет его за счёт соседнего
+//     свободного блока или вершины кучи, иначе выделяет новый и копирует
+//
+// Куча неактивна, пока не вызван begin(). Адреса — смещения от начала
+// кучи, сами данные не хранятся.
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <iosfwd>
+
+class AvrHeap {
+public:
+    static const size_t kNull = static_cast<size_t>(-1);
+
+    struct Stats {
+        size_t heap_size;      // Сколько байт доступно куче
+        size_t used;           // Занято блоками вместе с заголовками
+        size_t peak_used;
+        size_t brk;            // Текущая вершина кучи
+        size_t peak_brk;       // Максимальная вершина (граница со стеком)
+        size_t free_bytes;     // Свободно: список свободных блоков + над вершиной
+        size_t largest_free;   // Самый большой блок, который ещё можно выделить
+        uint32_t allocations;
+        uint32_t reallocations;
+        uint32_t frees;
+        uint32_t failed;       // Неудачные malloc/realloc
+        size_t last_failed_size;
+
+        // Доля свободной памяти, непригодной для самого большого выделения
+        double fragmentation() const {
+            if (free_bytes == 0) return 0;
+            return 1.0 - static_cast<double>(largest_free) / free_bytes;
+        }
+    };
+
+    static AvrHeap &instance() {
+        // Не уничтожается: глобальные String могут освобождаться позже
+        static AvrHeap *heap = new AvrHeap();
+        return *heap;
+    }
+
+    // Включает учёт с кучей размером bytes. Строки, созданные раньше,
+    // займут блоки при следующем изменении.
+    void begin(size_t bytes) {
+        reset();
+        stats_.heap_size = bytes;
+        active_ = true;
+        update();
+    }
+
+    void end() {
+        reset();
+        active_ = false;
+    }
+
+    bool active() const { return active_; }
+
+    // Меняется при каждом begin()/end(): блоки прошлых сессий недействительны
+    uint32_t epoch() const { return epoch_; }
+
+    size_t malloc(size_t len) {
+        if (len < kMinSize) len = kMinSize;
+        size_t block = allocate(len);
+        if (block == kNull) return fail(len);
+        stats_.allocations++;
+        update();
+        return block;
+    }
+
+    size_t realloc(size_t block, size_t len) {
+        if (block == kNull) return malloc(len);
+        std::map<size_t, size_t>::iterator used = used_.find(block);
+        if (used == used_.end()) return kNull;
+        size_t sz = used->second;
+        stats_.reallocations++;
+
+        // Уменьшение на месте, хвост уходит в свободные
+        if (len <= sz) {
+            if (sz <= kFreeListSize || len > sz - kFreeListSize) return block;
+            size_t tail = block + kHeader + len;
+            used->second = len;
+            used_[tail] = sz - len - kHeader;
+            release(tail);
+            update();
+            return block;
+        }
+
+        // Соседний свободный блок сверху
+        size_t incr = len - sz;
+        size_t next = block + kHeader + sz;
+        size_t largest = 0;
+        for (std::map<size_t, size_t>::iterator it = free_.begin(); it != free_.end(); ++it) {
+            if (it->first == next && it->second + kHeader >= incr) {
+                size_t rest = it->second + kHeader - incr;
+                free_.erase(it);
+                if (rest > kFreeListSize) {
+                    used->second = len;
+                    free_[block + kHeader + len] = rest - kHeader;
+                } else {
+                    used->second = sz + rest + incr;
+                }
+                update();
+                return block;
+            }
+            if (it->second > largest) largest = it->second;
+        }
+
+        // Последний блок кучи растёт вместе с вершиной
+        if (brk_ == next && len > largest) {
+            if (block + kHeader + len >= stats_.heap_size) return fail(len);
+            brk_ = block + kHeader + len;
+            used->second = len;
+            update();
+            return block;
+        }
+
+        size_t moved = allocate(len);
+        if (moved == kNull) return fail(len);
+        release(block);
+        update();
+        return moved;
+    }
+
+    void free(size_t block) {
+        if (block == kNull || used_.find(block) == used_.end()) return;
+        release(block);
+        stats_.frees++;
+        update();
+    }
+
+    // Размер данных блока
+    size_t blockSize(size_t block) const {
+        std::map<size_t, size_t>::const_iterator it = used_.find(block);
+        return it == used_.end() ? 0 : it->second;
+    }
+
+    size_t blockCount() const { return used_.size(); }
+
+    const Stats &stats() const { return stats_; }
+
+    void printStats(std::ostream &os) const;
+
+private:
+    static const size_t kHeader = 2;        // sizeof(size_t) на AVR
+    static const size_t kFreeListSize = 4;  // sizeof(struct __freelist)
+    static const size_t kMinSize = kFreeListSize - kHeader;
+
+    bool active_;
+    uint32_t epoch_;
+    size_t brk_;
+    // Начало блока (заголовка) -> размер данных
+    std::map<size_t, size_t> used_;
+    std::map<size_t, size_t> free_;
+    Stats stats_;
+
+    AvrHeap() : active_(false), epoch_(0), brk_(0) { reset(); }
+
+    void reset() {
+        stats_ = Stats();
+        brk_ = 0;
+        used_.clear();
+        free_.clear();
+        epoch_++;
+        update();
+    }
+
+    size_t fail(size_t len) {
+        stats_.failed++;
+        stats_.last_failed_size = len;
+        return kNull;
+    }
+
+    size_t allocate(size_t len) {
+        if (len < kMinSize) len = kMinSize;
+        std::map<size_t, size_t>::iterator best = free_.end();
+        for (std::map<size_t, size_t>::iterator it = free_.begin(); it != free_.end(); ++it) {
+            if (it->second < len) continue;
+            if (it->second == len) {
+                size_t block = it->first;
+                free_.erase(it);
+                used_[block] = len;
+                return block;
+            }
+            if (best == free_.end() || it->second < best->second) best = it;
+        }
+        if (best != free_.end()) {
+            size_t start = best->first;
+            size_t s = best->second;
+            if (s - len < kFreeListSize) {
+                free_.erase(best);
+                used_[start] = s;
+                return start;
+            }
+            // Выдаём верхнюю часть блока
+            best->second = s - len - kHeader;
+            size_t block = start + s - len;
+            used_[block] = len;
+            return block;
+        }
+        if (brk_ + len + kHeader > stats_.heap_size) return kNull;
+        size_t block = brk_;
+        brk_ += len + kHeader;
+        used_[block] = len;
+        return block;
+    }
+
+    void release(size_t block) {
+        std::map<size_t, size_t>::iterator used = used_.find(block);
+        size_t sz = used->second;
+        used_.erase(used);
+
+        std::map<size_t, size_t>::iterator it = free_.insert(std::make_pair(block, sz)).first;
+        std::map<size_t, size_t>::iterator next = it;
+        ++next;
+        if (next != free_.end() && block + kHeader + it->second == next->first) {
+            it->second += next->second + kHeader;
+            free_.erase(next);
+        }
+        if (it != free_.begin()) {
+            std::map<size_t, size_t>::iterator prev = it;
+            --prev;
+            if (prev->first + kHeader + prev->second == it->first) {
+                prev->second += it->second + kHeader;
+                free_.erase(it);
+            }
+        }
+        // Верхний свободный блок возвращается в вершину кучи
+        if (!free_.empty()) {
+            std::map<size_t, size_t>::iterator top = free_.end();
+            --top;
+            if (top->first + kHeader + top->second == brk_) {
+                brk_ = top->first;
+                free_.erase(top);
+            }
+        }
+    }
+
+    void update() {
+        size_t used = 0;
+        for (std::map<size_t, size_t>::const_iterator it = used_.begin(); it != used_.end(); ++it) {
+            used += it->second + kHeader;
+        }
+        size_t free_bytes = 0;
+        size_t largest = 0;
+        for (std::map<size_t, size_t>::const_iterator it = free_.begin(); it != free_.end(); ++it) {
+            free_bytes += it->second + kHeader;
+            if (it->second > largest) largest = it->second;
+        }
+        size_t top = stats_.heap_size > brk_ ? stats_.heap_size - brk_ : 0;
+        free_bytes += top;
+        if (top > kHeader && top - kHeader > largest) largest = top - kHeader;
+
+        stats_.used = used;
+        stats_.brk = brk_;
+        stats_.free_bytes = free_bytes;
+        stats_.largest_free = largest;
+        if (used > stats_.peak_used) stats_.peak_used = used;
+        if (brk_ > stats_.peak_brk) stats_.peak_brk = brk_;
+    }
+};
+
+#endif // AVR_HEAP_H
@@ -0,0 +1,82 @@
+#include "fake_serial.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include "stub_counters.h"
+#include "stub_trace.h"
+
+static uint64_t steadyMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FakeSerial::FakeSerial(bool echo, bool timestamp)
+    : echo_to_stdout_(echo),
+      timestamp_enabled_(timestamp),
+      start_ms_(steadyMillis()),
+      port_(stub_counters::registerPort()),
+      rx_pos_(0) {}
+
+void FakeSerial::begin(unsigned long baudrate) {
+    if (echo_to_stdout_) {
+        std::cout << "[Serial] Initialized with baud rate: " << baudrate << std::endl;
+    }
+}
+
+int FakeSerial::read() {
+    stub_replay::serialObserve(port_, rx_);
+    if (rx_pos_ >= rx_.size()) return -1;
+    stub_counters::serialRead(port_, 1);
+    unsigned char c = rx_[rx_pos_++];
+    if (rx_pos_ == rx_.size()) {
+        rx_.clear();
+        rx_pos_ = 0;
+    }
+    return c;
+}
+
+void FakeSerial::consumeInput(size_t n) {
+    stub_counters::serialRead(port_, n);
+    rx_pos_ += n;
+    if (rx_pos_ >= rx_.size()) {
+        rx_.clear();
+        rx_pos_ = 0;
+    }
+}
+
+size_t FakeSerial::write(const uint8_t* data, size_t size) {
+    const char* buffer = reinterpret_cast<const char*>(data);
+    stub_counters::serialWrite(port_, size);
+    stub_trace::instant(stub_trace::kSerialWrite, port_, size, buffer, size);
+    stub_replay::serialTx(port_, buffer, size);
+    // Добавляем в буфер
+    buffer_.append(buffer, size);
+
+    // Выводим в stdout если включено
+    if (echo_to_stdout_) {
+        if (timestamp_enabled_) {
+            std::cout << "[" << steadyMillis() - start_ms_ << "ms] ";
+        }
+        std::cout.write(buffer, size);
+        std::cout << std::flush;
+    }
+
+    return size;
+}
+
+std::vector<std::string> FakeSerial::getLines() const {
+    std::vector<std::string> lines;
+    std::stringstream ss(buffer_);
+    std::string line;
+
+    while (std::getline(ss, line)) {
+        lines.push_back(line);
+    }
+
+    return lines;
+}
+
+void FakeSerial::setPortName(const char* name) {
+    stub_counters::renamePort(port_, name);
+}
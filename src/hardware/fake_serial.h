@@ -1,33 +1,33 @@
 #ifndef FAKE_SERIAL_H
 #define FAKE_SERIAL_H
 
-#include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <sstream>
 #include <vector>
-#include <chrono>
 #include "arduino_compat.h"  // Для String
+#include "arduino_stream_stub.h"
+#include "stub_replay.h"
 
-class FakeSerial {
+// Объявление FakeSerial; форматирование и вывод в fake_serial.cpp
+
+class FakeSerial : public Stream {
 private:
-    std::stringstream buffer_;
+    std::string buffer_;  // Всё, что записано в порт
     bool echo_to_stdout_;
     bool timestamp_enabled_;
-    std::chrono::steady_clock::time_point start_time_;
+    uint64_t start_ms_;  // Время создания порта для меток в stdout
+    int port_;  // Номер порта в stub_counters
+    std::string rx_;  // Входящие байты, ещё не прочитанные скетчем
+    size_t rx_pos_;
     
 public:
     // Конструктор
-    FakeSerial(bool echo = true, bool timestamp = false) 
-        : echo_to_stdout_(echo), 
-          timestamp_enabled_(timestamp),
-          start_time_(std::chrono::steady_clock::now()) {}
+    FakeSerial(bool echo = true, bool timestamp = false);
     
     // Метод begin (имитация Serial.begin())
-    void begin(unsigned long baudrate) {
-        if (echo_to_stdout_) {
-            std::cout << "[Serial] Initialized with baud rate: " << baudrate << std::endl;
-        }
-    }
+    void begin(unsigned long baudrate);
     
     void begin(unsigned long baudrate, uint8_t config) {
         begin(baudrate);
@@ -35,209 +35,60 @@ public:
     }
     
     // Проверка доступности данных
-    int available() {
-        return 0;  // На ПК всегда 0
+    int available() override {
+        stub_replay::serialObserve(port_, rx_);
+        return static_cast<int>(rx_.size() - rx_pos_);
     }
     
-    // Чтение (заглушки)
-    int read() {
-        return -1;  // EOF
-    }
+    // Чтение входящих байтов, -1 если их нет
+    int read() override;
     
-    int peek() {
-        return -1;
+    int peek() override {
+        stub_replay::serialObserve(port_, rx_);
+        return rx_pos_ < rx_.size() ? static_cast<unsigned char>(rx_[rx_pos_]) : -1;
     }
     
-    void flush() {
+    void flush() override {
         // В реальном Serial очищает буфер передачи
-        buffer_.str("");  // Очищаем буфер
-        buffer_.clear();
-    }
-    
-    // Метод print для разных типов
-    size_t print(const char str[]) {
-        return write(str);
-    }
-    
-    size_t print(char c) {
-        return write(c);
-    }
-    
-    size_t print(unsigned char b, int base = DEC) {
-        return print(static_cast<unsigned long>(b), base);
-    }
-    
-    size_t print(int n, int base = DEC) {
-        return print(static_cast<long>(n), base);
-    }
-    
-    size_t print(unsigned int n, int base = DEC) {
-        return print(static_cast<unsigned long>(n), base);
-    }
-    
-    size_t print(long n, int base = DEC) {
-        std::string str;
-        if (base == DEC) {
-            str = std::to_string(n);
-        } else if (base == HEX) {
-            std::stringstream ss;
-            ss << std::hex << n;
-            str = ss.str();
-        } else if (base == OCT) {
-            std::stringstream ss;
-            ss << std::oct << n;
-            str = ss.str();
-        } else if (base == BIN) {
-            // Бинарное представление
-            unsigned long un = (n < 0) ? -n : n;
-            for (int i = sizeof(n) * 8 - 1; i >= 0; i--) {
-                str += (un & (1UL << i)) ? '1' : '0';
-            }
-        }
-        return write(str.c_str());
-    }
-    
-    size_t print(unsigned long n, int base = DEC) {
-        std::string str;
-        if (base == DEC) {
-            str = std::to_string(n);
-        } else if (base == HEX) {
-            std::stringstream ss;
-            ss << std::hex << n;
-            str = ss.str();
-        } else if (base == OCT) {
-            std::stringstream ss;
-            ss << std::oct << n;
-            str = ss.str();
-        }
-        return write(str.c_str());
-    }
-    
-    size_t print(double n, int digits = 2) {
-        std::stringstream ss;
-        ss.precision(digits);
-        ss << std::fixed << n;
-        return write(ss.str().c_str());
-    }
-    
-    // Для String (нашей реализации)
-    size_t print(const String &str) {
-        return write(str.c_str());
-    }
-    
-    // Метод println (print с новой строкой)
-    size_t println(const char str[]) {
-        size_t n = print(str);
-        n += println();
-        return n;
-    }
-    
-    size_t println(char c) {
-        size_t n = print(c);
-        n += println();
-        return n;
-    }
-    
-    size_t println(unsigned char b, int base = DEC) {
-        size_t n = print(b, base);
-        n += println();
-        return n;
-    }
-    
-    size_t println(int n, int base = DEC) {
-        size_t cnt = print(n, base);
-        cnt += println();
-        return cnt;
-    }
-    
-    size_t println(unsigned int n, int base = DEC) {
-        size_t cnt = print(n, base);
-        cnt += println();
-        return cnt;
-    }
-    
-    size_t println(long n, int base = DEC) {
-        size_t cnt = print(n, base);
-        cnt += println();
-        return cnt;
-    }
-    
-    size_t println(unsigned long n, int base = DEC) {
-        size_t cnt = print(n, base);
-        cnt += println();
-        return cnt;
+        buffer_.clear();  // Очищаем буфер
     }
     
-    size_t println(double n, int digits = 2) {
-        size_t cnt = print(n, digits);
-        cnt += println();
-        return cnt;
-    }
-    
-    size_t println(const String &str) {
-        size_t cnt = print(str);
-        cnt += println();
-        return cnt;
-    }
-    
-    size_t println() {
-        return write("\n");
-    }
+    // print/println/printf — из Print; весь вывод идёт через write()
+    using Print::write;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
     
-    // Низкоуровневый write
-    size_t write(uint8_t c) {
-        return write(static_cast<char>(c));
+    // Вспомогательные методы для тестирования
+
+    // Данные, «пришедшие» в порт: их читают available()/read()/peek().
+    // При воспроизведении журнала вход берётся из журнала, а эти игнорируются.
+    void pushInput(const char* data, size_t size) {
+        if (stub_replay::serialInput(port_, data, size)) rx_.append(data, size);
     }
-    
-    size_t write(const char* str) {
-        return write(str, strlen(str));
+
+    void pushInput(const char* str) {
+        pushInput(str, strlen(str));
     }
-    
-    size_t write(const uint8_t* buffer, size_t size) {
-        return write(reinterpret_cast<const char*>(buffer), size);
+
+    void pushInput(const String& str) {
+        pushInput(str.c_str(), str.length());
     }
-    
-    size_t write(const char* buffer, size_t size) {
-        // Добавляем в буфер
-        std::string data(buffer, size);
-        buffer_ << data;
-        
-        // Выводим в stdout если включено
-        if (echo_to_stdout_) {
-            if (timestamp_enabled_) {
-                auto now = std::chrono::steady_clock::now();
-                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now - start_time_).count();
-                std::cout << "[" << ms << "ms] ";
-            }
-            std::cout << data << std::flush;
-        }
-        
-        return size;
+
+    // Отбросить непрочитанный вход; память буфера остаётся за портом
+    void clearInput() {
+        rx_.clear();
+        rx_pos_ = 0;
     }
-    
-    // Вспомогательные методы для тестирования
+
     std::string getOutput() const {
-        return buffer_.str();
+        return buffer_;
     }
     
     void clearOutput() {
-        buffer_.str("");
         buffer_.clear();
     }
     
-    std::vector<std::string> getLines() const {
-        std::vector<std::string> lines;
-        std::string content = buffer_.str();
-        std::stringstream ss(content);
-        std::string line;
-        
-        while (std::getline(ss, line)) {
-            lines.push_back(line);
-        }
-        
-        return lines;
-    }
+    std::vector<std::string> getLines() const;
     
     // Настройки
     void setEcho(bool enable) {
@@ -247,6 +98,19 @@ public:
     void setTimestamp(bool enable) {
         timestamp_enabled_ = enable;
     }
+
+    // Имя порта в отчёте счётчиков (по умолчанию Serial, Serial1, ...)
+    void setPortName(const char* name);
+
+protected:
+    // Stream читает буфер приёма целиком
+    size_t inputView(const uint8_t*& data) override {
+        stub_replay::serialObserve(port_, rx_);
+        data = reinterpret_cast<const uint8_t*>(rx_.data()) + rx_pos_;
+        return rx_.size() - rx_pos_;
+    }
+
+    void consumeInput(size_t n) override;
 };
 
 // Глобальный экземпляр Serial
@@ -0,0 +1,285 @@
+#ifndef LITTLEFS_HANDLES_H
+#define LITTLEFS_HANDLES_H
+
+// Таблица открытых файлов LittleFSClass.
+//
+// Как и на устройстве, одновременно может быть открыто не больше
+// maxOpenFiles файлов (параметр begin()). Слоты под файлы вместе с буферами
+// выделяются один раз при begin() и дальше переиспользуются; File — только
+// индекс слота и номер поколения. После close() поколение слота меняется,
+// поэтому старые копии File становятся недействительными, а не начинают
+// указывать на чужой файл.
+//
+// Открытые каталоги в лимит не входят (в esp_littlefs они тоже не занимают
+// файловые дескрипторы) и берут слоты из отдельного пула, растущего по
+// необходимости.
+
+#include <cstdint>
+#include <deque>
+#include <dirent.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include "littlefs_volume.h"
+#include "stub_counters.h"
+#include "stub_trace.h"
+
+namespace fs {
+
+    struct FileSlot {
+        // Размер буфера чтения/записи файла на диске (кэш LittleFS)
+        static const size_t kBufferSize = 512;
+
+        uint32_t generation;
+        uint16_t refs;        // Число копий File, ссылающихся на слот
+        bool in_use;
+        bool is_directory;
+        bool readable;
+        bool writable;
+        bool append;
+        std::string path;     // Путь на диске или "/" + путь в томе
+        std::string rel;      // Путь в томе без ведущего '/', корень — ""
+        size_t name_pos;      // Начало имени в path
+        size_t position;
+        size_t size;
+        // Файл из openNextFile() открывается при первом чтении,
+        // а размер узнаётся при первом обращении к нему
+        bool open_pending;
+        bool size_pending;
+
+        // Файл на диске
+        int fd;
+        DIR *dir;
+        std::vector<uint8_t> buf;
+        size_t buf_pos;       // Смещение в файле начала буфера
+        size_t buf_len;
+        bool buf_dirty;       // В буфере незаписанные данные
+        // Журнал снимков дискового тома (LittleFSClass::snapshot) и
+        // признак, что путь файла уже записан в него после снимка
+        std::vector<std::string> *journal;
+        bool journaled;
+
+        // Том в памяти
+        std::shared_ptr<MemoryVolume> volume;
+        MemoryVolume::Data blob;           // Содержимое для чтения
+        std::vector<uint8_t> data;         // Рабочая копия для записи
+        bool mem_dirty;
+        std::vector<std::pair<std::string, bool> > entries;
+        size_t next_entry;
+        bool listed;
+
+        FileSlot()
+            : generation(0), refs(0), in_use(false), is_directory(false),
+              readable(false), writable(false), append(false), name_pos(0),
+              position(0), size(0), open_pending(false), size_pending(false),
+              fd(-1), dir(nullptr), buf_pos(0),
+              buf_len(0), buf_dirty(false), journal(nullptr), journaled(false),
+              mem_dirty(false), next_entry(0),
+              listed(false) {}
+
+        bool inMemory() const { return volume != nullptr; }
+
+        const char *name() const { return path.c_str() + name_pos; }
+
+        void setPath(const std::string &p) {
+            path.assign(p);
+            size_t pos = path.find_last_of('/');
+            name_pos = pos == std::string::npos ? 0 : pos + 1;
+        }
+
+        const std::vector<uint8_t> &content() const {
+            static const std::vector<uint8_t> empty;
+            if (writable) return data;
+            return blob ? *blob : empty;
+        }
+
+        // Запоминает путь в журнале снимков перед изменением файла на диске
+        void noteWrite() {
+            if (journal && !journaled) {
+                journal->push_back(rel);
+                journaled = true;
+            }
+        }
+
+        // Записывает буфер на диск или публикует содержимое в томе
+        bool flush() {
+            if (inMemory()) {
+                if (mem_dirty) {
+                    MemoryVolume::Data copy(new std::vector<uint8_t>(data));
+                    volume->writeFile(rel, copy);
+                    mem_dirty = false;
+                }
+                return true;
+            }
+            if (!buf_dirty) return true;
+            noteWrite();
+            bool ok = true;
+            size_t done = 0;
+            while (done < buf_len) {
+                stub_counters::fsSyscall(rel);
+                ssize_t n = pwrite(fd, buf.data() + done, buf_len - done,
+                                   buf_pos + done);
+                if (n <= 0) {
+                    ok = false;
+                    break;
+                }
+                done += n;
+            }
+            buf_dirty = false;
+            buf_len = 0;
+            return ok;
+        }
+
+        // Закрывает файл и очищает состояние. Строки и векторы сохраняют
+        // выделенную память для следующего открытия.
+        void reset() {
+            flush();
+            if (fd >= 0) {
+                stub_counters::fsSyscall(rel);
+                ::close(fd);
+            }
+            if (dir) {
+                stub_counters::fsSyscall(rel);
+                closedir(dir);
+            }
+            fd = -1;
+            dir = nullptr;
+            in_use = false;
+            refs = 0;
+            is_directory = readable = writable = append = false;
+            path.clear();
+            rel.clear();
+            name_pos = position = size = 0;
+            open_pending = size_pending = false;
+            buf_pos = buf_len = 0;
+            buf_dirty = false;
+            journaled = false;
+            volume.reset();
+            blob.reset();
+            data.clear();
+            mem_dirty = false;
+            entries.clear();
+            next_entry = 0;
+            listed = false;
+        }
+    };
+
+    class FileTable {
+    public:
+        explicit FileTable(uint8_t maxOpenFiles = 5)
+            : file_slots_(0), next_generation_(1), journal_(nullptr) {
+            configure(maxOpenFiles);
+        }
+
+        ~FileTable() { closeAll(); }
+
+        // Пересоздаёт таблицу под новый лимит. Открытые файлы закрываются.
+        void configure(uint8_t maxOpenFiles) {
+            if (maxOpenFiles == file_slots_ && !slots_.empty()) return;
+            closeAll();
+            slots_.clear();
+            free_files_.clear();
+            free_dirs_.clear();
+            file_slots_ = maxOpenFiles;
+            slots_.resize(file_slots_);
+            free_files_.reserve(file_slots_);
+            for (size_t i = file_slots_; i > 0; i--) {
+                slots_[i - 1].buf.resize(FileSlot::kBufferSize);
+                slots_[i - 1].journal = journal_;
+                free_files_.push_back(static_cast<int>(i - 1));
+            }
+        }
+
+        // Журнал, куда открытые файлы записывают свои пути при записи на
+        // диск (nullptr — не записывать). Каждый файл попадает в журнал
+        // один раз до следующего вызова.
+        void setJournal(std::vector<std::string> *journal) {
+            journal_ = journal;
+            for (size_t i = 0; i < slots_.size(); i++) {
+                slots_[i].journal = journal;
+                slots_[i].journaled = false;
+            }
+        }
+
+        // Занимает слот; -1, если лимит открытых файлов исчерпан
+        int acquire(bool directory) {
+            int index;
+            if (directory) {
+                if (free_dirs_.empty()) {
+                    slots_.push_back(FileSlot());
+                    index = static_cast<int>(slots_.size() - 1);
+                    slots_[index].journal = journal_;
+                } else {
+                    index = free_dirs_.back();
+                    free_dirs_.pop_back();
+                }
+            } else {
+                if (free_files_.empty()) return -1;
+                index = free_files_.back();
+                free_files_.pop_back();
+            }
+            FileSlot &slot = slots_[index];
+            slot.in_use = true;
+            slot.refs = 1;
+            slot.is_directory = directory;
+            slot.generation = next_generation_++;
+            return index;
+        }
+
+        // Закрывает слот независимо от числа ссылок
+        void release(int index) {
+            FileSlot &slot = slots_[index];
+            if (!slot.in_use) return;
+            if (!slot.is_directory) stub_trace::instant(stub_trace::kFsClose, slot.rel);
+            slot.reset();
+            slot.generation = next_generation_++;
+            if (static_cast<size_t>(index) < file_slots_) {
+                free_files_.push_back(index);
+            } else {
+                free_dirs_.push_back(index);
+            }
+        }
+
+        FileSlot *get(int index, uint32_t generation) {
+            if (index < 0 || static_cast<size_t>(index) >= slots_.size()) {
+                return nullptr;
+            }
+            FileSlot &slot = slots_[index];
+            if (!slot.in_use || slot.generation != generation) return nullptr;
+            return &slot;
+        }
+
+        FileSlot &at(int index) { return slots_[index]; }
+
+        // Сбрасывает буферы всех открытых файлов
+        void flushAll() {
+            for (size_t i = 0; i < slots_.size(); i++) {
+                if (slots_[i].in_use) slots_[i].flush();
+            }
+        }
+
+        void closeAll() {
+            for (size_t i = 0; i < slots_.size(); i++) {
+                release(static_cast<int>(i));
+            }
+        }
+
+        size_t maxOpenFiles() const { return file_slots_; }
+        size_t openFiles() const { return file_slots_ - free_files_.size(); }
+        bool full() const { return free_files_.empty(); }
+
+    private:
+        // deque: занятие слота под каталог не двигает остальные слоты
+        std::deque<FileSlot> slots_;
+        size_t file_slots_;
+        std::vector<int> free_files_;
+        std::vector<int> free_dirs_;
+        uint32_t next_generation_;
+        std::vector<std::string> *journal_;
+    };
+
+} // namespace fs
+
+#endif // LITTLEFS_HANDLES_H
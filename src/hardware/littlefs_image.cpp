@@ -0,0 +1,683 @@
+#include "littlefs_image.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace fs {
+
+    namespace {
+
+        // Типы тегов дискового формата LittleFS v2
+        const uint32_t kTypeReg = 0x001;
+        const uint32_t kTypeDir = 0x002;
+        const uint32_t kTypeSuperblock = 0x0ff;
+        const uint32_t kTypeDirStruct = 0x200;
+        const uint32_t kTypeInlineStruct = 0x201;
+        const uint32_t kTypeCtzStruct = 0x202;
+        const uint32_t kTypeCreate = 0x401;
+        const uint32_t kTypeDelete = 0x4ff;
+        const uint32_t kTypeSoftTail = 0x600;
+        const uint32_t kTypeHardTail = 0x601;
+        const uint32_t kTypeCrc = 0x500;
+
+        const uint32_t kDiskVersion = 0x00020000;
+        const uint32_t kFileMax = 2147483647;
+        const uint32_t kAttrMax = 1022;
+        const uint32_t kNoId = 0x3ff;
+
+        inline uint32_t mkTag(uint32_t type, uint32_t id, uint32_t size) {
+            return (type << 20) | (id << 10) | size;
+        }
+
+        inline uint32_t tagType3(uint32_t tag) { return (tag >> 20) & 0x7ff; }
+        inline uint32_t tagType1(uint32_t tag) { return (tag >> 20) & 0x700; }
+        inline uint32_t tagId(uint32_t tag) { return (tag >> 10) & 0x3ff; }
+        inline uint32_t tagSize(uint32_t tag) { return tag & 0x3ff; }
+        inline bool tagIsDelete(uint32_t tag) { return tagSize(tag) == 0x3ff; }
+        inline uint32_t tagDSize(uint32_t tag) {
+            return 4 + (tagIsDelete(tag) ? 0 : tagSize(tag));
+        }
+
+        inline uint32_t le32(const uint8_t *p) {
+            return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                   ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        }
+
+        inline uint32_t be32(const uint8_t *p) {
+            return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                   ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+        }
+
+        inline void putLe32(uint8_t *p, uint32_t v) {
+            p[0] = (uint8_t)v;
+            p[1] = (uint8_t)(v >> 8);
+            p[2] = (uint8_t)(v >> 16);
+            p[3] = (uint8_t)(v >> 24);
+        }
+
+        inline void appendLe32(std::vector<uint8_t> &buf, uint32_t v) {
+            uint8_t b[4];
+            putLe32(b, v);
+            buf.insert(buf.end(), b, b + 4);
+        }
+
+        inline int scmp(uint32_t a, uint32_t b) { return (int)(a - b); }
+
+        inline uint32_t ctz(uint32_t v) { return (uint32_t)__builtin_ctz(v); }
+
+        // Сколько байт данных помещается в i-м блоке CTZ-списка
+        inline uint32_t ctzCapacity(uint32_t blockSize, uint32_t index) {
+            return index == 0 ? blockSize : blockSize - 4 * (ctz(index) + 1);
+        }
+
+        // Порядок имён внутри каталога, как в lfs_dir_find_match
+        bool nameLess(const LittleFSImageNode *a, const LittleFSImageNode *b) {
+            size_t n = std::min(a->name.size(), b->name.size());
+            int r = memcmp(a->name.data(), b->name.data(), n);
+            if (r != 0) return r < 0;
+            return a->name.size() < b->name.size();
+        }
+
+        struct CrcTable {
+            uint32_t t[256];
+            CrcTable() {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; k++) {
+                        c = (c & 1) ? (c >> 1) ^ 0xedb88320 : (c >> 1);
+                    }
+                    t[i] = c;
+                }
+            }
+        };
+
+        // Последовательная запись тегов коммита с XOR-цепочкой
+        class CommitEncoder {
+        public:
+            std::vector<uint8_t> bytes;
+
+            CommitEncoder() : ptag_(0xffffffff) {}
+
+            void tag(uint32_t type, uint32_t id, const void *data, uint32_t size) {
+                uint32_t t = mkTag(type, id, size);
+                uint32_t stored = t ^ ptag_;
+                uint8_t b[4] = {(uint8_t)(stored >> 24), (uint8_t)(stored >> 16),
+                                (uint8_t)(stored >> 8), (uint8_t)stored};
+                bytes.insert(bytes.end(), b, b + 4);
+                if (size) {
+                    const uint8_t *p = static_cast<const uint8_t *>(data);
+                    bytes.insert(bytes.end(), p, p + size);
+                }
+                ptag_ = t;
+            }
+
+            uint32_t ptag() const { return ptag_; }
+
+        private:
+            uint32_t ptag_;
+        };
+
+        // Одна запись каталога до разбиения на пары
+        struct DirRecord {
+            uint32_t name_type;
+            std::string name;
+            uint32_t struct_type;
+            std::vector<uint8_t> payload;
+
+            uint32_t encodedSize() const {
+                return 8 + (uint32_t)name.size() + (uint32_t)payload.size();
+            }
+        };
+
+    } // namespace
+
+    uint32_t littlefs_crc(uint32_t crc, const void *buffer, size_t size) {
+        static const CrcTable table;
+        const uint8_t *data = static_cast<const uint8_t *>(buffer);
+        for (size_t i = 0; i < size; i++) {
+            crc = (crc >> 8) ^ table.t[(crc ^ data[i]) & 0xff];
+        }
+        return crc;
+    }
+
+    // ===================== Чтение =====================
+
+    LittleFSImageReader::LittleFSImageReader() : geometry_(0, 0, 0, 0) {
+        root_[0] = 0;
+        root_[1] = 1;
+    }
+
+    bool LittleFSImageReader::fetchBlock(uint32_t block, uint32_t blockSize,
+                                         uint32_t &rev,
+                                         std::vector<LittleFSImageEntry> &entries,
+                                         Tail &tail,
+                                         uint32_t *superblockOffset) const {
+        const std::vector<uint8_t> &img = *image_;
+        uint64_t start = (uint64_t)block * blockSize;
+        if (blockSize < 16 || start + blockSize > img.size()) return false;
+        const uint8_t *base = img.data() + start;
+
+        // Состояние записей внутри одного блока: применяем теги коммита
+        // к pending и переносим в committed только после проверки CRC
+        struct Raw {
+            uint32_t name_type;
+            uint32_t name_off, name_len;
+            uint32_t struct_type;
+            uint32_t struct_off, struct_len;
+            Raw() : name_type(0), name_off(0), name_len(0), struct_type(0),
+                    struct_off(0), struct_len(0) {}
+        };
+        std::vector<Raw> committed, pending;
+        Tail ctail, ptail;
+        ctail.present = ptail.present = false;
+        ctail.hard = ptail.hard = false;
+        bool found = false;
+
+        rev = le32(base);
+        uint32_t crc = littlefs_crc(0xffffffff, base, 4);
+        uint32_t ptag = 0xffffffff;
+        uint32_t off = 4;
+
+        while (off + 4 <= blockSize) {
+            crc = littlefs_crc(crc, base + off, 4);
+            uint32_t tag = be32(base + off) ^ ptag;
+            if (tag & 0x80000000) break;  // Дальше ещё не программировалось
+            uint32_t dsize = tagDSize(tag);
+            if (off + dsize > blockSize) break;
+            ptag = tag;
+
+            uint32_t type = tagType3(tag);
+            if ((type & 0x780) == kTypeCrc) {
+                if (off + 8 > blockSize) break;
+                if (le32(base + off + 4) != crc) break;
+                ptag ^= (uint32_t)(type & 1) << 31;
+                committed = pending;
+                ctail = ptail;
+                found = true;
+                crc = 0xffffffff;
+                off += dsize;
+                continue;
+            }
+
+            crc = littlefs_crc(crc, base + off + 4, dsize - 4);
+            uint32_t id = tagId(tag);
+            uint32_t data_off = (uint32_t)start + off + 4;
+            uint32_t data_len = dsize - 4;
+
+            switch (tagType1(tag)) {
+            case 0x000:  // NAME
+                if (id != kNoId && !tagIsDelete(tag)) {
+                    if (id >= pending.size()) pending.resize(id + 1);
+                    pending[id].name_type = type;
+                    pending[id].name_off = data_off;
+                    pending[id].name_len = data_len;
+                }
+                break;
+            case 0x200:  // STRUCT
+                if (id != kNoId && !tagIsDelete(tag)) {
+                    if (id >= pending.size()) pending.resize(id + 1);
+                    pending[id].struct_type = type;
+                    pending[id].struct_off = data_off;
+                    pending[id].struct_len = data_len;
+                }
+                break;
+            case 0x400:  // SPLICE
+                if (type == kTypeCreate && id <= pending.size()) {
+                    pending.insert(pending.begin() + id, Raw());
+                } else if (type == kTypeDelete && id < pending.size()) {
+                    pending.erase(pending.begin() + id);
+                }
+                break;
+            case 0x600:  // TAIL
+                if (data_len >= 8) {
+                    ptail.present = true;
+                    ptail.hard = (type & 1) != 0;
+                    ptail.pair[0] = le32(base + off + 4);
+                    ptail.pair[1] = le32(base + off + 8);
+                }
+                break;
+            default:  // USERATTR, GLOBALS, FCRC — не нужны для чтения
+                break;
+            }
+            off += dsize;
+        }
+
+        if (!found) return false;
+
+        entries.clear();
+        for (size_t i = 0; i < committed.size(); i++) {
+            const Raw &r = committed[i];
+            if (r.name_type == kTypeSuperblock) {
+                if (superblockOffset && r.struct_type == kTypeInlineStruct &&
+                    r.struct_len >= 24 && r.name_len == 8 &&
+                    memcmp(img.data() + r.name_off, "littlefs", 8) == 0) {
+                    *superblockOffset = r.struct_off;
+                }
+                continue;
+            }
+            if (r.name_type != kTypeReg && r.name_type != kTypeDir) continue;
+
+            LittleFSImageEntry e;
+            e.name.assign(reinterpret_cast<const char *>(img.data() + r.name_off),
+                          r.name_len);
+            e.is_dir = (r.name_type == kTypeDir);
+            if (e.is_dir) {
+                if (r.struct_type != kTypeDirStruct || r.struct_len < 8) continue;
+                e.pair[0] = le32(img.data() + r.struct_off);
+                e.pair[1] = le32(img.data() + r.struct_off + 4);
+            } else if (r.struct_type == kTypeCtzStruct && r.struct_len >= 8) {
+                e.is_inline = false;
+                e.head = le32(img.data() + r.struct_off);
+                e.size = le32(img.data() + r.struct_off + 4);
+            } else {
+                e.is_inline = true;
+                e.offset = r.struct_off;
+                e.size = (r.struct_type == kTypeInlineStruct) ? r.struct_len : 0;
+            }
+            entries.push_back(e);
+        }
+        tail = ctail;
+        return true;
+    }
+
+    bool LittleFSImageReader::fetchPair(const uint32_t pair[2],
+                                        std::vector<LittleFSImageEntry> &entries,
+                                        Tail &tail,
+                                        uint32_t *superblockOffset) const {
+        uint32_t bs = geometry_.block_size;
+        uint32_t rev[2];
+        std::vector<LittleFSImageEntry> e[2];
+        Tail t[2];
+        uint32_t sb[2] = {0, 0};
+        bool ok[2];
+        for (int i = 0; i < 2; i++) {
+            ok[i] = pair[i] < geometry_.block_count &&
+                    fetchBlock(pair[i], bs, rev[i], e[i], t[i], &sb[i]);
+        }
+        int pick;
+        if (ok[0] && ok[1]) {
+            pick = scmp(rev[1], rev[0]) > 0 ? 1 : 0;
+        } else if (ok[0] || ok[1]) {
+            pick = ok[0] ? 0 : 1;
+        } else {
+            return false;
+        }
+        entries.swap(e[pick]);
+        tail = t[pick];
+        if (superblockOffset) *superblockOffset = sb[pick];
+        return true;
+    }
+
+    bool LittleFSImageReader::open(const Bytes &image, uint32_t blockSize,
+                                   std::string *error) {
+        image_ = image;
+        if (!image_ || image_->size() < 1024) {
+            if (error) *error = "image is too small";
+            return false;
+        }
+
+        // Размер блока хранится в суперблоке; чтобы до него добраться,
+        // разбираем блок 0 (или блок 1 при типичных размерах блока)
+        if (blockSize == 0) {
+            uint32_t rev, sb = 0;
+            std::vector<LittleFSImageEntry> tmp;
+            Tail tail;
+            uint32_t bound = (uint32_t)std::min<size_t>(image_->size(), 1u << 20);
+            if (fetchBlock(0, bound, rev, tmp, tail, &sb) && sb) {
+                blockSize = le32(image_->data() + sb + 4);
+            } else {
+                for (uint32_t bs = 512; bs <= 65536 && !blockSize; bs <<= 1) {
+                    sb = 0;
+                    if (fetchBlock(1, bs, rev, tmp, tail, &sb) && sb &&
+                        le32(image_->data() + sb + 4) == bs) {
+                        blockSize = bs;
+                    }
+                }
+            }
+            if (blockSize == 0) {
+                if (error) *error = "superblock not found";
+                return false;
+            }
+        }
+
+        geometry_ = LittleFSGeometry(blockSize,
+                                     (uint32_t)(image_->size() / blockSize));
+        std::vector<LittleFSImageEntry> entries;
+        Tail tail;
+        uint32_t sb = 0;
+        if (!fetchPair(root_, entries, tail, &sb) || sb == 0) {
+            if (error) *error = "superblock not found";
+            return false;
+        }
+
+        const uint8_t *s = image_->data() + sb;
+        uint32_t version = le32(s);
+        if ((version >> 16) != 2) {
+            if (error) *error = "unsupported disk version";
+            return false;
+        }
+        if (le32(s + 4) != blockSize) {
+            if (error) *error = "block size mismatch";
+            return false;
+        }
+        uint32_t count = le32(s + 8);
+        if ((uint64_t)count * blockSize > image_->size()) {
+            if (error) *error = "image is shorter than block_count";
+            return false;
+        }
+        geometry_.block_count = count;
+        geometry_.name_max = le32(s + 12);
+        return true;
+    }
+
+    bool LittleFSImageReader::readDir(const uint32_t pair[2],
+                                      std::vector<LittleFSImageEntry> &out) const {
+        out.clear();
+        uint32_t cur[2] = {pair[0], pair[1]};
+        // Ограничение на длину цепочки защищает от циклов в битом образе
+        for (uint32_t hops = 0; hops < geometry_.block_count; hops++) {
+            std::vector<LittleFSImageEntry> part;
+            Tail tail;
+            if (!fetchPair(cur, part, tail)) return false;
+            out.insert(out.end(), part.begin(), part.end());
+            if (!tail.present || !tail.hard) return true;
+            cur[0] = tail.pair[0];
+            cur[1] = tail.pair[1];
+        }
+        return false;
+    }
+
+    bool LittleFSImageReader::readFile(const LittleFSImageEntry &entry,
+                                       std::vector<uint8_t> &out) const {
+        const std::vector<uint8_t> &img = *image_;
+        out.clear();
+        if (entry.is_dir) return false;
+        if (entry.is_inline) {
+            if ((uint64_t)entry.offset + entry.size > img.size()) return false;
+            out.assign(img.begin() + entry.offset,
+                       img.begin() + entry.offset + entry.size);
+            return true;
+        }
+        if (entry.size == 0) return true;
+
+        uint32_t bs = geometry_.block_size;
+        // Индекс последнего блока
+        uint32_t last = 0;
+        uint32_t remaining = entry.size;
+        while (remaining > ctzCapacity(bs, last)) {
+            remaining -= ctzCapacity(bs, last);
+            last++;
+        }
+
+        // Проходим по указателю 0 от головы к началу файла
+        std::vector<uint32_t> blocks(last + 1);
+        blocks[last] = entry.head;
+        for (uint32_t i = last; i > 0; i--) {
+            if (blocks[i] >= geometry_.block_count) return false;
+            blocks[i - 1] = le32(img.data() + (size_t)blocks[i] * bs);
+        }
+        if (blocks[0] >= geometry_.block_count) return false;
+
+        out.reserve(entry.size);
+        remaining = entry.size;
+        for (uint32_t i = 0; i <= last; i++) {
+            uint32_t skip = bs - ctzCapacity(bs, i);
+            uint32_t n = std::min(remaining, bs - skip);
+            const uint8_t *p = img.data() + (size_t)blocks[i] * bs + skip;
+            out.insert(out.end(), p, p + n);
+            remaining -= n;
+        }
+        return true;
+    }
+
+    // ===================== Запись =====================
+
+    struct LittleFSImageWriter::PendingDir {
+        std::vector<uint32_t> pairs;  // По два блока на каждую часть каталога
+        std::vector<std::vector<DirRecord> > chunks;
+    };
+
+    LittleFSImageWriter::LittleFSImageWriter(const LittleFSGeometry &geometry)
+        : geometry_(geometry), next_block_(2), out_(nullptr) {}
+
+    bool LittleFSImageWriter::allocBlock(uint32_t &block) {
+        if (next_block_ >= geometry_.block_count) {
+            error_ = "no space left in image";
+            return false;
+        }
+        block = next_block_++;
+        return true;
+    }
+
+    bool LittleFSImageWriter::writeCtz(const std::vector<uint8_t> &data,
+                                       uint32_t &head) {
+        uint32_t bs = geometry_.block_size;
+        std::vector<uint32_t> blocks;
+        size_t pos = 0;
+        for (uint32_t i = 0; pos < data.size(); i++) {
+            uint32_t block;
+            if (!allocBlock(block)) return false;
+            blocks.push_back(block);
+            uint8_t *p = out_->data() + (size_t)block * bs;
+            uint32_t skip = bs - ctzCapacity(bs, i);
+            // Указатель j ссылается на блок с индексом i - 2^j
+            for (uint32_t j = 0; j * 4 < skip; j++) {
+                putLe32(p + 4 * j, blocks[i - (1u << j)]);
+            }
+            size_t n = std::min<size_t>(data.size() - pos, bs - skip);
+            memcpy(p + skip, data.data() + pos, n);
+            pos += n;
+        }
+        head = blocks.back();
+        return true;
+    }
+
+    bool LittleFSImageWriter::layoutDir(const LittleFSImageNode &dir, bool isRoot,
+                                        std::vector<PendingDir> &dirs) {
+        size_t self = dirs.size();
+        dirs.push_back(PendingDir());
+        if (isRoot) {
+            dirs[self].pairs.push_back(0);
+            dirs[self].pairs.push_back(1);
+        } else {
+            // Первая пара уже выделена родителем — она нужна ему для DIRSTRUCT
+            dirs[self].pairs.push_back(0);
+            dirs[self].pairs.push_back(0);
+        }
+
+        std::vector<const LittleFSImageNode *> sorted;
+        for (size_t i = 0; i < dir.children.size(); i++) {
+            sorted.push_back(&dir.children[i]);
+        }
+        std::sort(sorted.begin(), sorted.end(), nameLess);
+
+        uint32_t bs = geometry_.block_size;
+        uint32_t inline_max = std::min(std::min(geometry_.prog_size, bs / 8),
+                                       (uint32_t)0x3fe);
+        std::vector<DirRecord> records;
+        std::vector<uint32_t> child_pairs;
+
+        if (isRoot) {
+            DirRecord sb;
+            sb.name_type = kTypeSuperblock;
+            sb.name = "littlefs";
+            sb.struct_type = kTypeInlineStruct;
+            appendLe32(sb.payload, kDiskVersion);
+            appendLe32(sb.payload, geometry_.block_size);
+            appendLe32(sb.payload, geometry_.block_count);
+            appendLe32(sb.payload, geometry_.name_max);
+            appendLe32(sb.payload, kFileMax);
+            appendLe32(sb.payload, kAttrMax);
+            records.push_back(sb);
+        }
+
+        for (size_t i = 0; i < sorted.size(); i++) {
+            const LittleFSImageNode &n = *sorted[i];
+            if (n.name.empty() || n.name.size() > geometry_.name_max ||
+                n.name.find('/') != std::string::npos) {
+                error_ = "invalid name: '" + n.name + "'";
+                return false;
+            }
+            if (i > 0 && n.name == sorted[i - 1]->name) {
+                error_ = "duplicate name: '" + n.name + "'";
+                return false;
+            }
+            DirRecord r;
+            r.name = n.name;
+            if (n.is_dir) {
+                uint32_t a, b;
+                if (!allocBlock(a) || !allocBlock(b)) return false;
+                r.name_type = kTypeDir;
+                r.struct_type = kTypeDirStruct;
+                appendLe32(r.payload, a);
+                appendLe32(r.payload, b);
+                child_pairs.push_back(a);
+                child_pairs.push_back(b);
+            } else {
+                static const std::vector<uint8_t> empty;
+                const std::vector<uint8_t> &data = n.data ? *n.data : empty;
+                r.name_type = kTypeReg;
+                if (data.size() <= inline_max) {
+                    r.struct_type = kTypeInlineStruct;
+                    r.payload = data;
+                } else {
+                    uint32_t head;
+                    if (!writeCtz(data, head)) return false;
+                    r.struct_type = kTypeCtzStruct;
+                    appendLe32(r.payload, head);
+                    appendLe32(r.payload, (uint32_t)data.size());
+                }
+            }
+            records.push_back(r);
+        }
+
+        // Разбиваем на части так, чтобы каждая занимала не больше половины
+        // блока — у устройства остаётся место для дописывания коммитов
+        const uint32_t overhead = 4 + 12 + 8 + geometry_.prog_size;
+        uint32_t limit = bs / 2;
+        std::vector<std::vector<DirRecord> > chunks(1);
+        uint32_t used = 0;
+        for (size_t i = 0; i < records.size(); i++) {
+            uint32_t sz = records[i].encodedSize();
+            if (sz + overhead > bs) {
+                error_ = "entry does not fit into metadata block: '" +
+                         records[i].name + "'";
+                return false;
+            }
+            if (!chunks.back().empty() && used + sz > limit) {
+                chunks.push_back(std::vector<DirRecord>());
+                used = 0;
+            }
+            chunks.back().push_back(records[i]);
+            used += sz;
+        }
+        for (size_t i = 1; i < chunks.size(); i++) {
+            uint32_t a, b;
+            if (!allocBlock(a) || !allocBlock(b)) return false;
+            dirs[self].pairs.push_back(a);
+            dirs[self].pairs.push_back(b);
+        }
+        dirs[self].chunks.swap(chunks);
+
+        // Дочерние каталоги идут в softtail-цепочке сразу за родителем
+        size_t k = 0;
+        for (size_t i = 0; i < sorted.size(); i++) {
+            if (!sorted[i]->is_dir) continue;
+            size_t child = dirs.size();
+            if (!layoutDir(*sorted[i], false, dirs)) return false;
+            dirs[child].pairs[0] = child_pairs[k];
+            dirs[child].pairs[1] = child_pairs[k + 1];
+            k += 2;
+        }
+        return true;
+    }
+
+    bool LittleFSImageWriter::commitPair(const uint32_t pair[2],
+                                         const std::vector<uint8_t> &tags) {
+        uint32_t bs = geometry_.block_size;
+        uint8_t *p = out_->data() + (size_t)pair[0] * bs;
+        // Ревизия 1 в первом блоке, второй блок пары остаётся стёртым
+        putLe32(p, 1);
+        memcpy(p + 4, tags.data(), tags.size());
+        return true;
+    }
+
+    bool LittleFSImageWriter::write(const LittleFSImageNode &root,
+                                    std::vector<uint8_t> &out,
+                                    std::string *error) {
+        const LittleFSGeometry &g = geometry_;
+        error_.clear();
+        if (g.block_size < 512 || g.prog_size == 0 || g.prog_size > 512 ||
+            g.block_size % g.prog_size != 0 || g.block_count < 2) {
+            if (error) *error = "invalid geometry";
+            return false;
+        }
+
+        out.assign((size_t)g.block_size * g.block_count, 0xff);
+        out_ = &out;
+        next_block_ = 2;
+
+        std::vector<PendingDir> dirs;
+        if (!layoutDir(root, true, dirs)) {
+            if (error) *error = error_;
+            out.clear();
+            return false;
+        }
+
+        // Сквозной список всех пар: внутри каталога hardtail, между
+        // каталогами softtail
+        for (size_t d = 0; d < dirs.size(); d++) {
+            const PendingDir &pd = dirs[d];
+            for (size_t c = 0; c < pd.chunks.size(); c++) {
+                CommitEncoder enc;
+                const std::vector<DirRecord> &recs = pd.chunks[c];
+                for (uint32_t id = 0; id < recs.size(); id++) {
+                    const DirRecord &r = recs[id];
+                    enc.tag(r.name_type, id, r.name.data(), (uint32_t)r.name.size());
+                    enc.tag(r.struct_type, id, r.payload.data(),
+                            (uint32_t)r.payload.size());
+                }
+
+                const uint32_t *next = nullptr;
+                uint32_t tail_type = kTypeSoftTail;
+                if (c + 1 < pd.chunks.size()) {
+                    next = &pd.pairs[2 * (c + 1)];
+                    tail_type = kTypeHardTail;
+                } else if (d + 1 < dirs.size()) {
+                    next = &dirs[d + 1].pairs[0];
+                }
+                if (next) {
+                    uint8_t t[8];
+                    putLe32(t, next[0]);
+                    putLe32(t + 4, next[1]);
+                    enc.tag(tail_type, kNoId, t, 8);
+                }
+
+                // CRC-тег: добиваем коммит до границы prog_size
+                uint32_t off = 4 + (uint32_t)enc.bytes.size();
+                uint32_t end = (off + 8 + g.prog_size - 1) / g.prog_size * g.prog_size;
+                if (end > g.block_size) {
+                    if (error) *error = "metadata block overflow";
+                    out.clear();
+                    return false;
+                }
+                uint8_t rev[4];
+                putLe32(rev, 1);
+                uint32_t crc = littlefs_crc(0xffffffff, rev, 4);
+                crc = littlefs_crc(crc, enc.bytes.data(), enc.bytes.size());
+                uint32_t tag = mkTag(kTypeCrc, kNoId, end - (off + 4));
+                uint32_t stored = tag ^ enc.ptag();
+                uint8_t footer[8] = {(uint8_t)(stored >> 24), (uint8_t)(stored >> 16),
+                                     (uint8_t)(stored >> 8), (uint8_t)stored};
+                crc = littlefs_crc(crc, footer, 4);
+                putLe32(footer + 4, crc);
+                enc.bytes.insert(enc.bytes.end(), footer, footer + 8);
+
+                commitPair(&pd.pairs[2 * c], enc.bytes);
+            }
+        }
+        out_ = nullptr;
+        return true;
+    }
+
+} // namespace fs
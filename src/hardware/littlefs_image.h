@@ -0,0 +1,133 @@
+#ifndef LITTLEFS_IMAGE_H
+#define LITTLEFS_IMAGE_H
+
+// Чтение и запись бинарных образов LittleFS (дисковый формат v2.0),
+// совместимых с mklittlefs и с прошивкой на устройстве.
+//
+// Поддерживается подмножество формата, которого достаточно для образов,
+// собранных mklittlefs или снятых с устройства:
+//  - пары метаданных с журналом коммитов, XOR-цепочкой тегов и CRC;
+//  - встроенные (inline) файлы и файлы в CTZ skip-list;
+//  - каталоги, разбитые на несколько пар (hardtail).
+// Пользовательские атрибуты и незавершённые перемещения (gstate)
+// игнорируются.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+    // Геометрия тома. Значения по умолчанию соответствуют разделу 1MB
+    // на ESP32 (mklittlefs -b 4096 -p 256).
+    struct LittleFSGeometry {
+        uint32_t block_size;
+        uint32_t block_count;
+        uint32_t prog_size;  // Выравнивание коммитов, должно делить block_size
+        uint32_t name_max;   // Записывается в суперблок
+
+        LittleFSGeometry(uint32_t blockSize = 4096, uint32_t blockCount = 256,
+                         uint32_t progSize = 256, uint32_t nameMax = 64)
+            : block_size(blockSize), block_count(blockCount),
+              prog_size(progSize), name_max(nameMax) {}
+    };
+
+    // Запись каталога в образе
+    struct LittleFSImageEntry {
+        std::string name;
+        bool is_dir;
+        uint32_t pair[2];     // Каталог: пара метаданных
+        bool is_inline;       // Файл: данные лежат прямо в метаданных
+        uint32_t offset;      // inline: смещение данных от начала образа
+        uint32_t head;        // CTZ: последний блок файла
+        uint32_t size;        // Размер файла
+
+        LittleFSImageEntry()
+            : is_dir(false), is_inline(true), offset(0), head(0), size(0) {
+            pair[0] = pair[1] = 0;
+        }
+    };
+
+    // Декодер образа. Образ целиком лежит в памяти и разделяется с
+    // вызывающим кодом; каталоги декодируются только по запросу.
+    class LittleFSImageReader {
+    public:
+        typedef std::shared_ptr<const std::vector<uint8_t> > Bytes;
+
+        LittleFSImageReader();
+
+        // blockSize == 0 — определить по суперблоку
+        bool open(const Bytes &image, uint32_t blockSize = 0,
+                  std::string *error = nullptr);
+
+        const LittleFSGeometry &geometry() const { return geometry_; }
+        const uint32_t *rootPair() const { return root_; }
+
+        // Читает все записи каталога, проходя по hardtail-цепочке
+        bool readDir(const uint32_t pair[2],
+                     std::vector<LittleFSImageEntry> &out) const;
+
+        bool readFile(const LittleFSImageEntry &entry,
+                      std::vector<uint8_t> &out) const;
+
+    private:
+        struct Tail {
+            bool present;
+            bool hard;
+            uint32_t pair[2];
+        };
+
+        Bytes image_;
+        LittleFSGeometry geometry_;
+        uint32_t root_[2];
+
+        bool fetchPair(const uint32_t pair[2],
+                       std::vector<LittleFSImageEntry> &entries, Tail &tail,
+                       uint32_t *superblockOffset = nullptr) const;
+        bool fetchBlock(uint32_t block, uint32_t blockSize, uint32_t &rev,
+                        std::vector<LittleFSImageEntry> &entries, Tail &tail,
+                        uint32_t *superblockOffset) const;
+    };
+
+    // Узел дерева для записи образа
+    struct LittleFSImageNode {
+        std::string name;
+        bool is_dir;
+        std::shared_ptr<const std::vector<uint8_t> > data;  // Для файлов
+        std::vector<LittleFSImageNode> children;            // Для каталогов
+
+        LittleFSImageNode() : is_dir(false) {}
+    };
+
+    // Кодировщик: раскладывает дерево в образ так же, как mklittlefs —
+    // корень в блоках 0/1, каталоги по одной (или несколько, если не
+    // помещаются) паре метаданных, связанные softtail-цепочкой.
+    class LittleFSImageWriter {
+    public:
+        explicit LittleFSImageWriter(const LittleFSGeometry &geometry);
+
+        bool write(const LittleFSImageNode &root, std::vector<uint8_t> &out,
+                   std::string *error = nullptr);
+
+    private:
+        struct PendingDir;
+
+        LittleFSGeometry geometry_;
+        uint32_t next_block_;
+        std::vector<uint8_t> *out_;
+        std::string error_;
+
+        bool allocBlock(uint32_t &block);
+        bool writeCtz(const std::vector<uint8_t> &data, uint32_t &head);
+        bool layoutDir(const LittleFSImageNode &dir, bool isRoot,
+                       std::vector<PendingDir> &dirs);
+        bool commitPair(const uint32_t pair[2], const std::vector<uint8_t> &tags);
+    };
+
+    // CRC32 в варианте LittleFS (полином 0x04c11db7, без финальной инверсии)
+    uint32_t littlefs_crc(uint32_t crc, const void *buffer, size_t size);
+
+} // namespace fs
+
+#endif // LITTLEFS_IMAGE_H
@@ -0,0 +1,174 @@
+#ifndef LITTLEFS_PATHS_H
+#define LITTLEFS_PATHS_H
+
+// Общий слой разрешения путей для LittleFSClass.
+//
+// Каждый путь, переданный в open/exists/remove/rename/mkdir, приводится к
+// одному виду (без повторных и крайних слешей, "." пропускается, ".."
+// поднимается на уровень выше) и запоминается. Повторное обращение по той
+// же строке находит готовую запись по хешу без выделения памяти; разные
+// написания одного пути разделяют одну запись.
+//
+// Таблица хранит не больше kMaxPaths написаний. Когда место кончается,
+// текущее поколение записей откладывается, и таблица начинается заново.
+// Отложенное поколение освобождается при следующей смене, поэтому ссылка
+// из предыдущего resolve() (rename разрешает два пути подряд) остаётся
+// валидной, а тест, открывающий миллионы разных имён, не копит память.
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs {
+
+    struct PathEntry {
+        std::string rel;       // "dir/file.txt", корень — ""
+        std::string host;      // Полный путь на диске: base + "/" + rel
+        std::string host_dir;  // Каталог на диске, в котором лежит host
+        size_t name_pos;       // Начало последнего компонента в rel
+
+        const char *name() const { return rel.c_str() + name_pos; }
+        bool isRoot() const { return rel.empty(); }
+    };
+
+    class PathTable {
+    public:
+        static const size_t kMaxPaths = 4096;
+
+        PathTable() : used_(0) { slots_.resize(64); }
+
+        // Сбрасывает таблицу: записи зависят от базового пути
+        void reset(const std::string &basePath) {
+            base_ = basePath;
+            slots_.assign(64, Slot());
+            used_ = 0;
+            raw_.clear();
+            entries_.clear();
+            by_rel_.clear();
+            retired_raw_.clear();
+            retired_entries_.clear();
+        }
+
+        const PathEntry &resolve(const char *path) {
+            if (!path) path = "";
+            uint32_t len = 0;
+            uint32_t hash = 2166136261u;  // FNV-1a
+            for (const char *p = path; *p; p++, len++) {
+                hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619u;
+            }
+
+            size_t mask = slots_.size() - 1;
+            size_t i = hash & mask;
+            while (slots_[i].entry) {
+                const Slot &s = slots_[i];
+                if (s.hash == hash && s.raw->size() == len &&
+                    memcmp(s.raw->data(), path, len) == 0) {
+                    return *s.entry;
+                }
+                i = (i + 1) & mask;
+            }
+
+            // Промах: нормализуем и находим или создаём общую запись
+            if (raw_.size() >= kMaxPaths) retire();
+            std::string rel = normalize(path);
+            std::unordered_map<std::string, PathEntry *>::iterator it = by_rel_.find(rel);
+            PathEntry *entry;
+            if (it != by_rel_.end()) {
+                entry = it->second;
+            } else {
+                entries_.push_back(PathEntry());
+                entry = &entries_.back();
+                entry->rel = rel;
+                entry->host = rel.empty() ? base_ : base_ + "/" + rel;
+                size_t slash = entry->host.find_last_of('/');
+                entry->host_dir = slash == std::string::npos
+                                      ? std::string()
+                                      : entry->host.substr(0, slash);
+                size_t pos = rel.find_last_of('/');
+                entry->name_pos = pos == std::string::npos ? 0 : pos + 1;
+                by_rel_[rel] = entry;
+            }
+
+            raw_.push_back(std::string(path, len));
+            insert(hash, &raw_.back(), entry);
+            return *entry;
+        }
+
+        static std::string normalize(const char *path) {
+            std::string result;
+            const char *p = path ? path : "";
+            while (*p) {
+                while (*p == '/') p++;
+                const char *start = p;
+                while (*p && *p != '/') p++;
+                size_t len = p - start;
+                if (len == 0 || (len == 1 && start[0] == '.')) continue;
+                if (len == 2 && start[0] == '.' && start[1] == '.') {
+                    size_t pos = result.find_last_of('/');
+                    result.erase(pos == std::string::npos ? 0 : pos);
+                    continue;
+                }
+                if (!result.empty()) result += '/';
+                result.append(start, len);
+            }
+            return result;
+        }
+
+        // Записи текущего поколения
+        size_t size() const { return entries_.size(); }
+
+    private:
+        struct Slot {
+            uint32_t hash;
+            const std::string *raw;
+            PathEntry *entry;
+            Slot() : hash(0), raw(nullptr), entry(nullptr) {}
+        };
+
+        std::string base_;
+        std::vector<Slot> slots_;
+        size_t used_;
+        // deque не переносит элементы, ссылки на записи остаются валидными
+        std::deque<std::string> raw_;
+        std::deque<PathEntry> entries_;
+        std::unordered_map<std::string, PathEntry *> by_rel_;
+        // Предыдущее поколение: на его записи ещё могут ссылаться
+        std::deque<std::string> retired_raw_;
+        std::deque<PathEntry> retired_entries_;
+
+        void retire() {
+            retired_raw_.swap(raw_);
+            retired_entries_.swap(entries_);
+            raw_.clear();
+            entries_.clear();
+            by_rel_.clear();
+            slots_.assign(64, Slot());
+            used_ = 0;
+        }
+
+        void insert(uint32_t hash, const std::string *raw, PathEntry *entry) {
+            if ((used_ + 1) * 4 > slots_.size() * 3) {
+                std::vector<Slot> old;
+                old.swap(slots_);
+                slots_.resize(old.size() * 2);
+                used_ = 0;
+                for (size_t i = 0; i < old.size(); i++) {
+                    if (old[i].entry) insert(old[i].hash, old[i].raw, old[i].entry);
+                }
+            }
+            size_t mask = slots_.size() - 1;
+            size_t i = hash & mask;
+            while (slots_[i].entry) i = (i + 1) & mask;
+            slots_[i].hash = hash;
+            slots_[i].raw = raw;
+            slots_[i].entry = entry;
+            used_++;
+        }
+    };
+
+} // namespace fs
+
+#endif // LITTLEFS_PATHS_H
@@ -1,5 +1,1060 @@
 #include "littlefs_stub.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "stub_counters.h"
+#include "stub_replay.h"
+#include "stub_trace.h"
+
 namespace fs {
     LittleFSClass LittleFS;
-}
\ No newline at end of file
+
+    void File::release() {
+        FileSlot* s = slot();
+        if (s && --s->refs == 0) {
+            table_->release(index_);
+        }
+        table_ = nullptr;
+        index_ = -1;
+        generation_ = 0;
+    }
+
+    File File::openHost(FileTable& table, const std::string& host,
+                        const std::string& relPath, const char* mode) {
+        struct stat st;
+        stub_counters::fsSyscall(relPath);
+        bool exists = stat(host.c_str(), &st) == 0;
+        bool create = strchr(mode, 'w') || strchr(mode, 'a');
+
+        if (exists && S_ISDIR(st.st_mode)) {
+            if (create) return File();
+            int index = table.acquire(true);
+            table.at(index).setPath(host);
+            table.at(index).rel.assign(relPath);
+            return File(&table, index);
+        }
+        if (!exists && !create) return File();
+
+        int index = table.acquire(false);
+        if (index < 0) return File();
+        FileSlot& s = table.at(index);
+        applyMode(s, mode);
+        int flags = (s.readable && s.writable) ? O_RDWR
+                  : s.writable ? O_WRONLY : O_RDONLY;
+        if (create) flags |= O_CREAT;
+        if (strchr(mode, 'w')) flags |= O_TRUNC;
+        stub_counters::fsSyscall(relPath);
+        s.fd = ::open(host.c_str(), flags | O_CLOEXEC, 0644);
+        if (s.fd < 0) {
+            table.release(index);
+            return File();
+        }
+        s.setPath(host);
+        s.rel.assign(relPath);
+        s.size = (exists && !(flags & O_TRUNC)) ? st.st_size : 0;
+        if (s.append) s.position = s.size;
+        return File(&table, index);
+    }
+
+    File File::openMemory(FileTable& table, const std::shared_ptr<MemoryVolume>& volume,
+                          const std::string& relPath, bool is_dir, const char* mode) {
+        int index = table.acquire(is_dir);
+        if (index < 0) return File();
+        FileSlot& s = table.at(index);
+        s.volume = volume;
+        s.rel.assign(relPath);
+        s.path.assign("/");
+        s.path.append(relPath);
+        s.name_pos = s.path.find_last_of('/') + 1;
+        if (is_dir) return File(&table, index);
+
+        applyMode(s, mode);
+        volume->readFile(relPath, s.blob);
+        if (s.writable && !strchr(mode, 'w') && s.blob) {
+            s.data.assign(s.blob->begin(), s.blob->end());
+        }
+        s.size = s.content().size();
+        if (s.append) s.position = s.size;
+        return File(&table, index);
+    }
+
+    bool File::nextEntry(FileSlot& s, const char*& name, bool& is_dir) {
+        if (s.inMemory()) {
+            if (!s.listed) {
+                s.volume->list(s.rel, s.entries);
+                s.listed = true;
+                s.next_entry = 0;
+            }
+            if (s.next_entry >= s.entries.size()) return false;
+            const std::pair<std::string, bool>& entry = s.entries[s.next_entry++];
+            name = entry.first.c_str();
+            is_dir = entry.second;
+            return true;
+        }
+
+        if (s.dir == nullptr) {
+            stub_counters::fsSyscall(s.rel);
+            s.dir = opendir(s.path.c_str());
+            if (!s.dir) return false;
+        }
+        struct dirent* entry;
+        while ((entry = readdir(s.dir)) != nullptr) {
+            // Пропускаем . и ..
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                std::string full_path;
+                appendChild(full_path, s.path, entry->d_name);
+                struct stat st;
+                stub_counters::fsVolumeSyscall();
+                if (stat(full_path.c_str(), &st) != 0) continue;
+                type = S_ISDIR(st.st_mode) ? DT_DIR
+                     : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+            }
+            // В LittleFS бывают только файлы и каталоги
+            if (type != DT_DIR && type != DT_REG) continue;
+            name = entry->d_name;
+            is_dir = type == DT_DIR;
+            return true;
+        }
+        // Конец каталога: до rewindDirectory() записей больше не будет
+        return false;
+    }
+
+    bool File::ensureOpen(FileSlot& s) {
+        if (!s.open_pending) return true;
+        s.open_pending = false;
+        stub_counters::fsSyscall(s.rel, s.size_pending ? 2 : 1);
+        s.fd = ::open(s.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (s.fd < 0) return false;
+        struct stat st;
+        if (s.size_pending && fstat(s.fd, &st) == 0) {
+            s.size = st.st_size;
+            s.size_pending = false;
+        }
+        return true;
+    }
+
+    size_t File::sizeOf(FileSlot& s) {
+        if (s.size_pending) {
+            struct stat st;
+            stub_counters::fsSyscall(s.rel);
+            s.size = stat(s.path.c_str(), &st) == 0 ? st.st_size : 0;
+            s.size_pending = false;
+        }
+        return s.size;
+    }
+
+    size_t File::memRead(FileSlot& s, uint8_t* buf, size_t size) {
+        const std::vector<uint8_t>& data = s.content();
+        if (s.position >= data.size()) return 0;
+        size_t n = std::min(size, data.size() - s.position);
+        memcpy(buf, data.data() + s.position, n);
+        s.position += n;
+        return n;
+    }
+
+    size_t File::memWrite(FileSlot& s, const uint8_t* buf, size_t size) {
+        std::vector<uint8_t>& data = s.data;
+        if (s.append) s.position = data.size();
+        if (s.position + size > data.size()) data.resize(s.position + size);
+        memcpy(data.data() + s.position, buf, size);
+        s.position += size;
+        s.size = data.size();
+        s.mem_dirty = true;
+        return size;
+    }
+
+    size_t File::diskRead(FileSlot& s, uint8_t* out, size_t size) {
+        size_t total = 0;
+        while (total < size && s.position < s.size) {
+            size_t want = std::min(size - total, s.size - s.position);
+            if (!s.buf_dirty && s.position >= s.buf_pos &&
+                s.position < s.buf_pos + s.buf_len) {
+                size_t n = std::min(want, s.buf_pos + s.buf_len - s.position);
+                memcpy(out + total, s.buf.data() + (s.position - s.buf_pos), n);
+                s.position += n;
+                total += n;
+                continue;
+            }
+            s.flush();
+            // Большие чтения идут мимо буфера
+            uint8_t* dst = want >= s.buf.size() ? out + total : s.buf.data();
+            size_t len = want >= s.buf.size() ? want : s.buf.size();
+            stub_counters::fsSyscall(s.rel);
+            ssize_t n = pread(s.fd, dst, len, s.position);
+            if (n <= 0) break;
+            if (dst == out + total) {
+                s.position += n;
+                total += n;
+            } else {
+                s.buf_pos = s.position;
+                s.buf_len = n;
+            }
+        }
+        return total;
+    }
+
+    size_t File::diskWrite(FileSlot& s, const uint8_t* in, size_t size) {
+        s.noteWrite();
+        if (s.append) s.position = s.size;
+        if (s.buf_dirty && s.position != s.buf_pos + s.buf_len) s.flush();
+        if (!s.buf_dirty) {
+            s.buf_pos = s.position;
+            s.buf_len = 0;
+        }
+        if (s.buf_len + size > s.buf.size()) {
+            if (!s.flush()) return 0;
+            s.buf_pos = s.position;
+            if (size >= s.buf.size()) {
+                size_t done = 0;
+                while (done < size) {
+                    stub_counters::fsSyscall(s.rel);
+                    ssize_t n = pwrite(s.fd, in + done, size - done,
+                                       s.position + done);
+                    if (n <= 0) break;
+                    done += n;
+                }
+                s.position += done;
+                if (s.position > s.size) s.size = s.position;
+                return done;
+            }
+        }
+        memcpy(s.buf.data() + s.buf_len, in, size);
+        s.buf_len += size;
+        s.buf_dirty = true;
+        s.position += size;
+        if (s.position > s.size) s.size = s.position;
+        return size;
+    }
+
+    size_t File::read(uint8_t* buf, size_t size) {
+        FileSlot* s = slot();
+        if (!s || s->is_directory || !s->readable) return 0;
+        stub_trace::Scope trace(stub_trace::kFsRead, s->rel);
+        size_t n;
+        if (s->inMemory()) {
+            n = memRead(*s, buf, size);
+        } else {
+            if (!ensureOpen(*s)) return 0;
+            n = diskRead(*s, buf, size);
+        }
+        stub_counters::fsRead(s->rel, n);
+        trace.arg0(n);
+        return n;
+    }
+
+    size_t File::inputView(const uint8_t*& data) {
+        FileSlot* s = slot();
+        if (!s || s->is_directory || !s->readable) return 0;
+        if (s->inMemory()) {
+            const std::vector<uint8_t>& content = s->content();
+            if (s->position >= content.size()) return 0;
+            data = content.data() + s->position;
+            return content.size() - s->position;
+        }
+        if (!ensureOpen(*s) || s->position >= s->size) return 0;
+        if (s->buf_dirty || s->position < s->buf_pos ||
+            s->position >= s->buf_pos + s->buf_len) {
+            s->flush();
+            stub_counters::fsSyscall(s->rel);
+            ssize_t n = pread(s->fd, s->buf.data(), s->buf.size(), s->position);
+            if (n <= 0) return 0;
+            s->buf_pos = s->position;
+            s->buf_len = n;
+        }
+        data = s->buf.data() + (s->position - s->buf_pos);
+        return s->buf_pos + s->buf_len - s->position;
+    }
+
+    void File::consumeInput(size_t n) {
+        FileSlot* s = slot();
+        if (!s) return;
+        s->position += n;
+        stub_counters::fsRead(s->rel, n);
+    }
+
+    size_t File::write(const uint8_t* buf, size_t size) {
+        FileSlot* s = slot();
+        if (!s || s->is_directory || !s->writable) return 0;
+        stub_trace::Scope trace(stub_trace::kFsWrite, s->rel);
+        size_t n = s->inMemory() ? memWrite(*s, buf, size)
+                                 : diskWrite(*s, buf, size);
+        stub_counters::fsWrite(s->rel, n);
+        trace.arg0(n);
+        if (stub_replay::mode() != stub_replay::kOff) {
+            stub_replay::fsOp(stub_replay::kFsWrite, s->rel, n, stub_replay::hash(buf, n));
+        }
+        return n;
+    }
+
+    bool File::seek(uint32_t pos, SeekMode mode) {
+        FileSlot* s = slot();
+        if (!s || s->is_directory) return false;
+        size_t base;
+        switch (mode) {
+            case SeekSet: base = 0; break;
+            case SeekCur: base = s->position; break;
+            case SeekEnd: base = sizeOf(*s); break;
+            default: return false;
+        }
+        s->position = base + pos;
+        return true;
+    }
+
+    File File::openNextFile(const char* mode) {
+        FileSlot* s = slot();
+        if (!s || !s->is_directory) return File();
+        const char* name;
+        bool is_dir;
+        if (!nextEntry(*s, name, is_dir)) return File();
+
+        if (s->inMemory()) {
+            std::string child;
+            appendChild(child, s->rel, name);
+            stub_counters::fsOpen(child);
+            return openMemory(*table_, s->volume, child, is_dir, mode);
+        }
+        if (!is_dir && strpbrk(mode, "wa+")) {
+            std::string full_path, child;
+            appendChild(full_path, s->path, name);
+            appendChild(child, s->rel, name);
+            stub_counters::fsOpen(child);
+            return openHost(*table_, full_path, child, mode);
+        }
+
+        int index = table_->acquire(is_dir);
+        if (index < 0) return File();
+        FileSlot& entry = table_->at(index);
+        appendChild(entry.path, s->path, name);
+        entry.name_pos = entry.path.size() - strlen(name);
+        appendChild(entry.rel, s->rel, name);
+        stub_counters::fsOpen(entry.rel);
+        if (!is_dir) {
+            entry.readable = true;
+            entry.open_pending = true;
+            entry.size_pending = true;
+        }
+        return File(table_, index);
+    }
+
+    String File::getNextFileName(bool* isDir) {
+        FileSlot* s = slot();
+        if (!s || !s->is_directory) return String();
+        const char* name;
+        bool is_dir;
+        if (!nextEntry(*s, name, is_dir)) return String();
+        if (isDir) *isDir = is_dir;
+        String result("/");
+        if (!s->rel.empty()) {
+            result += s->rel.c_str();
+            result += '/';
+        }
+        result += name;
+        return result;
+    }
+
+    void File::rewindDirectory() {
+        FileSlot* s = slot();
+        if (!s) return;
+        s->listed = false;
+        if (s->dir) {
+            rewinddir(s->dir);
+        }
+    }
+
+    void File::debugInfo(const char* prefix) const {
+        FileSlot* s = slot();
+        std::cout << prefix << "=== File Debug Info ===" << std::endl;
+        if (!s) {
+            std::cout << prefix << "Handle: INVALID" << std::endl;
+            std::cout << prefix << "=========================" << std::endl;
+            return;
+        }
+        std::cout << prefix << "Handle: slot " << index_ << ", generation "
+                  << generation_ << ", refs " << s->refs << std::endl;
+        std::cout << prefix << "Path: '" << s->path << "'" << std::endl;
+        std::cout << prefix << "Name: '" << s->name() << "'" << std::endl;
+        std::cout << prefix << "Mode: " << (s->readable ? "r" : "")
+                  << (s->writable ? "w" : "") << (s->append ? "a" : "")
+                  << std::endl;
+        std::cout << prefix << "Is directory: " << (s->is_directory ? "YES" : "NO") << std::endl;
+        std::cout << prefix << "Size: " << sizeOf(*s) << " bytes" << std::endl;
+        std::cout << prefix << "Position: " << s->position << std::endl;
+
+        if (s->inMemory()) {
+            std::cout << prefix << "Volume: memory, dirty: "
+                      << (s->mem_dirty ? "YES" : "NO") << std::endl;
+        } else if (s->is_directory) {
+            std::cout << prefix << "Directory pointer: "
+                      << (s->dir ? "VALID" : "NULL") << std::endl;
+        } else {
+            std::cout << prefix << "Descriptor: " << s->fd
+                      << (s->open_pending ? " (opens on first read)" : "")
+                      << ", buffered: " << s->buf_len << " bytes"
+                      << (s->buf_dirty ? " (dirty)" : "") << std::endl;
+        }
+
+        // Проверка доступности файла на диске (еще раз для уверенности)
+        struct stat st;
+        if (s->inMemory()) {
+            // Файл тома в памяти на диске не ищем
+        } else if (stat(s->path.c_str(), &st) == 0) {
+            std::cout << prefix << "Disk info - ";
+            if (S_ISDIR(st.st_mode)) {
+                std::cout << "Is a directory";
+            } else if (S_ISREG(st.st_mode)) {
+                std::cout << "Is a regular file, size: " << st.st_size << " bytes";
+                std::cout << ", permissions: " << std::oct << (st.st_mode & 0777) << std::dec;
+            } else {
+                std::cout << "Is a special file";
+            }
+            std::cout << std::endl;
+        } else {
+            std::cout << prefix << "Disk info - File not found on disk (errno: " << errno << ")" << std::endl;
+        }
+
+        std::cout << prefix << "Operator bool(): " << (operator bool() ? "TRUE" : "FALSE") << std::endl;
+        std::cout << prefix << "Available(): " << remaining() << std::endl;
+        std::cout << prefix << "=========================" << std::endl;
+    }
+
+    void File::debugShort() const {
+        FileSlot* s = slot();
+        std::cout << "File['" << name() << "']";
+        std::cout << " path:'" << fullName() << "'";
+        std::cout << " slot:" << index_;
+        std::cout << " open:" << (s ? "Y" : "N");
+        std::cout << " dir:" << (isDirectory() ? "Y" : "N");
+        std::cout << " size:" << size();
+        std::cout << " pos:" << position();
+        std::cout << std::endl;
+    }
+
+    bool LittleFSClass::sys_mkdir(const char *path, mode_t mode) {
+      stub_counters::fsVolumeSyscall();
+      return ::mkdir(path, mode) == 0 || errno == EEXIST;
+    }
+
+    bool LittleFSClass::sys_rmdir(const char *path) {
+      stub_counters::fsVolumeSyscall();
+      return ::rmdir(path) == 0;
+    }
+
+    bool LittleFSClass::createDirRecursive(const std::string &path) {
+      if (path.empty() || path == "/") {
+        return true;
+      }
+
+      std::string current;
+
+      for (size_t i = 0; i <= path.length(); i++) {
+        // Если нашли слеш или конец строки
+        if (i == path.length() || path[i] == '/') {
+          if (!current.empty()) {
+            struct stat st;
+            stub_counters::fsVolumeSyscall();
+            if (stat(current.c_str(), &st) != 0) {
+              // Директории нет, создаем
+              stub_counters::fsVolumeSyscall();
+              int result = ::mkdir(current.c_str(), 0755);
+              if (result != 0 && errno != EEXIST) {
+                std::cerr << "[ERROR]     FAILED to create '" << current
+                          << "': " << strerror(errno) << " (errno=" << errno
+                          << ")" << std::endl;
+                return false;
+              }
+            } else if (!S_ISDIR(st.st_mode)) {
+              std::cerr << "[ERROR]     EXISTS BUT NOT A DIRECTORY"
+                        << std::endl;
+              std::cerr << "[ERROR]     st_mode: " << std::oct << st.st_mode
+                        << std::dec << std::endl;
+              return false;
+            }
+          }
+
+          // Добавляем слеш для следующей части
+          if (i < path.length() && path[i] == '/') {
+            current += "/";
+          }
+        } else {
+          current += path[i];
+        }
+      }
+
+      // Проверяем финальный результат
+      struct stat final_st;
+      stub_counters::fsVolumeSyscall();
+      if (stat(path.c_str(), &final_st) == 0 && S_ISDIR(final_st.st_mode)) {
+        return true;
+      } else {
+        std::cerr << "[ERROR] FAILED: Directory '" << path
+                  << "' not created properly" << std::endl;
+        return false;
+      }
+    }
+
+    bool LittleFSClass::removeRecursive(const std::string &path) {
+      // Сначала проверяем, это файл или директория
+      struct stat st;
+      stub_counters::fsVolumeSyscall();
+      if (stat(path.c_str(), &st) != 0) {
+        return false;
+      }
+
+      if (!S_ISDIR(st.st_mode)) {
+        // Это файл - просто удаляем
+        stub_counters::fsVolumeSyscall();
+        return unlink(path.c_str()) == 0;
+      }
+
+      // Это директория - удаляем рекурсивно
+      stub_counters::fsVolumeSyscall();
+      DIR *dir = opendir(path.c_str());
+      if (!dir) {
+        return false;
+      }
+
+      struct dirent *entry;
+      while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 ||
+            strcmp(entry->d_name, "..") == 0) {
+          continue;
+        }
+
+        std::string full_path = path + "/" + entry->d_name;
+
+        stub_counters::fsVolumeSyscall();
+        if (stat(full_path.c_str(), &st) == 0) {
+          if (S_ISDIR(st.st_mode)) {
+            removeRecursive(full_path);
+          } else {
+            stub_counters::fsVolumeSyscall();
+            unlink(full_path.c_str());
+          }
+        }
+      }
+
+      closedir(dir);
+      return sys_rmdir(path.c_str());
+    }
+
+    bool LittleFSClass::pathExists(const std::string &path) {
+      struct stat st;
+      stub_counters::fsVolumeSyscall();
+      return stat(path.c_str(), &st) == 0;
+    }
+
+    void LittleFSClass::noteChange(const PathEntry &entry) {
+      if (!disk_mirror_) return;
+      std::string rel = entry.rel;
+      size_t pos = rel.find('/');
+      while (pos != std::string::npos) {
+        if (!pathExists(hostPath(rel.substr(0, pos)))) {
+          rel.erase(pos);
+          break;
+        }
+        pos = rel.find('/', pos + 1);
+      }
+      journal_.push_back(rel);
+    }
+
+    void LittleFSClass::collapsePaths(std::vector<std::string> &paths) {
+      std::set<std::string> unique(paths.begin(), paths.end());
+      paths.clear();
+      if (unique.count(std::string())) {
+        paths.push_back(std::string());
+        return;
+      }
+      for (std::set<std::string>::const_iterator it = unique.begin();
+           it != unique.end(); ++it) {
+        bool covered = false;
+        for (size_t pos = it->find('/'); pos != std::string::npos && !covered;
+             pos = it->find('/', pos + 1)) {
+          covered = unique.count(it->substr(0, pos)) > 0;
+        }
+        if (!covered) paths.push_back(*it);
+      }
+    }
+
+    bool LittleFSClass::begin(bool formatOnFail, const char *basePath,
+                              uint8_t maxOpenFiles, const char *partitionLabel) {
+      (void)partitionLabel;
+      (void)formatOnFail;
+      mem_.reset();
+      resetSnapshots();
+
+      if (partition_) {
+        files_.configure(maxOpenFiles);
+        stub_trace::Scope trace(stub_trace::kFsBegin, "partition");
+        trace.arg0(maxOpenFiles);
+        mem_ = partition_;
+        mounted_ = true;
+        trace.arg1(1);
+        return true;
+      }
+
+      // Всегда используем /tmp для тестов
+      //   base_path_ = "/tmp/littlefs_test_" + std::to_string(getpid());
+      //   base_path_ = "/tmp/littlefs_test";
+      if (basePath && strlen(basePath) > 0) {
+        base_path_ = basePath;
+      }
+      paths_.reset(base_path_);
+      files_.configure(maxOpenFiles);
+
+      stub_trace::Scope trace(stub_trace::kFsBegin, base_path_);
+      trace.arg0(maxOpenFiles);
+
+      // Создаем базовую директорию рекурсивно
+      if (!createDirRecursive(base_path_)) {
+        std::cerr << "Failed to create base directory: " << base_path_
+                  << std::endl;
+
+        if (formatOnFail) {
+          bool ok = format();
+          trace.arg1(ok);
+          return ok;
+        }
+        return false;
+      }
+
+      mounted_ = true;
+      trace.arg1(1);
+      return true;
+    }
+
+    void LittleFSClass::end() {
+        stub_trace::instant(stub_trace::kFsEnd);
+        files_.closeAll();
+        mounted_ = false;
+    }
+
+    bool LittleFSClass::mountImage(const char *imagePath) {
+      FILE *f = fopen(imagePath, "rb");
+      if (!f) {
+        std::cerr << "[ERROR] Failed to open image: " << imagePath
+                  << std::endl;
+        return false;
+      }
+      struct stat st;
+      std::shared_ptr<std::vector<uint8_t> > bytes(new std::vector<uint8_t>());
+      if (fstat(fileno(f), &st) == 0 && st.st_size > 0) {
+        bytes->resize(st.st_size);
+        if (fread(bytes->data(), 1, bytes->size(), f) != bytes->size()) {
+          bytes->clear();
+        }
+      }
+      fclose(f);
+      return mountImage(bytes);
+    }
+
+    bool LittleFSClass::mountImage(const MemoryVolume::Data &image) {
+      stub_trace::Scope trace(stub_trace::kFsMountImage);
+      trace.arg0(image ? image->size() : 0);
+      std::shared_ptr<MemoryVolume> volume(new MemoryVolume());
+      std::string error;
+      if (!volume->load(image, &error)) {
+        std::cerr << "[ERROR] Failed to mount LittleFS image: " << error
+                  << std::endl;
+        return false;
+      }
+      mem_ = volume;
+      mounted_ = true;
+      resetSnapshots();
+      trace.arg1(1);
+      return true;
+    }
+
+    bool LittleFSClass::setPartition(const MemoryVolume::Data &image) {
+      std::shared_ptr<MemoryVolume> volume(new MemoryVolume());
+      if (image) {
+        std::string error;
+        if (!volume->load(image, &error)) {
+          std::cerr << "[ERROR] Failed to load LittleFS partition: " << error
+                    << std::endl;
+          return false;
+        }
+      }
+      partition_ = volume;
+      return true;
+    }
+
+    bool LittleFSClass::exportImage(std::vector<uint8_t> &out,
+                                    const LittleFSGeometry &geometry) {
+      std::string error;
+      bool ok;
+      if (mem_) {
+        ok = mem_->exportImage(geometry, out, &error);
+      } else {
+        MemoryVolume volume;
+        ok = volume.loadDirectory(base_path_, geometry) &&
+             volume.exportImage(geometry, out, &error);
+      }
+      if (!ok) {
+        std::cerr << "[ERROR] Failed to build LittleFS image: " << error
+                  << std::endl;
+      }
+      return ok;
+    }
+
+    bool LittleFSClass::saveImage(const char *imagePath,
+                                  const LittleFSGeometry &geometry) {
+      std::vector<uint8_t> image;
+      if (!exportImage(image, geometry)) return false;
+      FILE *f = fopen(imagePath, "wb");
+      if (!f) return false;
+      bool ok = fwrite(image.data(), 1, image.size(), f) == image.size();
+      return fclose(f) == 0 && ok;
+    }
+
+    int LittleFSClass::snapshot() {
+      // Снимок видит и то, что ещё лежит в буферах открытых файлов
+      files_.flushAll();
+      if (mem_) return mem_->snapshot();
+      if (!mounted_) return -1;
+      if (!disk_mirror_) {
+        disk_mirror_.reset(new MemoryVolume());
+        if (!disk_mirror_->loadDirectory(base_path_, LittleFSGeometry())) {
+          disk_mirror_.reset();
+          return -1;
+        }
+        journal_.clear();
+        mirror_pos_ = 0;
+      } else {
+        std::vector<std::string> changed(journal_.begin() + mirror_pos_,
+                                         journal_.end());
+        collapsePaths(changed);
+        for (size_t i = 0; i < changed.size(); i++) {
+          disk_mirror_->importHostPath(hostPath(changed[i]), changed[i]);
+        }
+        mirror_pos_ = journal_.size();
+      }
+      int id = disk_mirror_->snapshot();
+      snapshot_pos_[id] = journal_.size();
+      // Записи через уже открытые файлы тоже попадут в журнал
+      files_.setJournal(&journal_);
+      return id;
+    }
+
+    bool LittleFSClass::restore(int id) {
+      // Открытые файлы закрываются: их содержимое и позиции относятся к
+      // состоянию до отката
+      files_.closeAll();
+      if (mem_) return mem_->restore(id);
+      std::map<int, size_t>::iterator snap = snapshot_pos_.find(id);
+      if (!disk_mirror_ || snap == snapshot_pos_.end()) return false;
+
+      std::vector<std::string> changed(journal_.begin() + snap->second,
+                                       journal_.end());
+      collapsePaths(changed);
+      disk_mirror_->restore(id);
+      bool ok = true;
+      for (size_t i = 0; i < changed.size(); i++) {
+        std::string host = hostPath(changed[i]);
+        if (pathExists(host)) removeRecursive(host);
+        size_t pos = host.find_last_of('/');
+        if (pos != std::string::npos && pos > 0) {
+          createDirRecursive(host.substr(0, pos));
+        }
+        ok = disk_mirror_->exportHostPath(changed[i], host) && ok;
+        // Откат — тоже изменение с точки зрения остальных снимков
+        journal_.push_back(changed[i]);
+      }
+      mirror_pos_ = journal_.size();
+      snap->second = journal_.size();
+      files_.setJournal(&journal_);
+      return ok;
+    }
+
+    void LittleFSClass::dropSnapshot(int id) {
+      if (mem_) {
+        mem_->dropSnapshot(id);
+      } else if (disk_mirror_) {
+        disk_mirror_->dropSnapshot(id);
+        snapshot_pos_.erase(id);
+      }
+    }
+
+    bool LittleFSClass::format() {
+      bool ok = formatVolume();
+      stub_replay::fsOp(stub_replay::kFsFormat, "/", ok);
+      return ok;
+    }
+
+    File LittleFSClass::open(const char *path, const char *mode) {
+      stub_trace::Scope trace(stub_trace::kFsOpen, path);
+      File file = openPath(path, mode);
+      bool create = strchr(mode, 'w') || strchr(mode, 'a');
+      if (trace.active()) {
+        trace.arg0(create);
+        trace.arg1(static_cast<bool>(file));
+      }
+      stub_replay::fsOp(stub_replay::kFsOpen, path, (create ? 2 : 0) | (file ? 1 : 0));
+      return file;
+    }
+
+    bool LittleFSClass::exists(const char* path) {
+        if (!mounted_) return false;
+        const PathEntry &entry = paths_.resolve(path);
+        if (mem_) return mem_->type(entry.rel) != MemoryVolume::NodeNone;
+        struct stat st;
+        stub_counters::fsSyscall(entry.rel);
+        return stat(entry.host.c_str(), &st) == 0;
+    }
+
+    bool LittleFSClass::remove(const char* path) {
+        stub_trace::Scope trace(stub_trace::kFsRemove, path);
+        bool ok = removePath(path);
+        trace.arg1(ok);
+        stub_replay::fsOp(stub_replay::kFsRemove, path, ok);
+        return ok;
+    }
+
+    bool LittleFSClass::rename(const char* pathFrom, const char* pathTo) {
+        stub_trace::Scope trace(stub_trace::kFsRename, pathFrom);
+        bool ok = renamePath(pathFrom, pathTo);
+        trace.arg1(ok);
+        if (stub_replay::mode() != stub_replay::kOff) {
+            stub_replay::fsOp(stub_replay::kFsRename, std::string(pathFrom) + " " + pathTo, ok);
+        }
+        return ok;
+    }
+
+    bool LittleFSClass::mkdir(const char* path) {
+        stub_trace::Scope trace(stub_trace::kFsMkdir, path);
+        bool ok = mkdirPath(path);
+        trace.arg1(ok);
+        stub_replay::fsOp(stub_replay::kFsMkdir, path, ok);
+        return ok;
+    }
+
+    size_t LittleFSClass::totalBytes() {
+        if (!mounted_) return 0;
+        if (mem_) {
+            return (size_t)mem_->geometry().block_size *
+                   mem_->geometry().block_count;
+        }
+
+        size_t total = 0;
+        calculateDirSize(base_path_, total);
+        return total;
+    }
+
+    size_t LittleFSClass::freeBytes() {
+        if (mem_) {
+            size_t total = totalBytes();
+            size_t used = usedBytes();
+            return total > used ? total - used : 0;
+        }
+        // Эмулируем 1MB свободного места
+        size_t used = usedBytes();
+        return (1024 * 1024 > used) ? (1024 * 1024 - used) : 0;
+    }
+
+    void LittleFSClass::clearAll() {
+        if (mem_) {
+            mem_->format();
+            return;
+        }
+        noteChange(paths_.resolve("/"));
+        if (pathExists(base_path_)) {
+            removeRecursive(base_path_);
+            sys_mkdir(base_path_.c_str(), 0755);
+        }
+    }
+
+    std::vector<std::string> LittleFSClass::listFiles() {
+        std::vector<std::string> files;
+        if (!mounted_) return files;
+        if (mem_) {
+            mem_->listRecursive(files);
+            return files;
+        }
+
+        listFilesRecursive(base_path_, base_path_, files);
+        return files;
+    }
+
+    bool LittleFSClass::formatVolume() {
+      stub_trace::Scope trace(stub_trace::kFsFormat);
+      if (mem_) {
+        mem_->format();
+        mounted_ = true;
+        trace.arg1(1);
+        return true;
+      }
+      noteChange(paths_.resolve("/"));
+
+      // Удаляем все файлы в директории
+      if (pathExists(base_path_)) {
+        if (!removeRecursive(base_path_)) {
+          return false;
+        }
+      }
+
+      // Создаем заново
+      if (!sys_mkdir(base_path_.c_str(), 0755)) {
+        return false;
+      }
+
+      mounted_ = true;
+      trace.arg1(1);
+      return true;
+    }
+
+    File LittleFSClass::openPath(const char *path, const char *mode) {
+      if (!mounted_) {
+        return File();
+      }
+
+      const PathEntry &entry = paths_.resolve(path);
+      bool create = strchr(mode, 'w') || strchr(mode, 'a');
+      stub_counters::fsOpen(entry.rel);
+
+      if (mem_) {
+        MemoryVolume::NodeType type = mem_->type(entry.rel);
+        // Лимит проверяется до создания файла, как в esp_littlefs
+        if (type != MemoryVolume::NodeDir && files_.full()) {
+          return File();
+        }
+        if (create) {
+          if (type == MemoryVolume::NodeDir) return File();
+          if ((strchr(mode, 'w') || type == MemoryVolume::NodeNone) &&
+              !mem_->writeFile(entry.rel, MemoryVolume::Data())) {
+            return File();
+          }
+        } else if (type == MemoryVolume::NodeNone) {
+          return File();
+        }
+        return File::openMemory(files_, mem_, entry.rel,
+                                type == MemoryVolume::NodeDir, mode);
+      }
+
+      if (files_.full()) {
+        struct stat st;
+        stub_counters::fsSyscall(entry.rel);
+        if (stat(entry.host.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+          return File();
+        }
+      }
+
+      // Любой режим записи, включая "r+", меняет файл
+      if (strpbrk(mode, "wa+") && !entry.isRoot()) noteChange(entry);
+      // Создаем директории если нужно (для режима записи)
+      if (create && !entry.isRoot()) {
+        if (!createDirRecursive(entry.host_dir)) {
+          std::cerr << "[ERROR] Failed to create directory path"
+                    << std::endl;
+          return File();
+        }
+      }
+      return File::openHost(files_, entry.host, entry.rel, mode);
+    }
+
+    bool LittleFSClass::removePath(const char* path) {
+        if (!mounted_) return false;
+        const PathEntry &entry = paths_.resolve(path);
+        // Корень тома удалить нельзя, как и на устройстве
+        if (entry.isRoot()) return false;
+        if (mem_) return mem_->remove(entry.rel);
+        noteChange(entry);
+
+        if (pathExists(entry.host)) {
+            return removeRecursive(entry.host);
+        }
+        return false;
+    }
+
+    bool LittleFSClass::renamePath(const char* pathFrom, const char* pathTo) {
+        if (!mounted_) return false;
+        const PathEntry &from = paths_.resolve(pathFrom);
+        const PathEntry &to = paths_.resolve(pathTo);
+        if (from.isRoot() || to.isRoot()) return false;
+        if (mem_) return mem_->rename(from.rel, to.rel);
+
+        if (pathExists(from.host)) {
+            noteChange(from);
+            noteChange(to);
+            // Создаем директории для пути назначения
+            createDirRecursive(to.host_dir);
+
+            // Переименовываем
+            stub_counters::fsSyscall(from.rel);
+            return ::rename(from.host.c_str(), to.host.c_str()) == 0;
+        }
+        return false;
+    }
+
+    bool LittleFSClass::mkdirPath(const char* path) {
+        if (!mounted_) return false;
+        const PathEntry &entry = paths_.resolve(path);
+        if (mem_) return mem_->mkdir(entry.rel);
+        noteChange(entry);
+        return createDirRecursive(entry.host);
+    }
+
+    void LittleFSClass::calculateDirSize(const std::string& path, size_t& total) {
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return;
+
+        struct dirent* entry;
+        struct stat st;
+
+        while ((entry = readdir(dir)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+
+            std::string full_path = path + "/" + entry->d_name;
+
+            if (stat(full_path.c_str(), &st) == 0) {
+                if (S_ISDIR(st.st_mode)) {
+                    calculateDirSize(full_path, total);
+                } else {
+                    total += st.st_size;
+                }
+            }
+        }
+
+        closedir(dir);
+    }
+
+    void LittleFSClass::listFilesRecursive(const std::string& base,
+                                           const std::string& path,
+                                           std::vector<std::string>& files) {
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return;
+
+        struct dirent* entry;
+
+        while ((entry = readdir(dir)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+
+            std::string full_path = path + "/" + entry->d_name;
+            std::string relative_path = full_path.substr(base.length());
+
+            files.push_back(relative_path);
+
+            // Проверяем, является ли это директорией
+            struct stat st;
+            if (stat(full_path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                listFilesRecursive(base, full_path, files);
+            }
+        }
+
+        closedir(dir);
+    }
+
+} // namespace fs
@@ -1,21 +1,23 @@
 #ifndef LITTLEFS_STUB_H
 #define LITTLEFS_STUB_H
 
-// #define LITTLEFS_STUB_DEBUG // Включить отладочные сообщения
+// Объявления File и LittleFSClass; реализация в littlefs_stub.cpp
+// (собирается в libarduinostub.a)
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
 #include <string>
-#include <fstream>
+#include <sys/types.h>
+#include <utility>
 #include <vector>
-#include <memory>
-#include <chrono>
-#include <cstring>
-#include <cstdarg>
-#include <cstdio>
-#include <sys/stat.h>
-#include <dirent.h>
-#include <unistd.h>
-#include <algorithm>
 #include "arduino_compat.h"
+#include "arduino_stream_stub.h"
+#include "littlefs_handles.h"
+#include "littlefs_paths.h"
+#include "littlefs_volume.h"
 
 namespace fs {
     enum SeekMode {
@@ -24,784 +26,275 @@ namespace fs {
         SeekEnd = 2
     };
 
-    class File {
+    class LittleFSClass;
+
+    class File : public Stream {
     private:
-        std::fstream file_;
-        std::string path_;
-        std::string name_;
-        std::string mode_;
-        bool is_directory_;
-        size_t position_;
-        size_t size_;
-        bool exists_;
-        DIR* dir_ptr_;
-        
-        // Вспомогательные функции для работы с файлами
-
-        static bool checkExists(const std::string &path) {
-          struct stat st;
-          int result = stat(path.c_str(), &st);
-#ifdef LITTLEFS_STUB_DEBUG
-        std::cout << "[DEBUG] Call checkExists() of path: '" << path << "'"
-                  << std::endl;
-          std::cout << "[DEBUG] stat('" << path << "') returned " << result;
-          if (result == 0) {
-            std::cout << ", file exists" << std::endl;
-          } else {
-            std::cout << ", error: " << strerror(errno) << " (errno=" << errno
-                      << ")" << std::endl;
-          }
-#endif
-          return result == 0;
+        // File — ссылка на слот в таблице открытых файлов LittleFSClass.
+        // Копии File ссылаются на один и тот же открытый файл, как в ESP32;
+        // слот освобождается при close() или уничтожении последней копии.
+        FileTable* table_;
+        int index_;
+        uint32_t generation_;
+
+        File(FileTable* table, int index)
+            : table_(table), index_(index),
+              generation_(table->at(index).generation) {}
+
+        FileSlot* slot() const {
+            return table_ ? table_->get(index_, generation_) : nullptr;
         }
 
-        // static bool checkExists(const std::string& path) {
-        //     struct stat st;
-        //     return stat(path.c_str(), &st) == 0;
-        // }
-        
-        static bool isDir(const std::string& path) {
-            struct stat st;
-            if (stat(path.c_str(), &st) == 0) {
-                return S_ISDIR(st.st_mode);
-            }
-            return false;
+        // Отпускает ссылку на слот
+        void release();
+
+        // Режим открытия в духе fopen: "r", "w", "a" и варианты с '+'
+        static void applyMode(FileSlot& s, const char* mode) {
+            bool plus = strchr(mode, '+') != nullptr;
+            s.append = strchr(mode, 'a') != nullptr;
+            s.writable = plus || s.append || strchr(mode, 'w') != nullptr;
+            s.readable = plus || strchr(mode, 'r') != nullptr;
         }
-        
-        static size_t getFileSize(const std::string& path) {
-            struct stat st;
-            if (stat(path.c_str(), &st) == 0) {
-                return st.st_size;
-            }
-            return 0;
+
+        // Открытие файла или каталога на диске
+        static File openHost(FileTable& table, const std::string& host,
+                             const std::string& relPath, const char* mode);
+
+        // Открытие файла или каталога на томе в памяти. Существование и
+        // создание проверяет LittleFSClass::open.
+        static File openMemory(FileTable& table,
+                               const std::shared_ptr<MemoryVolume>& volume,
+                               const std::string& relPath, bool is_dir,
+                               const char* mode);
+
+        static void appendChild(std::string& out, const std::string& parent,
+                                const char* name) {
+            out.assign(parent);
+            if (!out.empty() && out[out.size() - 1] != '/') out += '/';
+            out += name;
         }
 
-        void initFile() {
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] initFile called with path: '" << path_
-                    << "', mode: '" << mode_ << "'" << std::endl;
-#endif
-          // Извлекаем имя файла
-          size_t pos = path_.find_last_of('/');
-          if (pos != std::string::npos) {
-            name_ = path_.substr(pos + 1);
-          } else {
-            name_ = path_;
-          }
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] File name extracted: '" << name_ << "'"
-                    << std::endl;
-#endif
-          // Проверяем существование
-          exists_ = checkExists(path_);
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] checkExists('" << path_
-                    << "') = " << (exists_ ? "true" : "false") << std::endl;
-#endif
-
-          if (exists_) {
-            is_directory_ = isDir(path_);
-#ifdef LITTLEFS_STUB_DEBUG
-            std::cout << "[DEBUG] isDir('" << path_
-                      << "') = " << (is_directory_ ? "true" : "false")
-                      << std::endl;
-#endif
-
-            if (!is_directory_) {
-              size_ = getFileSize(path_);
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "[DEBUG] File size: " << size_ << " bytes"
-                        << std::endl;
-#endif
-            }
-          } else {
-            is_directory_ = false;
-#ifdef LITTLEFS_STUB_DEBUG
-            std::cout
-                << "[DEBUG] File doesn't exist, setting is_directory_ = false"
-                << std::endl;
-#endif
-          }
-
-          // Для файлов (не директорий) открываем поток
-          if (!is_directory_) {
-            std::ios_base::openmode openmode = std::ios::binary;
-            if (mode_.find('r') != std::string::npos)
-              openmode |= std::ios::in;
-            if (mode_.find('w') != std::string::npos)
-              openmode |= std::ios::out | std::ios::trunc;
-            if (mode_.find('a') != std::string::npos)
-              openmode |= std::ios::out | std::ios::app;
-
-#ifdef LITTLEFS_STUB_DEBUG
-            std::cout << "[DEBUG] Opening file with mode: ";
-            if (openmode & std::ios::in)
-              std::cout << "in ";
-            if (openmode & std::ios::out)
-              std::cout << "out ";
-            if (openmode & std::ios::app)
-              std::cout << "app ";
-            if (openmode & std::ios::trunc)
-              std::cout << "trunc ";
-            if (openmode & std::ios::binary)
-              std::cout << "binary";
-            std::cout << std::endl;
-            std::cout << "[DEBUG] Opening file: '" << path_ << "'" << std::endl;
-#endif
-            file_.open(path_, openmode);
-
-            if (file_.is_open()) {
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "[DEBUG] File opened successfully" << std::endl;
-#endif
-              position_ = 0;
+        // Имя и тип следующей записи каталога. Тип берётся из d_type, stat()
+        // нужен только файловым системам, которые его не заполняют.
+        static bool nextEntry(FileSlot& s, const char*& name, bool& is_dir);
+
+        // Файл из openNextFile() открывается при первом чтении
+        static bool ensureOpen(FileSlot& s);
+
+        static size_t sizeOf(FileSlot& s);
+
+        static size_t memRead(FileSlot& s, uint8_t* buf, size_t size);
+
+        static size_t memWrite(FileSlot& s, const uint8_t* buf, size_t size);
+
+        // Чтение с диска через буфер слота
+        static size_t diskRead(FileSlot& s, uint8_t* out, size_t size);
+
+        // Запись на диск: последовательные записи копятся в буфере слота
+        static size_t diskWrite(FileSlot& s, const uint8_t* in, size_t size);
+
+        friend class LittleFSClass;
+
+      public:
+        File() : table_(nullptr), index_(-1), generation_(0) {}
+
+        File(const File& other)
+            : Stream(other), table_(other.table_), index_(other.index_),
+              generation_(other.generation_) {
+            FileSlot* s = slot();
+            if (s) {
+                s->refs++;
             } else {
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "[DEBUG] FAILED to open file!" << std::endl;
-              std::cout << "[DEBUG] Error state: ";
-              std::cout << "good:" << file_.good() << " ";
-              std::cout << "eof:" << file_.eof() << " ";
-              std::cout << "fail:" << file_.fail() << " ";
-              std::cout << "bad:" << file_.bad() << std::endl;
-
-              // Проверяем почему не открылся
-              struct stat st;
-              if (stat(path_.c_str(), &st) != 0) {
-                std::cout << "[DEBUG] stat() failed: " << strerror(errno)
-                          << std::endl;
-              } else {
-                std::cout << "[DEBUG] stat() succeeded, mode: " << std::oct
-                          << st.st_mode << std::dec << std::endl;
-                std::cout << "[DEBUG] Is regular file: " << S_ISREG(st.st_mode)
-                          << std::endl;
-                std::cout << "[DEBUG] Is directory: " << S_ISDIR(st.st_mode)
-                          << std::endl;
-                std::cout << "[DEBUG] Permissions: " << std::oct
-                          << (st.st_mode & 0777) << std::dec << std::endl;
-              }
-#endif
+                table_ = nullptr;
+                index_ = -1;
+                generation_ = 0;
             }
-          } else {
-#ifdef LITTLEFS_STUB_DEBUG
-            std::cout
-                << "[DEBUG] This is a directory, not opening as file stream"
-                << std::endl;
-#endif
-          }
         }
 
-      public:
-        File() : is_directory_(false), position_(0), size_(0), exists_(false), dir_ptr_(nullptr) {}
-        
-        File(const std::string& path, const std::string& mode = "r") 
-            : path_(path), mode_(mode), is_directory_(false), 
-              position_(0), size_(0), exists_(false), dir_ptr_(nullptr) {
-            initFile();
-        }
-        
-        // Конструктор перемещения
-        File(File&& other) noexcept 
-            : file_(std::move(other.file_)),
-              path_(std::move(other.path_)),
-              name_(std::move(other.name_)),
-              mode_(std::move(other.mode_)),
-              is_directory_(other.is_directory_),
-              position_(other.position_),
-              size_(other.size_),
-              exists_(other.exists_),
-              dir_ptr_(other.dir_ptr_) {
-            
-            other.is_directory_ = false;
-            other.position_ = 0;
-            other.size_ = 0;
-            other.exists_ = false;
-            other.dir_ptr_ = nullptr;
+        File(File&& other) noexcept
+            : Stream(other), table_(other.table_), index_(other.index_),
+              generation_(other.generation_) {
+            other.table_ = nullptr;
+            other.index_ = -1;
+            other.generation_ = 0;
         }
-        
-        // Оператор перемещения
-        File& operator=(File&& other) noexcept {
-            if (this != &other) {
-                close();
-                if (dir_ptr_) {
-                    closedir(dir_ptr_);
-                }
-                
-                file_ = std::move(other.file_);
-                path_ = std::move(other.path_);
-                name_ = std::move(other.name_);
-                mode_ = std::move(other.mode_);
-                is_directory_ = other.is_directory_;
-                position_ = other.position_;
-                size_ = other.size_;
-                exists_ = other.exists_;
-                dir_ptr_ = other.dir_ptr_;
-                
-                other.is_directory_ = false;
-                other.position_ = 0;
-                other.size_ = 0;
-                other.exists_ = false;
-                other.dir_ptr_ = nullptr;
-            }
+
+        // Копирование и перемещение через обмен
+        File& operator=(File other) {
+            std::swap(table_, other.table_);
+            std::swap(index_, other.index_);
+            std::swap(generation_, other.generation_);
+            setTimeout(other.getTimeout());
             return *this;
         }
-        
-        // Запретить копирование
-        File(const File&) = delete;
-        File& operator=(const File&) = delete;
-        
+
         ~File() {
-            close();
-            if (dir_ptr_) {
-                closedir(dir_ptr_);
-            }
+            release();
         }
         
         // Чтение
-        size_t read(uint8_t* buf, size_t size) {
-            if (!file_.is_open() || !file_.good()) return 0;
-            
-            file_.read(reinterpret_cast<char*>(buf), size);
-            size_t bytes_read = file_.gcount();
-            position_ += bytes_read;
-            return bytes_read;
-        }
+        size_t read(uint8_t* buf, size_t size);
         
-        int read() {
-            if (!file_.is_open() || !file_.good()) return -1;
-            
-            char c;
-            file_.get(c);
-            if (file_.good()) {
-                position_++;
-                return static_cast<uint8_t>(c);
-            }
-            return -1;
+        int read() override {
+            uint8_t c;
+            return read(&c, 1) == 1 ? c : -1;
         }
-        
-        // Запись
-        size_t write(const uint8_t* buf, size_t size) {
-            if (!file_.is_open() || !file_.good()) return 0;
-            
-            file_.write(reinterpret_cast<const char*>(buf), size);
-            position_ += size;
-            
-            // Обновляем размер файла если нужно
-            if (position_ > size_) {
-                size_ = position_;
-            }
-            
-            return size;
-        }
-        
-        size_t write(uint8_t c) {
-            return write(&c, 1);
-        }
-        
-        size_t write(const char* str) {
-            if (!str) return 0;
-            return write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+
+        int peek() override {
+            const uint8_t* data;
+            return inputView(data) > 0 ? data[0] : -1;
         }
         
-        size_t write(const char* str, size_t len) {
-            if (strlen(str) <= len) {
-                return write(str);
-            }
+        // Запись; print/println/printf — из Print
+        using Print::write;
 
-            char buffer[len + 1];
-            memcpy(buffer, str, len);
-            buffer[len] = '\0';
-            return write(buffer);
-        }
+        size_t write(const uint8_t* buf, size_t size) override;
 
         size_t write(const String& str) {
-            return write(str.c_str());
-        }
-        
-        // Печать
-        size_t print(const char* str) {
-            return write(str);
-        }
-        
-        size_t print(char c) {
-            return write(static_cast<uint8_t>(c));
-        }
-        
-        size_t print(int n, int base = DEC) {
-            return print(static_cast<long>(n), base);
-        }
-        
-        size_t print(unsigned int n, int base = DEC) {
-            return print(static_cast<unsigned long>(n), base);
-        }
-        
-        size_t print(long n, int base = DEC) {
-            std::string str;
-            if (base == DEC) {
-                str = std::to_string(n);
-            } else if (base == HEX) {
-                char buffer[20];
-                snprintf(buffer, sizeof(buffer), "%lx", n);
-                str = buffer;
-            } else if (base == OCT) {
-                char buffer[20];
-                snprintf(buffer, sizeof(buffer), "%lo", n);
-                str = buffer;
-            } else if (base == BIN) {
-                unsigned long un = (n < 0) ? -n : n;
-                for (int i = sizeof(n) * 8 - 1; i >= 0; i--) {
-                    str += (un & (1UL << i)) ? '1' : '0';
-                }
-                // Убираем ведущие нули
-                size_t pos = str.find_first_not_of('0');
-                if (pos != std::string::npos) {
-                    str = str.substr(pos);
-                } else {
-                    str = "0";
-                }
-            }
-            return print(str.c_str());
-        }
-        
-        size_t print(unsigned long n, int base = DEC) {
-            std::string str;
-            if (base == DEC) {
-                str = std::to_string(n);
-            } else if (base == HEX) {
-                char buffer[20];
-                snprintf(buffer, sizeof(buffer), "%lx", n);
-                str = buffer;
-            } else if (base == OCT) {
-                char buffer[20];
-                snprintf(buffer, sizeof(buffer), "%lo", n);
-                str = buffer;
-            }
-            return print(str.c_str());
-        }
-        
-        size_t print(double n, int digits = 2) {
-            char format[20];
-            snprintf(format, sizeof(format), "%%.%df", digits);
-            
-            char buffer[50];
-            snprintf(buffer, sizeof(buffer), format, n);
-            return print(buffer);
-        }
-        
-        size_t print(const String& str) {
-            return print(str.c_str());
-        }
-        
-        // Печать с новой строкой
-        size_t println(const char* str) {
-            size_t n = print(str);
-            n += println();
-            return n;
-        }
-        
-        size_t println(char c) {
-            size_t n = print(c);
-            n += println();
-            return n;
-        }
-        
-        size_t println(int n, int base = DEC) {
-            size_t cnt = print(n, base);
-            cnt += println();
-            return cnt;
-        }
-        
-        size_t println(unsigned int n, int base = DEC) {
-            size_t cnt = print(n, base);
-            cnt += println();
-            return cnt;
-        }
-        
-        size_t println(long n, int base = DEC) {
-            size_t cnt = print(n, base);
-            cnt += println();
-            return cnt;
-        }
-        
-        size_t println(unsigned long n, int base = DEC) {
-            size_t cnt = print(n, base);
-            cnt += println();
-            return cnt;
-        }
-        
-        size_t println(double n, int digits = 2) {
-            size_t cnt = print(n, digits);
-            cnt += println();
-            return cnt;
-        }
-        
-        size_t println(const String& str) {
-            size_t cnt = print(str);
-            cnt += println();
-            return cnt;
-        }
-        
-        size_t println() {
-            return print("\n");  // Исправлено: используем print вместо write
-        }
-        
-        // Форматированный вывод
-        size_t printf(const char* format, ...) {
-            va_list args;
-            va_start(args, format);
-            
-            // Определяем размер буфера
-            va_list args_copy;
-            va_copy(args_copy, args);
-            int size = vsnprintf(nullptr, 0, format, args_copy);
-            va_end(args_copy);
-            
-            if (size < 0) {
-                va_end(args);
-                return 0;
-            }
-            
-            // Выделяем буфер
-            std::vector<char> buffer(size + 1);
-            vsnprintf(buffer.data(), buffer.size(), format, args);
-            va_end(args);
-            
-            // Записываем в файл
-            return print(buffer.data());
+            return write(str.c_str(), str.length());
         }
         
         // Позиционирование
-        bool seek(uint32_t pos, SeekMode mode = SeekSet) {
-            if (!file_.is_open()) return false;
-            
-            std::ios_base::seekdir dir;
-            switch (mode) {
-                case SeekSet: dir = std::ios::beg; break;
-                case SeekCur: dir = std::ios::cur; break;
-                case SeekEnd: dir = std::ios::end; break;
-                default: return false;
-            }
-            
-            file_.seekg(pos, dir);
-            file_.seekp(pos, dir);
-            
-            if (file_.good()) {
-                position_ = file_.tellg();
-                return true;
-            }
-            return false;
-        }
+        bool seek(uint32_t pos, SeekMode mode = SeekSet);
         
         size_t position() const {
-            return position_;
+            FileSlot* s = slot();
+            return s ? s->position : 0;
         }
         
         size_t size() const {
-            return size_;
+            FileSlot* s = slot();
+            return s ? sizeOf(*s) : 0;
         }
         
-        // Закрытие
+        // Сброс буферов: на томе в памяти содержимое становится видно
+        // остальным только после flush() или close(), как в LittleFS
+        void flush() override {
+            FileSlot* s = slot();
+            if (s) s->flush();
+        }
+
+        // Закрытие. Слот освобождается сразу, остальные копии File
+        // становятся недействительными.
         void close() {
-            if (file_.is_open()) {
-                file_.close();
-            }
+            FileSlot* s = slot();
+            if (s) table_->release(index_);
+            release();
         }
         
         // Проверки
         operator bool() const {
-            return file_.is_open() && file_.good();
+            return slot() != nullptr;
         }
         
         bool isDirectory() const {
-            return is_directory_;
+            FileSlot* s = slot();
+            return s && s->is_directory;
         }
         
         const char* name() const {
-            return name_.c_str();
+            FileSlot* s = slot();
+            return s ? s->name() : "";
         }
         
         const char* fullName() const {
-            return path_.c_str();
+            FileSlot* s = slot();
+            return s ? s->path.c_str() : "";
         }
         
-        bool available() const {
-            return file_.is_open() && file_.good() && (position_ < size_);
+        // Сколько байт осталось до конца файла
+        size_t remaining() const {
+            FileSlot* s = slot();
+            if (!s || s->is_directory) return 0;
+            size_t size = sizeOf(*s);
+            return s->position < size ? size - s->position : 0;
         }
-        
-        // Для директорий
-        File openNextFile(const char* mode = "r") {
-            if (!is_directory_) return File();
-            
-            if (dir_ptr_ == nullptr) {
-                dir_ptr_ = opendir(path_.c_str());
-                if (!dir_ptr_) return File();
-            }
-            
-            struct dirent* entry;
-            while ((entry = readdir(dir_ptr_)) != nullptr) {
-                // Пропускаем . и ..
-                if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-                    continue;
-                }
-                
-                std::string full_path = path_ + "/" + entry->d_name;
-                return File(full_path, mode);
-            }
-            
-            // Конец директории
-            if (dir_ptr_) {
-                closedir(dir_ptr_);
-                dir_ptr_ = nullptr;
-            }
-            
-            return File();
+
+        int available() override {
+            return static_cast<int>(remaining());
         }
         
-        void rewindDirectory() {
-            if (dir_ptr_) {
-                closedir(dir_ptr_);
-                dir_ptr_ = nullptr;
-            }
-        }
+        // Для директорий. Тип записи известен из каталога, поэтому файл
+        // для чтения открывается только при первом read().
+        File openNextFile(const char* mode = "r");
+
+        // Полный путь следующей записи ("/dir/name") без открытия файла,
+        // как в ESP32. Пустая строка — записи закончились.
+        String getNextFileName(bool* isDir = nullptr);
+        
+        void rewindDirectory();
 
     // DEBUG: METHODS
     public:
     // В публичной секции класса File добавьте:
 
         // Метод для отладки - выводит состояние всех переменных
-        void debugInfo(const char* prefix = "") const {
-            std::cout << prefix << "=== File Debug Info ===" << std::endl;
-            std::cout << prefix << "Path: '" << path_ << "'" << std::endl;
-            std::cout << prefix << "Name: '" << name_ << "'" << std::endl;
-            std::cout << prefix << "Mode: '" << mode_ << "'" << std::endl;
-            std::cout << prefix << "Is directory: " << (is_directory_ ? "YES" : "NO") << std::endl;
-            std::cout << prefix << "Exists: " << (exists_ ? "YES" : "NO") << std::endl;
-            std::cout << prefix << "Size: " << size_ << " bytes" << std::endl;
-            std::cout << prefix << "Position: " << position_ << std::endl;
-            
-            // Информация о файловом потоке
-            std::cout << prefix << "File stream: ";
-            if (file_.is_open()) {
-                std::cout << "OPEN";
-                std::cout << " (good: " << file_.good();
-                std::cout << ", eof: " << file_.eof();
-                std::cout << ", fail: " << file_.fail();
-                std::cout << ", bad: " << file_.bad() << ")";
-                
-                // Текущая позиция в потоке
-                // std::streampos pos = file_.tellg();
-                // std::cout << "\n" << prefix << "Stream position: " << pos;
-            } else {
-                std::cout << "CLOSED";
-            }
-            std::cout << std::endl;
-            
-            // Для директорий
-            if (is_directory_) {
-                std::cout << prefix << "Directory pointer: ";
-                if (dir_ptr_) {
-                    std::cout << "VALID";
-                } else {
-                    std::cout << "NULL";
-                }
-                std::cout << std::endl;
-            }
-            
-            // Проверка доступности файла на диске (еще раз для уверенности)
-            struct stat st;
-            if (stat(path_.c_str(), &st) == 0) {
-                std::cout << prefix << "Disk info - ";
-                if (S_ISDIR(st.st_mode)) {
-                    std::cout << "Is a directory";
-                } else if (S_ISREG(st.st_mode)) {
-                    std::cout << "Is a regular file, size: " << st.st_size << " bytes";
-                    std::cout << ", permissions: " << std::oct << (st.st_mode & 0777) << std::dec;
-                } else {
-                    std::cout << "Is a special file";
-                }
-                std::cout << std::endl;
-            } else {
-                std::cout << prefix << "Disk info - File not found on disk (errno: " << errno << ")" << std::endl;
-            }
-            
-            std::cout << prefix << "Operator bool(): " << (operator bool() ? "TRUE" : "FALSE") << std::endl;
-            std::cout << prefix << "Available(): " << (available() ? "TRUE" : "FALSE") << std::endl;
-            std::cout << prefix << "=========================" << std::endl;
-        }
+        void debugInfo(const char* prefix = "") const;
 
         // Упрощенная версия для быстрой отладки
-        void debugShort() const {
-            std::cout << "File['" << name_ << "']";
-            std::cout << " path:'" << path_ << "'";
-            std::cout << " mode:'" << mode_ << "'";
-            std::cout << " open:" << (file_.is_open() ? "Y" : "N");
-            std::cout << " dir:" << (is_directory_ ? "Y" : "N");
-            std::cout << " exists:" << (exists_ ? "Y" : "N");
-            std::cout << " size:" << size_;
-            std::cout << " pos:" << position_;
-            std::cout << std::endl;
-        }
+        void debugShort() const;
+
+    protected:
+        // Stream читает содержимое файла в памяти или буфер файла на диске
+        size_t inputView(const uint8_t*& data) override;
+
+        void consumeInput(size_t n) override;
     };
 
     class LittleFSClass {
     private:
       std::string base_path_;
       bool mounted_;
+      // Том в памяти, если смонтирован образ; иначе работаем с диском
+      std::shared_ptr<MemoryVolume> mem_;
+      // Раздел в памяти, который монтирует begin() (setPartition)
+      std::shared_ptr<MemoryVolume> partition_;
+      // Нормализованные пути всех точек входа
+      PathTable paths_;
+      // Открытые файлы, не больше maxOpenFiles из begin()
+      FileTable files_;
+      // Снимки дискового тома: зеркало диска в памяти и журнал путей,
+      // изменённых через LittleFSClass после его последней синхронизации
+      std::shared_ptr<MemoryVolume> disk_mirror_;
+      std::vector<std::string> journal_;
+      size_t mirror_pos_;
+      std::map<int, size_t> snapshot_pos_;
 
       // Статическая функция mkdir из sys/stat.h (не путать с методом класса)
-      static bool sys_mkdir(const char *path, mode_t mode) {
-        return ::mkdir(path, mode) == 0 || errno == EEXIST;
-      }
+      static bool sys_mkdir(const char *path, mode_t mode);
 
-      static bool sys_rmdir(const char *path) { return ::rmdir(path) == 0; }
+      static bool sys_rmdir(const char *path);
 
-      static bool createDirRecursive(const std::string &path) {
-#ifdef LITTLEFS_STUB_DEBUG
-        std::cout << "[DEBUG] createDirRecursive('" << path << "') called"
-                  << std::endl;
-#endif
+      static bool createDirRecursive(const std::string &path);
 
-        if (path.empty() || path == "/") {
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] Path is empty or root, returning true"
-                    << std::endl;
-#endif
-          return true;
-        }
-
-#ifdef LITTLEFS_STUB_DEBUG
-        std::cout << "[DEBUG] Creating directories for path: '" << path << "'"
-                  << std::endl;
-#endif
-
-        std::string current;
-
-        for (size_t i = 0; i <= path.length(); i++) {
-          // Если нашли слеш или конец строки
-          if (i == path.length() || path[i] == '/') {
-            if (!current.empty()) {
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "[DEBUG]   Checking/creating: '" << current << "'"
-                        << std::endl;
-#endif
-
-              struct stat st;
-              if (stat(current.c_str(), &st) != 0) {
-    // Директории нет, создаем
-#ifdef LITTLEFS_STUB_DEBUG
-                std::cout << "[DEBUG]     Directory doesn't exist, creating..."
-                          << std::endl;
-                std::cout << "[DEBUG]     Calling mkdir('" << current
-                          << "', 0755)" << std::endl;
-#endif
-
-                int result = ::mkdir(current.c_str(), 0755);
-#ifdef LITTLEFS_STUB_DEBUG
-                std::cout << "[DEBUG]     mkdir returned: " << result
-                          << std::endl;
-#endif
-
-                if (result != 0 && errno != EEXIST) {
-                  std::cerr << "[ERROR]     FAILED to create '" << current
-                            << "': " << strerror(errno) << " (errno=" << errno
-                            << ")" << std::endl;
-                  return false;
-                }
-
-                if (result == 0) {
-#ifdef LITTLEFS_STUB_DEBUG
-                  std::cout << "[DEBUG]     Created successfully" << std::endl;
-#endif
-                } else if (errno == EEXIST) {
-#ifdef LITTLEFS_STUB_DEBUG
-                  std::cout << "[DEBUG]     Already exists (EEXIST)"
-                            << std::endl;
-#endif
-                }
-              } else if (!S_ISDIR(st.st_mode)) {
-                std::cerr << "[ERROR]     EXISTS BUT NOT A DIRECTORY"
-                          << std::endl;
-                std::cerr << "[ERROR]     st_mode: " << std::oct << st.st_mode
-                          << std::dec << std::endl;
-                return false;
-              } else {
-#ifdef LITTLEFS_STUB_DEBUG
-                std::cout << "[DEBUG]     Already exists" << std::endl;
-#endif
-              }
-            }
+      static bool removeRecursive(const std::string &path);
 
-            // Добавляем слеш для следующей части
-            if (i < path.length() && path[i] == '/') {
-              current += "/";
-            }
-          } else {
-            current += path[i];
-          }
-        }
+      static bool pathExists(const std::string &path);
 
-        // Проверяем финальный результат
-        struct stat final_st;
-        if (stat(path.c_str(), &final_st) == 0 && S_ISDIR(final_st.st_mode)) {
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] SUCCESS: Directory '" << path
-                    << "' exists and is a directory" << std::endl;
-#endif
-          return true;
-        } else {
-          std::cerr << "[ERROR] FAILED: Directory '" << path
-                    << "' not created properly" << std::endl;
-          return false;
-        }
+      std::string hostPath(const std::string &rel) const {
+        return rel.empty() ? base_path_ : base_path_ + "/" + rel;
       }
 
-      static bool removeRecursive(const std::string &path) {
-        // Сначала проверяем, это файл или директория
-        struct stat st;
-        if (stat(path.c_str(), &st) != 0) {
-          return false;
-        }
-
-        if (!S_ISDIR(st.st_mode)) {
-          // Это файл - просто удаляем
-          return unlink(path.c_str()) == 0;
-        }
-
-        // Это директория - удаляем рекурсивно
-        DIR *dir = opendir(path.c_str());
-        if (!dir) {
-          return false;
-        }
-
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != nullptr) {
-          if (strcmp(entry->d_name, ".") == 0 ||
-              strcmp(entry->d_name, "..") == 0) {
-            continue;
-          }
+      // Запоминает путь, который сейчас будет изменён. Для создаваемых
+      // путей берётся верхний ещё не существующий каталог, чтобы откат
+      // убрал и промежуточные каталоги.
+      void noteChange(const PathEntry &entry);
 
-          std::string full_path = path + "/" + entry->d_name;
+      // Уникальные пути без тех, чей предок уже есть в списке
+      static void collapsePaths(std::vector<std::string> &paths);
 
-          if (stat(full_path.c_str(), &st) == 0) {
-            if (S_ISDIR(st.st_mode)) {
-              removeRecursive(full_path);
-            } else {
-              unlink(full_path.c_str());
-            }
-          }
-        }
-
-        closedir(dir);
-        return sys_rmdir(path.c_str());
-      }
-
-      static bool pathExists(const std::string &path) {
-        struct stat st;
-        return stat(path.c_str(), &st) == 0;
+      void resetSnapshots() {
+        files_.setJournal(nullptr);
+        disk_mirror_.reset();
+        journal_.clear();
+        mirror_pos_ = 0;
+        snapshot_pos_.clear();
       }
         
     public:
-        LittleFSClass() : mounted_(false) {
+        LittleFSClass() : mounted_(false), mirror_pos_(0) {
             base_path_ = "./littlefs_data";
+            paths_.reset(base_path_);
         }
 
         /**
@@ -809,256 +302,121 @@ namespace fs {
          * 
          * @param formatOnFail 
          * @param basePath Путь к директории для монтирования LittleFS (по умолчанию ./littlefs)
-         * @param maxOpenFiles 
+         * @param maxOpenFiles Сколько файлов может быть открыто одновременно;
+         * при изменении лимита открытые файлы закрываются
          * @param partitionLabel 
          * @return true 
          * @return false 
          */
         bool begin(bool formatOnFail = false,
                    const char *basePath = "./littlefs", uint8_t maxOpenFiles = 5,
-                   const char *partitionLabel = NULL) {
-          (void)maxOpenFiles;
-          (void)partitionLabel;
-          (void)formatOnFail;
-
-          // Всегда используем /tmp для тестов
-          //   base_path_ = "/tmp/littlefs_test_" + std::to_string(getpid());
-          //   base_path_ = "/tmp/littlefs_test";
-          if (basePath && strlen(basePath) > 0) {
-            base_path_ = basePath;
-          }
-
-          std::cout << "[DEBUG] Trying to mount LittleFS at: " << base_path_
-                    << std::endl;
-
-          // Создаем базовую директорию рекурсивно
-          if (!createDirRecursive(base_path_)) {
-            std::cerr << "Failed to create base directory: " << base_path_
-                      << std::endl;
-
-            if (formatOnFail) {
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "Trying format..." << std::endl;
-#endif
-              return format();
+                   const char *partitionLabel = NULL);
 
-            } else {
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "[DEBUG] Mount failed and formatOnFail=false"
-                        << std::endl;
-#endif
-            }
-            return false;
-          }
+        void end();
 
-          mounted_ = true;
-          std::cout << "LittleFS mounted successfully at: " << base_path_
-                    << std::endl;
-          return true;
+        /**
+         * @brief Монтирование бинарного образа LittleFS (mklittlefs или дамп
+         * раздела с устройства) в память для чтения и записи
+         *
+         * Файл образа читается одним вызовом, каталоги и файлы
+         * декодируются при первом обращении. Изменения остаются в памяти,
+         * сохранить их можно через saveImage().
+         */
+        bool mountImage(const char *imagePath);
+
+        bool mountImage(const uint8_t *data, size_t size) {
+          return mountImage(MemoryVolume::Data(
+              new std::vector<uint8_t>(data, data + size)));
         }
 
-        void end() {
-            mounted_ = false;
+        bool mountImage(const MemoryVolume::Data &image);
+
+        /**
+         * @brief Раздел флеша в памяти: begin() монтирует его вместо
+         * каталога на диске
+         *
+         * Без образа раздел пустой. Содержимое переживает end() и
+         * повторный begin(), как флеш при перезагрузке. Так у каждого
+         * устройства stub_device своя файловая система.
+         */
+        bool setPartition(const MemoryVolume::Data &image = MemoryVolume::Data());
+
+        /**
+         * @brief Сериализация текущего тома (в памяти или на диске) в образ
+         *
+         * Для смонтированного образа по умолчанию используется его геометрия,
+         * для диска — 256 блоков по 4096 байт (раздел 1MB, как в freeBytes()).
+         */
+        bool exportImage(std::vector<uint8_t> &out) {
+          return exportImage(out, mem_ ? mem_->geometry() : LittleFSGeometry());
         }
 
-        bool format() {
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] Formatting LittleFS at: " << base_path_
-                    << std::endl;
-#endif
-
-          // Удаляем все файлы в директории
-          if (pathExists(base_path_)) {
-            #ifdef LITTLEFS_STUB_DEBUG
-            std::cout << "[DEBUG] Removing existing files in: " << base_path_
-                      << std::endl;
-                #endif
-            if (!removeRecursive(base_path_)) {
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "[DEBUG] Failed to remove existing files in: "
-                        << base_path_ << std::endl;
-#endif
-              return false;
-            }
-          }
-
-          // Создаем заново
-          if (!sys_mkdir(base_path_.c_str(), 0755)) {
-#ifdef LITTLEFS_STUB_DEBUG
-            std::cout << "[DEBUG] Failed to create base directory: " << base_path_
-                      << std::endl;
-#endif
-            return false;
-          }
-
-          mounted_ = true;
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] LittleFS formatted at: " << base_path_
-                    << std::endl;
-#endif
-          return true;
+        bool exportImage(std::vector<uint8_t> &out,
+                         const LittleFSGeometry &geometry);
+
+        bool saveImage(const char *imagePath) {
+          return saveImage(imagePath,
+                           mem_ ? mem_->geometry() : LittleFSGeometry());
         }
 
-        File open(const char *path, const char *mode = "r") {
-          if (!mounted_) {
-#ifdef LITTLEFS_STUB_DEBUG
-            std::cout << "[ERROR] LittleFS not mounted!" << std::endl;
-#endif
-            return File();
-          }
-
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] open() called with path: '" << path
-                    << "', mode: '" << mode << "'" << std::endl;
-          std::cout << "[DEBUG] base_path_: '" << base_path_ << "'"
-                    << std::endl;
-#endif
-
-          std::string full_path = base_path_ + "/" + path;
-
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] full_path before normalize: '" << full_path
-                    << "'" << std::endl;
-#endif
-
-          // Нормализуем путь
-          std::string normalized;
-          bool last_was_slash = false;
-          for (char c : full_path) {
-            if (c == '/') {
-              if (!last_was_slash) {
-                normalized += c;
-                last_was_slash = true;
-              }
-            } else {
-              normalized += c;
-              last_was_slash = false;
-            }
-          }
-
-          // Убираем слеш в конце если есть
-          if (normalized.length() > 1 && normalized.back() == '/') {
-            normalized.pop_back();
-          }
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] normalized path: '" << normalized << "'"
-                    << std::endl;
-#endif
-
-          // Создаем директории если нужно (для режима записи)
-          if (strchr(mode, 'w') || strchr(mode, 'a')) {
-            // Извлекаем путь к директории
-            size_t pos = normalized.find_last_of('/');
-            if (pos != std::string::npos) {
-              std::string dir_path = normalized.substr(0, pos);
-
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "[DEBUG] Directory path to create: '" << dir_path
-                        << "'" << std::endl;
-              std::cout << "[DEBUG] dir_path.empty(): " << dir_path.empty()
-                        << std::endl;
-#endif
-
-              if (!dir_path.empty()) {
-#ifdef LITTLEFS_STUB_DEBUG
-                std::cout << "[DEBUG] Calling createDirRecursive('" << dir_path
-                          << "')" << std::endl;
-#endif
-                if (!createDirRecursive(dir_path)) {
-                  std::cerr << "[ERROR] Failed to create directory path"
-                            << std::endl;
-                  return File();
-                }
-#ifdef LITTLEFS_STUB_DEBUG
-                std::cout << "[DEBUG] createDirRecursive succeeded"
-                          << std::endl;
-#endif
-
-              } else {
-#ifdef LITTLEFS_STUB_DEBUG
-                std::cout
-                    << "[DEBUG] dir_path is empty, skipping directory creation"
-                    << std::endl;
-#endif
-              }
-            } else {
-#ifdef LITTLEFS_STUB_DEBUG
-              std::cout << "[DEBUG] No '/' found in normalized path"
-                        << std::endl;
-#endif
-            }
-          }
-#ifdef LITTLEFS_STUB_DEBUG
-          std::cout << "[DEBUG] Creating File object with path: '" << normalized
-                    << "', mode: '" << mode << "'" << std::endl;
-#endif
-          return File(normalized, mode);
+        bool saveImage(const char *imagePath, const LittleFSGeometry &geometry);
+
+        // Смонтирован ли образ в память
+        bool inMemory() const {
+          return mem_ != nullptr;
         }
 
+        /**
+         * @brief Снимок текущего состояния тома
+         *
+         * Снимки разделяют неизменённые файлы между собой. Для образа в
+         * памяти snapshot() и restore() не копируют данных вовсе. Для тома на
+         * диске первый снимок читает каталог целиком, а дальше snapshot() и
+         * restore() трогают только пути, изменённые через LittleFS после
+         * предыдущей синхронизации. Изменения в обход LittleFS (прямая запись
+         * в base path) не отслеживаются. Буферы открытых файлов
+         * сбрасываются перед снимком и перед откатом.
+         *
+         * @return Идентификатор снимка или -1 при ошибке
+         */
+        int snapshot();
+
+        // Откат тома к снимку; сам снимок остаётся доступным. Все открытые
+        // файлы закрываются (с записью буферов до отката), их копии File
+        // становятся недействительными, как после close().
+        bool restore(int id);
+
+        void dropSnapshot(int id);
+
+        bool format();
+
+        File open(const char *path, const char *mode = "r");
+
         File open(const String& path, const char* mode = "r") {
             return open(path.c_str(), mode);
         }
         
-        bool exists(const char* path) {
-            if (!mounted_) return false;
-            
-            std::string full_path = base_path_ + "/" + path;
-            return pathExists(full_path);
-        }
+        bool exists(const char* path);
         
         bool exists(const String& path) {
             return exists(path.c_str());
         }
         
-        bool remove(const char* path) {
-            if (!mounted_) return false;
-            
-            std::string full_path = base_path_ + "/" + path;
-            
-            if (pathExists(full_path)) {
-                return removeRecursive(full_path);
-            }
-            return false;
-        }
-        
+        bool remove(const char* path);
+
         bool remove(const String& path) {
             return remove(path.c_str());
         }
         
-        bool rename(const char* pathFrom, const char* pathTo) {
-            if (!mounted_) return false;
-            
-            std::string from_path = base_path_ + "/" + pathFrom;
-            std::string to_path = base_path_ + "/" + pathTo;
-            
-            if (pathExists(from_path)) {
-                // Создаем директории для пути назначения
-                size_t pos = to_path.find_last_of('/');
-                if (pos != std::string::npos) {
-                    std::string dir_path = to_path.substr(0, pos);
-                    if (!dir_path.empty()) {
-                        createDirRecursive(dir_path);
-                    }
-                }
-                
-                // Переименовываем
-                return ::rename(from_path.c_str(), to_path.c_str()) == 0;
-            }
-            return false;
-        }
-        
+        bool rename(const char* pathFrom, const char* pathTo);
+
         bool rename(const String& pathFrom, const String& pathTo) {
             return rename(pathFrom.c_str(), pathTo.c_str());
         }
         
         // Методы класса
-        bool mkdir(const char* path) {
-            if (!mounted_) return false;
-            
-            std::string full_path = base_path_ + "/" + path;
-            return createDirRecursive(full_path);
-        }
-        
+        bool mkdir(const char* path);
+
         bool mkdir(const String& path) {
             return mkdir(path.c_str());
         }
@@ -1072,98 +430,45 @@ namespace fs {
         }
         
         // Информация
-        size_t totalBytes() {
-            if (!mounted_) return 0;
-            
-            size_t total = 0;
-            calculateDirSize(base_path_, total);
-            return total;
-        }
+        size_t totalBytes();
         
         size_t usedBytes() {
+            if (mem_) return mounted_ ? mem_->usedBytes() : 0;
             return totalBytes();
         }
         
-        size_t freeBytes() {
-            // Эмулируем 1MB свободного места
-            size_t used = usedBytes();
-            return (1024 * 1024 > used) ? (1024 * 1024 - used) : 0;
-        }
+        size_t freeBytes();
         
         // Получить путь к данным
         std::string getBasePath() const {
             return base_path_;
         }
+
+        // Сколько файлов сейчас открыто (каталоги не считаются)
+        size_t openFiles() const {
+            return files_.openFiles();
+        }
         
         // Очистить все данные
-        void clearAll() {
-            if (pathExists(base_path_)) {
-                removeRecursive(base_path_);
-                sys_mkdir(base_path_.c_str(), 0755);
-            }
-        }
+        void clearAll();
         
         // Список файлов
-        std::vector<std::string> listFiles() {
-            std::vector<std::string> files;
-            if (!mounted_) return files;
-            
-            listFilesRecursive(base_path_, base_path_, files);
-            return files;
-        }
+        std::vector<std::string> listFiles();
         
     private:
-        void calculateDirSize(const std::string& path, size_t& total) {
-            DIR* dir = opendir(path.c_str());
-            if (!dir) return;
-            
-            struct dirent* entry;
-            struct stat st;
-            
-            while ((entry = readdir(dir)) != nullptr) {
-                if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-                    continue;
-                }
-                
-                std::string full_path = path + "/" + entry->d_name;
-                
-                if (stat(full_path.c_str(), &st) == 0) {
-                    if (S_ISDIR(st.st_mode)) {
-                        calculateDirSize(full_path, total);
-                    } else {
-                        total += st.st_size;
-                    }
-                }
-            }
-            
-            closedir(dir);
-        }
+        bool formatVolume();
+
+        File openPath(const char *path, const char *mode);
+
+        bool removePath(const char* path);
+
+        bool renamePath(const char* pathFrom, const char* pathTo);
+
+        bool mkdirPath(const char* path);
+
+        void calculateDirSize(const std::string& path, size_t& total);
         
-        void listFilesRecursive(const std::string& base, const std::string& path, std::vector<std::string>& files) {
-            DIR* dir = opendir(path.c_str());
-            if (!dir) return;
-            
-            struct dirent* entry;
-            
-            while ((entry = readdir(dir)) != nullptr) {
-                if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-                    continue;
-                }
-                
-                std::string full_path = path + "/" + entry->d_name;
-                std::string relative_path = full_path.substr(base.length());
-                
-                files.push_back(relative_path);
-                
-                // Проверяем, является ли это директорией
-                struct stat st;
-                if (stat(full_path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
-                    listFilesRecursive(base, full_path, files);
-                }
-            }
-            
-            closedir(dir);
-        }
+        void listFilesRecursive(const std::string& base, const std::string& path, std::vector<std::string>& files);
     };
 
     // Глобальный экземпляр
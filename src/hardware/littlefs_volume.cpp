@@ -0,0 +1,375 @@
+#include "littlefs_volume.h"
+
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+
+namespace fs {
+
+    MemoryVolume::MemoryVolume() : root_(new Node()), next_snapshot_(1) {
+        root_->is_dir = true;
+    }
+
+    bool MemoryVolume::load(const Data &image, std::string *error) {
+        std::shared_ptr<LittleFSImageReader> reader(new LittleFSImageReader());
+        if (!reader->open(image, 0, error)) {
+            return false;
+        }
+        image_ = reader;
+        geometry_ = reader->geometry();
+        // Прошивка пишет коммиты с тем же шагом, что и mklittlefs
+        geometry_.prog_size = LittleFSGeometry().prog_size;
+
+        root_.reset(new Node());
+        root_->is_dir = true;
+        root_->pending = true;
+        root_->source.is_dir = true;
+        root_->source.pair[0] = reader->rootPair()[0];
+        root_->source.pair[1] = reader->rootPair()[1];
+        return true;
+    }
+
+    MemoryVolume::NodePtr MemoryVolume::loadHostNode(const std::string &hostPath) {
+        struct stat st;
+        if (stat(hostPath.c_str(), &st) != 0) return NodePtr();
+
+        NodePtr node(new Node());
+        if (!S_ISDIR(st.st_mode)) {
+            std::ifstream in(hostPath.c_str(), std::ios::binary);
+            node->data.reset(new std::vector<uint8_t>(
+                (std::istreambuf_iterator<char>(in)),
+                std::istreambuf_iterator<char>()));
+            return node;
+        }
+
+        node->is_dir = true;
+        DIR *d = opendir(hostPath.c_str());
+        if (!d) return NodePtr();
+        struct dirent *entry;
+        while ((entry = readdir(d)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 ||
+                strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            NodePtr child = loadHostNode(hostPath + "/" + entry->d_name);
+            if (child) node->children[entry->d_name] = child;
+        }
+        closedir(d);
+        return node;
+    }
+
+    bool MemoryVolume::loadDirectory(const std::string &hostPath,
+                                     const LittleFSGeometry &geometry) {
+        geometry_ = geometry;
+        image_.reset();
+        root_ = loadHostNode(hostPath);
+        if (!root_ || !root_->is_dir) {
+            root_.reset(new Node());
+            root_->is_dir = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool MemoryVolume::importHostPath(const std::string &hostPath,
+                                      const std::string &path) {
+        std::vector<std::string> parts;
+        split(path, parts);
+        NodePtr node = loadHostNode(hostPath);
+        if (parts.empty()) {
+            if (!node || !node->is_dir) return false;
+            root_ = node;
+            return true;
+        }
+        if (!node) {
+            remove(path);
+            return true;
+        }
+        Node *dir = mutableDir(parts, parts.size() - 1, true);
+        if (!dir) return false;
+        dir->children[parts.back()] = node;
+        return true;
+    }
+
+    bool MemoryVolume::exportHostPath(const std::string &path,
+                                      const std::string &hostPath) {
+        Node *node = lookup(path);
+        if (!node) return true;
+        if (!materialize(*node)) return false;
+        if (!node->is_dir) {
+            std::ofstream out(hostPath.c_str(), std::ios::binary | std::ios::trunc);
+            if (node->data && !node->data->empty()) {
+                out.write(reinterpret_cast<const char *>(node->data->data()),
+                          node->data->size());
+            }
+            return out.good();
+        }
+        if (::mkdir(hostPath.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        std::string prefix = path.empty() ? path : path + "/";
+        for (std::map<std::string, NodePtr>::iterator it = node->children.begin();
+             it != node->children.end(); ++it) {
+            if (!exportHostPath(prefix + it->first, hostPath + "/" + it->first)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void MemoryVolume::format() {
+        image_.reset();
+        root_.reset(new Node());
+        root_->is_dir = true;
+    }
+
+    int MemoryVolume::snapshot() {
+        Snapshot snap;
+        snap.root = root_;
+        snap.image = image_;
+        int id = next_snapshot_++;
+        snapshots_[id] = snap;
+        return id;
+    }
+
+    bool MemoryVolume::restore(int id) {
+        std::map<int, Snapshot>::const_iterator it = snapshots_.find(id);
+        if (it == snapshots_.end()) return false;
+        root_ = it->second.root;
+        image_ = it->second.image;
+        return true;
+    }
+
+    void MemoryVolume::dropSnapshot(int id) { snapshots_.erase(id); }
+
+    bool MemoryVolume::hasSnapshot(int id) const {
+        return snapshots_.find(id) != snapshots_.end();
+    }
+
+    // Узел, на который ссылается кто-то ещё (снимок), перед изменением
+    // копируется; дочерние узлы при этом остаются общими
+    MemoryVolume::Node *MemoryVolume::own(NodePtr &node) {
+        if (node.use_count() > 1) {
+            node.reset(new Node(*node));
+        }
+        return node.get();
+    }
+
+    void MemoryVolume::split(const std::string &path,
+                             std::vector<std::string> &parts) {
+        parts.clear();
+        size_t start = 0;
+        while (start <= path.size()) {
+            size_t end = path.find('/', start);
+            if (end == std::string::npos) end = path.size();
+            if (end > start) parts.push_back(path.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+
+    bool MemoryVolume::materialize(Node &node) {
+        if (!node.pending) return true;
+        if (!image_) return false;
+        if (node.is_dir) {
+            std::vector<LittleFSImageEntry> entries;
+            if (!image_->readDir(node.source.pair, entries)) return false;
+            for (size_t i = 0; i < entries.size(); i++) {
+                NodePtr child(new Node());
+                child->is_dir = entries[i].is_dir;
+                child->pending = true;
+                child->source = entries[i];
+                node.children[entries[i].name] = child;
+            }
+        } else {
+            std::shared_ptr<std::vector<uint8_t> > data(new std::vector<uint8_t>());
+            if (!image_->readFile(node.source, *data)) return false;
+            node.data = data;
+        }
+        node.pending = false;
+        return true;
+    }
+
+    MemoryVolume::Node *MemoryVolume::lookup(const std::string &path) {
+        std::vector<std::string> parts;
+        split(path, parts);
+        Node *cur = root_.get();
+        for (size_t i = 0; i < parts.size(); i++) {
+            if (!cur->is_dir || !materialize(*cur)) return nullptr;
+            std::map<std::string, NodePtr>::iterator it = cur->children.find(parts[i]);
+            if (it == cur->children.end()) return nullptr;
+            cur = it->second.get();
+        }
+        return cur;
+    }
+
+    MemoryVolume::Node *MemoryVolume::mutableDir(const std::vector<std::string> &parts,
+                                                 size_t count, bool create) {
+        Node *cur = own(root_);
+        for (size_t i = 0; i < count; i++) {
+            if (!materialize(*cur)) return nullptr;
+            std::map<std::string, NodePtr>::iterator it = cur->children.find(parts[i]);
+            if (it == cur->children.end()) {
+                if (!create) return nullptr;
+                NodePtr dir(new Node());
+                dir->is_dir = true;
+                it = cur->children.insert(std::make_pair(parts[i], dir)).first;
+            } else if (!it->second->is_dir) {
+                return nullptr;
+            }
+            cur = own(it->second);
+        }
+        if (!materialize(*cur)) return nullptr;
+        return cur;
+    }
+
+    MemoryVolume::NodeType MemoryVolume::type(const std::string &path) {
+        Node *node = lookup(path);
+        if (!node) return NodeNone;
+        return node->is_dir ? NodeDir : NodeFile;
+    }
+
+    bool MemoryVolume::readFile(const std::string &path, Data &out) {
+        Node *node = lookup(path);
+        if (!node || node->is_dir || !materialize(*node)) return false;
+        out = node->data;
+        return true;
+    }
+
+    size_t MemoryVolume::fileSize(const std::string &path) {
+        Node *node = lookup(path);
+        if (!node || node->is_dir) return 0;
+        if (node->pending) return node->source.size;
+        return node->data ? node->data->size() : 0;
+    }
+
+    bool MemoryVolume::writeFile(const std::string &path, const Data &data) {
+        std::vector<std::string> parts;
+        split(path, parts);
+        if (parts.empty()) return false;
+        Node *dir = mutableDir(parts, parts.size() - 1, true);
+        if (!dir) return false;
+        NodePtr &node = dir->children[parts.back()];
+        if (node && node->is_dir) return false;
+        node.reset(new Node());
+        node->data = data;
+        return true;
+    }
+
+    bool MemoryVolume::mkdir(const std::string &path) {
+        std::vector<std::string> parts;
+        split(path, parts);
+        return mutableDir(parts, parts.size(), true) != nullptr;
+    }
+
+    bool MemoryVolume::remove(const std::string &path) {
+        std::vector<std::string> parts;
+        split(path, parts);
+        if (parts.empty()) return false;
+        Node *dir = mutableDir(parts, parts.size() - 1, false);
+        if (!dir) return false;
+        return dir->children.erase(parts.back()) > 0;
+    }
+
+    bool MemoryVolume::rename(const std::string &from, const std::string &to) {
+        std::vector<std::string> src, dst;
+        split(from, src);
+        split(to, dst);
+        if (src.empty() || dst.empty()) return false;
+        // Нельзя перенести каталог внутрь самого себя
+        if (dst.size() > src.size() &&
+            std::equal(src.begin(), src.end(), dst.begin())) {
+            return false;
+        }
+
+        Node *src_dir = mutableDir(src, src.size() - 1, false);
+        if (!src_dir) return false;
+        std::map<std::string, NodePtr>::iterator it = src_dir->children.find(src.back());
+        if (it == src_dir->children.end()) return false;
+        NodePtr node = it->second;
+        src_dir->children.erase(it);
+
+        Node *dst_dir = mutableDir(dst, dst.size() - 1, true);
+        if (!dst_dir) {
+            src_dir->children[src.back()] = node;
+            return false;
+        }
+        dst_dir->children[dst.back()] = node;
+        return true;
+    }
+
+    bool MemoryVolume::list(const std::string &path,
+                            std::vector<std::pair<std::string, bool> > &out) {
+        out.clear();
+        Node *node = lookup(path);
+        if (!node || !node->is_dir || !materialize(*node)) return false;
+        for (std::map<std::string, NodePtr>::const_iterator it = node->children.begin();
+             it != node->children.end(); ++it) {
+            out.push_back(std::make_pair(it->first, it->second->is_dir));
+        }
+        return true;
+    }
+
+    void MemoryVolume::listRecursive(Node &node, const std::string &prefix,
+                                     std::vector<std::string> &out) {
+        if (!materialize(node)) return;
+        for (std::map<std::string, NodePtr>::iterator it = node.children.begin();
+             it != node.children.end(); ++it) {
+            std::string path = prefix + "/" + it->first;
+            out.push_back(path);
+            if (it->second->is_dir) {
+                listRecursive(*it->second, path, out);
+            }
+        }
+    }
+
+    void MemoryVolume::listRecursive(std::vector<std::string> &out) {
+        out.clear();
+        listRecursive(*root_, "", out);
+    }
+
+    size_t MemoryVolume::usedBytes(Node &node) {
+        if (!node.is_dir) {
+            if (node.pending) return node.source.size;
+            return node.data ? node.data->size() : 0;
+        }
+        if (!materialize(node)) return 0;
+        size_t total = 0;
+        for (std::map<std::string, NodePtr>::iterator it = node.children.begin();
+             it != node.children.end(); ++it) {
+            total += usedBytes(*it->second);
+        }
+        return total;
+    }
+
+    size_t MemoryVolume::usedBytes() { return usedBytes(*root_); }
+
+    bool MemoryVolume::toImageNode(Node &node, LittleFSImageNode &out) {
+        out.is_dir = node.is_dir;
+        if (!materialize(node)) return false;
+        if (!node.is_dir) {
+            out.data = node.data;
+            return true;
+        }
+        out.children.resize(node.children.size());
+        size_t i = 0;
+        for (std::map<std::string, NodePtr>::iterator it = node.children.begin();
+             it != node.children.end(); ++it, ++i) {
+            out.children[i].name = it->first;
+            if (!toImageNode(*it->second, out.children[i])) return false;
+        }
+        return true;
+    }
+
+    bool MemoryVolume::exportImage(const LittleFSGeometry &geometry,
+                                   std::vector<uint8_t> &out, std::string *error) {
+        LittleFSImageNode root;
+        if (!toImageNode(*root_, root)) {
+            if (error) *error = "failed to decode source image";
+            return false;
+        }
+        LittleFSImageWriter writer(geometry);
+        return writer.write(root, out, error);
+    }
+
+} // namespace fs
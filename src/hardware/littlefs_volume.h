@@ -0,0 +1,125 @@
+#ifndef LITTLEFS_VOLUME_H
+#define LITTLEFS_VOLUME_H
+
+// Том LittleFS в памяти. Используется, когда LittleFS смонтирован из
+// бинарного образа: файлы и каталоги живут в дереве узлов, а содержимое
+// образа декодируется лениво — каталог при первом обращении, файл при
+// первом открытии.
+//
+// Пути передаются относительными, без ведущего и завершающего '/',
+// корень — пустая строка.
+//
+// Узлы дерева неизменяемы, пока на них ссылается снимок: изменение
+// копирует только путь от корня до изменённого узла, а содержимое файлов
+// и нетронутые каталоги разделяются между снимками.
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "littlefs_image.h"
+
+namespace fs {
+
+    class MemoryVolume {
+    public:
+        typedef std::shared_ptr<const std::vector<uint8_t> > Data;
+
+        enum NodeType {
+            NodeNone = 0,
+            NodeFile = 1,
+            NodeDir = 2
+        };
+
+        MemoryVolume();
+
+        // Монтирует образ. Сам образ не копируется и не разбирается целиком.
+        bool load(const Data &image, std::string *error = nullptr);
+
+        // Загружает дерево из каталога на диске (для экспорта дискового тома)
+        bool loadDirectory(const std::string &hostPath,
+                           const LittleFSGeometry &geometry);
+
+        // Пустой том с той же геометрией
+        void format();
+
+        // Снимки: snapshot() и restore() — O(1), данные не копируются
+        int snapshot();
+        bool restore(int id);
+        void dropSnapshot(int id);
+        bool hasSnapshot(int id) const;
+
+        // Заменяет узел path содержимым файла или каталога с диска
+        // (удаляет узел, если на диске его нет)
+        bool importHostPath(const std::string &hostPath, const std::string &path);
+        // Записывает узел path (файл или каталог целиком) на диск.
+        // Существующие на диске данные должны быть удалены заранее.
+        bool exportHostPath(const std::string &path, const std::string &hostPath);
+
+        const LittleFSGeometry &geometry() const { return geometry_; }
+
+        NodeType type(const std::string &path);
+        bool readFile(const std::string &path, Data &out);
+        size_t fileSize(const std::string &path);
+
+        // Создаёт или перезаписывает файл, недостающие каталоги создаются
+        bool writeFile(const std::string &path, const Data &data);
+        bool mkdir(const std::string &path);
+        bool remove(const std::string &path);
+        bool rename(const std::string &from, const std::string &to);
+
+        // Содержимое каталога: имя и признак каталога
+        bool list(const std::string &path,
+                  std::vector<std::pair<std::string, bool> > &out);
+        // Все пути тома в формате LittleFSClass::listFiles ("/a", "/a/b")
+        void listRecursive(std::vector<std::string> &out);
+
+        size_t usedBytes();
+
+        bool exportImage(const LittleFSGeometry &geometry,
+                         std::vector<uint8_t> &out, std::string *error = nullptr);
+
+    private:
+        struct Node;
+        typedef std::shared_ptr<Node> NodePtr;
+
+        struct Node {
+            bool is_dir;
+            std::map<std::string, NodePtr> children;
+            Data data;
+            // Ленивое чтение из образа
+            bool pending;
+            LittleFSImageEntry source;
+
+            Node() : is_dir(false), pending(false) {}
+        };
+
+        struct Snapshot {
+            NodePtr root;
+            std::shared_ptr<LittleFSImageReader> image;
+        };
+
+        std::shared_ptr<LittleFSImageReader> image_;
+        LittleFSGeometry geometry_;
+        NodePtr root_;
+        std::map<int, Snapshot> snapshots_;
+        int next_snapshot_;
+
+        static void split(const std::string &path, std::vector<std::string> &parts);
+        static Node *own(NodePtr &node);
+        bool materialize(Node &node);
+        static NodePtr loadHostNode(const std::string &hostPath);
+        Node *lookup(const std::string &path);
+        Node *mutableDir(const std::vector<std::string> &parts, size_t count,
+                         bool create);
+        bool toImageNode(Node &node, LittleFSImageNode &out);
+        void listRecursive(Node &node, const std::string &prefix,
+                           std::vector<std::string> &out);
+        size_t usedBytes(Node &node);
+    };
+
+} // namespace fs
+
+#endif // LITTLEFS_VOLUME_H
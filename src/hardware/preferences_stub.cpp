@@ -0,0 +1,466 @@
+#include "preferences_stub.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace stub_nvs {
+
+    // Состояния страницы и записи: как во флеше, биты только сбрасываются
+    static const uint32_t kPageEmpty = 0xFFFFFFFF;
+    static const uint32_t kPageActive = 0xFFFFFFFE;
+    static const uint32_t kPageFull = 0xFFFFFFFC;
+    static const uint32_t kPageFreeing = 0xFFFFFFF8;
+
+    static const uint8_t kEntryEmpty = 3;
+    static const uint8_t kEntryWritten = 2;
+    static const uint8_t kEntryErased = 0;
+
+    // Заголовок страницы, за ним битовая карта по 2 бита на запись
+    static const size_t kHeaderSize = 32;
+    static const size_t kBitmapSize = 32;
+    static const size_t kFirstEntry = kHeaderSize + kBitmapSize;
+
+    // Поля записи
+    static const size_t kKeyOffset = 8;
+    static const size_t kDataOffset = 24;
+
+    static bool variableLength(uint8_t type) { return type == kStr || type == kBlob; }
+
+    Partition::Partition(size_t pages) : pages_(pages < 2 ? 2 : pages), active_(0), next_seq_(0) {}
+
+    void Partition::ensureFlash() {
+        if (!flash_.empty()) return;
+        flash_.assign(pages_.size() * kPageSize, 0xFF);
+        for (size_t i = 0; i < pages_.size(); i++) {
+            Page page = {kPageEmpty, 0, 0, 0};
+            pages_[i] = page;
+        }
+        index_.clear();
+        next_seq_ = 0;
+        active_ = 0;
+        pages_[0].seq = next_seq_++;
+        setPageState(0, kPageActive);
+    }
+
+    uint8_t *Partition::entryAt(size_t page, size_t entry) {
+        return &flash_[page * kPageSize + kFirstEntry + entry * kEntrySize];
+    }
+
+    void Partition::setEntryState(size_t page, size_t entry, uint8_t state) {
+        uint8_t &bits = flash_[page * kPageSize + kHeaderSize + entry / 4];
+        size_t shift = (entry % 4) * 2;
+        bits = static_cast<uint8_t>((bits & ~(3 << shift)) | (state << shift));
+    }
+
+    uint8_t Partition::entryState(size_t page, size_t entry) {
+        size_t shift = (entry % 4) * 2;
+        return (flash_[page * kPageSize + kHeaderSize + entry / 4] >> shift) & 3;
+    }
+
+    void Partition::setPageState(size_t page, uint32_t state) {
+        pages_[page].state = state;
+        uint8_t *header = &flash_[page * kPageSize];
+        memcpy(header, &state, 4);
+        memcpy(header + 4, &pages_[page].seq, 4);
+    }
+
+    std::string Partition::indexKey(uint8_t ns, const char *key) {
+        std::string result(1, static_cast<char>(ns));
+        result.append(key);
+        return result;
+    }
+
+    void Partition::erasePage(size_t page) {
+        memset(&flash_[page * kPageSize], 0xFF, kPageSize);
+        Page empty = {kPageEmpty, 0, 0, 0};
+        pages_[page] = empty;
+        stats_.erases++;
+    }
+
+    bool Partition::nextActivePage() {
+        size_t empty = 0, first = pages_.size();
+        for (size_t i = 0; i < pages_.size(); i++) {
+            if (pages_[i].state != kPageEmpty) continue;
+            if (first == pages_.size()) first = i;
+            empty++;
+        }
+        // Последняя пустая страница — запас для сборки мусора
+        if (empty < 2) return false;
+        active_ = first;
+        pages_[first].seq = next_seq_++;
+        setPageState(first, kPageActive);
+        return true;
+    }
+
+    bool Partition::collectGarbage() {
+        // Самая старая заполненная страница, в которой есть что освободить
+        size_t victim = pages_.size(), spare = pages_.size();
+        for (size_t i = 0; i < pages_.size(); i++) {
+            const Page &page = pages_[i];
+            if (page.state == kPageEmpty && spare == pages_.size()) spare = i;
+            if (page.state != kPageFull || page.erased == 0) continue;
+            if (victim == pages_.size() || page.seq < pages_[victim].seq) victim = i;
+        }
+        if (victim == pages_.size() || spare == pages_.size()) return false;
+
+        pages_[victim].state = kPageFreeing;
+        setPageState(victim, kPageFreeing);
+        active_ = spare;
+        pages_[spare].seq = next_seq_++;
+        setPageState(spare, kPageActive);
+
+        for (size_t i = 0; i < pages_[victim].next;) {
+            const uint8_t *entry = entryAt(victim, i);
+            size_t span = std::max<size_t>(entry[2], 1);
+            if (entryState(victim, i) == kEntryWritten) {
+                Location location;
+                appendEntry(entry, span, &location);
+                stats_.relocated += span;
+                index_[indexKey(entry[0], reinterpret_cast<const char *>(entry + kKeyOffset))] = location;
+            }
+            i += span;
+        }
+        erasePage(victim);
+        return true;
+    }
+
+    bool Partition::reserve(size_t span) {
+        for (;;) {
+            Page &active = pages_[active_];
+            if (active.state == kPageActive && active.next + span <= kEntriesPerPage) return true;
+            if (active.state == kPageActive) setPageState(active_, kPageFull);
+            if (nextActivePage()) continue;
+            if (!collectGarbage()) return false;
+        }
+    }
+
+    void Partition::appendEntry(const uint8_t *entry, size_t span, Location *location) {
+        Page &page = pages_[active_];
+        // Сначала данные, потом состояние: прерванная запись останется пустой
+        memcpy(entryAt(active_, page.next), entry, span * kEntrySize);
+        for (size_t i = 0; i < span; i++) setEntryState(active_, page.next + i, kEntryWritten);
+        location->page = static_cast<uint16_t>(active_);
+        location->entry = static_cast<uint8_t>(page.next);
+        location->span = static_cast<uint8_t>(span);
+        page.next += span;
+        stats_.entries += span;
+    }
+
+    void Partition::eraseEntry(const Location &location) {
+        for (size_t i = 0; i < location.span; i++) {
+            setEntryState(location.page, location.entry + i, kEntryErased);
+        }
+        pages_[location.page].erased += location.span;
+    }
+
+    bool Partition::write(uint8_t ns, const char *key, ItemType type, const void *data, size_t size) {
+        size_t keyLen = key ? strlen(key) : 0;
+        if (keyLen == 0 || keyLen >= kKeySize) return false;
+        size_t span = 1;
+        if (variableLength(type)) {
+            span += (size + kEntrySize - 1) / kEntrySize;
+            if (span > kEntriesPerPage - 1) return false;
+        } else if (size > 8) {
+            return false;
+        }
+        ensureFlash();
+
+        std::string k = indexKey(ns, key);
+        std::unordered_map<std::string, Location>::iterator it = index_.find(k);
+        if (it != index_.end()) {
+            // Как в ESP-IDF: то же значение не пишется повторно
+            const uint8_t *entry = entryAt(it->second.page, it->second.entry);
+            size_t stored = variableLength(type) ? (entry[kDataOffset] | (entry[kDataOffset + 1] << 8)) : size;
+            const uint8_t *value = variableLength(type) ? entry + kEntrySize : entry + kDataOffset;
+            if (entry[1] == type && stored == size && memcmp(value, data, size) == 0) {
+                stats_.skipped++;
+                return true;
+            }
+        }
+
+        std::vector<uint8_t> buffer(span * kEntrySize, 0xFF);
+        buffer[0] = ns;
+        buffer[1] = static_cast<uint8_t>(type);
+        buffer[2] = static_cast<uint8_t>(span);
+        memset(&buffer[kKeyOffset], 0, kKeySize);
+        memcpy(&buffer[kKeyOffset], key, keyLen);
+        if (variableLength(type)) {
+            buffer[kDataOffset] = static_cast<uint8_t>(size);
+            buffer[kDataOffset + 1] = static_cast<uint8_t>(size >> 8);
+            if (size) memcpy(&buffer[kEntrySize], data, size);
+        } else {
+            memcpy(&buffer[kDataOffset], data, size);
+        }
+
+        if (!reserve(span)) return false;
+        Location location;
+        appendEntry(buffer.data(), span, &location);
+        // Старая запись могла переехать при сборке мусора: ищем заново
+        it = index_.find(k);
+        if (it != index_.end()) eraseEntry(it->second);
+        index_[k] = location;
+        return true;
+    }
+
+    const uint8_t *Partition::value(uint8_t ns, const char *key, ItemType type, size_t *size,
+                                    ItemType *found) {
+        if (!key) return nullptr;
+        ensureFlash();
+        std::unordered_map<std::string, Location>::const_iterator it = index_.find(indexKey(ns, key));
+        if (it == index_.end()) return nullptr;
+        const uint8_t *entry = entryAt(it->second.page, it->second.entry);
+        if (type != kAny && entry[1] != type) return nullptr;
+        if (found) *found = static_cast<ItemType>(entry[1]);
+        // Данные строки или массива лежат в следующих записях подряд
+        if (variableLength(entry[1])) {
+            if (size) *size = entry[kDataOffset] | (entry[kDataOffset + 1] << 8);
+            return entry + kEntrySize;
+        }
+        if (size) *size = entry[1] & 0x0F;
+        return entry + kDataOffset;
+    }
+
+    bool Partition::find(uint8_t ns, const char *key, ItemType type, size_t *size, ItemType *found) {
+        return value(ns, key, type, size, found) != nullptr;
+    }
+
+    size_t Partition::read(uint8_t ns, const char *key, ItemType type, void *data, size_t size) {
+        size_t stored = 0;
+        const uint8_t *bytes = value(ns, key, type, &stored);
+        if (!bytes) return 0;
+        memcpy(data, bytes, std::min(size, stored));
+        return stored;
+    }
+
+    bool Partition::erase(uint8_t ns, const char *key) {
+        if (!key) return false;
+        ensureFlash();
+        std::unordered_map<std::string, Location>::iterator it = index_.find(indexKey(ns, key));
+        if (it == index_.end()) return false;
+        eraseEntry(it->second);
+        index_.erase(it);
+        return true;
+    }
+
+    void Partition::eraseNamespace(uint8_t ns) {
+        ensureFlash();
+        for (std::unordered_map<std::string, Location>::iterator it = index_.begin(); it != index_.end();) {
+            if (static_cast<uint8_t>(it->first[0]) == ns) {
+                eraseEntry(it->second);
+                it = index_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    int Partition::openNamespace(const char *name, bool create) {
+        uint8_t ns = 0;
+        if (read(0, name, kU8, &ns, 1) == 1) return ns;
+        if (!create) return -1;
+        // Пространства имён — записи в нулевом пространстве: имя и номер
+        uint8_t last = 0;
+        for (std::unordered_map<std::string, Location>::const_iterator it = index_.begin(); it != index_.end(); ++it) {
+            if (it->first[0] != 0) continue;
+            last = std::max(last, entryAt(it->second.page, it->second.entry)[kDataOffset]);
+        }
+        if (last >= 254) return -1;
+        ns = static_cast<uint8_t>(last + 1);
+        return write(0, name, kU8, &ns, 1) ? ns : -1;
+    }
+
+    void Partition::format() {
+        size_t erased = flash_.empty() ? 0 : pages_.size();
+        flash_.clear();
+        ensureFlash();
+        stats_.erases += erased;
+    }
+
+    void Partition::remount() {
+        ensureFlash();
+        index_.clear();
+        next_seq_ = 0;
+        // Страницы по возрасту: более новая запись ключа перекрывает старую
+        std::vector<size_t> order;
+        for (size_t p = 0; p < pages_.size(); p++) {
+            Page &page = pages_[p];
+            memcpy(&page.state, &flash_[p * kPageSize], 4);
+            memcpy(&page.seq, &flash_[p * kPageSize + 4], 4);
+            page.next = 0;
+            page.erased = 0;
+            if (page.state == kPageEmpty) continue;
+            if (page.state == kPageFreeing) page.state = kPageFull;
+            for (size_t i = 0; i < kEntriesPerPage; i++) {
+                uint8_t state = entryState(p, i);
+                if (state != kEntryEmpty) page.next = i + 1;
+                if (state == kEntryErased) page.erased++;
+            }
+            next_seq_ = std::max(next_seq_, page.seq + 1);
+            order.push_back(p);
+        }
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return pages_[a].seq < pages_[b].seq;
+        });
+
+        bool active = false;
+        for (size_t n = 0; n < order.size(); n++) {
+            size_t p = order[n];
+            if (pages_[p].state == kPageActive) {
+                active_ = p;
+                active = true;
+            }
+            for (size_t i = 0; i < pages_[p].next;) {
+                const uint8_t *entry = entryAt(p, i);
+                size_t span = std::max<size_t>(entry[2], 1);
+                if (entryState(p, i) == kEntryWritten) {
+                    Location location = {static_cast<uint16_t>(p), static_cast<uint8_t>(i),
+                                         static_cast<uint8_t>(span)};
+                    std::string k = indexKey(entry[0], reinterpret_cast<const char *>(entry + kKeyOffset));
+                    std::unordered_map<std::string, Location>::iterator it = index_.find(k);
+                    if (it != index_.end()) eraseEntry(it->second);
+                    index_[k] = location;
+                }
+                i += span;
+            }
+        }
+        if (!active) {
+            for (size_t p = 0; p < pages_.size(); p++) {
+                if (pages_[p].state != kPageEmpty) continue;
+                active_ = p;
+                pages_[p].seq = next_seq_++;
+                setPageState(p, kPageActive);
+                break;
+            }
+        }
+    }
+
+    size_t Partition::freeEntries() {
+        ensureFlash();
+        size_t free = 0;
+        for (size_t i = 0; i < pages_.size(); i++) {
+            if (pages_[i].state == kPageEmpty || pages_[i].state == kPageActive) {
+                free += kEntriesPerPage - pages_[i].next;
+            }
+        }
+        return free > kEntriesPerPage ? free - kEntriesPerPage : 0;
+    }
+
+    size_t Partition::usedEntries() {
+        ensureFlash();
+        size_t used = 0;
+        for (size_t i = 0; i < pages_.size(); i++) used += pages_[i].next - pages_[i].erased;
+        return used;
+    }
+
+    const std::vector<uint8_t> &Partition::image() {
+        ensureFlash();
+        return flash_;
+    }
+
+    void Partition::load(const std::vector<uint8_t> &image) {
+        if (image.empty() || image.size() % kPageSize != 0) return;
+        flash_ = image;
+        pages_.resize(image.size() / kPageSize);
+        remount();
+    }
+
+    Partition &defaultPartition() {
+        static Partition partition;
+        return partition;
+    }
+
+} // namespace stub_nvs
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition_label) {
+    (void)partition_label;
+    end();
+    size_t len = name ? strlen(name) : 0;
+    if (len == 0 || len >= stub_nvs::Partition::kKeySize) return false;
+    stub_nvs::Partition &partition = stub_nvs::current();
+    int ns = partition.openNamespace(name, !readOnly);
+    if (ns < 0) return false;
+    partition_ = &partition;
+    ns_ = static_cast<uint8_t>(ns);
+    read_only_ = readOnly;
+    return true;
+}
+
+size_t Preferences::put(const char *key, stub_nvs::ItemType type, const void *data, size_t size) {
+    if (!partition_ || read_only_ || !key) return 0;
+    return partition_->write(ns_, key, type, data, size) ? size : 0;
+}
+
+size_t Preferences::putString(const char *key, const char *value) {
+    if (!value) return 0;
+    size_t len = strlen(value);
+    return put(key, stub_nvs::kStr, value, len + 1) ? len : 0;
+}
+
+bool Preferences::clear() {
+    if (!partition_ || read_only_) return false;
+    partition_->eraseNamespace(ns_);
+    return true;
+}
+
+bool Preferences::remove(const char *key) {
+    if (!partition_ || read_only_) return false;
+    return partition_->erase(ns_, key);
+}
+
+bool Preferences::isKey(const char *key) {
+    return partition_ && partition_->find(ns_, key, stub_nvs::kAny, nullptr);
+}
+
+PreferenceType Preferences::getType(const char *key) {
+    stub_nvs::ItemType type;
+    if (!partition_ || !partition_->find(ns_, key, stub_nvs::kAny, nullptr, &type)) return PT_INVALID;
+    switch (type) {
+        case stub_nvs::kI8: return PT_I8;
+        case stub_nvs::kU8: return PT_U8;
+        case stub_nvs::kI16: return PT_I16;
+        case stub_nvs::kU16: return PT_U16;
+        case stub_nvs::kI32: return PT_I32;
+        case stub_nvs::kU32: return PT_U32;
+        case stub_nvs::kI64: return PT_I64;
+        case stub_nvs::kU64: return PT_U64;
+        case stub_nvs::kStr: return PT_STR;
+        case stub_nvs::kBlob: return PT_BLOB;
+        default: return PT_INVALID;
+    }
+}
+
+size_t Preferences::freeEntries() {
+    return partition_ ? partition_->freeEntries() : 0;
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLen) {
+    size_t size = 0;
+    if (!partition_ || !value || !partition_->find(ns_, key, stub_nvs::kStr, &size) || size > maxLen) {
+        return 0;
+    }
+    partition_->read(ns_, key, stub_nvs::kStr, value, maxLen);
+    return size;
+}
+
+String Preferences::getString(const char *key, const String &defaultValue) {
+    size_t size = 0;
+    if (!partition_ || !partition_->find(ns_, key, stub_nvs::kStr, &size) || size == 0) {
+        return defaultValue;
+    }
+    std::vector<char> buffer(size);
+    partition_->read(ns_, key, stub_nvs::kStr, buffer.data(), size);
+    buffer[size - 1] = '\0';
+    return String(buffer.data());
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+    size_t size = 0;
+    if (!partition_ || !partition_->find(ns_, key, stub_nvs::kBlob, &size)) return 0;
+    return size;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+    size_t size = getBytesLength(key);
+    if (size == 0 || size > maxLen || !buf) return 0;
+    return partition_->read(ns_, key, stub_nvs::kBlob, buf, maxLen);
+}
@@ -0,0 +1,249 @@
+#ifndef PREFERENCES_STUB_H
+#define PREFERENCES_STUB_H
+
+// Preferences ядра ESP32 поверх модели раздела NVS.
+//
+// Раздел устроен как в ESP-IDF: страницы по 4096 байт, в странице
+// заголовок, битовая карта состояний и 126 записей по 32 байта. Запись
+// только дописывается в активную страницу; новое значение ключа — новая
+// запись, старая помечается стёртой. Число занимает одну запись, строка
+// и массив байт — запись-заголовок и ещё по записи на каждые 32 байта.
+// Когда свободных страниц не остаётся (одна всегда в запасе), самая
+// старая заполненная страница переносится: живые записи копируются в
+// запасную, а сама страница стирается. Число стираний — eraseCount():
+// по нему видно, во что обходится частое сохранение.
+//
+// Ключи ищутся по хеш-индексу в памяти, а не проходом по страницам;
+// remount() строит индекс заново по содержимому флеша, как после
+// перезагрузки. Запись того же значения, как в ESP-IDF, пропускается.
+//
+//   Preferences prefs;
+//   prefs.begin("calib");
+//   prefs.putFloat("offset", 0.25f);
+//   float offset = prefs.getFloat("offset", 0);
+//   stub_nvs::current().eraseCount();
+//
+// Упрощения: CRC записей не считаются, строка или массив байт должны
+// поместиться в одну страницу (до 4000 байт). Реализация —
+// preferences_stub.cpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "arduino_string_stub.h"
+
+namespace stub_nvs {
+
+    // Типы записей NVS
+    enum ItemType {
+        kU8 = 0x01, kI8 = 0x11, kU16 = 0x02, kI16 = 0x12,
+        kU32 = 0x04, kI32 = 0x14, kU64 = 0x08, kI64 = 0x18,
+        kStr = 0x21, kBlob = 0x41, kAny = 0xFF
+    };
+
+    class Partition {
+    public:
+        static const size_t kPageSize = 4096;
+        static const size_t kEntrySize = 32;
+        static const size_t kEntriesPerPage = 126;
+        static const size_t kKeySize = 16;           // 15 символов и ноль
+        static const size_t kDefaultPages = 5;       // Раздел nvs 0x5000 по умолчанию
+
+        struct Stats {
+            uint64_t erases;        // Стёртые страницы
+            uint64_t entries;       // Записи, записанные во флеш (с переносами)
+            uint64_t relocated;     // Из них перенесено при сборке мусора
+            uint64_t skipped;       // Запись пропущена: значение не изменилось
+
+            Stats() : erases(0), entries(0), relocated(0), skipped(0) {}
+        };
+
+        // Память под флеш выделяется при первом обращении
+        explicit Partition(size_t pages = kDefaultPages);
+
+        // Номер пространства имён; -1 — нет и create == false или некуда
+        int openNamespace(const char *name, bool create);
+
+        // false — ключ длиннее 15 символов, значение не влезает в страницу
+        // или в разделе нет места даже после сборки мусора
+        bool write(uint8_t ns, const char *key, ItemType type, const void *data, size_t size);
+
+        // Размер значения; type == kAny — любой тип; false — нет ключа
+        // или другой тип
+        bool find(uint8_t ns, const char *key, ItemType type, size_t *size, ItemType *found = nullptr);
+
+        // Копирует не больше size байт значения, возвращает его размер
+        size_t read(uint8_t ns, const char *key, ItemType type, void *data, size_t size);
+
+        // Значение прямо во флеше за один поиск; nullptr — как у find
+        const uint8_t *value(uint8_t ns, const char *key, ItemType type, size_t *size,
+                             ItemType *found = nullptr);
+
+        bool erase(uint8_t ns, const char *key);
+        void eraseNamespace(uint8_t ns);
+
+        // Стирает весь раздел
+        void format();
+
+        // Индекс заново по содержимому флеша, как после перезагрузки
+        void remount();
+
+        // Свободные записи без запасной страницы, как nvs_get_stats
+        size_t freeEntries();
+        size_t usedEntries();
+        size_t pageCount() const { return pages_.size(); }
+
+        uint64_t eraseCount() const { return stats_.erases; }
+        const Stats &stats() const { return stats_; }
+        void resetStats() { stats_ = Stats(); }
+
+        // Содержимое флеша: его можно сохранить и загрузить в другой раздел
+        const std::vector<uint8_t> &image();
+        void load(const std::vector<uint8_t> &image);
+
+    private:
+        struct Page {
+            uint32_t state;
+            uint32_t seq;
+            size_t next;        // Первая ещё не записанная запись
+            size_t erased;      // Стёртые записи
+        };
+
+        struct Location {
+            uint16_t page;
+            uint8_t entry;
+            uint8_t span;
+        };
+
+        void ensureFlash();
+        uint8_t *entryAt(size_t page, size_t entry);
+        void setEntryState(size_t page, size_t entry, uint8_t state);
+        uint8_t entryState(size_t page, size_t entry);
+        void setPageState(size_t page, uint32_t state);
+
+        // Место под span записей в активной странице, со сборкой мусора
+        bool reserve(size_t span);
+        bool nextActivePage();
+        bool collectGarbage();
+        void erasePage(size_t page);
+
+        void appendEntry(const uint8_t *entry, size_t span, Location *location);
+        void eraseEntry(const Location &location);
+
+        static std::string indexKey(uint8_t ns, const char *key);
+
+        std::vector<uint8_t> flash_;
+        std::vector<Page> pages_;
+        std::unordered_map<std::string, Location> index_;
+        size_t active_;
+        uint32_t next_seq_;
+        Stats stats_;
+    };
+
+    Partition &defaultPartition();
+
+    // Раздел потока; nullptr — раздел по умолчанию
+    inline Partition *&currentPtr() {
+        static thread_local Partition *partition = nullptr;
+        return partition;
+    }
+
+    inline Partition &current() {
+        Partition *partition = currentPtr();
+        return partition ? *partition : defaultPartition();
+    }
+
+} // namespace stub_nvs
+
+typedef enum {
+    PT_I8, PT_U8, PT_I16, PT_U16, PT_I32, PT_U32, PT_I64, PT_U64, PT_STR, PT_BLOB, PT_INVALID
+} PreferenceType;
+
+class Preferences {
+public:
+    Preferences() : partition_(nullptr), ns_(0), read_only_(false) {}
+    ~Preferences() { end(); }
+
+    // Пространство имён в разделе текущего потока (stub_nvs::current());
+    // partition_label не используется
+    bool begin(const char *name, bool readOnly = false, const char *partition_label = nullptr);
+    void end() { partition_ = nullptr; }
+
+    bool clear();
+    bool remove(const char *key);
+
+    size_t putChar(const char *key, int8_t value) { return put(key, stub_nvs::kI8, &value, 1); }
+    size_t putUChar(const char *key, uint8_t value) { return put(key, stub_nvs::kU8, &value, 1); }
+    size_t putShort(const char *key, int16_t value) { return put(key, stub_nvs::kI16, &value, 2); }
+    size_t putUShort(const char *key, uint16_t value) { return put(key, stub_nvs::kU16, &value, 2); }
+    size_t putInt(const char *key, int32_t value) { return put(key, stub_nvs::kI32, &value, 4); }
+    size_t putUInt(const char *key, uint32_t value) { return put(key, stub_nvs::kU32, &value, 4); }
+    size_t putLong(const char *key, int32_t value) { return putInt(key, value); }
+    size_t putULong(const char *key, uint32_t value) { return putUInt(key, value); }
+    size_t putLong64(const char *key, int64_t value) { return put(key, stub_nvs::kI64, &value, 8); }
+    size_t putULong64(const char *key, uint64_t value) { return put(key, stub_nvs::kU64, &value, 8); }
+    // Как в ядре: float и double хранятся массивом байт, bool — байтом
+    size_t putFloat(const char *key, float value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putDouble(const char *key, double value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putBool(const char *key, bool value) { return putUChar(key, value ? 1 : 0); }
+    size_t putString(const char *key, const char *value);
+    size_t putString(const char *key, const String &value) { return putString(key, value.c_str()); }
+    size_t putBytes(const char *key, const void *value, size_t len) {
+        return put(key, stub_nvs::kBlob, value, len);
+    }
+
+    bool isKey(const char *key);
+    PreferenceType getType(const char *key);
+    size_t freeEntries();
+
+    int8_t getChar(const char *key, int8_t defaultValue = 0) { return get(key, stub_nvs::kI8, defaultValue); }
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0) { return get(key, stub_nvs::kU8, defaultValue); }
+    int16_t getShort(const char *key, int16_t defaultValue = 0) { return get(key, stub_nvs::kI16, defaultValue); }
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0) { return get(key, stub_nvs::kU16, defaultValue); }
+    int32_t getInt(const char *key, int32_t defaultValue = 0) { return get(key, stub_nvs::kI32, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return get(key, stub_nvs::kU32, defaultValue); }
+    int32_t getLong(const char *key, int32_t defaultValue = 0) { return getInt(key, defaultValue); }
+    uint32_t getULong(const char *key, uint32_t defaultValue = 0) { return getUInt(key, defaultValue); }
+    int64_t getLong64(const char *key, int64_t defaultValue = 0) { return get(key, stub_nvs::kI64, defaultValue); }
+    uint64_t getULong64(const char *key, uint64_t defaultValue = 0) { return get(key, stub_nvs::kU64, defaultValue); }
+    float getFloat(const char *key, float defaultValue = std::numeric_limits<float>::quiet_NaN()) { return get(key, stub_nvs::kBlob, defaultValue); }
+    double getDouble(const char *key, double defaultValue = std::numeric_limits<double>::quiet_NaN()) { return get(key, stub_nvs::kBlob, defaultValue); }
+    bool getBool(const char *key, bool defaultValue = false) {
+        return getUChar(key, defaultValue ? 1 : 0) == 1;
+    }
+
+    // Размер строки вместе с нулём, как в ядре; 0 — нет ключа или не
+    // влезает в maxLen
+    size_t getString(const char *key, char *value, size_t maxLen);
+    String getString(const char *key, const String &defaultValue = String());
+
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+private:
+    Preferences(const Preferences &);
+    Preferences &operator=(const Preferences &);
+
+    size_t put(const char *key, stub_nvs::ItemType type, const void *data, size_t size);
+
+    // Значение фиксированного размера; другой тип или размер — defaultValue
+    template <typename T>
+    T get(const char *key, stub_nvs::ItemType type, T defaultValue) {
+        size_t size = 0;
+        const uint8_t *stored = partition_ ? partition_->value(ns_, key, type, &size) : nullptr;
+        if (!stored || size != sizeof(T)) return defaultValue;
+        T value;
+        memcpy(&value, stored, sizeof(T));
+        return value;
+    }
+
+    stub_nvs::Partition *partition_;
+    uint8_t ns_;
+    bool read_only_;
+};
+
+#endif // PREFERENCES_STUB_H
@@ -0,0 +1,103 @@
+#include "spi_stub.h"
+
+#include <algorithm>
+#include <cstring>
+#include "stub_board.h"
+
+SPIClass SPI;
+
+namespace stub_spi {
+
+    void Capture::exchange(const uint8_t *out, uint8_t *in, size_t len) {
+        // Сначала забираем MOSI: in может указывать на тот же буфер
+        data_.insert(data_.end(), out, out + len);
+        if (!in) {
+            response_pos_ = std::min(response_.size(), response_pos_ + len);
+            return;
+        }
+        size_t n = std::min(len, response_.size() - response_pos_);
+        memcpy(in, response_.data() + response_pos_, n);
+        memset(in + n, 0xFF, len - n);
+        response_pos_ += n;
+    }
+
+    void Capture::respond(const uint8_t *bytes, size_t len) {
+        response_.erase(response_.begin(), response_.begin() + response_pos_);
+        response_pos_ = 0;
+        response_.insert(response_.end(), bytes, bytes + len);
+    }
+
+    void Bus::attach(uint8_t csPin, Device *device) {
+        detach(csPin);
+        Slot slot = {csPin, device};
+        devices_.push_back(slot);
+    }
+
+    void Bus::detach(uint8_t csPin) {
+        for (size_t i = 0; i < devices_.size(); i++) {
+            if (devices_[i].pin != csPin) continue;
+            if (devices_[i].device == active_) active_ = nullptr;
+            devices_.erase(devices_.begin() + i);
+            return;
+        }
+    }
+
+    Device *Bus::selected() const {
+        const stub_board::Board &board = stub_board::current();
+        for (size_t i = 0; i < devices_.size(); i++) {
+            if (board.digital[devices_[i].pin] == 0) return devices_[i].device;
+        }
+        return nullptr;
+    }
+
+    void Bus::sync() {
+        Device *device = selected();
+        if (device == active_) return;
+        if (active_) active_->deselect();
+        active_ = device;
+        if (active_) active_->select();
+    }
+
+    void Bus::exchange(const uint8_t *out, uint8_t *in, size_t len, uint32_t clock) {
+        if (len == 0) return;
+        sync();
+        if (active_) {
+            active_->exchange(out, in, len);
+        } else {
+            if (in) memset(in, 0xFF, len);
+            stats_.idle_bytes += len;
+        }
+        charge(len, clock);
+    }
+
+    void Bus::charge(size_t bytes, uint32_t clock) {
+        if (clock == 0) clock = 4000000;
+        // Наносекунды копятся между обменами: байт на 40 МГц — 200 нс
+        pending_ns_ += static_cast<uint64_t>(bytes) * 8 * 1000000000ULL / clock;
+        uint64_t us = pending_ns_ / 1000;
+        pending_ns_ %= 1000;
+        stats_.transfers++;
+        stats_.bytes += bytes;
+        stats_.busy_us += us;
+        if (us) stub_board::advanceMicros(stub_board::current(), static_cast<unsigned long>(us));
+    }
+
+} // namespace stub_spi
+
+uint16_t SPIClass::transfer16(uint16_t data) {
+    uint8_t bytes[2];
+    bool msb = settings_.bitOrder == MSBFIRST;
+    bytes[msb ? 0 : 1] = static_cast<uint8_t>(data >> 8);
+    bytes[msb ? 1 : 0] = static_cast<uint8_t>(data);
+    bus_.exchange(bytes, bytes, 2, settings_.clock);
+    return msb ? static_cast<uint16_t>((bytes[0] << 8) | bytes[1])
+               : static_cast<uint16_t>((bytes[1] << 8) | bytes[0]);
+}
+
+void SPIClass::write16(uint16_t data) {
+    uint8_t bytes[2];
+    bool msb = settings_.bitOrder == MSBFIRST;
+    bytes[msb ? 0 : 1] = static_cast<uint8_t>(data >> 8);
+    bytes[msb ? 1 : 0] = static_cast<uint8_t>(data);
+    bus_.exchange(bytes, nullptr, 2, settings_.clock);
+}
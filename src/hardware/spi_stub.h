@@ -0,0 +1,203 @@
+#ifndef SPI_STUB_H
+#define SPI_STUB_H
+
+// SPI (SPIClass) поверх симулятора шины с моделями ведомых устройств.
+//
+// Модель подключается к пину CS; обмен получает то устройство, чей CS
+// скетч опустил в LOW через digitalWrite (уровни берутся с платы,
+// stub_board.h):
+//
+//   stub_spi::Capture display;                 // записывает всё, что пришло
+//   SPI.attach(5, &display);
+//
+//   SPI.beginTransaction(SPISettings(40000000, MSBFIRST, SPI_MODE0));
+//   digitalWrite(5, LOW);
+//   SPI.transfer(frame, sizeof(frame));        // кадр целиком, одним вызовом
+//   digitalWrite(5, HIGH);
+//   SPI.endTransaction();
+//
+// Буфер передаётся модели целиком указателем, без копии и без
+// виртуального вызова на байт: Capture складывает кадр в плоский
+// массив одним memcpy, так что сотни килобайт кадров идут со скоростью
+// памяти. Время обмена по частоте из SPISettings (8 тактов на байт)
+// добавляется к часам платы. Реализация — spi_stub.cpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef LSBFIRST
+#define LSBFIRST 0
+#endif
+#ifndef MSBFIRST
+#define MSBFIRST 1
+#endif
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+
+namespace stub_spi {
+
+    // Модель ведомого устройства
+    class Device {
+    public:
+        virtual ~Device() {}
+
+        // CS опущен / поднят
+        virtual void select() {}
+        virtual void deselect() {}
+
+        // Полнодуплексный обмен len байт: out — от мастера (MOSI), in —
+        // ответ (MISO). in может совпадать с out (transfer(buf, n) на
+        // месте) или быть nullptr, если ответ мастеру не нужен.
+        virtual void exchange(const uint8_t *out, uint8_t *in, size_t len) = 0;
+    };
+
+    // Записывает всё, что прислал мастер, в один массив и отвечает
+    // заранее заданными байтами (потом 0xFF)
+    class Capture : public Device {
+    public:
+        Capture() : response_pos_(0), selects_(0) {}
+
+        void select() override { selects_++; }
+        void exchange(const uint8_t *out, uint8_t *in, size_t len) override;
+
+        // Байты от мастера с последнего clear()
+        const std::vector<uint8_t> &data() const { return data_; }
+        void clear() { data_.clear(); }
+        void reserve(size_t bytes) { data_.reserve(bytes); }
+
+        // Ответ на следующие байты обмена
+        void respond(const uint8_t *bytes, size_t len);
+
+        // Сколько раз устройство выбирали
+        uint32_t selects() const { return selects_; }
+
+    private:
+        std::vector<uint8_t> data_;
+        std::vector<uint8_t> response_;
+        size_t response_pos_;
+        uint32_t selects_;
+    };
+
+    // Шина: устройства по пинам CS и учёт времени обмена
+    class Bus {
+    public:
+        struct Stats {
+            uint64_t transfers;     // Вызовы обмена
+            uint64_t bytes;
+            uint64_t idle_bytes;    // Обмен без выбранного устройства
+            uint64_t busy_us;       // Время на шине при текущих частотах
+
+            Stats() : transfers(0), bytes(0), idle_bytes(0), busy_us(0) {}
+        };
+
+        Bus() : active_(nullptr), pending_ns_(0) {}
+
+        // Устройство не принадлежит шине и должно жить, пока подключено
+        void attach(uint8_t csPin, Device *device);
+        void detach(uint8_t csPin);
+        size_t deviceCount() const { return devices_.size(); }
+
+        // Обмен с выбранным устройством; без него MISO читается как 0xFF
+        void exchange(const uint8_t *out, uint8_t *in, size_t len, uint32_t clock);
+
+        // Вызывает deselect(), если CS активного устройства уже поднят
+        void sync();
+
+        const Stats &stats() const { return stats_; }
+        void resetStats() { stats_ = Stats(); }
+
+    private:
+        struct Slot {
+            uint8_t pin;
+            Device *device;
+        };
+
+        // Устройство с CS в LOW; одновременно выбранным считается первое
+        Device *selected() const;
+        void charge(size_t bytes, uint32_t clock);
+
+        std::vector<Slot> devices_;   // Обычно их несколько, поиск — проход по массиву
+        Device *active_;
+        uint64_t pending_ns_;         // Доли микросекунды между обменами
+        Stats stats_;
+    };
+
+} // namespace stub_spi
+
+class SPISettings {
+public:
+    SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clockHz, uint8_t order, uint8_t mode)
+        : clock(clockHz), bitOrder(order), dataMode(mode) {}
+
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+class SPIClass {
+public:
+    SPIClass() : transaction_(false) {}
+
+    void begin() {}
+    void end() {}
+
+    void beginTransaction(const SPISettings &settings) {
+        settings_ = settings;
+        transaction_ = true;
+    }
+
+    void endTransaction() {
+        transaction_ = false;
+        bus_.sync();
+    }
+
+    // Настройки вне транзакции, как в старом API
+    void setBitOrder(uint8_t bitOrder) { settings_.bitOrder = bitOrder; }
+    void setDataMode(uint8_t dataMode) { settings_.dataMode = dataMode; }
+    void setFrequency(uint32_t hz) { settings_.clock = hz; }
+    const SPISettings &settings() const { return settings_; }
+    bool inTransaction() const { return transaction_; }
+
+    uint8_t transfer(uint8_t data) {
+        bus_.exchange(&data, &data, 1, settings_.clock);
+        return data;
+    }
+
+    // Старший байт первым при MSBFIRST, как в ядре AVR
+    uint16_t transfer16(uint16_t data);
+
+    // Обмен на месте: ответ устройства замещает buf
+    void transfer(void *buf, size_t count) {
+        uint8_t *bytes = static_cast<uint8_t *>(buf);
+        bus_.exchange(bytes, bytes, count, settings_.clock);
+    }
+
+    // Как в ядре ESP32: только запись и обмен в отдельный буфер
+    void write(uint8_t data) { bus_.exchange(&data, nullptr, 1, settings_.clock); }
+    void write16(uint16_t data);
+    void writeBytes(const uint8_t *data, size_t size) {
+        bus_.exchange(data, nullptr, size, settings_.clock);
+    }
+    void transferBytes(const uint8_t *data, uint8_t *out, size_t size) {
+        bus_.exchange(data, out, size, settings_.clock);
+    }
+
+    // Модели устройств на шине
+    void attach(uint8_t csPin, stub_spi::Device *device) { bus_.attach(csPin, device); }
+    void detach(uint8_t csPin) { bus_.detach(csPin); }
+    stub_spi::Bus &bus() { return bus_; }
+
+private:
+    stub_spi::Bus bus_;
+    SPISettings settings_;
+    bool transaction_;
+};
+
+extern SPIClass SPI;
+
+#endif // SPI_STUB_H
@@ -0,0 +1,225 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+// Арена для временных String.
+//
+// Пока в потоке открыт StringArenaFrame, память под данные String берётся
+// из блоков кадра сдвигом указателя, а delete ничего не делает. Когда кадр
+// закрывается, его блоки целиком возвращаются в пул потока и достаются
+// следующему кадру, так что цикл вида
+//
+//   void loop() {
+//     StringArenaFrame frame;
+//     String cmd = line.substring(0, 4) + String(value);
+//     ...
+//   }
+//
+// после первой итерации не обращается к системной куче вовсе.
+//
+// Строка может пережить кадр (например, сохранена в глобальной
+// переменной): блок с живыми строками не переиспользуется и
+// освобождается, когда уйдёт последняя из них. Кадры вкладываются,
+// строки берут память из самого внутреннего. Без кадра String ведёт
+// себя как обычно.
+//
+// Строка из кадра должна освобождаться в том же потоке.
+
+#include <cstddef>
+#include <new>
+#include "stub_counters.h"
+#include "stub_trace.h"
+
+namespace string_arena {
+
+    static const size_t kAlign = 16;
+    static const size_t kDefaultChunkSize = 64 * 1024;
+    static const size_t kMaxPooledChunks = 8;
+
+    inline size_t alignUp(size_t n) { return (n + kAlign - 1) & ~(kAlign - 1); }
+
+    struct Chunk {
+        Chunk *next;      // Следующий блок кадра или пула
+        size_t size;      // Размер области данных
+        size_t used;
+        size_t live;      // Неосвобождённые выделения
+        bool detached;    // Кадр закрыт, блок ждёт последнюю строку
+
+        char *data() { return reinterpret_cast<char *>(this) + alignUp(sizeof(Chunk)); }
+
+        static Chunk *create(size_t size) {
+            Chunk *chunk = static_cast<Chunk *>(::operator new(alignUp(sizeof(Chunk)) + size));
+            chunk->next = nullptr;
+            chunk->size = size;
+            chunk->used = 0;
+            chunk->live = 0;
+            chunk->detached = false;
+            return chunk;
+        }
+    };
+
+    // Заголовок перед каждым выделением: откуда взята память
+    struct Header {
+        Chunk *chunk;     // nullptr — системная куча
+        size_t reserved;
+    };
+
+    class Frame;
+
+    struct ThreadState {
+        Frame *frame;
+        Chunk *pool;
+        size_t pooled;
+
+        ThreadState() : frame(nullptr), pool(nullptr), pooled(0) {}
+        ~ThreadState() {
+            while (pool) {
+                Chunk *next = pool->next;
+                ::operator delete(pool);
+                pool = next;
+            }
+        }
+
+        Chunk *take(size_t size) {
+            if (pool && pool->size >= size) {
+                Chunk *chunk = pool;
+                pool = chunk->next;
+                pooled--;
+                chunk->next = nullptr;
+                return chunk;
+            }
+            return Chunk::create(size);
+        }
+
+        void recycle(Chunk *chunk) {
+            if (chunk->size == kDefaultChunkSize && pooled < kMaxPooledChunks) {
+                chunk->used = 0;
+                chunk->next = pool;
+                pool = chunk;
+                pooled++;
+            } else {
+                ::operator delete(chunk);
+            }
+        }
+    };
+
+    inline ThreadState &state() {
+        static thread_local ThreadState s;
+        return s;
+    }
+
+    class Frame {
+    public:
+        explicit Frame(size_t chunkSize = kDefaultChunkSize)
+            : prev_(state().frame), chunks_(nullptr), chunk_size_(chunkSize),
+              allocations_(0), bytes_(0) {
+            state().frame = this;
+        }
+
+        ~Frame() {
+            ThreadState &st = state();
+            st.frame = prev_;
+            while (chunks_) {
+                Chunk *next = chunks_->next;
+                if (chunks_->live == 0) {
+                    st.recycle(chunks_);
+                } else {
+                    chunks_->detached = true;
+                }
+                chunks_ = next;
+            }
+        }
+
+        void *allocate(size_t n) {
+            size_t total = alignUp(sizeof(Header) + n);
+            if (!chunks_ || chunks_->used + total > chunks_->size) {
+                size_t size = total > chunk_size_ ? total : chunk_size_;
+                Chunk *chunk = state().take(size);
+                chunk->next = chunks_;
+                chunks_ = chunk;
+            }
+            Header *header = reinterpret_cast<Header *>(chunks_->data() + chunks_->used);
+            header->chunk = chunks_;
+            chunks_->used += total;
+            chunks_->live++;
+            allocations_++;
+            bytes_ += n;
+            return header + 1;
+        }
+
+        // Сколько выделений и байт строк обслужил кадр
+        size_t allocations() const { return allocations_; }
+        size_t bytes() const { return bytes_; }
+
+        static Frame *current() { return state().frame; }
+
+    private:
+        Frame *prev_;
+        Chunk *chunks_;
+        size_t chunk_size_;
+        size_t allocations_;
+        size_t bytes_;
+
+        Frame(const Frame &);
+        Frame &operator=(const Frame &);
+    };
+
+    inline void *allocate(size_t n) {
+        Frame *frame = state().frame;
+        if (frame) return frame->allocate(n);
+        Header *header = static_cast<Header *>(::operator new(sizeof(Header) + n));
+        header->chunk = nullptr;
+        return header + 1;
+    }
+
+    inline void deallocate(void *p) {
+        Header *header = static_cast<Header *>(p) - 1;
+        Chunk *chunk = header->chunk;
+        if (!chunk) {
+            ::operator delete(header);
+            return;
+        }
+        chunk->live--;
+        if (chunk->detached && chunk->live == 0) {
+            ::operator delete(chunk);
+        }
+    }
+
+} // namespace string_arena
+
+typedef string_arena::Frame StringArenaFrame;
+
+// Аллокатор данных String: кадр арены, если он открыт, иначе куча
+template <typename T>
+struct StringAllocator {
+    typedef T value_type;
+
+    StringAllocator() {}
+    template <typename U>
+    StringAllocator(const StringAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        stub_counters::stringAlloc(n * sizeof(T));
+        stub_trace::instant(stub_trace::kStringAlloc, n * sizeof(T),
+                            string_arena::Frame::current() != nullptr);
+        return static_cast<T *>(string_arena::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t) { string_arena::deallocate(p); }
+
+    template <typename U>
+    struct rebind {
+        typedef StringAllocator<U> other;
+    };
+};
+
+template <typename T, typename U>
+inline bool operator==(const StringAllocator<T> &, const StringAllocator<U> &) {
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const StringAllocator<T> &, const StringAllocator<U> &) {
+    return false;
+}
+
+#endif // STRING_ARENA_H
@@ -0,0 +1,158 @@
+#ifndef STRING_HASH_H
+#define STRING_HASH_H
+
+// Хеш String для unordered_map и поиск без временных строк.
+//
+// std::hash<String> считает хеш по требованию: по 8 байт за шаг с
+// умножением 64x64 -> 128 (схема wyhash), без прохода по байту.
+//
+// StringKey — ключ со строкой и уже посчитанным хешем. В
+// std::unordered_map<StringKey, V> хеш считается один раз при вставке, а
+// искать можно по StringKey::ref("topic") — ключу, который ссылается на
+// чужие байты: ни копии строки, ни выделения памяти. Копия StringKey
+// всегда владеет своей строкой, поэтому ссылочный ключ не попадёт в
+// таблицу. Один ref с посчитанным хешем можно искать в нескольких
+// таблицах подряд.
+//
+//   std::unordered_map<string_hash::StringKey, Handler> routes;
+//   routes["/api/state"] = handleState;
+//   routes.find(string_hash::StringKey::ref(path));
+//
+// string_hash::Hash и string_hash::Equal прозрачны (is_transparent): в
+// сборке C++20 std::unordered_map<String, V, Hash, Equal>::find("...")
+// ищет по const char* без временного String. В C++11, на котором собраны
+// заглушки, гетерогенного поиска в стандартных таблицах нет — для него
+// и нужен StringKey::ref.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "arduino_string_stub.h"
+
+namespace string_hash {
+
+    inline uint64_t mix(uint64_t a, uint64_t b) {
+        __uint128_t product = static_cast<__uint128_t>(a) * b;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+    }
+
+    inline size_t hashBytes(const char *data, size_t len) {
+        const uint64_t k0 = 0xa0761d6478bd642fULL;
+        const uint64_t k1 = 0xe7037ed1a0b428dbULL;
+        const uint64_t k2 = 0x8ebc6af09c88c6e3ULL;
+        uint64_t h = k0 ^ len;
+        for (; len >= 8; data += 8, len -= 8) {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            h = mix(h ^ word, k1);
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, data, len);
+        return static_cast<size_t>(mix(h ^ tail, k2));
+    }
+
+    inline size_t hashBytes(const char *str) { return hashBytes(str, strlen(str)); }
+
+    class StringKey {
+    public:
+        StringKey() : data_(nullptr), len_(0), hash_(hashBytes("", 0)) {}
+
+        StringKey(const String &str)
+            : owned_(str), data_(nullptr), len_(str.length()), hash_(hashBytes(str.c_str(), len_)) {}
+
+        StringKey(const char *str)
+            : owned_(str), data_(nullptr), len_(owned_.length()), hash_(hashBytes(owned_.c_str(), len_)) {}
+
+        // Копия владеет строкой, даже если other — ссылочный ключ
+        StringKey(const StringKey &other)
+            : owned_(other.owned()), data_(nullptr), len_(other.len_), hash_(other.hash_) {}
+
+        StringKey &operator=(const StringKey &other) {
+            if (this != &other) {
+                owned_ = other.owned();
+                data_ = nullptr;
+                len_ = other.len_;
+                hash_ = other.hash_;
+            }
+            return *this;
+        }
+
+        // Ключ для поиска: ссылается на data, пока тот жив
+        static StringKey ref(const char *data, size_t len) { return StringKey(data, len); }
+        static StringKey ref(const char *str) { return StringKey(str, strlen(str)); }
+        static StringKey ref(const String &str) { return StringKey(str.c_str(), str.length()); }
+
+        const char *data() const { return data_ ? data_ : owned_.c_str(); }
+        size_t length() const { return len_; }
+        size_t hash() const { return hash_; }
+        String toString() const { return owned(); }
+
+        bool operator==(const StringKey &other) const {
+            return hash_ == other.hash_ && len_ == other.len_ && memcmp(data(), other.data(), len_) == 0;
+        }
+
+        bool operator!=(const StringKey &other) const { return !(*this == other); }
+
+    private:
+        StringKey(const char *data, size_t len) : data_(data), len_(len), hash_(hashBytes(data, len)) {}
+
+        String owned() const {
+            if (!data_) return owned_;
+            String copy;
+            copy.concat(data_, static_cast<unsigned int>(len_));
+            return copy;
+        }
+
+        String owned_;
+        const char *data_;   // Не nullptr — ссылочный ключ
+        size_t len_;
+        size_t hash_;
+    };
+
+    // Байты и длина любого вида строки
+    inline const char *bytes(const String &s) { return s.c_str(); }
+    inline const char *bytes(const char *s) { return s; }
+    inline const char *bytes(const std::string &s) { return s.data(); }
+    inline const char *bytes(const StringKey &s) { return s.data(); }
+    inline size_t size(const String &s) { return s.length(); }
+    inline size_t size(const char *s) { return strlen(s); }
+    inline size_t size(const std::string &s) { return s.size(); }
+    inline size_t size(const StringKey &s) { return s.length(); }
+
+    struct Hash {
+        typedef void is_transparent;
+
+        size_t operator()(const String &s) const { return hashBytes(s.c_str(), s.length()); }
+        size_t operator()(const char *s) const { return hashBytes(s); }
+        size_t operator()(const std::string &s) const { return hashBytes(s.data(), s.size()); }
+        size_t operator()(const StringKey &s) const { return s.hash(); }
+    };
+
+    struct Equal {
+        typedef void is_transparent;
+
+        template <typename A, typename B>
+        bool operator()(const A &a, const B &b) const {
+            size_t len = size(a);
+            return len == size(b) && memcmp(bytes(a), bytes(b), len) == 0;
+        }
+    };
+
+} // namespace string_hash
+
+namespace std {
+
+    template <>
+    struct hash<String> {
+        size_t operator()(const String &s) const { return string_hash::hashBytes(s.c_str(), s.length()); }
+    };
+
+    template <>
+    struct hash<string_hash::StringKey> {
+        size_t operator()(const string_hash::StringKey &key) const { return key.hash(); }
+    };
+
+} // namespace std
+
+#endif // STRING_HASH_H
@@ -0,0 +1,136 @@
+#ifndef STRING_NUMBER_H
+#define STRING_NUMBER_H
+
+// Разбор чисел для String::toInt/toFloat/toDouble без strtol/strtod.
+//
+// Семантика как у Arduino (atol/atof): пробелы в начале пропускаются,
+// разбор останавливается на первом недопустимом символе, пустая или
+// нечисловая строка даёт 0. strtol/strtod при этом обращаются к локали и
+// errno, что заметно на коротких полях вроде "23.5".
+//
+// Результат совпадает со strtol/strtod/strtof бит в бит:
+//   - целое больше 18 цифр (возможное переполнение) разбирает strtol
+//   - дробное число считается точно, если мантисса помещается в
+//     double (float) без потерь, а степень 10 не больше 22 (10): тогда
+//     одно умножение или деление даёт правильно округлённый результат
+//     (быстрый путь Клингера). Всё остальное, а также hex, inf и nan,
+//     разбирает strtod/strtof.
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace string_number {
+
+    inline bool isSpace(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    inline long parseLong(const char *s) {
+        const char *p = s;
+        while (isSpace(*p)) p++;
+        bool negative = false;
+        if (*p == '-' || *p == '+') negative = *p++ == '-';
+        while (*p == '0') p++;
+        unsigned long value = 0;
+        int digits = 0;
+        for (; isDigit(*p); p++, digits++) {
+            if (digits == 18) return std::strtol(s, nullptr, 10);
+            value = value * 10 + static_cast<unsigned long>(*p - '0');
+        }
+        return negative ? -static_cast<long>(value) : static_cast<long>(value);
+    }
+
+    // Десятичная запись: мантисса и показатель степени 10
+    struct Decimal {
+        uint64_t mantissa;
+        int exponent;
+        bool negative;
+        bool exact;      // Мантисса не обрезана, показатель в разумных пределах
+    };
+
+    // Возвращает false, если запись не десятичная (hex, inf, nan)
+    inline bool parseDecimal(const char *s, Decimal &d) {
+        const char *p = s;
+        while (isSpace(*p)) p++;
+        d.negative = false;
+        if (*p == '-' || *p == '+') d.negative = *p++ == '-';
+        d.mantissa = 0;
+        d.exponent = 0;
+        d.exact = true;
+        if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) return false;
+        if (!isDigit(*p) && !(*p == '.' && isDigit(p[1]))) {
+            // Не число даёт +0, даже после '-'; "inf" и "nan" разбирает strtod
+            d.negative = false;
+            return *p != 'i' && *p != 'I' && *p != 'n' && *p != 'N';
+        }
+
+        int digits = 0;
+        while (*p == '0') p++;
+        for (; isDigit(*p); p++) {
+            if (digits < 19) {
+                d.mantissa = d.mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                if (d.mantissa) digits++;
+            } else {
+                d.exact = false;
+            }
+        }
+        if (*p == '.') {
+            p++;
+            for (; isDigit(*p); p++) {
+                if (digits < 19) {
+                    d.mantissa = d.mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    d.exponent--;
+                    if (d.mantissa) digits++;
+                } else {
+                    d.exact = false;
+                }
+            }
+        }
+        if ((*p == 'e' || *p == 'E') &&
+            (isDigit(p[1]) || ((p[1] == '-' || p[1] == '+') && isDigit(p[2])))) {
+            p++;
+            bool negative = false;
+            if (*p == '-' || *p == '+') negative = *p++ == '-';
+            int exponent = 0;
+            for (; isDigit(*p); p++) {
+                if (exponent < 100000) exponent = exponent * 10 + (*p - '0');
+            }
+            d.exponent += negative ? -exponent : exponent;
+        }
+        return true;
+    }
+
+    inline double parseDouble(const char *s) {
+        static const double kPow10[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        Decimal d;
+        if (!parseDecimal(s, d)) return std::strtod(s, nullptr);
+        if (d.exact && d.mantissa == 0) return d.negative ? -0.0 : 0.0;
+        if (!d.exact || d.mantissa > (1ULL << 53) || d.exponent < -22 || d.exponent > 22) {
+            return std::strtod(s, nullptr);
+        }
+        double value = static_cast<double>(d.mantissa);
+        value = d.exponent < 0 ? value / kPow10[-d.exponent] : value * kPow10[d.exponent];
+        return d.negative ? -value : value;
+    }
+
+    inline float parseFloat(const char *s) {
+        static const float kPow10[] = {
+            1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+        Decimal d;
+        if (!parseDecimal(s, d)) return std::strtof(s, nullptr);
+        if (d.exact && d.mantissa == 0) return d.negative ? -0.0f : 0.0f;
+        if (!d.exact || d.mantissa > (1ULL << 24) || d.exponent < -10 || d.exponent > 10) {
+            return std::strtof(s, nullptr);
+        }
+        float value = static_cast<float>(d.mantissa);
+        value = d.exponent < 0 ? value / kPow10[-d.exponent] : value * kPow10[d.exponent];
+        return d.negative ? -value : value;
+    }
+
+} // namespace string_number
+
+#endif // STRING_NUMBER_H
@@ -0,0 +1,58 @@
+#ifndef STUB_BOARD_H
+#define STUB_BOARD_H
+
+// Состояние платы, которое читают функции arduino_compat.h: часы
+// millis(), уровни пинов, значения analogRead и EEPROM.
+//
+// Без устройств (stub_device.h) все потоки работают с одной платой по
+// умолчанию, как раньше со статическим счётчиком в millis(). Устройство
+// подставляет свою плату в поток на время работы скетча.
+
+#include <cstdint>
+#include <cstring>
+
+namespace stub_board {
+
+    static const int kPins = 256;          // Любой uint8_t пин без проверки границ
+    static const size_t kEepromSize = 1024;
+
+    struct Board {
+        unsigned long clock;                // Последнее значение millis()
+        unsigned long micros;               // Доли миллисекунды (время шин)
+        uint8_t digital[kPins];             // digitalWrite / digitalRead
+        int analog[kPins];                  // analogRead, задаётся тестом
+        uint8_t eeprom[kEepromSize];        // Стёртая EEPROM читается как 0xFF
+
+        Board() : clock(0), micros(0) {
+            memset(digital, 0, sizeof(digital));
+            memset(analog, 0, sizeof(analog));
+            memset(eeprom, 0xFF, sizeof(eeprom));
+        }
+    };
+
+    inline Board &defaultBoard() {
+        static Board board;
+        return board;
+    }
+
+    // Плата потока; nullptr — плата по умолчанию
+    inline Board *&currentPtr() {
+        static thread_local Board *board = nullptr;
+        return board;
+    }
+
+    inline Board &current() {
+        Board *board = currentPtr();
+        return board ? *board : defaultBoard();
+    }
+
+    // Время, которое скетч провёл в обмене по шине (Wire, SPI)
+    inline void advanceMicros(Board &board, unsigned long us) {
+        board.micros += us;
+        board.clock += board.micros / 1000;
+        board.micros %= 1000;
+    }
+
+} // namespace stub_board
+
+#endif // STUB_BOARD_H
@@ -0,0 +1,33 @@
+#include "stub_counters.h"
+
+#include <ostream>
+
+namespace stub_counters {
+
+    void Snapshot::dump(std::ostream &os) const {
+        os << "Stub counters" << (kEnabled ? "" : " (disabled, build with -DARDUINOSTUB_COUNTERS)")
+           << std::endl;
+        for (size_t i = 0; i < port_names.size(); i++) {
+            const SerialStats &s = serial[i];
+            if (!s.writes && !s.reads) continue;
+            os << "  serial " << port_names[i] << ": written " << s.bytes_written
+               << " bytes in " << s.writes << " writes, read " << s.bytes_read
+               << " bytes in " << s.reads << " reads" << std::endl;
+        }
+        os << "  string: " << string.allocations << " allocations, "
+           << string.bytes_allocated << " bytes; " << string.copies << " copies, "
+           << string.bytes_copied << " bytes" << std::endl;
+        os << "  littlefs: " << littlefs.opens << " opens, " << littlefs.syscalls
+           << " syscalls, read " << littlefs.bytes_read << ", written "
+           << littlefs.bytes_written << " bytes" << std::endl;
+        for (std::map<std::string, FsStats>::const_iterator it = paths.begin();
+             it != paths.end(); ++it) {
+            const FsStats &p = it->second;
+            os << "    /" << it->first << ": opens " << p.opens << ", syscalls "
+               << p.syscalls << ", read " << p.bytes_read << " (" << p.reads
+               << "), written " << p.bytes_written << " (" << p.writes << ")"
+               << std::endl;
+        }
+    }
+
+} // namespace stub_counters
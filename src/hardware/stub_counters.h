@@ -0,0 +1,404 @@
+#ifndef STUB_COUNTERS_H
+#define STUB_COUNTERS_H
+
+// Счётчики горячих путей заглушек: сколько байт прошло через каждый порт
+// FakeSerial, сколько выделений и копирований сделали String, сколько
+// открытий, системных вызовов и байт пришлось на каждый путь LittleFS.
+//
+// Включаются при компиляции: -DARDUINOSTUB_COUNTERS. Без флага функции
+// учёта пустые и исчезают при встраивании, snapshot() возвращает нули.
+//
+// Каждый поток пишет в свой блок счётчиков без блокировок; блоки
+// выровнены по строке кэша, чтобы потоки не делили строки. snapshot()
+// суммирует блоки всех потоков, включая уже завершившиеся:
+//
+//   stub_counters::Snapshot s = stub_counters::snapshot();
+//   s.dump(std::cout);
+//
+// Счётчики открытого файла LittleFS идут по пути, с которым он открыт,
+// в блок потока, выполнившего операцию.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <iosfwd>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace stub_counters {
+
+#ifdef ARDUINOSTUB_COUNTERS
+    static const bool kEnabled = true;
+#else
+    static const bool kEnabled = false;
+#endif
+
+    static const size_t kCacheLine = 64;
+    static const int kMaxSerialPorts = 8;
+
+    // Значения счётчиков для snapshot()
+    struct SerialStats {
+        uint64_t writes;
+        uint64_t bytes_written;
+        uint64_t reads;
+        uint64_t bytes_read;
+    };
+
+    struct StringStats {
+        uint64_t allocations;
+        uint64_t bytes_allocated;
+        uint64_t copies;
+        uint64_t bytes_copied;
+    };
+
+    struct FsStats {
+        uint64_t opens;
+        uint64_t syscalls;
+        uint64_t reads;
+        uint64_t bytes_read;
+        uint64_t writes;
+        uint64_t bytes_written;
+    };
+
+    // Счётчик, который пишет только поток-владелец. Сложение без
+    // атомарной операции чтения-записи, но читать можно из любого потока.
+    class Counter {
+    public:
+        Counter() : value_(0) {}
+        void add(uint64_t n) {
+            value_.store(value_.load(std::memory_order_relaxed) + n,
+                         std::memory_order_relaxed);
+        }
+        uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+        void clear() { value_.store(0, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value_;
+    };
+
+    struct alignas(kCacheLine) SerialCounters {
+        Counter writes, bytes_written, reads, bytes_read;
+
+        void addTo(SerialStats &s) const {
+            s.writes += writes.get();
+            s.bytes_written += bytes_written.get();
+            s.reads += reads.get();
+            s.bytes_read += bytes_read.get();
+        }
+        void clear() {
+            writes.clear();
+            bytes_written.clear();
+            reads.clear();
+            bytes_read.clear();
+        }
+    };
+
+    struct alignas(kCacheLine) StringCounters {
+        Counter allocations, bytes_allocated, copies, bytes_copied;
+
+        void addTo(StringStats &s) const {
+            s.allocations += allocations.get();
+            s.bytes_allocated += bytes_allocated.get();
+            s.copies += copies.get();
+            s.bytes_copied += bytes_copied.get();
+        }
+        void clear() {
+            allocations.clear();
+            bytes_allocated.clear();
+            copies.clear();
+            bytes_copied.clear();
+        }
+    };
+
+    struct alignas(kCacheLine) FsCounters {
+        Counter opens, syscalls, reads, bytes_read, writes, bytes_written;
+
+        void addTo(FsStats &s) const {
+            s.opens += opens.get();
+            s.syscalls += syscalls.get();
+            s.reads += reads.get();
+            s.bytes_read += bytes_read.get();
+            s.writes += writes.get();
+            s.bytes_written += bytes_written.get();
+        }
+        void clear() {
+            opens.clear();
+            syscalls.clear();
+            reads.clear();
+            bytes_read.clear();
+            writes.clear();
+            bytes_written.clear();
+        }
+    };
+
+    struct Snapshot {
+        std::vector<std::string> port_names;
+        SerialStats serial[kMaxSerialPorts];
+        StringStats string;
+        FsStats littlefs;                        // Все пути вместе
+        std::map<std::string, FsStats> paths;    // Путь тома ("" — корень)
+
+        Snapshot() : serial(), string(), littlefs() {}
+
+        void dump(std::ostream &os) const;
+    };
+
+    // Блок счётчиков одного потока
+    class ThreadCounters {
+    public:
+        SerialCounters serial[kMaxSerialPorts];
+        StringCounters string;
+        FsCounters littlefs;
+
+        ThreadCounters();
+        ~ThreadCounters();
+
+        // Счётчики пути; последний путь запоминается, повторные операции
+        // с одним файлом обходятся без поиска в таблице
+        FsCounters &path(const std::string &rel) {
+            if (last_ && *last_key_ == rel) return *last_;
+            std::unordered_map<std::string, FsCounters>::iterator it = paths_.find(rel);
+            if (it == paths_.end()) {
+                std::lock_guard<std::mutex> lock(paths_mutex_);
+                it = paths_.emplace(std::piecewise_construct, std::forward_as_tuple(rel),
+                                    std::forward_as_tuple()).first;
+            }
+            last_key_ = &it->first;
+            last_ = &it->second;
+            return *last_;
+        }
+
+        void addTo(Snapshot &s) {
+            for (int i = 0; i < kMaxSerialPorts; i++) serial[i].addTo(s.serial[i]);
+            string.addTo(s.string);
+            littlefs.addTo(s.littlefs);
+            std::lock_guard<std::mutex> lock(paths_mutex_);
+            for (std::unordered_map<std::string, FsCounters>::const_iterator it = paths_.begin();
+                 it != paths_.end(); ++it) {
+                it->second.addTo(s.paths[it->first]);
+            }
+        }
+
+        void clear() {
+            for (int i = 0; i < kMaxSerialPorts; i++) serial[i].clear();
+            string.clear();
+            littlefs.clear();
+            std::lock_guard<std::mutex> lock(paths_mutex_);
+            for (std::unordered_map<std::string, FsCounters>::iterator it = paths_.begin();
+                 it != paths_.end(); ++it) {
+                it->second.clear();
+            }
+        }
+
+    private:
+        // Вставляет только владелец под мьютексом; snapshot() читает под ним же
+        std::unordered_map<std::string, FsCounters> paths_;
+        std::mutex paths_mutex_;
+        const std::string *last_key_;
+        FsCounters *last_;
+    };
+
+    // Список живых потоков и итоги завершившихся
+    class Registry {
+    public:
+        static Registry &instance() {
+            // Не уничтожается: потоки могут завершаться после main()
+            static Registry *registry = new Registry();
+            return *registry;
+        }
+
+        // Номер порта для счётчиков. Без имени порты называются Serial,
+        // Serial1, Serial2...; лишние порты делят последний номер.
+        int registerPort(const std::string &name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (port_names_.size() >= static_cast<size_t>(kMaxSerialPorts)) {
+                return kMaxSerialPorts - 1;
+            }
+            int port = static_cast<int>(port_names_.size());
+            if (!name.empty()) {
+                port_names_.push_back(name);
+            } else {
+                port_names_.push_back(port == 0 ? std::string("Serial")
+                                                : "Serial" + std::to_string(port));
+            }
+            return port;
+        }
+
+        void renamePort(int port, const std::string &name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (port >= 0 && static_cast<size_t>(port) < port_names_.size()) {
+                port_names_[port] = name;
+            }
+        }
+
+        void add(ThreadCounters *t) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threads_.push_back(t);
+        }
+
+        void remove(ThreadCounters *t) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            t->addTo(retired_);
+            for (size_t i = 0; i < threads_.size(); i++) {
+                if (threads_[i] == t) {
+                    threads_.erase(threads_.begin() + i);
+                    break;
+                }
+            }
+        }
+
+        Snapshot snapshot() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Snapshot s = retired_;
+            for (size_t i = 0; i < threads_.size(); i++) threads_[i]->addTo(s);
+            s.port_names = port_names_;
+            return s;
+        }
+
+        // Обнуляет счётчики; точно только когда остальные потоки стоят
+        void reset() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            retired_ = Snapshot();
+            for (size_t i = 0; i < threads_.size(); i++) threads_[i]->clear();
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<ThreadCounters *> threads_;
+        std::vector<std::string> port_names_;
+        Snapshot retired_;
+    };
+
+    inline ThreadCounters::ThreadCounters() : last_key_(nullptr), last_(nullptr) {
+        Registry::instance().add(this);
+    }
+
+    inline ThreadCounters::~ThreadCounters() { Registry::instance().remove(this); }
+
+    inline ThreadCounters &local() {
+        static thread_local ThreadCounters counters;
+        return counters;
+    }
+
+    inline Snapshot snapshot() { return Registry::instance().snapshot(); }
+    inline void reset() { Registry::instance().reset(); }
+
+    // Точки учёта. Без ARDUINOSTUB_COUNTERS тела пустые.
+
+    inline int registerPort(const std::string &name = std::string()) {
+        return Registry::instance().registerPort(name);
+    }
+
+    inline void renamePort(int port, const std::string &name) {
+        Registry::instance().renamePort(port, name);
+    }
+
+    inline void serialWrite(int port, size_t bytes) {
+#ifdef ARDUINOSTUB_COUNTERS
+        SerialCounters &c = local().serial[port];
+        c.writes.add(1);
+        c.bytes_written.add(bytes);
+#else
+        (void)port;
+        (void)bytes;
+#endif
+    }
+
+    inline void serialRead(int port, size_t bytes) {
+#ifdef ARDUINOSTUB_COUNTERS
+        SerialCounters &c = local().serial[port];
+        c.reads.add(1);
+        c.bytes_read.add(bytes);
+#else
+        (void)port;
+        (void)bytes;
+#endif
+    }
+
+    inline void stringAlloc(size_t bytes) {
+#ifdef ARDUINOSTUB_COUNTERS
+        StringCounters &c = local().string;
+        c.allocations.add(1);
+        c.bytes_allocated.add(bytes);
+#else
+        (void)bytes;
+#endif
+    }
+
+    inline void stringCopy(size_t bytes) {
+#ifdef ARDUINOSTUB_COUNTERS
+        StringCounters &c = local().string;
+        c.copies.add(1);
+        c.bytes_copied.add(bytes);
+#else
+        (void)bytes;
+#endif
+    }
+
+    inline void fsOpen(const std::string &rel) {
+#ifdef ARDUINOSTUB_COUNTERS
+        ThreadCounters &t = local();
+        t.littlefs.opens.add(1);
+        t.path(rel).opens.add(1);
+#else
+        (void)rel;
+#endif
+    }
+
+    // Системные вызовы ради пути rel
+    inline void fsSyscall(const std::string &rel, unsigned count = 1) {
+#ifdef ARDUINOSTUB_COUNTERS
+        ThreadCounters &t = local();
+        t.littlefs.syscalls.add(count);
+        t.path(rel).syscalls.add(count);
+#else
+        (void)rel;
+        (void)count;
+#endif
+    }
+
+    // Системные вызовы тома в целом (монтирование, форматирование)
+    inline void fsVolumeSyscall(unsigned count = 1) {
+#ifdef ARDUINOSTUB_COUNTERS
+        local().littlefs.syscalls.add(count);
+#else
+        (void)count;
+#endif
+    }
+
+    inline void fsRead(const std::string &rel, size_t bytes) {
+#ifdef ARDUINOSTUB_COUNTERS
+        ThreadCounters &t = local();
+        t.littlefs.reads.add(1);
+        t.littlefs.bytes_read.add(bytes);
+        FsCounters &p = t.path(rel);
+        p.reads.add(1);
+        p.bytes_read.add(bytes);
+#else
+        (void)rel;
+        (void)bytes;
+#endif
+    }
+
+    inline void fsWrite(const std::string &rel, size_t bytes) {
+#ifdef ARDUINOSTUB_COUNTERS
+        ThreadCounters &t = local();
+        t.littlefs.writes.add(1);
+        t.littlefs.bytes_written.add(bytes);
+        FsCounters &p = t.path(rel);
+        p.writes.add(1);
+        p.bytes_written.add(bytes);
+#else
+        (void)rel;
+        (void)bytes;
+#endif
+    }
+
+} // namespace stub_counters
+
+#endif // STUB_COUNTERS_H
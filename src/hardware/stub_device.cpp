@@ -0,0 +1,110 @@
+#include "stub_device.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace stub_device {
+
+    Device::Device(uint32_t id, const fs::MemoryVolume::Data &image)
+        : id_(id), random_(id + 1), serial0_(false), serial1_(false) {
+        fs_.setPartition(image);
+    }
+
+    Device &defaultDevice() {
+        static Device device;
+        return device;
+    }
+
+    Pool::Pool(unsigned threads) : threads_(threads), steals_(0) {
+        if (threads_ == 0) threads_ = std::thread::hardware_concurrency();
+        if (threads_ == 0) threads_ = 1;
+    }
+
+    // Очередь рабочего потока: свои задачи берутся с конца, чужие — с начала
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void Pool::run(const std::vector<Device *> &devices,
+                   const std::function<void()> &setup,
+                   const std::function<void()> &loop,
+                   uint64_t iterations, uint32_t chunk) {
+        steals_ = 0;
+        size_t count = devices.size();
+        if (count == 0) return;
+        if (chunk == 0) chunk = 1;
+        unsigned workers = static_cast<unsigned>(std::min<size_t>(threads_, count));
+
+        // Устройства раскладываются по очередям подряд идущими блоками
+        std::vector<std::unique_ptr<WorkQueue> > queues;
+        for (unsigned w = 0; w < workers; w++) queues.emplace_back(new WorkQueue());
+        for (size_t i = 0; i < count; i++) queues[i * workers / count]->tasks.push_back(i);
+
+        // Состояние устройства меняет только поток, взявший его из очереди
+        std::vector<uint64_t> remaining(count, iterations);
+        std::vector<char> started(count, 0);
+        std::atomic<size_t> pending(count);
+        std::atomic<uint64_t> steals(0);
+
+        auto work = [&](unsigned self) {
+            while (pending.load(std::memory_order_acquire) > 0) {
+                size_t task = 0;
+                bool found = false;
+                {
+                    WorkQueue &own = *queues[self];
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    if (!own.tasks.empty()) {
+                        task = own.tasks.back();
+                        own.tasks.pop_back();
+                        found = true;
+                    }
+                }
+                for (unsigned k = 1; !found && k < workers; k++) {
+                    WorkQueue &victim = *queues[(self + k) % workers];
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if (!victim.tasks.empty()) {
+                        task = victim.tasks.front();
+                        victim.tasks.pop_front();
+                        found = true;
+                        steals.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                if (!found) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                {
+                    Scope scope(*devices[task]);
+                    if (!started[task]) {
+                        started[task] = 1;
+                        if (setup) setup();
+                    }
+                    uint64_t n = std::min<uint64_t>(chunk, remaining[task]);
+                    for (uint64_t i = 0; i < n; i++) loop();
+                    remaining[task] -= n;
+                }
+
+                if (remaining[task] > 0) {
+                    WorkQueue &own = *queues[self];
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    own.tasks.push_back(task);
+                } else {
+                    pending.fetch_sub(1, std::memory_order_release);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned w = 1; w < workers; w++) threads.push_back(std::thread(work, w));
+        work(0);
+        for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+        steals_ = steals.load();
+    }
+
+} // namespace stub_device
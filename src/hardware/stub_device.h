@@ -0,0 +1,152 @@
+#ifndef STUB_DEVICE_H
+#define STUB_DEVICE_H
+
+// Несколько независимых экземпляров скетча в одном процессе.
+//
+// Device владеет всем, что на плате своё: портами Serial и Serial1,
+// шинами Wire и SPI, разделами LittleFS и NVS (Preferences) в памяти,
+// часами, пинами и EEPROM (stub_board.h), генератором random()
+// (stub_random.h). Scope подставляет устройство в текущий поток;
+// функции arduino_compat.h и Preferences работают с его платой и NVS.
+//
+// Чтобы скетч без изменений обращался к Serial и LittleFS своего
+// устройства, его файлы компилируются с -DARDUINOSTUB_DEVICES и
+// подключают этот заголовок: тогда Serial, Serial1, Wire, SPI и
+// LittleFS — порты, шины и раздел устройства текущего потока. Библиотеку заглушек
+// пересобирать не нужно.
+//
+//   std::vector<stub_device::Device *> fleet;
+//   for (uint32_t i = 0; i < 1000; i++) fleet.push_back(new stub_device::Device(i));
+//   stub_device::Pool pool;
+//   pool.run(fleet, setup, loop, 10000);
+//
+// Pool раскладывает устройства по очередям рабочих потоков и гоняет
+// loop() отрезками; освободившийся поток забирает устройства из
+// чужих очередей. Одно устройство в каждый момент выполняется одним
+// потоком. Запись и воспроизведение (stub_replay.h) общие на процесс и
+// с несколькими устройствами не используются. Реализация — stub_device.cpp.
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "arduino_compat.h"
+#include "fake_serial.h"
+#include "littlefs_stub.h"
+#include "preferences_stub.h"
+#include "spi_stub.h"
+#include "stub_board.h"
+#include "stub_random.h"
+#include "wire_stub.h"
+
+namespace stub_device {
+
+    class Device {
+    public:
+        // Раздел LittleFS — копия image при записи (пустой, если образа нет);
+        // random() начинается с seed id + 1
+        explicit Device(uint32_t id = 0,
+                        const fs::MemoryVolume::Data &image = fs::MemoryVolume::Data());
+
+        uint32_t id() const { return id_; }
+
+        // 0 — Serial, 1 — Serial1
+        FakeSerial &serial(int port = 0) { return port == 1 ? serial1_ : serial0_; }
+
+        // Свои шины I2C и SPI: модели подключаются к wire().bus() и spi().attach()
+        TwoWire &wire() { return wire_; }
+        SPIClass &spi() { return spi_; }
+
+        fs::LittleFSClass &fs() { return fs_; }
+        stub_nvs::Partition &nvs() { return nvs_; }
+        stub_board::Board &board() { return board_; }
+        stub_random::Generator &random() { return random_; }
+
+    private:
+        Device(const Device &);
+        Device &operator=(const Device &);
+
+        uint32_t id_;
+        stub_board::Board board_;
+        stub_random::Generator random_;
+        FakeSerial serial0_;
+        FakeSerial serial1_;
+        TwoWire wire_;
+        SPIClass spi_;
+        fs::LittleFSClass fs_;
+        stub_nvs::Partition nvs_;
+    };
+
+    // Устройство потока; nullptr — устройство по умолчанию
+    inline Device *&currentPtr() {
+        static thread_local Device *device = nullptr;
+        return device;
+    }
+
+    Device &defaultDevice();
+
+    inline Device &current() {
+        Device *device = currentPtr();
+        return device ? *device : defaultDevice();
+    }
+
+    // Подменяет устройство потока до конца области видимости
+    class Scope {
+    public:
+        explicit Scope(Device &device)
+            : prev_(currentPtr()), prev_board_(stub_board::currentPtr()),
+              prev_nvs_(stub_nvs::currentPtr()), random_(device.random()) {
+            currentPtr() = &device;
+            stub_board::currentPtr() = &device.board();
+            stub_nvs::currentPtr() = &device.nvs();
+        }
+
+        ~Scope() {
+            currentPtr() = prev_;
+            stub_board::currentPtr() = prev_board_;
+            stub_nvs::currentPtr() = prev_nvs_;
+        }
+
+    private:
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+
+        Device *prev_;
+        stub_board::Board *prev_board_;
+        stub_nvs::Partition *prev_nvs_;
+        stub_random::Scope random_;
+    };
+
+    // Пул с перехватом работы для прогона loop() многих устройств
+    class Pool {
+    public:
+        // threads = 0 — по числу ядер
+        explicit Pool(unsigned threads = 0);
+
+        unsigned threads() const { return threads_; }
+
+        // На каждом устройстве один раз setup(), затем iterations раз loop().
+        // Устройство выполняется отрезками по chunk итераций.
+        void run(const std::vector<Device *> &devices,
+                 const std::function<void()> &setup,
+                 const std::function<void()> &loop,
+                 uint64_t iterations, uint32_t chunk = 64);
+
+        // Сколько отрезков последнего run() забрали из чужих очередей
+        uint64_t steals() const { return steals_; }
+
+    private:
+        unsigned threads_;
+        uint64_t steals_;
+    };
+
+} // namespace stub_device
+
+#ifdef ARDUINOSTUB_DEVICES
+#define Serial (::stub_device::current().serial(0))
+#define Serial1 (::stub_device::current().serial(1))
+#define Wire (::stub_device::current().wire())
+#define SPI (::stub_device::current().spi())
+#define LittleFS (::stub_device::current().fs())
+#endif
+
+#endif // STUB_DEVICE_H
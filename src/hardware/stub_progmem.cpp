@@ -0,0 +1,103 @@
+#include "stub_progmem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <ostream>
+
+// Границы секции stub_progmem задаёт компоновщик; слабые ссылки равны
+// nullptr, если в программе нет ни одного PROGMEM
+extern "C" {
+    extern const char __start_stub_progmem[] __attribute__((weak));
+    extern const char __stop_stub_progmem[] __attribute__((weak));
+}
+
+namespace stub_progmem {
+
+    namespace {
+
+        struct Registry {
+            std::vector<Literal> literals;
+            size_t bytes;
+            std::map<const char *, size_t> ranges;  // Начало строки -> размер
+
+            Registry() : bytes(0) {}
+        };
+
+        // Строки регистрируются до main() из разных единиц трансляции,
+        // поэтому реестр создаётся при первом обращении
+        Registry &registry() {
+            static Registry registry;
+            return registry;
+        }
+
+        struct Violations {
+            uint64_t count;
+            std::string first;
+
+            Violations() : count(0) {}
+        };
+
+        Violations &violationState() {
+            static Violations state;
+            return state;
+        }
+
+    } // namespace
+
+    bool registerLiteral(const char *text, size_t size, const char *file, int line) {
+        Registry &r = registry();
+        Literal literal = {text, size, file, line};
+        r.literals.push_back(literal);
+        r.bytes += size;
+        r.ranges[text] = size;
+        return true;
+    }
+
+    const std::vector<Literal> &literals() { return registry().literals; }
+
+    size_t literalBytes() { return registry().bytes; }
+
+    size_t progmemBytes() {
+        if (!__start_stub_progmem) return 0;
+        return static_cast<size_t>(__stop_stub_progmem - __start_stub_progmem);
+    }
+
+    bool isFlash(const void *addr) {
+        const char *p = static_cast<const char *>(addr);
+        if (__start_stub_progmem && p >= __start_stub_progmem && p < __stop_stub_progmem) return true;
+        const std::map<const char *, size_t> &ranges = registry().ranges;
+        std::map<const char *, size_t>::const_iterator it = ranges.upper_bound(p);
+        if (it == ranges.begin()) return false;
+        --it;
+        return p < it->first + it->second;
+    }
+
+    void report(std::ostream &os, size_t top) {
+        std::vector<Literal> sorted = literals();
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const Literal &a, const Literal &b) { return a.size > b.size; });
+        os << "Flash strings: " << sorted.size() << " literals, " << literalBytes()
+           << " bytes; other PROGMEM data " << progmemBytes() << " bytes" << std::endl;
+        for (size_t i = 0; i < sorted.size() && i < top; i++) {
+            os << "  " << sorted[i].size << "  " << sorted[i].file << ":" << sorted[i].line
+               << std::endl;
+        }
+    }
+
+    uint64_t violations() { return violationState().count; }
+
+    const std::string &firstViolation() { return violationState().first; }
+
+    void resetViolations() { violationState() = Violations(); }
+
+    void violation(const char *function, const void *addr) {
+        Violations &v = violationState();
+        if (v.count++ == 0) {
+            char buffer[96];
+            snprintf(buffer, sizeof(buffer), "%s(%p): address is not in PROGMEM", function, addr);
+            v.first = buffer;
+        }
+    }
+
+} // namespace stub_progmem
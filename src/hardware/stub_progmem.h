@@ -0,0 +1,162 @@
+#ifndef STUB_PROGMEM_H
+#define STUB_PROGMEM_H
+
+// PROGMEM, PSTR() и F() как на AVR: строки во флеше — отдельная секция
+// и отдельный тип, их размер известен до main().
+//
+// PROGMEM кладёт данные в секцию stub_progmem исполняемого файла.
+// PSTR() и F() — каждый вызов своим статическим массивом, как у avr-gcc:
+// одинаковые строки в разных местах не сливаются и каждая занимает
+// флеш. Эти массивы не в секции: GCC не сводит в одну секцию статические
+// переменные inline-функций и обычные, а F() пишут и в заголовках; по
+// той же причине PROGMEM не ставится на static внутри inline-функций и
+// шаблонов. F() возвращает const __FlashStringHelper*, и print(),
+// String, += и concat() выбирают для него отдельную перегрузку. PSTR()
+// и F() принимают только строковый литерал: F(buffer) не соберётся,
+// как и на AVR; вне функции их, как и на AVR, не использовать.
+//
+// Каждая строка PSTR() и F() регистрируется при статической
+// инициализации (файл, строка, размер вместе с нулём), поэтому тест
+// проверяет бюджет флеша, не выполнив ни одной печати:
+//
+//   assert(stub_progmem::literalBytes() <= 2048);
+//   stub_progmem::report(std::cout);
+//
+// Строгий режим (setStrict(true)) проверяет, что pgm_read_*(), функции
+// *_P и печать __FlashStringHelper получают адрес во флеше: строка из
+// ОЗУ на AVR прочиталась бы как мусор. Нарушения считает violations(),
+// первое запоминается с именем функции. Реализация — stub_progmem.cpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Тип строки во флеше, как в ядре Arduino: объявлен, но не определён
+class __FlashStringHelper;
+
+#define PROGMEM __attribute__((section("stub_progmem")))
+#define PGM_P const char *
+#define PGM_VOID_P const void *
+
+#define PSTR(str)                                                              \
+  (__extension__({                                                             \
+    static const char stub_progmem_text[] = "" str;                            \
+    struct StubProgmemSite {                                                   \
+      static const char *text() { return stub_progmem_text; }                  \
+      static size_t size() { return sizeof(stub_progmem_text); }               \
+      static const char *file() { return __FILE__; }                           \
+      static int line() { return __LINE__; }                                   \
+    };                                                                         \
+    ::stub_progmem::literal<StubProgmemSite>();                                \
+  }))
+
+#define F(str) (reinterpret_cast<const __FlashStringHelper *>(PSTR(str)))
+#define FPSTR(pstr) (reinterpret_cast<const __FlashStringHelper *>(pstr))
+
+namespace stub_progmem {
+
+    // Строка PSTR() или F() в исходниках
+    struct Literal {
+        const char *text;
+        size_t size;        // Вместе с нулём
+        const char *file;
+        int line;
+    };
+
+    bool registerLiteral(const char *text, size_t size, const char *file, int line);
+
+    // Регистрация места вызова: статический член инициализируется до main()
+    template <typename Site>
+    struct Registration {
+        static const bool done;
+    };
+
+    template <typename Site>
+    const bool Registration<Site>::done =
+        registerLiteral(Site::text(), Site::size(), Site::file(), Site::line());
+
+    template <typename Site>
+    inline const char *literal() {
+        (void)Registration<Site>::done;
+        return Site::text();
+    }
+
+    // Зарегистрированные строки в порядке инициализации
+    const std::vector<Literal> &literals();
+    size_t literalBytes();
+
+    // Данные PROGMEM; флеш всего — progmemBytes() + literalBytes()
+    size_t progmemBytes();
+    // Адрес в данных PROGMEM или в строке PSTR() и F()
+    bool isFlash(const void *addr);
+
+    // Итог и top самых длинных строк с местом в исходниках
+    void report(std::ostream &os, size_t top = 10);
+
+    inline bool &strictFlag() {
+        static bool strict = false;
+        return strict;
+    }
+
+    inline void setStrict(bool strict) { strictFlag() = strict; }
+    inline bool strict() { return strictFlag(); }
+
+    uint64_t violations();
+    // Функция и адрес первого нарушения; пустая строка — нарушений не было
+    const std::string &firstViolation();
+    void resetViolations();
+    void violation(const char *function, const void *addr);
+
+    inline const char *check(const void *addr, const char *function) {
+        if (strictFlag() && !isFlash(addr)) violation(function, addr);
+        return static_cast<const char *>(addr);
+    }
+
+    template <typename T>
+    inline T read(const void *addr, const char *function) {
+        T value;
+        memcpy(&value, check(addr, function), sizeof(T));
+        return value;
+    }
+
+} // namespace stub_progmem
+
+// Ширины как на AVR: word — 16 бит, dword — 32
+#define pgm_read_byte(addr) (::stub_progmem::read<uint8_t>((addr), "pgm_read_byte"))
+#define pgm_read_word(addr) (::stub_progmem::read<uint16_t>((addr), "pgm_read_word"))
+#define pgm_read_dword(addr) (::stub_progmem::read<uint32_t>((addr), "pgm_read_dword"))
+#define pgm_read_float(addr) (::stub_progmem::read<float>((addr), "pgm_read_float"))
+#define pgm_read_ptr(addr) (::stub_progmem::read<void *>((addr), "pgm_read_ptr"))
+
+inline char *strcpy_P(char *dest, const char *src) {
+  return strcpy(dest, stub_progmem::check(src, "strcpy_P"));
+}
+
+inline char *strncpy_P(char *dest, const char *src, size_t n) {
+  return strncpy(dest, stub_progmem::check(src, "strncpy_P"), n);
+}
+
+inline char *strcat_P(char *dest, const char *src) {
+  return strcat(dest, stub_progmem::check(src, "strcat_P"));
+}
+
+inline int strcmp_P(const char *a, const char *b) {
+  return strcmp(a, stub_progmem::check(b, "strcmp_P"));
+}
+
+inline int strncmp_P(const char *a, const char *b, size_t n) {
+  return strncmp(a, stub_progmem::check(b, "strncmp_P"), n);
+}
+
+inline size_t strlen_P(const char *str) {
+  return strlen(stub_progmem::check(str, "strlen_P"));
+}
+
+inline void *memcpy_P(void *dest, const void *src, size_t n) {
+  return memcpy(dest, stub_progmem::check(src, "memcpy_P"), n);
+}
+
+#endif // STUB_PROGMEM_H
@@ -0,0 +1,162 @@
+#ifndef STUB_RANDOM_H
+#define STUB_RANDOM_H
+
+// Генератор для random() и randomSeed().
+//
+// По умолчанию — xorshift64*: быстрый, без смещения по модулю в
+// random(max). Каждый поток получает свой генератор с одинаковым
+// начальным состоянием, как плата после сброса, так что параллельные
+// прогоны не мешают друг другу и воспроизводимы. Для отдельной
+// симуляции можно завести свой поток чисел:
+//
+//   stub_random::Generator gen(seed);
+//   stub_random::Scope scope(gen);   // random() в этом потоке берёт gen
+//   runSimulation();
+//
+// Алгоритм kAvr повторяет random() из avr-libc (Park–Miller, 16807 mod
+// 2^31-1) вместе со смещением random(max) % max, как в ядре Arduino:
+// последовательность совпадает с платой при том же randomSeed().
+//
+//   stub_random::current().setAlgorithm(stub_random::kAvr);
+
+#include <cstdint>
+
+namespace stub_random {
+
+    enum Algorithm { kXorshift, kAvr };
+
+    class Generator {
+    public:
+        explicit Generator(uint32_t seed = 1, Algorithm algorithm = kXorshift)
+            : state_(0), algorithm_(algorithm) {
+            this->seed(seed);
+        }
+
+        Algorithm algorithm() const { return algorithm_; }
+
+        // Смена алгоритма сбрасывает состояние к начальному (seed 1)
+        void setAlgorithm(Algorithm algorithm) {
+            algorithm_ = algorithm;
+            seed(1);
+        }
+
+        void seed(uint32_t seed) {
+            if (algorithm_ == kAvr) {
+                state_ = seed;
+                return;
+            }
+            // splitmix64: соседние seed дают несвязанные состояния
+            uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            state_ = z ? z : 0x9E3779B97F4A7C15ULL;
+        }
+
+        // 32 случайных бита (kAvr — 31, как random() в avr-libc)
+        uint32_t next() {
+            if (algorithm_ == kAvr) return nextAvr();
+            uint64_t x = state_;
+            x ^= x >> 12;
+            x ^= x << 25;
+            x ^= x >> 27;
+            state_ = x;
+            return static_cast<uint32_t>((x * 0x2545F4914F6CDD1DULL) >> 32);
+        }
+
+        // random(max): [0, max), 0 при max <= 0. В kAvr — как в ядре
+        // Arduino для AVR: 0 только при max == 0, а при отрицательном max
+        // random() % max со знаковым остатком, то есть [0, -max)
+        long below(long max) {
+            if (algorithm_ == kAvr) {
+                return max ? static_cast<long>(nextAvr()) % max : 0;
+            }
+            if (max <= 0) return 0;
+            return static_cast<long>(uniform(static_cast<uint64_t>(max)));
+        }
+
+        // random(min, max): [min, max), min при min >= max
+        long between(long min, long max) {
+            if (min >= max) return min;
+            uint64_t range = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+            if (algorithm_ == kAvr) {
+                return static_cast<long>(static_cast<uint64_t>(min) +
+                                         nextAvr() % range);
+            }
+            return static_cast<long>(static_cast<uint64_t>(min) + uniform(range));
+        }
+
+    private:
+        // do_random() из avr-libc: метод Шрейджа в 32-битной арифметике
+        uint32_t nextAvr() {
+            int32_t x = static_cast<int32_t>(state_);
+            if (x == 0) x = 123459876;
+            int32_t hi = x / 127773;
+            int32_t lo = x % 127773;
+            x = 16807 * lo - 2836 * hi;
+            if (x < 0) x += 0x7fffffff;
+            state_ = static_cast<uint32_t>(x);
+            return static_cast<uint32_t>(x);
+        }
+
+        // [0, range) без смещения: умножение Лемира с редким повтором
+        uint64_t uniform(uint64_t range) {
+            if (range <= 0xFFFFFFFFULL) {
+                uint32_t r = static_cast<uint32_t>(range);
+                uint64_t m = static_cast<uint64_t>(next()) * r;
+                uint32_t low = static_cast<uint32_t>(m);
+                if (low < r) {
+                    uint32_t threshold = (0u - r) % r;
+                    while (low < threshold) {
+                        m = static_cast<uint64_t>(next()) * r;
+                        low = static_cast<uint32_t>(m);
+                    }
+                }
+                return m >> 32;
+            }
+            uint64_t threshold = (0ULL - range) % range;
+            uint64_t x;
+            do {
+                x = (static_cast<uint64_t>(next()) << 32) | next();
+            } while (x < threshold);
+            return x % range;
+        }
+
+        uint64_t state_;
+        Algorithm algorithm_;
+    };
+
+    struct ThreadState {
+        Generator fallback;
+        Generator *current;
+
+        ThreadState() : current(&fallback) {}
+    };
+
+    inline ThreadState &state() {
+        static thread_local ThreadState s;
+        return s;
+    }
+
+    // Генератор, которым пользуются random() и randomSeed() в этом потоке
+    inline Generator &current() { return *state().current; }
+
+    // Подменяет генератор потока до конца области видимости
+    class Scope {
+    public:
+        explicit Scope(Generator &gen) : prev_(state().current) {
+            state().current = &gen;
+        }
+
+        ~Scope() { state().current = prev_; }
+
+    private:
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+
+        Generator *prev_;
+    };
+
+} // namespace stub_random
+
+#endif // STUB_RANDOM_H
@@ -0,0 +1,461 @@
+#include "stub_replay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <sstream>
+
+namespace stub_replay {
+
+    enum RecordType {
+        kImage = 1,
+        kMillis,
+        kDigitalRead,
+        kSerialRx,
+        kSerialTx,
+        kFsOp
+    };
+
+    static const char kMagic[4] = {'A', 'S', 'R', 'R'};
+    static const uint8_t kVersion = 1;
+
+    static const char *fsOpName(int op) {
+        static const char *names[] = {"open", "write", "remove", "rename", "mkdir", "format"};
+        return op >= 0 && op <= kFsFormat ? names[op] : "?";
+    }
+
+    // Печатное представление байтов для отчёта
+    static std::string quote(const std::string &data) {
+        std::string out = "\"";
+        for (size_t i = 0; i < data.size(); i++) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c == '\n') out += "\\n";
+            else if (c == '\r') out += "\\r";
+            else if (c == '"' || c == '\\') { out += '\\'; out += c; }
+            else if (c < 0x20 || c >= 0x7f) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\x%02x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    std::string Report::describe() const {
+        std::ostringstream out;
+        if (diverged) {
+            out << "Divergence at record " << record << " (" << what << "): expected "
+                << expected << ", got " << actual << "\n";
+        } else {
+            out << "No divergence in " << records << " records\n";
+        }
+        if (inputs_exhausted) out << "Replay ran out of recorded inputs\n";
+        return out.str();
+    }
+
+    class Session {
+    public:
+        Session() : last_millis_(0), records_(0) {}
+
+        const std::vector<uint8_t> &image() const { return image_; }
+        const Report &report() const { return report_; }
+
+        bool startRecording(const char *path, const std::vector<uint8_t> *image) {
+            resetState();
+            path_ = path;
+            log_.assign(kMagic, sizeof(kMagic));
+            log_ += static_cast<char>(kVersion);
+            if (image) {
+                image_ = *image;
+                beginRecord(kImage);
+                putBytes(reinterpret_cast<const char *>(image_.data()), image_.size());
+            }
+            currentMode() = kRecord;
+            return true;
+        }
+
+        bool stopRecording() {
+            if (currentMode() != kRecord) return false;
+            currentMode() = kOff;
+            FILE *f = fopen(path_.c_str(), "wb");
+            if (!f) return false;
+            bool ok = fwrite(log_.data(), 1, log_.size(), f) == log_.size();
+            ok = fclose(f) == 0 && ok;
+            log_.clear();
+            return ok;
+        }
+
+        bool startReplay(const char *path) {
+            resetState();
+            FILE *f = fopen(path, "rb");
+            if (!f) return false;
+            std::string data;
+            char buf[4096];
+            size_t n;
+            while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+            fclose(f);
+            if (!parse(data)) {
+                resetState();
+                return false;
+            }
+            currentMode() = kReplay;
+            return true;
+        }
+
+        Report finishReplay() {
+            if (currentMode() != kReplay) return report_;
+            currentMode() = kOff;
+            // Записанный вывод, которого новая версия так и не выдала
+            for (std::map<int, Stream>::iterator it = tx_.begin(); it != tx_.end(); ++it) {
+                Stream &s = it->second;
+                if (s.pos < s.data.size()) {
+                    diverge(s.recordAt(s.pos), portName(it->first),
+                            quote(s.data.substr(s.pos, 32)), "end of output");
+                }
+            }
+            if (fs_pos_ < fs_.size()) {
+                diverge(fs_[fs_pos_].record, "littlefs", describe(fs_[fs_pos_]), "no operation");
+            }
+            report_.records = records_;
+            return report_;
+        }
+
+        unsigned long millis(unsigned long live) {
+            if (currentMode() == kRecord) {
+                beginRecord(kMillis);
+                putVarint(live - last_millis_);  // По модулю, как переполнение millis()
+                last_millis_ = live;
+                return live;
+            }
+            if (millis_pos_ < millis_.size()) return last_millis_ = millis_[millis_pos_++];
+            report_.inputs_exhausted = true;
+            return last_millis_;
+        }
+
+        int digitalRead(uint8_t pin, int live) {
+            if (currentMode() == kRecord) {
+                beginRecord(kDigitalRead);
+                log_ += static_cast<char>(pin);
+                log_ += static_cast<char>(live);
+                return live;
+            }
+            Inputs &in = pins_[pin];
+            if (in.pos < in.values.size()) return in.values[in.pos++];
+            report_.inputs_exhausted = true;
+            return live;
+        }
+
+        // Байты, пришедшие в порт; при воспроизведении вход берётся из журнала
+        bool serialInput(int port, const char *data, size_t len) {
+            if (currentMode() == kReplay) return false;
+            rx_pending_[port].append(data, len);
+            return true;
+        }
+
+        // Скетч смотрит во входной буфер порта (available/read/peek)
+        void serialObserve(int port, std::string &rx) {
+            uint64_t n = observations_[port]++;
+            if (currentMode() == kRecord) {
+                std::string &pending = rx_pending_[port];
+                if (pending.empty()) return;
+                beginRecord(kSerialRx);
+                putVarint(port);
+                putVarint(n);
+                putBytes(pending.data(), pending.size());
+                pending.clear();
+                return;
+            }
+            std::vector<RxChunk> &chunks = rx_[port];
+            size_t &pos = rx_pos_[port];
+            while (pos < chunks.size() && chunks[pos].observation <= n) {
+                rx += chunks[pos++].data;
+            }
+        }
+
+        void serialTx(int port, const char *data, size_t len) {
+            if (currentMode() == kRecord) {
+                beginRecord(kSerialTx);
+                putVarint(port);
+                putBytes(data, len);
+                return;
+            }
+            Stream &s = tx_[port];
+            for (size_t i = 0; i < len; i++, s.pos++) {
+                if (s.pos >= s.data.size() || s.data[s.pos] != data[i]) {
+                    std::string expected = s.pos < s.data.size() ? quote(s.data.substr(s.pos, 32))
+                                                                 : "end of output";
+                    diverge(s.recordAt(s.pos), portName(port), expected,
+                            quote(std::string(data + i, std::min<size_t>(len - i, 32))));
+                    s.pos += len - i;
+                    return;
+                }
+            }
+        }
+
+        void fsOp(int op, const std::string &path, int64_t value, uint32_t digest) {
+            if (currentMode() == kRecord) {
+                beginRecord(kFsOp);
+                log_ += static_cast<char>(op);
+                putBytes(path.data(), path.size());
+                putVarint(zigzag(value));
+                putVarint(digest);
+                return;
+            }
+            FsRecord actual;
+            actual.op = op;
+            actual.path = path;
+            actual.value = value;
+            actual.digest = digest;
+            if (fs_pos_ >= fs_.size()) {
+                diverge(records_, "littlefs", "no operation", describe(actual));
+                return;
+            }
+            const FsRecord &expected = fs_[fs_pos_++];
+            if (expected.op != op || expected.path != path || expected.value != value ||
+                expected.digest != digest) {
+                diverge(expected.record, "littlefs", describe(expected), describe(actual));
+            }
+        }
+
+    private:
+        struct Inputs {
+            std::vector<int> values;
+            size_t pos;
+            Inputs() : pos(0) {}
+        };
+
+        struct RxChunk {
+            uint64_t observation;
+            std::string data;
+        };
+
+        // Ожидаемый вывод порта одной строкой; starts — начало каждой записи
+        struct Stream {
+            std::string data;
+            std::vector<std::pair<size_t, uint64_t> > starts;
+            size_t pos;
+            Stream() : pos(0) {}
+
+            uint64_t recordAt(size_t offset) const {
+                uint64_t record = starts.empty() ? 0 : starts.back().second;
+                for (size_t i = 1; i < starts.size(); i++) {
+                    if (starts[i].first > offset) return starts[i - 1].second;
+                }
+                return record;
+            }
+        };
+
+        struct FsRecord {
+            uint64_t record;
+            int op;
+            std::string path;
+            int64_t value;
+            uint32_t digest;
+        };
+
+        std::string path_;
+        std::string log_;
+        std::vector<uint8_t> image_;
+        unsigned long last_millis_;
+        uint64_t records_;
+        std::map<int, uint64_t> observations_;
+        std::map<int, std::string> rx_pending_;
+
+        std::vector<unsigned long> millis_;
+        size_t millis_pos_;
+        std::map<int, Inputs> pins_;
+        std::map<int, std::vector<RxChunk> > rx_;
+        std::map<int, size_t> rx_pos_;
+        std::map<int, Stream> tx_;
+        std::vector<FsRecord> fs_;
+        size_t fs_pos_;
+        Report report_;
+
+        void resetState() {
+            currentMode() = kOff;
+            log_.clear();
+            image_.clear();
+            last_millis_ = 0;
+            records_ = 0;
+            observations_.clear();
+            rx_pending_.clear();
+            millis_.clear();
+            millis_pos_ = 0;
+            pins_.clear();
+            rx_.clear();
+            rx_pos_.clear();
+            tx_.clear();
+            fs_.clear();
+            fs_pos_ = 0;
+            report_ = Report();
+        }
+
+        void diverge(uint64_t record, const std::string &what, const std::string &expected,
+                     const std::string &actual) {
+            if (report_.diverged) return;
+            report_.diverged = true;
+            report_.record = record;
+            report_.what = what;
+            report_.expected = expected;
+            report_.actual = actual;
+        }
+
+        static std::string portName(int port) {
+            std::ostringstream out;
+            out << "serial " << port;
+            return out.str();
+        }
+
+        static std::string describe(const FsRecord &r) {
+            std::ostringstream out;
+            out << fsOpName(r.op) << " " << r.path << " -> " << r.value;
+            if (r.op == kFsWrite) out << " #" << std::hex << r.digest;
+            return out.str();
+        }
+
+        static uint64_t zigzag(int64_t v) {
+            return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+        }
+
+        static int64_t unzigzag(uint64_t v) {
+            return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+        }
+
+        void beginRecord(RecordType type) {
+            log_ += static_cast<char>(type);
+            records_++;
+        }
+
+        void putVarint(uint64_t v) {
+            while (v >= 0x80) {
+                log_ += static_cast<char>((v & 0x7f) | 0x80);
+                v >>= 7;
+            }
+            log_ += static_cast<char>(v);
+        }
+
+        void putBytes(const char *data, size_t len) {
+            putVarint(len);
+            log_.append(data, len);
+        }
+
+        // Разбор журнала в очереди входов и ожидаемых выходов
+        bool parse(const std::string &data) {
+            if (data.size() < 5 || data.compare(0, 4, kMagic, 4) != 0 ||
+                static_cast<uint8_t>(data[4]) != kVersion) {
+                return false;
+            }
+            size_t pos = 5;
+            unsigned long millis = 0;
+            while (pos < data.size()) {
+                int type = static_cast<uint8_t>(data[pos++]);
+                uint64_t record = records_++;
+                uint64_t port, n;
+                std::string bytes;
+                switch (type) {
+                case kImage:
+                    if (!getBytes(data, pos, bytes)) return false;
+                    image_.assign(bytes.begin(), bytes.end());
+                    break;
+                case kMillis:
+                    if (!getVarint(data, pos, n)) return false;
+                    millis += static_cast<unsigned long>(n);
+                    millis_.push_back(millis);
+                    break;
+                case kDigitalRead:
+                    if (pos + 2 > data.size()) return false;
+                    pins_[static_cast<uint8_t>(data[pos])].values.push_back(
+                        static_cast<uint8_t>(data[pos + 1]));
+                    pos += 2;
+                    break;
+                case kSerialRx: {
+                    RxChunk chunk;
+                    if (!getVarint(data, pos, port) || !getVarint(data, pos, chunk.observation) ||
+                        !getBytes(data, pos, chunk.data)) {
+                        return false;
+                    }
+                    rx_[static_cast<int>(port)].push_back(chunk);
+                    break;
+                }
+                case kSerialTx: {
+                    if (!getVarint(data, pos, port) || !getBytes(data, pos, bytes)) return false;
+                    Stream &s = tx_[static_cast<int>(port)];
+                    s.starts.push_back(std::make_pair(s.data.size(), record));
+                    s.data += bytes;
+                    break;
+                }
+                case kFsOp: {
+                    FsRecord r;
+                    r.record = record;
+                    if (pos >= data.size()) return false;
+                    r.op = static_cast<uint8_t>(data[pos++]);
+                    if (!getBytes(data, pos, r.path) || !getVarint(data, pos, n)) return false;
+                    r.value = unzigzag(n);
+                    if (!getVarint(data, pos, n)) return false;
+                    r.digest = static_cast<uint32_t>(n);
+                    fs_.push_back(r);
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static bool getVarint(const std::string &data, size_t &pos, uint64_t &v) {
+            v = 0;
+            for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+                uint8_t b = static_cast<uint8_t>(data[pos++]);
+                v |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80)) return true;
+            }
+            return false;
+        }
+
+        static bool getBytes(const std::string &data, size_t &pos, std::string &out) {
+            uint64_t len;
+            if (!getVarint(data, pos, len) || len > data.size() - pos) return false;
+            out.assign(data, pos, static_cast<size_t>(len));
+            pos += static_cast<size_t>(len);
+            return true;
+        }
+    };
+
+    static Session &session() {
+        // Не уничтожается: заглушки могут писать в журнал из деструкторов
+        static Session *s = new Session();
+        return *s;
+    }
+
+    const std::vector<uint8_t> &image() { return session().image(); }
+    const Report &report() { return session().report(); }
+
+    bool startRecording(const char *path, const std::vector<uint8_t> *image) {
+        return session().startRecording(path, image);
+    }
+
+    bool stopRecording() { return session().stopRecording(); }
+    bool startReplay(const char *path) { return session().startReplay(path); }
+    Report finishReplay() { return session().finishReplay(); }
+
+    unsigned long onMillis(unsigned long live) { return session().millis(live); }
+    int onDigitalRead(uint8_t pin, int live) { return session().digitalRead(pin, live); }
+
+    bool onSerialInput(int port, const char *data, size_t len) {
+        return session().serialInput(port, data, len);
+    }
+
+    void onSerialObserve(int port, std::string &rx) { session().serialObserve(port, rx); }
+
+    void onSerialTx(int port, const char *data, size_t len) {
+        session().serialTx(port, data, len);
+    }
+
+    void onFsOp(int op, const std::string &path, int64_t value, uint32_t digest) {
+        session().fsOp(op, path, value, digest);
+    }
+
+} // namespace stub_replay
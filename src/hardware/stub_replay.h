@@ -0,0 +1,129 @@
+#ifndef STUB_REPLAY_H
+#define STUB_REPLAY_H
+
+// Запись и воспроизведение ввода-вывода скетча.
+//
+// При записи в журнал попадает всё, что скетч получает извне (значения
+// millis(), результаты digitalRead, входящие байты Serial), и всё, что он
+// отдаёт наружу (исходящие байты Serial, операции LittleFS). В начало
+// журнала можно положить образ файловой системы.
+//
+// При воспроизведении входы берутся из журнала, а выходы сравниваются
+// с записанными; первое расхождение сохраняется в отчёте. delay() в
+// заглушках не ждёт, а время идёт по журналу, поэтому прогон идёт с
+// той скоростью, с какой работает сам скетч.
+//
+//   std::vector<uint8_t> image;
+//   LittleFS.exportImage(image);
+//   stub_replay::startRecording("target/run.bin", &image);
+//   ... работа скетча ...
+//   stub_replay::stopRecording();
+//
+//   stub_replay::startReplay("target/run.bin");
+//   LittleFS.mountImage(stub_replay::image().data(), stub_replay::image().size());
+//   ... работа новой версии скетча ...
+//   stub_replay::Report r = stub_replay::finishReplay();
+//   if (r.diverged) std::cout << r.describe();
+//
+// Формат журнала: "ASRR", версия, затем записи «тип + поля»; числа
+// записываются varint, millis — разностью с предыдущим значением.
+// Журнал однопоточный, как и сам скетч. Реализация — stub_replay.cpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stub_replay {
+
+    enum Mode { kOff, kRecord, kReplay };
+
+    // Операции LittleFS, которые сравниваются при воспроизведении
+    enum FsOpType {
+        kFsOpen,
+        kFsWrite,
+        kFsRemove,
+        kFsRename,
+        kFsMkdir,
+        kFsFormat
+    };
+
+    // FNV-1a: содержимое записи в файл сравнивается по хешу
+    inline uint32_t hash(const void *data, size_t len) {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+        return h;
+    }
+
+    struct Report {
+        bool diverged;
+        uint64_t record;        // Номер записи журнала, с которой разошлись
+        std::string what;       // "serial 0", "littlefs"
+        std::string expected;
+        std::string actual;
+        bool inputs_exhausted;  // Скетч запросил больше входов, чем записано
+        uint64_t records;       // Всего записей в журнале
+
+        Report() : diverged(false), record(0), inputs_exhausted(false), records(0) {}
+
+        std::string describe() const;
+    };
+
+    // Текущий режим; его проверяют точки подключения заглушек
+    inline Mode &currentMode() {
+        static Mode mode = kOff;
+        return mode;
+    }
+
+    inline Mode mode() { return currentMode(); }
+    inline bool recording() { return mode() == kRecord; }
+    inline bool replaying() { return mode() == kReplay; }
+
+    const std::vector<uint8_t> &image();
+    const Report &report();
+    bool startRecording(const char *path, const std::vector<uint8_t> *image = nullptr);
+    bool stopRecording();
+    bool startReplay(const char *path);
+    Report finishReplay();
+
+    // Обработка событий при записи или воспроизведении
+    unsigned long onMillis(unsigned long live);
+    int onDigitalRead(uint8_t pin, int live);
+    bool onSerialInput(int port, const char *data, size_t len);
+    void onSerialObserve(int port, std::string &rx);
+    void onSerialTx(int port, const char *data, size_t len);
+    void onFsOp(int op, const std::string &path, int64_t value, uint32_t digest);
+
+    // Точки подключения заглушек: без записи и воспроизведения — одна проверка
+    inline unsigned long millis(unsigned long live) {
+        return mode() == kOff ? live : onMillis(live);
+    }
+
+    inline int digitalRead(uint8_t pin, int live) {
+        return mode() == kOff ? live : onDigitalRead(pin, live);
+    }
+
+    inline bool serialInput(int port, const char *data, size_t len) {
+        return mode() == kOff || onSerialInput(port, data, len);
+    }
+
+    inline void serialObserve(int port, std::string &rx) {
+        if (mode() != kOff) onSerialObserve(port, rx);
+    }
+
+    inline void serialTx(int port, const char *data, size_t len) {
+        if (mode() != kOff) onSerialTx(port, data, len);
+    }
+
+    inline void fsOp(int op, const std::string &path, int64_t value, uint32_t digest = 0) {
+        if (mode() != kOff) onFsOp(op, path, value, digest);
+    }
+
+    inline void fsOp(int op, const char *path, int64_t value, uint32_t digest = 0) {
+        if (mode() != kOff) onFsOp(op, path, value, digest);
+    }
+
+} // namespace stub_replay
+
+#endif // STUB_REPLAY_H
@@ -0,0 +1,90 @@
+#include "stub_trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+
+namespace stub_trace {
+
+    uint32_t enableFromEnvironment() {
+        const char *env = getenv("ARDUINOSTUB_TRACE");
+        if (!env) return 0;
+        uint32_t subsystems = 0;
+        std::string list(env);
+        size_t pos = 0;
+        while (pos <= list.size()) {
+            size_t end = list.find(',', pos);
+            if (end == std::string::npos) end = list.size();
+            std::string name = list.substr(pos, end - pos);
+            if (name == "all") subsystems |= kAll;
+            for (uint32_t s = kSerial; s <= kSketch; s <<= 1) {
+                if (name == subsystemName(s)) subsystems |= s;
+            }
+            pos = end + 1;
+        }
+        enable(subsystems);
+        return subsystems;
+    }
+
+    // Текст события — байты, а не UTF-8: двоичные данные порта или символ,
+    // обрезанный clipText(). Байты вне ASCII пишутся как \u00XX, чтобы JSON
+    // оставался корректным.
+    static void writeJsonString(std::ostream &out, const char *s, size_t len) {
+        out << '"';
+        for (size_t i = 0; i < len; i++) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (c < 0x20 || c >= 0x80) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out << buf;
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    void writeChromeJson(std::ostream &out) {
+        std::vector<Event> events = buffer().events();
+        out << "{\"traceEvents\": [\n";
+        for (size_t i = 0; i < events.size(); i++) {
+            const Event &e = events[i];
+            const EventInfo &ei = info(e.id);
+            char times[96];
+            if (e.complete) {
+                snprintf(times, sizeof(times), "\"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f",
+                         e.ts_ns / 1000.0, e.dur_ns / 1000.0);
+            } else {
+                snprintf(times, sizeof(times), "\"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f",
+                         e.ts_ns / 1000.0);
+            }
+            out << "  {\"name\": \"" << ei.name << "\", \"cat\": \""
+                << subsystemName(ei.subsystem) << "\", " << times
+                << ", \"pid\": 1, \"tid\": " << e.tid << ", \"args\": {";
+            const char *sep = "";
+            if (ei.text) {
+                out << "\"" << ei.text << "\": ";
+                writeJsonString(out, e.text, e.text_len);
+                sep = ", ";
+            }
+            if (ei.arg0) {
+                out << sep << "\"" << ei.arg0 << "\": " << e.args[0];
+                sep = ", ";
+            }
+            if (ei.arg1) out << sep << "\"" << ei.arg1 << "\": " << e.args[1];
+            out << "}}" << (i + 1 < events.size() ? "," : "") << "\n";
+        }
+        out << "], \"displayTimeUnit\": \"ns\"}\n";
+    }
+
+    bool saveChromeJson(const char *path) {
+        std::ofstream out(path);
+        if (!out) return false;
+        writeChromeJson(out);
+        return static_cast<bool>(out);
+    }
+
+} // namespace stub_trace
@@ -0,0 +1,295 @@
+#ifndef STUB_TRACE_H
+#define STUB_TRACE_H
+
+// Трассировка операций заглушек в кольцевой буфер.
+//
+// Событие — запись фиксированного размера (64 байта): номер события,
+// время, длительность, поток, два числовых аргумента и до 24 символов
+// текста (путь, начало данных). Запись в буфер — один fetch_add и
+// копирование, без форматирования и вывода; при переполнении старые
+// события затираются.
+//
+// Подсистемы включаются во время работы, выключенная стоит одну проверку
+// маски:
+//
+//   stub_trace::enable(stub_trace::kLittleFS | stub_trace::kSerial);
+//   ... работа скетча ...
+//   stub_trace::saveChromeJson("target/trace.json");
+//
+// Файл открывается в chrome://tracing или ui.perfetto.dev. Подсистемы
+// можно включить и переменной окружения ARDUINOSTUB_TRACE=littlefs,serial
+// (или all), вызвав enableFromEnvironment().
+//
+// Экспорт во время записи из других потоков может захватить недописанные
+// события; снимайте трассу, когда потоки остановлены. Экспорт и разбор
+// ARDUINOSTUB_TRACE — в stub_trace.cpp.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace stub_trace {
+
+    enum Subsystem {
+        kSerial = 1 << 0,
+        kString = 1 << 1,
+        kLittleFS = 1 << 2,
+        kSketch = 1 << 3,
+        kAll = 0xff
+    };
+
+    enum EventId {
+        kFsBegin,
+        kFsEnd,
+        kFsMountImage,
+        kFsFormat,
+        kFsOpen,
+        kFsClose,
+        kFsRead,
+        kFsWrite,
+        kFsMkdir,
+        kFsRemove,
+        kFsRename,
+        kSerialWrite,
+        kStringAlloc,
+        kMark,
+        kEventCount
+    };
+
+    struct EventInfo {
+        const char *name;
+        uint32_t subsystem;
+        const char *text;   // Имя текстового аргумента
+        const char *arg0;   // Имена числовых аргументов, nullptr — нет
+        const char *arg1;
+        bool keep_tail;     // Длинный текст (путь) обрезается с начала
+    };
+
+    inline const EventInfo &info(int id) {
+        static const EventInfo table[kEventCount] = {
+            {"begin", kLittleFS, "base", "max_open_files", "ok", true},
+            {"end", kLittleFS, nullptr, nullptr, nullptr, false},
+            {"mount_image", kLittleFS, nullptr, "bytes", "ok", false},
+            {"format", kLittleFS, nullptr, nullptr, "ok", false},
+            {"open", kLittleFS, "path", "create", "ok", true},
+            {"close", kLittleFS, "path", nullptr, nullptr, true},
+            {"read", kLittleFS, "path", "bytes", nullptr, true},
+            {"write", kLittleFS, "path", "bytes", nullptr, true},
+            {"mkdir", kLittleFS, "path", nullptr, "ok", true},
+            {"remove", kLittleFS, "path", nullptr, "ok", true},
+            {"rename", kLittleFS, "from", nullptr, "ok", true},
+            {"write", kSerial, "data", "port", "bytes", false},
+            {"alloc", kString, nullptr, "bytes", "arena", false},
+            {"mark", kSketch, "text", "a", "b", false},
+        };
+        return table[id];
+    }
+
+    inline const char *subsystemName(uint32_t subsystem) {
+        switch (subsystem) {
+            case kSerial: return "serial";
+            case kString: return "string";
+            case kLittleFS: return "littlefs";
+            default: return "sketch";
+        }
+    }
+
+    static const size_t kTextSize = 24;
+    static const size_t kDefaultCapacity = 1 << 16;
+
+    // Сколько текста поместится в событие и откуда его брать
+    inline size_t clipText(int id, const char *&text, size_t len) {
+        if (len <= kTextSize) return len;
+        if (info(id).keep_tail) text += len - kTextSize;
+        return kTextSize;
+    }
+
+    struct Event {
+        uint64_t ts_ns;      // От начала трассы
+        uint64_t dur_ns;     // 0 — мгновенное событие
+        int64_t args[2];
+        uint32_t tid;
+        uint16_t id;
+        uint8_t text_len;
+        uint8_t complete;    // Событие с длительностью
+        char text[kTextSize];
+    };
+
+    static_assert(sizeof(Event) == 64, "trace event must fill one cache line");
+
+    // Маска включённых подсистем
+    inline std::atomic<uint32_t> &mask() {
+        static std::atomic<uint32_t> value(0);
+        return value;
+    }
+
+    inline bool enabled(uint32_t subsystem) {
+        return (mask().load(std::memory_order_relaxed) & subsystem) != 0;
+    }
+
+    inline bool enabledFor(int id) { return enabled(info(id).subsystem); }
+
+    class Buffer {
+    public:
+        Buffer() : start_(std::chrono::steady_clock::now()), next_(0) {
+            events_.resize(kDefaultCapacity);
+        }
+
+        uint64_t now() const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start_).count();
+        }
+
+        void record(int id, uint64_t ts, uint64_t dur, bool complete,
+                    int64_t a0, int64_t a1, const char *text, size_t len) {
+            uint64_t n = next_.fetch_add(1, std::memory_order_relaxed);
+            Event &e = events_[n & (events_.size() - 1)];
+            e.ts_ns = ts;
+            e.dur_ns = dur;
+            e.args[0] = a0;
+            e.args[1] = a1;
+            e.tid = threadId();
+            e.id = static_cast<uint16_t>(id);
+            e.complete = complete;
+            len = clipText(id, text, len);
+            e.text_len = static_cast<uint8_t>(len);
+            if (len) memcpy(e.text, text, len);
+        }
+
+        // События в порядке записи (самые старые могли быть затёрты)
+        std::vector<Event> events() const {
+            uint64_t end = next_.load(std::memory_order_acquire);
+            uint64_t count = end < events_.size() ? end : events_.size();
+            std::vector<Event> out;
+            out.reserve(count);
+            for (uint64_t n = end - count; n < end; n++) {
+                out.push_back(events_[n & (events_.size() - 1)]);
+            }
+            return out;
+        }
+
+        uint64_t recorded() const { return next_.load(std::memory_order_relaxed); }
+        size_t capacity() const { return events_.size(); }
+
+        // Очищает буфер; ёмкость округляется вверх до степени двойки
+        void reset(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity) size <<= 1;
+            events_.assign(size, Event());
+            next_.store(0, std::memory_order_relaxed);
+            start_ = std::chrono::steady_clock::now();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start_;
+        std::atomic<uint64_t> next_;
+        std::vector<Event> events_;
+
+        static uint32_t threadId() {
+            static std::atomic<uint32_t> counter(0);
+            static thread_local uint32_t id = ++counter;
+            return id;
+        }
+    };
+
+    inline Buffer &buffer() {
+        // Не уничтожается: события пишутся и из деструкторов глобальных объектов
+        static Buffer *b = new Buffer();
+        return *b;
+    }
+
+    inline void enable(uint32_t subsystems) {
+        buffer();
+        mask().fetch_or(subsystems, std::memory_order_relaxed);
+    }
+
+    inline void disable(uint32_t subsystems) {
+        mask().fetch_and(~subsystems, std::memory_order_relaxed);
+    }
+
+    inline void clear(size_t capacity = kDefaultCapacity) { buffer().reset(capacity); }
+
+    // ARDUINOSTUB_TRACE=littlefs,serial,string,sketch или all
+    uint32_t enableFromEnvironment();
+
+    inline void instant(int id, int64_t a0 = 0, int64_t a1 = 0,
+                        const char *text = nullptr, size_t len = 0) {
+        if (!enabledFor(id)) return;
+        Buffer &b = buffer();
+        b.record(id, b.now(), 0, false, a0, a1, text, len);
+    }
+
+    inline void instant(int id, const std::string &text, int64_t a0 = 0, int64_t a1 = 0) {
+        if (!enabledFor(id)) return;
+        instant(id, a0, a1, text.data(), text.size());
+    }
+
+    // Отметка из кода скетча
+    inline void mark(const char *text, int64_t a = 0, int64_t b = 0) {
+        if (!enabled(kSketch)) return;
+        instant(kMark, a, b, text, strlen(text));
+    }
+
+    // Событие с длительностью: от создания до уничтожения объекта
+    class Scope {
+    public:
+        explicit Scope(int id) : id_(id), active_(enabledFor(id)), len_(0) {
+            if (active_) start();
+        }
+
+        Scope(int id, const std::string &text) : id_(id), active_(enabledFor(id)), len_(0) {
+            if (!active_) return;
+            setText(text.data(), text.size());
+            start();
+        }
+
+        Scope(int id, const char *text) : id_(id), active_(enabledFor(id)), len_(0) {
+            if (!active_) return;
+            if (text) setText(text, strlen(text));
+            start();
+        }
+
+        ~Scope() {
+            if (!active_) return;
+            Buffer &b = buffer();
+            b.record(id_, start_, b.now() - start_, true, args_[0], args_[1], text_, len_);
+        }
+
+        bool active() const { return active_; }
+        void arg0(int64_t v) { args_[0] = v; }
+        void arg1(int64_t v) { args_[1] = v; }
+
+    private:
+        int id_;
+        bool active_;
+        size_t len_;
+        uint64_t start_;
+        int64_t args_[2];
+        char text_[kTextSize];
+
+        void start() {
+            args_[0] = args_[1] = 0;
+            start_ = buffer().now();
+        }
+
+        void setText(const char *text, size_t len) {
+            len_ = clipText(id_, text, len);
+            memcpy(text_, text, len_);
+        }
+
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+    };
+
+    // Трасса в формате Chrome trace event (JSON Object Format)
+    void writeChromeJson(std::ostream &out);
+
+    bool saveChromeJson(const char *path);
+
+} // namespace stub_trace
+
+#endif // STUB_TRACE_H
@@ -0,0 +1,569 @@
+#include "wifi_stub.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+WiFiClass WiFi;
+
+bool IPAddress::fromString(const char *address) {
+    unsigned a, b, c, d;
+    char tail;
+    if (!address || sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4) return false;
+    if (a > 255 || b > 255 || c > 255 || d > 255) return false;
+    set(a, b, c, d);
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", bytes_[0], bytes_[1], bytes_[2], bytes_[3]);
+    return String(buffer);
+}
+
+namespace stub_net {
+
+    // Соединение или слушающий сокет. Живёт, пока на него ссылаются
+    // клиенты (или очередь сервера); удаляется только под мьютексом
+    // реактора, поэтому событие epoll не увидит удалённый объект.
+    class Socket {
+    public:
+        Socket(int fd, bool listening)
+            : fd(fd), listening(listening), want_out(false), ready_pos(0), tx_pos(0),
+              remote_ip(0), remote_port(0), local_port(0) {}
+
+        ~Socket() { closeFd(); }
+
+        void closeFd();
+
+        int fd;                     // -1 — закрыт
+        bool listening;
+        bool want_out;              // Ждём EPOLLOUT, чтобы дописать tx
+        // Пришедшее реактор дописывает в rx, скетч читает из ready. Когда
+        // ready прочитан, буферы меняются местами: указатель, который
+        // Stream получил из inputView, не испортит приём в другом потоке.
+        std::string rx;
+        std::string ready;
+        size_t ready_pos;
+        std::string tx;             // Не ушло в сокет сразу
+        size_t tx_pos;
+        std::deque<std::shared_ptr<Socket> > accepted;
+        uint32_t remote_ip;         // Порядок байт сети
+        uint16_t remote_port;
+        uint16_t local_port;
+    };
+
+    struct Reactor {
+        std::mutex mutex;
+        int epfd;
+        Stats stats;
+        std::unordered_map<uint16_t, uint16_t> ports;
+
+        Reactor() : epfd(epoll_create1(EPOLL_CLOEXEC)) {}
+    };
+
+    // Не разрушается при выходе: клиенты в глобальных объектах скетча
+    // закрываются позже статических переменных этого файла
+    static Reactor &reactor() {
+        static Reactor *instance = new Reactor();
+        return *instance;
+    }
+
+    void Socket::closeFd() {
+        if (fd < 0) return;
+        epoll_ctl(reactor().epfd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        fd = -1;
+    }
+
+    static uint16_t mappedLocked(uint16_t port) {
+        std::unordered_map<uint16_t, uint16_t>::const_iterator it = reactor().ports.find(port);
+        return it != reactor().ports.end() ? it->second : port;
+    }
+
+    static void watchLocked(Socket *socket, int op) {
+        epoll_event event;
+        event.events = EPOLLIN | (socket->want_out ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        event.data.ptr = socket;
+        epoll_ctl(reactor().epfd, op, socket->fd, &event);
+    }
+
+    static void setNonBlocking(int fd) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    static uint16_t boundPort(int fd) {
+        sockaddr_in address;
+        socklen_t len = sizeof(address);
+        if (getsockname(fd, reinterpret_cast<sockaddr *>(&address), &len) != 0) return 0;
+        return ntohs(address.sin_port);
+    }
+
+    static sockaddr_in loopback(uint16_t port) {
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        return address;
+    }
+
+    // Всё, что сейчас лежит в сокете, — в rx; 0 байт — соединение закрыто
+    static void receiveLocked(Socket *socket) {
+        char buffer[16384];
+        while (socket->fd >= 0) {
+            ssize_t n = recv(socket->fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                socket->rx.append(buffer, static_cast<size_t>(n));
+                reactor().stats.bytes_received += n;
+                if (static_cast<size_t>(n) < sizeof(buffer)) return;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                socket->closeFd();
+            }
+        }
+    }
+
+    static void sendLocked(Socket *socket) {
+        while (socket->fd >= 0 && socket->tx_pos < socket->tx.size()) {
+            ssize_t n = send(socket->fd, socket->tx.data() + socket->tx_pos,
+                             socket->tx.size() - socket->tx_pos, MSG_NOSIGNAL);
+            if (n > 0) {
+                socket->tx_pos += n;
+                reactor().stats.bytes_sent += n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else if (!(n < 0 && errno == EINTR)) {
+                socket->closeFd();
+            }
+        }
+        bool pending = socket->fd >= 0 && socket->tx_pos < socket->tx.size();
+        if (!pending) {
+            socket->tx.clear();
+            socket->tx_pos = 0;
+        }
+        if (socket->fd >= 0 && pending != socket->want_out) {
+            socket->want_out = pending;
+            watchLocked(socket, EPOLL_CTL_MOD);
+        }
+    }
+
+    static void acceptLocked(Socket *listener) {
+        for (;;) {
+            sockaddr_in address;
+            socklen_t len = sizeof(address);
+            int fd = accept4(listener->fd, reinterpret_cast<sockaddr *>(&address), &len,
+                             SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return;   // EAGAIN или кончились дескрипторы: остальные подождут
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            std::shared_ptr<Socket> socket(new Socket(fd, false));
+            socket->remote_ip = address.sin_addr.s_addr;
+            socket->remote_port = ntohs(address.sin_port);
+            socket->local_port = listener->local_port;
+            watchLocked(socket.get(), EPOLL_CTL_ADD);
+            listener->accepted.push_back(socket);
+            reactor().stats.accepts++;
+        }
+    }
+
+    static size_t pollLocked(int timeoutMs) {
+        static const int kBatch = 256;
+        epoll_event events[kBatch];
+        Reactor &r = reactor();
+        r.stats.polls++;
+        int n = epoll_wait(r.epfd, events, kBatch, timeoutMs);
+        if (n <= 0) return 0;
+        r.stats.events += n;
+        for (int i = 0; i < n; i++) {
+            Socket *socket = static_cast<Socket *>(events[i].data.ptr);
+            if (socket->fd < 0) continue;   // Закрыт раньше в этой же пачке
+            if (socket->listening) {
+                acceptLocked(socket);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) receiveLocked(socket);
+            if (events[i].events & EPOLLOUT) sendLocked(socket);
+        }
+        return static_cast<size_t>(n);
+    }
+
+    size_t poll(int timeoutMs) {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        return pollLocked(timeoutMs);
+    }
+
+    void mapPort(uint16_t port, uint16_t localPort) {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        if (localPort) reactor().ports[port] = localPort;
+        else reactor().ports.erase(port);
+    }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        return reactor().stats;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        reactor().stats = Stats();
+    }
+
+    // Непрочитанное в ready; если пусто — то, что принял реактор, при
+    // необходимости после прохода без ожидания
+    static size_t readyLocked(Socket *socket) {
+        if (socket->ready_pos < socket->ready.size()) return socket->ready.size() - socket->ready_pos;
+        socket->ready.clear();
+        socket->ready_pos = 0;
+        if (socket->rx.empty() && socket->fd >= 0) pollLocked(0);
+        socket->ready.swap(socket->rx);
+        return socket->ready.size();
+    }
+
+} // namespace stub_net
+
+using stub_net::Socket;
+using stub_net::reactor;
+
+WiFiClient::WiFiClient() {}
+
+WiFiClient::WiFiClient(const std::shared_ptr<Socket> &socket) : socket_(socket) {}
+
+WiFiClient::WiFiClient(const WiFiClient &other) : Stream(other), socket_(other.socket_) {}
+
+WiFiClient &WiFiClient::operator=(const WiFiClient &other) {
+    if (this == &other) return *this;
+    setTimeout(other.getTimeout());
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    socket_ = other.socket_;
+    return *this;
+}
+
+WiFiClient::~WiFiClient() {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    socket_.reset();
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    (void)ip;   // Любой адрес — localhost
+    return connect(static_cast<const char *>(nullptr), port, timeoutMs);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeoutMs) {
+    (void)host;
+    stop();
+    uint16_t target;
+    {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        target = stub_net::mappedLocked(port);
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 0;
+    stub_net::setNonBlocking(fd);
+    sockaddr_in address = stub_net::loopback(target);
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        // Неблокирующее подключение к localhost обычно завершается сразу
+        int error = errno;
+        if (error == EINPROGRESS) {
+            pollfd pfd = {fd, POLLOUT, 0};
+            socklen_t len = sizeof(error);
+            if (::poll(&pfd, 1, timeoutMs) != 1 ||
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0) {
+                error = ETIMEDOUT;
+            }
+        }
+        if (error != 0) {
+            ::close(fd);
+            return 0;
+        }
+    }
+
+    std::shared_ptr<Socket> socket(new Socket(fd, false));
+    socket->remote_ip = address.sin_addr.s_addr;
+    socket->remote_port = target;
+    socket->local_port = stub_net::boundPort(fd);
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    stub_net::watchLocked(socket.get(), EPOLL_CTL_ADD);
+    reactor().stats.connects++;
+    socket_ = socket;
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t *data, size_t size) {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    Socket *socket = socket_.get();
+    if (!socket || socket->fd < 0) {
+        setWriteError();
+        return 0;
+    }
+    socket->tx.append(reinterpret_cast<const char *>(data), size);
+    stub_net::sendLocked(socket);
+    if (socket->fd < 0) {
+        setWriteError();
+        return 0;
+    }
+    return size;
+}
+
+int WiFiClient::available() {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    if (!socket_) return 0;
+    size_t n = stub_net::readyLocked(socket_.get());
+    return static_cast<int>(n + socket_->rx.size());
+}
+
+int WiFiClient::read() {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    Socket *socket = socket_.get();
+    if (!socket || stub_net::readyLocked(socket) == 0) return -1;
+    return static_cast<uint8_t>(socket->ready[socket->ready_pos++]);
+}
+
+int WiFiClient::peek() {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    Socket *socket = socket_.get();
+    if (!socket || stub_net::readyLocked(socket) == 0) return -1;
+    return static_cast<uint8_t>(socket->ready[socket->ready_pos]);
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size) {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    Socket *socket = socket_.get();
+    if (!socket) return -1;
+    size_t n = stub_net::readyLocked(socket);
+    if (n == 0) return socket->fd >= 0 ? 0 : -1;
+    if (n > size) n = size;
+    memcpy(buffer, socket->ready.data() + socket->ready_pos, n);
+    socket->ready_pos += n;
+    return static_cast<int>(n);
+}
+
+size_t WiFiClient::inputView(const uint8_t *&data) {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    Socket *socket = socket_.get();
+    if (!socket) return 0;
+    size_t n = stub_net::readyLocked(socket);
+    data = reinterpret_cast<const uint8_t *>(socket->ready.data()) + socket->ready_pos;
+    return n;
+}
+
+void WiFiClient::consumeInput(size_t n) {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    if (socket_) socket_->ready_pos += n;
+}
+
+void WiFiClient::flush() {
+    // Дописывает очередь, ждёт не дольше таймаута Stream в реальном времени
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    Socket *socket = socket_.get();
+    if (!socket) return;
+    stub_net::sendLocked(socket);
+    unsigned long waited = 0;
+    while (socket->fd >= 0 && socket->want_out && waited < getTimeout()) {
+        pollfd pfd = {socket->fd, POLLOUT, 0};
+        ::poll(&pfd, 1, 10);
+        waited += 10;
+        stub_net::sendLocked(socket);
+    }
+}
+
+void WiFiClient::stop() {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    if (!socket_) return;
+    stub_net::sendLocked(socket_.get());
+    socket_->closeFd();
+    socket_.reset();
+}
+
+uint8_t WiFiClient::connected() {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    Socket *socket = socket_.get();
+    if (!socket) return 0;
+    size_t pending = stub_net::readyLocked(socket);
+    return socket->fd >= 0 || pending > 0 || !socket->rx.empty();
+}
+
+IPAddress WiFiClient::remoteIP() const {
+    if (!socket_) return IPAddress();
+    const uint8_t *ip = reinterpret_cast<const uint8_t *>(&socket_->remote_ip);
+    return IPAddress(ip[0], ip[1], ip[2], ip[3]);
+}
+
+uint16_t WiFiClient::remotePort() const { return socket_ ? socket_->remote_port : 0; }
+
+uint16_t WiFiClient::localPort() const { return socket_ ? socket_->local_port : 0; }
+
+void WiFiServer::begin(uint16_t port) {
+    if (port) port_ = port;
+    end();
+    uint16_t target;
+    {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        target = stub_net::mappedLocked(port_);
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address = stub_net::loopback(target);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return;
+    }
+
+    std::shared_ptr<Socket> listener(new Socket(fd, true));
+    listener->local_port = stub_net::boundPort(fd);
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    stub_net::watchLocked(listener.get(), EPOLL_CTL_ADD);
+    listener_ = listener;
+}
+
+void WiFiServer::end() {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    listener_.reset();
+}
+
+WiFiClient WiFiServer::accept() {
+    std::shared_ptr<Socket> socket;
+    {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        if (!listener_) return WiFiClient();
+        if (listener_->accepted.empty()) stub_net::pollLocked(0);
+        if (listener_->accepted.empty()) return WiFiClient();
+        socket = listener_->accepted.front();
+        listener_->accepted.pop_front();
+    }
+    return WiFiClient(socket);
+}
+
+bool WiFiServer::hasClient() {
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    if (!listener_) return false;
+    if (listener_->accepted.empty()) stub_net::pollLocked(0);
+    return !listener_->accepted.empty();
+}
+
+uint16_t WiFiServer::port() const {
+    if (listener_) return listener_->local_port;
+    std::lock_guard<std::mutex> lock(reactor().mutex);
+    return stub_net::mappedLocked(port_);
+}
+
+WiFiUDP::WiFiUDP()
+    : fd_(-1), local_port_(0), tx_port_(0), tx_open_(false), rx_pos_(0), remote_port_(0) {}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    uint16_t target;
+    {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        target = stub_net::mappedLocked(port);
+    }
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 0;
+    sockaddr_in address = stub_net::loopback(target);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return 0;
+    }
+    fd_ = fd;
+    local_port_ = stub_net::boundPort(fd);
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    local_port_ = 0;
+    rx_.clear();
+    rx_pos_ = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+    (void)ip;
+    return beginPacket(static_cast<const char *>(nullptr), port);
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+    (void)host;
+    // Отправка без begin(): сокет на свободном порту, как в ядре
+    if (fd_ < 0 && !begin(0)) return 0;
+    tx_.clear();
+    tx_port_ = port;
+    tx_open_ = true;
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t *data, size_t size) {
+    if (!tx_open_) return 0;
+    tx_.append(reinterpret_cast<const char *>(data), size);
+    return size;
+}
+
+int WiFiUDP::endPacket() {
+    if (!tx_open_ || fd_ < 0) return 0;
+    tx_open_ = false;
+    uint16_t target;
+    {
+        std::lock_guard<std::mutex> lock(reactor().mutex);
+        target = stub_net::mappedLocked(tx_port_);
+    }
+    sockaddr_in address = stub_net::loopback(target);
+    ssize_t n = sendto(fd_, tx_.data(), tx_.size(), 0,
+                       reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    return n == static_cast<ssize_t>(tx_.size()) ? 1 : 0;
+}
+
+int WiFiUDP::parsePacket() {
+    rx_.clear();
+    rx_pos_ = 0;
+    if (fd_ < 0) return 0;
+    // Размер датаграммы без чтения: буфер ровно под неё
+    ssize_t size = recv(fd_, nullptr, 0, MSG_PEEK | MSG_TRUNC);
+    if (size < 0) return 0;
+    rx_.resize(static_cast<size_t>(size));
+    // Пустую датаграмму тоже нужно вычитать, иначе она закроет очередь
+    char empty;
+    sockaddr_in address;
+    socklen_t len = sizeof(address);
+    ssize_t n = recvfrom(fd_, size ? &rx_[0] : &empty, rx_.size(), 0,
+                         reinterpret_cast<sockaddr *>(&address), &len);
+    if (n <= 0) {
+        rx_.clear();
+        return 0;
+    }
+    rx_.resize(static_cast<size_t>(n));
+    const uint8_t *ip = reinterpret_cast<const uint8_t *>(&address.sin_addr.s_addr);
+    remote_ip_ = IPAddress(ip[0], ip[1], ip[2], ip[3]);
+    remote_port_ = ntohs(address.sin_port);
+    return static_cast<int>(n);
+}
+
+int WiFiUDP::read(uint8_t *buffer, size_t size) {
+    size_t n = rx_.size() - rx_pos_;
+    if (n > size) n = size;
+    memcpy(buffer, rx_.data() + rx_pos_, n);
+    rx_pos_ += n;
+    return static_cast<int>(n);
+}
@@ -0,0 +1,271 @@
+#ifndef WIFI_STUB_H
+#define WIFI_STUB_H
+
+// WiFi, WiFiClient, WiFiServer и WiFiUDP ядра ESP32 поверх сокетов
+// localhost.
+//
+// Любое имя хоста и любой адрес означают 127.0.0.1, а порт можно
+// перенаправить: прошивка подключается к "mqtt.example.com":1883, а тест
+// поднимает брокер-заглушку на свободном порту.
+//
+//   WiFiServer broker(0);                       // порт выберет система
+//   broker.begin();
+//   stub_net::mapPort(1883, broker.port());
+//   client.connect("mqtt.example.com", 1883);   // попадёт в broker
+//
+// Все TCP-сокеты неблокирующие и зарегистрированы в одном epoll на
+// процесс. Реактор качает тот, кто ждёт данных: available(), read(),
+// connected() у клиента и accept() у сервера делают epoll_wait без
+// ожидания, а тест или цикл симуляции может вызвать stub_net::poll() сам.
+// Потоков на соединение нет, так что тысячи клиентов прошивки и
+// брокер-заглушка работают в одном потоке. Реактор общий для всех
+// потоков и защищён мьютексом.
+//
+// WiFiUDP реактор не использует: parsePacket() читает датаграмму
+// неблокирующим recvfrom. Реализация — wifi_stub.cpp, только Linux.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "arduino_stream_stub.h"
+#include "arduino_string_stub.h"
+
+class IPAddress {
+public:
+    IPAddress() { set(0, 0, 0, 0); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { set(a, b, c, d); }
+
+    // Как в ядре: первый октет — младший байт
+    IPAddress(uint32_t address) {
+        set(address & 0xFF, (address >> 8) & 0xFF, (address >> 16) & 0xFF, address >> 24);
+    }
+
+    operator uint32_t() const {
+        return bytes_[0] | (bytes_[1] << 8) | (bytes_[2] << 16) |
+               (static_cast<uint32_t>(bytes_[3]) << 24);
+    }
+
+    uint8_t operator[](int index) const { return bytes_[index]; }
+    uint8_t &operator[](int index) { return bytes_[index]; }
+    bool operator==(const IPAddress &other) const { return memcmp(bytes_, other.bytes_, 4) == 0; }
+    bool operator!=(const IPAddress &other) const { return !(*this == other); }
+
+    bool fromString(const char *address);
+    String toString() const;
+
+private:
+    void set(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        bytes_[0] = a;
+        bytes_[1] = b;
+        bytes_[2] = c;
+        bytes_[3] = d;
+    }
+
+    uint8_t bytes_[4];
+};
+
+namespace stub_net {
+
+    class Socket;
+
+    struct Stats {
+        uint64_t connects;      // Успешные WiFiClient::connect
+        uint64_t accepts;       // Соединения, принятые серверами
+        uint64_t bytes_sent;
+        uint64_t bytes_received;
+        uint64_t polls;         // Вызовы epoll_wait
+        uint64_t events;        // События, которые они вернули
+
+        Stats() : connects(0), accepts(0), bytes_sent(0), bytes_received(0), polls(0), events(0) {}
+    };
+
+    // Один проход реактора: ждёт событий не дольше timeoutMs (0 — не
+    // ждать) и разбирает их. Возвращает число событий.
+    size_t poll(int timeoutMs = 0);
+
+    // Подключения и серверы на порту port уходят на localPort; 0 — снять
+    void mapPort(uint16_t port, uint16_t localPort);
+
+    Stats stats();
+    void resetStats();
+
+} // namespace stub_net
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+// Сеть всегда есть: begin() сразу даёт WL_CONNECTED
+class WiFiClass {
+public:
+    WiFiClass() : status_(WL_IDLE_STATUS), mode_(WIFI_OFF) {}
+
+    wl_status_t begin(const char *ssid, const char *password = nullptr) {
+        (void)ssid;
+        (void)password;
+        if (mode_ == WIFI_OFF) mode_ = WIFI_STA;
+        return status_ = WL_CONNECTED;
+    }
+
+    bool disconnect(bool wifiOff = false) {
+        status_ = WL_DISCONNECTED;
+        if (wifiOff) mode_ = WIFI_OFF;
+        return true;
+    }
+
+    wl_status_t status() const { return status_; }
+    bool isConnected() const { return status_ == WL_CONNECTED; }
+    bool mode(wifi_mode_t mode) { mode_ = mode; return true; }
+    wifi_mode_t getMode() const { return mode_; }
+    IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+    int32_t RSSI() const { return status_ == WL_CONNECTED ? -50 : 0; }
+
+private:
+    wl_status_t status_;
+    wifi_mode_t mode_;
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient : public Stream {
+public:
+    WiFiClient();
+    WiFiClient(const WiFiClient &other);
+    WiFiClient &operator=(const WiFiClient &other);
+    ~WiFiClient();
+
+    // 1 — подключились, 0 — нет. Подключение к localhost ждёт не дольше
+    // timeoutMs реального времени.
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs = 3000);
+    int connect(const char *host, uint16_t port, int32_t timeoutMs = 3000);
+
+    // Байты, которые не ушли сразу, ждут в очереди реактора
+    using Print::write;
+    size_t write(const uint8_t *data, size_t size) override;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    int read(uint8_t *buffer, size_t size);
+    void flush() override;
+
+    // Закрывает соединение для всех копий клиента
+    void stop();
+
+    // Соединение открыто или есть непрочитанные данные
+    uint8_t connected();
+    operator bool() { return connected(); }
+
+    bool operator==(const WiFiClient &other) const { return socket_ == other.socket_; }
+    bool operator!=(const WiFiClient &other) const { return socket_ != other.socket_; }
+
+    IPAddress remoteIP() const;
+    uint16_t remotePort() const;
+    uint16_t localPort() const;
+
+    // TCP_NODELAY включён всегда: на localhost задержка Нейгла не нужна
+    int setNoDelay(bool nodelay) { (void)nodelay; return 0; }
+
+protected:
+    size_t inputView(const uint8_t *&data) override;
+    void consumeInput(size_t n) override;
+
+private:
+    friend class WiFiServer;
+    explicit WiFiClient(const std::shared_ptr<stub_net::Socket> &socket);
+
+    std::shared_ptr<stub_net::Socket> socket_;
+};
+
+class WiFiServer {
+public:
+    explicit WiFiServer(uint16_t port = 80) : port_(port) {}
+    ~WiFiServer() { end(); }
+
+    void begin(uint16_t port = 0);
+    void end();
+    void close() { end(); }
+    void stop() { end(); }
+
+    // Следующее принятое соединение; пустой клиент, если его нет
+    WiFiClient accept();
+    WiFiClient available() { return accept(); }
+    bool hasClient();
+
+    // Порт, на котором сервер слушает на самом деле (после mapPort и 0)
+    uint16_t port() const;
+    operator bool() const { return static_cast<bool>(listener_); }
+
+private:
+    WiFiServer(const WiFiServer &);
+    WiFiServer &operator=(const WiFiServer &);
+
+    uint16_t port_;
+    std::shared_ptr<stub_net::Socket> listener_;
+};
+
+class WiFiUDP : public Stream {
+public:
+    WiFiUDP();
+    ~WiFiUDP() { stop(); }
+
+    // 1 — сокет открыт на порту port (0 — любой свободный)
+    uint8_t begin(uint16_t port);
+    void stop();
+    uint16_t localPort() const { return local_port_; }
+
+    int beginPacket(IPAddress ip, uint16_t port);
+    int beginPacket(const char *host, uint16_t port);
+    int endPacket();
+
+    using Print::write;
+    size_t write(const uint8_t *data, size_t size) override;
+
+    // Размер следующей датаграммы, 0 — очередь пуста
+    int parsePacket();
+    int available() override { return static_cast<int>(rx_.size() - rx_pos_); }
+    int read() override { return rx_pos_ < rx_.size() ? static_cast<uint8_t>(rx_[rx_pos_++]) : -1; }
+    int peek() override { return rx_pos_ < rx_.size() ? static_cast<uint8_t>(rx_[rx_pos_]) : -1; }
+    int read(uint8_t *buffer, size_t size);
+    void flush() override {}
+
+    IPAddress remoteIP() const { return remote_ip_; }
+    uint16_t remotePort() const { return remote_port_; }
+
+protected:
+    size_t inputView(const uint8_t *&data) override {
+        data = reinterpret_cast<const uint8_t *>(rx_.data()) + rx_pos_;
+        return rx_.size() - rx_pos_;
+    }
+
+    void consumeInput(size_t n) override { rx_pos_ += n; }
+
+private:
+    WiFiUDP(const WiFiUDP &);
+    WiFiUDP &operator=(const WiFiUDP &);
+
+    int fd_;
+    uint16_t local_port_;
+    std::string tx_;
+    uint16_t tx_port_;
+    bool tx_open_;
+    std::string rx_;
+    size_t rx_pos_;
+    IPAddress remote_ip_;
+    uint16_t remote_port_;
+};
+
+#endif // WIFI_STUB_H
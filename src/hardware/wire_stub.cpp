@@ -0,0 +1,139 @@
+#include "wire_stub.h"
+
+#include <cstring>
+#include "stub_board.h"
+
+TwoWire Wire;
+
+namespace stub_i2c {
+
+    RegisterDevice::RegisterDevice(size_t registers, uint8_t width, bool autoIncrement)
+        : regs_((registers ? registers : 1) * (width ? width : 1), 0),
+          registers_(registers ? registers : 1), width_(width ? width : 1),
+          auto_increment_(autoIncrement), pointer_(0) {}
+
+    void RegisterDevice::set16(uint8_t reg, uint16_t value) {
+        size_t pos = offset(reg);
+        regs_[pos] = static_cast<uint8_t>(value >> 8);
+        regs_[nextByte(pos)] = static_cast<uint8_t>(value);
+    }
+
+    uint16_t RegisterDevice::get16(uint8_t reg) const {
+        size_t pos = offset(reg);
+        return static_cast<uint16_t>((regs_[pos] << 8) | regs_[nextByte(pos)]);
+    }
+
+    size_t RegisterDevice::nextByte(size_t pos) const {
+        size_t next = pos + 1;
+        if (!auto_increment_ && next % width_ == 0) return next - width_;
+        return next < regs_.size() ? next : 0;
+    }
+
+    bool RegisterDevice::receive(const uint8_t *data, size_t len) {
+        if (len == 0) return true;
+        pointer_ = data[0];
+        size_t count = len - 1;
+        if (count == 0) return true;
+        size_t pos = offset(pointer_);
+        if (auto_increment_ && pos + count <= regs_.size()) {
+            memcpy(regs_.data() + pos, data + 1, count);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                regs_[pos] = data[1 + i];
+                pos = nextByte(pos);
+            }
+        }
+        onWrite(pointer_, count);
+        return true;
+    }
+
+    size_t RegisterDevice::transmit(uint8_t *data, size_t len) {
+        onRead(pointer_);
+        size_t pos = offset(pointer_);
+        // Обычный случай — чтение подряд внутри карты одним memcpy
+        if (auto_increment_ && pos + len <= regs_.size()) {
+            memcpy(data, regs_.data() + pos, len);
+            return len;
+        }
+        for (size_t i = 0; i < len; i++) {
+            data[i] = regs_[pos];
+            pos = nextByte(pos);
+        }
+        return len;
+    }
+
+    size_t Bus::deviceCount() const {
+        size_t count = 0;
+        for (int i = 0; i < kAddresses; i++) count += devices_[i] != nullptr;
+        return count;
+    }
+
+    void Bus::charge(size_t bytes) {
+        // Старт, адрес с ACK, bytes байт по 9 тактов, стоп
+        uint64_t bits = 1 + 9 * (1 + static_cast<uint64_t>(bytes)) + 1;
+        uint64_t us = (bits * 1000000 + clock_ - 1) / clock_;
+        stats_.transactions++;
+        stats_.bytes += bytes;
+        stats_.busy_us += us;
+        stub_board::advanceMicros(stub_board::current(), static_cast<unsigned long>(us));
+    }
+
+    uint8_t Bus::write(uint8_t address, const uint8_t *data, size_t len) {
+        Device *dev = devices_[address & 0x7F];
+        if (!dev) {
+            charge(0);
+            stats_.nacks++;
+            return 2;
+        }
+        charge(len);
+        if (!dev->receive(data, len)) {
+            stats_.nacks++;
+            return 3;
+        }
+        return 0;
+    }
+
+    size_t Bus::read(uint8_t address, uint8_t *data, size_t len) {
+        Device *dev = devices_[address & 0x7F];
+        if (!dev) {
+            charge(0);
+            stats_.nacks++;
+            return 0;
+        }
+        size_t n = dev->transmit(data, len);
+        charge(n);
+        return n;
+    }
+
+} // namespace stub_i2c
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    transmitting_ = false;
+    if (getWriteError()) {
+        clearWriteError();
+        return 1;
+    }
+    return bus_.write(tx_address_, tx_, tx_len_);
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity, int sendStop) {
+    (void)sendStop;
+    size_t len = quantity > 0 ? static_cast<size_t>(quantity) : 0;
+    if (len > kBufferLength) len = kBufferLength;
+    rx_pos_ = 0;
+    rx_len_ = bus_.read(static_cast<uint8_t>(address), rx_, len);
+    return static_cast<uint8_t>(rx_len_);
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t size) {
+    if (!transmitting_) return 0;
+    size_t n = size;
+    if (n > kBufferLength - tx_len_) {
+        n = kBufferLength - tx_len_;
+        setWriteError();
+    }
+    memcpy(tx_ + tx_len_, data, n);
+    tx_len_ += n;
+    return n;
+}
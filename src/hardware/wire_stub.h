@@ -0,0 +1,201 @@
+#ifndef WIRE_STUB_H
+#define WIRE_STUB_H
+
+// Wire (TwoWire) поверх симулятора шины I2C.
+//
+// Тест вешает на шину модели устройств по 7-битным адресам, скетч
+// работает с ними через обычный Wire:
+//
+//   stub_i2c::RegisterDevice bme(256);        // 256 однобайтовых регистров
+//   bme.set8(0xD0, 0x60);                     // chip id BME280
+//   Wire.bus().attach(0x76, &bme);
+//
+//   Wire.beginTransmission(0x76);
+//   Wire.write(0xD0);
+//   Wire.endTransmission(false);
+//   Wire.requestFrom(0x76, 1);
+//   uint8_t id = Wire.read();                 // 0x60
+//
+// Устройства лежат в таблице на 128 адресов, регистры модели — плоский
+// массив байт, так что опрос в цикле не выделяет память и не ищет по
+// спискам. Каждая транзакция стоит времени на шине по setClock()
+// (100 кГц по умолчанию, 400 кГц fast mode): 9 тактов на байт с ACK,
+// плюс старт и стоп. Это время добавляется к часам платы (stub_board.h).
+// Реализация — wire_stub.cpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "arduino_stream_stub.h"
+
+namespace stub_i2c {
+
+    // Модель устройства на шине
+    class Device {
+    public:
+        virtual ~Device() {}
+
+        // Мастер записал байты; false — устройство ответило NACK
+        virtual bool receive(const uint8_t *data, size_t len) = 0;
+
+        // Мастер читает len байт; возвращает, сколько отдано
+        virtual size_t transmit(uint8_t *data, size_t len) = 0;
+    };
+
+    // Устройство с картой регистров: первый записанный байт — номер
+    // регистра, дальше запись или чтение с него. Регистры шириной width
+    // байт (старший первым, как у INA219) лежат подряд в одном массиве.
+    class RegisterDevice : public Device {
+    public:
+        explicit RegisterDevice(size_t registers = 256, uint8_t width = 1,
+                                bool autoIncrement = true);
+
+        bool receive(const uint8_t *data, size_t len) override;
+        size_t transmit(uint8_t *data, size_t len) override;
+
+        // Карта регистров для теста: регистр r занимает байты r*width ...
+        uint8_t *regs() { return regs_.data(); }
+        size_t registers() const { return registers_; }
+        uint8_t width() const { return width_; }
+
+        void set8(uint8_t reg, uint8_t value) { regs_[offset(reg)] = value; }
+        uint8_t get8(uint8_t reg) const { return regs_[offset(reg)]; }
+        void set16(uint8_t reg, uint16_t value);
+        uint16_t get16(uint8_t reg) const;
+
+        // Текущий регистр (указатель, записанный мастером)
+        uint8_t pointer() const { return pointer_; }
+
+    protected:
+        // Перед чтением с регистра reg: модель может обновить значения
+        virtual void onRead(uint8_t reg) { (void)reg; }
+        // После записи count байт начиная с регистра reg
+        virtual void onWrite(uint8_t reg, size_t count) { (void)reg; (void)count; }
+
+    private:
+        size_t offset(uint8_t reg) const { return (reg % registers_) * width_; }
+        // Байт, следующий за pos при чтении или записи подряд
+        size_t nextByte(size_t pos) const;
+
+        std::vector<uint8_t> regs_;
+        size_t registers_;
+        uint8_t width_;
+        bool auto_increment_;
+        uint8_t pointer_;
+    };
+
+    // Шина: устройства по адресам и учёт времени обмена
+    class Bus {
+    public:
+        static const int kAddresses = 128;
+
+        struct Stats {
+            uint64_t transactions;
+            uint64_t bytes;
+            uint64_t nacks;
+            uint64_t busy_us;     // Время на шине при текущих частотах
+
+            Stats() : transactions(0), bytes(0), nacks(0), busy_us(0) {}
+        };
+
+        Bus() : clock_(100000) {
+            for (int i = 0; i < kAddresses; i++) devices_[i] = nullptr;
+        }
+
+        // Устройство не принадлежит шине и должно жить, пока подключено
+        void attach(uint8_t address, Device *device) { devices_[address & 0x7F] = device; }
+        void detach(uint8_t address) { devices_[address & 0x7F] = nullptr; }
+        Device *device(uint8_t address) const { return devices_[address & 0x7F]; }
+        size_t deviceCount() const;
+
+        void setClock(uint32_t hz) { clock_ = hz ? hz : 100000; }
+        uint32_t clock() const { return clock_; }
+
+        // Запись: 0 — успех, 2 — NACK на адресе, 3 — NACK на данных
+        uint8_t write(uint8_t address, const uint8_t *data, size_t len);
+
+        // Чтение: сколько байт получено, 0 — NACK на адресе
+        size_t read(uint8_t address, uint8_t *data, size_t len);
+
+        const Stats &stats() const { return stats_; }
+        void resetStats() { stats_ = Stats(); }
+
+    private:
+        // Время транзакции из bytes байт после адреса, в микросекундах
+        void charge(size_t bytes);
+
+        Device *devices_[kAddresses];
+        uint32_t clock_;
+        Stats stats_;
+    };
+
+} // namespace stub_i2c
+
+class TwoWire : public Stream {
+public:
+    // Размер буферов передачи и приёма, как у Wire в ESP32/ESP8266
+    static const size_t kBufferLength = 128;
+
+    TwoWire() : tx_address_(0), tx_len_(0), transmitting_(false), rx_pos_(0), rx_len_(0) {}
+
+    void begin() {}
+    void end() {}
+
+    void setClock(uint32_t hz) { bus_.setClock(hz); }
+    uint32_t getClock() const { return bus_.clock(); }
+
+    void beginTransmission(uint8_t address) {
+        tx_address_ = address;
+        tx_len_ = 0;
+        transmitting_ = true;
+    }
+
+    void beginTransmission(int address) { beginTransmission(static_cast<uint8_t>(address)); }
+
+    // 0 — успех, 1 — данные не поместились в буфер, 2 — NACK на адресе,
+    // 3 — NACK на данных. sendStop на симуляцию не влияет.
+    uint8_t endTransmission(bool sendStop = true);
+
+    // Сколько байт получено; 0 — NACK на адресе
+    uint8_t requestFrom(int address, int quantity, int sendStop = true);
+
+    using Print::write;
+    size_t write(const uint8_t *data, size_t size) override;
+
+    // Как в AVR Wire: write(0) и прочие числа — один байт
+    size_t write(int n) { return write(static_cast<uint8_t>(n)); }
+    size_t write(unsigned int n) { return write(static_cast<uint8_t>(n)); }
+    size_t write(long n) { return write(static_cast<uint8_t>(n)); }
+    size_t write(unsigned long n) { return write(static_cast<uint8_t>(n)); }
+
+    int available() override { return static_cast<int>(rx_len_ - rx_pos_); }
+
+    int read() override { return rx_pos_ < rx_len_ ? rx_[rx_pos_++] : -1; }
+
+    int peek() override { return rx_pos_ < rx_len_ ? rx_[rx_pos_] : -1; }
+
+    // Шина, на которую тест вешает модели устройств
+    stub_i2c::Bus &bus() { return bus_; }
+
+protected:
+    size_t inputView(const uint8_t *&data) override {
+        data = rx_ + rx_pos_;
+        return rx_len_ - rx_pos_;
+    }
+
+    void consumeInput(size_t n) override { rx_pos_ += n; }
+
+private:
+    stub_i2c::Bus bus_;
+    uint8_t tx_address_;
+    uint8_t tx_[kBufferLength];
+    size_t tx_len_;
+    bool transmitting_;
+    uint8_t rx_[kBufferLength];
+    size_t rx_pos_;
+    size_t rx_len_;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_STUB_H
@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""Образ LittleFS v2 для test_littlefs_image: littlefs_512x64.bin.
+
+  python3 src/test/fixtures/make_littlefs_fixture.py [--spec] [файл]
+
+Если установлен littlefs-python (pip install littlefs-python), образ
+собирает настоящая библиотека LittleFS. Без него (или с --spec) образ
+кодируется здесь по SPEC.md littlefs: отдельно от littlefs_image.cpp, на
+Python и с CRC из zlib, чтобы ошибка в кодировщике заглушки не повторилась
+в эталоне. Закоммиченный образ собран вторым способом, в нём то, чего
+кодировщик заглушки не пишет: несколько коммитов в одном блоке, CREATE и
+DELETE со сдвигом id, XOR-цепочка тегов через CRC-тег коммита.
+
+Дерево (test_littlefs_image.cpp проверяет именно его):
+  /config.json                  inline, {"mode":2}
+  /data/empty.txt               inline, пустой
+  /data/log.bin                 CTZ, 3000 байт, байт i = (i * 7 + 3) & 0xff
+  /data/nested/deep/note.txt    inline, deep
+  /etc/                         пустой каталог
+  /readme.txt                   inline, hello from littlefs\\n
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+BLOCK_SIZE = 512
+BLOCK_COUNT = 64
+PROG_SIZE = 16
+NAME_MAX = 255
+FILE_MAX = 2147483647
+ATTR_MAX = 1022
+DISK_VERSION = 0x00020000
+
+README = b"hello from littlefs\n"
+CONFIG = b'{"mode":2}'
+NOTE = b"deep"
+LOG = bytes((i * 7 + 3) & 0xFF for i in range(3000))
+
+
+def build_with_littlefs():
+    from littlefs import LittleFS
+
+    fs = LittleFS(block_size=BLOCK_SIZE, block_count=BLOCK_COUNT,
+                  prog_size=PROG_SIZE, read_size=PROG_SIZE, name_max=NAME_MAX)
+    fs.mkdir("data")
+    fs.mkdir("etc")
+    for path, data in (("readme.txt", README), ("old.txt", b"removed"),
+                       ("data/empty.txt", b""), ("data/log.bin", LOG),
+                       ("config.json", CONFIG)):
+        with fs.open(path, "wb") as f:
+            f.write(data)
+    fs.remove("old.txt")
+    fs.makedirs("data/nested/deep")
+    with fs.open("data/nested/deep/note.txt", "wb") as f:
+        f.write(NOTE)
+    return bytes(fs.context.buffer)
+
+
+# --- Кодирование по SPEC.md --------------------------------------------------
+
+TYPE_REG = 0x001
+TYPE_DIR = 0x002
+TYPE_SUPERBLOCK = 0x0FF
+TYPE_DIRSTRUCT = 0x200
+TYPE_INLINESTRUCT = 0x201
+TYPE_CTZSTRUCT = 0x202
+TYPE_CREATE = 0x401
+TYPE_DELETE = 0x4FF
+TYPE_SOFTTAIL = 0x600
+TYPE_CRC = 0x500
+NO_ID = 0x3FF
+
+
+def lfs_crc(crc, data):
+    # CRC-32 littlefs: тот же полином, что в zlib, без начальной и
+    # финальной инверсии
+    return zlib.crc32(data, crc ^ 0xFFFFFFFF) ^ 0xFFFFFFFF
+
+
+def mktag(type_, id_, size):
+    return (type_ << 20) | (id_ << 10) | size
+
+
+class MetadataBlock:
+    """Блок пары метаданных: счётчик ревизий и журнал коммитов."""
+
+    def __init__(self, rev):
+        self.buf = bytearray(struct.pack("<I", rev))
+        self.ptag = 0xFFFFFFFF
+        self.commit_start = 0
+        self.attrs = []
+
+    def attr(self, type_, id_, data=b""):
+        self.attrs.append((mktag(type_, id_, len(data)), data))
+
+    def commit(self):
+        start = len(self.buf)
+        for tag, data in self.attrs:
+            self.buf += struct.pack(">I", (tag & 0x7FFFFFFF) ^ self.ptag)
+            self.buf += data
+            self.ptag = tag & 0x7FFFFFFF
+        self.attrs = []
+        # CRC-тег: дополняет коммит до границы prog_size; CRC считается с
+        # начала коммита (у первого — вместе со счётчиком ревизий)
+        off = len(self.buf)
+        end = (off + 8 + PROG_SIZE - 1) // PROG_SIZE * PROG_SIZE
+        tag = mktag(TYPE_CRC, NO_ID, end - (off + 4))
+        self.buf += struct.pack(">I", tag ^ self.ptag)
+        crc_from = 0 if self.commit_start == 0 else start
+        crc = lfs_crc(0xFFFFFFFF, bytes(self.buf[crc_from:]))
+        self.buf += struct.pack("<I", crc)
+        self.buf += b"\xff" * (end - len(self.buf))
+        # Следующее слово стёрто (0xffffffff), бит сброса — 0
+        self.ptag = tag
+        self.commit_start = len(self.buf)
+
+
+def pair_struct(pair):
+    return struct.pack("<II", *pair)
+
+
+def write_ctz(image, blocks, data):
+    """CTZ skip-list: блок i > 0 начинается с ctz(i) + 1 указателей
+    на блоки i - 2^k, блок 0 — только данные."""
+    pos = 0
+    for i, block in enumerate(blocks):
+        raw = bytearray()
+        if i > 0:
+            skips = (i & -i).bit_length()
+            for k in range(skips):
+                raw += struct.pack("<I", blocks[i - (1 << k)])
+        take = BLOCK_SIZE - len(raw)
+        raw += data[pos:pos + take]
+        pos += take
+        image[block * BLOCK_SIZE:block * BLOCK_SIZE + len(raw)] = raw
+    assert pos >= len(data), "not enough CTZ blocks"
+
+
+def build_from_spec():
+    image = bytearray(b"\xff" * (BLOCK_SIZE * BLOCK_COUNT))
+    root, data_dir, etc, nested, deep = (0, 1), (2, 3), (4, 5), (6, 7), (8, 9)
+    log_blocks = list(range(10, 16))
+
+    def place(pair, block):
+        image[pair[0] * BLOCK_SIZE:pair[0] * BLOCK_SIZE + len(block.buf)] = block.buf
+
+    superblock = struct.pack("<IIIIII", DISK_VERSION, BLOCK_SIZE, BLOCK_COUNT,
+                             NAME_MAX, FILE_MAX, ATTR_MAX)
+
+    # Корень: компактный коммит, затем создание config.json (сдвигает id),
+    # затем запись его содержимого и удаление old.txt. Второй блок пары
+    # стёрт, как после форматирования.
+    b = MetadataBlock(rev=1)
+    b.attr(TYPE_SUPERBLOCK, 0, b"littlefs")
+    b.attr(TYPE_INLINESTRUCT, 0, superblock)
+    b.attr(TYPE_DIR, 1, b"data")
+    b.attr(TYPE_DIRSTRUCT, 1, pair_struct(data_dir))
+    b.attr(TYPE_DIR, 2, b"etc")
+    b.attr(TYPE_DIRSTRUCT, 2, pair_struct(etc))
+    b.attr(TYPE_REG, 3, b"old.txt")
+    b.attr(TYPE_INLINESTRUCT, 3, b"removed")
+    b.attr(TYPE_REG, 4, b"readme.txt")
+    b.attr(TYPE_INLINESTRUCT, 4, README)
+    b.attr(TYPE_SOFTTAIL, NO_ID, pair_struct(etc))
+    b.commit()
+    b.attr(TYPE_CREATE, 1)
+    b.attr(TYPE_REG, 1, b"config.json")
+    b.attr(TYPE_INLINESTRUCT, 1, b"")
+    b.commit()
+    b.attr(TYPE_INLINESTRUCT, 1, CONFIG)
+    b.attr(TYPE_DELETE, 4)
+    b.commit()
+    place(root, b)
+
+    # /etc без записей, в ревизии 2 на втором блоке пары; первый блок —
+    # старая ревизия с тем же содержимым
+    for block, rev in ((etc[0], 1), (etc[1], 2)):
+        e = MetadataBlock(rev=rev)
+        e.attr(TYPE_SOFTTAIL, NO_ID, pair_struct(data_dir))
+        e.commit()
+        image[block * BLOCK_SIZE:block * BLOCK_SIZE + len(e.buf)] = e.buf
+
+    d = MetadataBlock(rev=1)
+    d.attr(TYPE_REG, 0, b"empty.txt")
+    d.attr(TYPE_INLINESTRUCT, 0, b"")
+    d.attr(TYPE_REG, 1, b"log.bin")
+    d.attr(TYPE_CTZSTRUCT, 1, struct.pack("<II", log_blocks[-1], len(LOG)))
+    d.attr(TYPE_DIR, 2, b"nested")
+    d.attr(TYPE_DIRSTRUCT, 2, pair_struct(nested))
+    d.attr(TYPE_SOFTTAIL, NO_ID, pair_struct(nested))
+    d.commit()
+    place(data_dir, d)
+
+    n = MetadataBlock(rev=1)
+    n.attr(TYPE_DIR, 0, b"deep")
+    n.attr(TYPE_DIRSTRUCT, 0, pair_struct(deep))
+    n.attr(TYPE_SOFTTAIL, NO_ID, pair_struct(deep))
+    n.commit()
+    place(nested, n)
+
+    p = MetadataBlock(rev=1)
+    p.attr(TYPE_REG, 0, b"note.txt")
+    p.attr(TYPE_INLINESTRUCT, 0, NOTE)
+    p.commit()
+    place(deep, p)
+
+    write_ctz(image, log_blocks, LOG)
+    return bytes(image)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--spec", action="store_true",
+                        help="encode from SPEC.md even if littlefs-python is installed")
+    parser.add_argument("output", nargs="?", default=os.path.join(here, "littlefs_512x64.bin"))
+    args = parser.parse_args()
+    image = None
+    if not args.spec:
+        try:
+            image = build_with_littlefs()
+            print("built with littlefs-python")
+        except ImportError:
+            print("littlefs-python is not installed, encoding from SPEC.md")
+    if image is None:
+        image = build_from_spec()
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("%s: %d bytes" % (args.output, len(image)))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,352 @@
+#ifndef FORK_RUNNER_H
+#define FORK_RUNNER_H
+
+// Запуск тестов в отдельных процессах: каждый случай — в fork() от
+// готовых фикстур.
+//
+// Serial, смонтированный LittleFS, часы millis() и прочее глобальное
+// состояние заглушек общие на процесс. Раннер один раз выполняет то, что
+// тест подготовил до run(), а затем запускает каждый случай в дочернем
+// процессе: тот получает копию памяти при записи (copy-on-write) и может
+// менять что угодно — следующий случай снова начнёт с фикстур. Сброс
+// состояния стоит одного fork(), случаи идут параллельно по числу ядер.
+//
+//   fork_runner::Runner runner(argc, argv);
+//   LittleFS.mountImage(image.data(), image.size());  // Фикстуры — один раз
+//   runner.add("config/save", test_save);
+//   runner.add("config/defaults", test_defaults);
+//   return runner.run();
+//
+// Вывод случая (stdout и stderr) идёт по каналу (pipe) в родителя и
+// печатается целиком, когда случай упал (assert, сигнал, исключение,
+// ненулевой код) или с --verbose. Результаты печатаются в порядке
+// add(), независимо от того, какой процесс закончил раньше.
+//
+// Параметры командной строки:
+//   --jobs N        сколько случаев одновременно (по умолчанию — ядра)
+//   --filter TEXT   только случаи, в имени которых есть TEXT
+//   --timeout SEC   случай дольше этого убивается (по умолчанию 60)
+//   --no-fork       все случаи по очереди в этом процессе, для отладчика;
+//                   состояние тогда не изолировано
+//   --verbose       печатать вывод и успешных случаев
+//   --quiet         печатать только упавшие случаи и итог
+//
+// Изолирована только память. Каталог на диске (LittleFS.begin(path),
+// файлы в /tmp) общий для всех процессов: для фикстур берите образ в
+// памяти (mountImage, setPartition). Потоки родителя в дочерний процесс
+// не переходят — фикстуры с потоками (реактор WiFi) создавайте в самом
+// случае.
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fork_runner {
+
+    struct Result {
+        std::string name;
+        bool passed;
+        int exit_code;      // -1 — процесс завершён сигналом
+        int signal;         // 0 — без сигнала
+        bool timed_out;
+        double ms;
+        std::string output;
+
+        Result() : passed(false), exit_code(0), signal(0), timed_out(false), ms(0) {}
+    };
+
+    class Runner {
+    public:
+        Runner(int argc = 0, char **argv = nullptr)
+            : jobs_(defaultJobs()), timeout_s_(60), fork_(true), verbose_(false), quiet_(false) {
+            for (int i = 1; i < argc; i++) {
+                std::string arg = argv[i];
+                const char *value = i + 1 < argc ? argv[i + 1] : "";
+                if (arg == "--jobs") {
+                    jobs_ = std::max(1, atoi(value));
+                    i++;
+                } else if (arg == "--filter") {
+                    filter_ = value;
+                    i++;
+                } else if (arg == "--timeout") {
+                    timeout_s_ = atof(value);
+                    i++;
+                } else if (arg == "--no-fork") {
+                    fork_ = false;
+                } else if (arg == "--verbose") {
+                    verbose_ = true;
+                } else if (arg == "--quiet") {
+                    quiet_ = true;
+                } else {
+                    std::cerr << "Unknown option: " << arg << std::endl;
+                }
+            }
+        }
+
+        void add(const std::string &name, std::function<void()> fn) {
+            Case c = {name, fn};
+            cases_.push_back(c);
+        }
+
+        void setJobs(int jobs) { jobs_ = std::max(1, jobs); }
+        void setTimeout(double seconds) { timeout_s_ = seconds; }
+        void setVerbose(bool verbose) { verbose_ = verbose; }
+        void setQuiet(bool quiet) { quiet_ = quiet; }
+
+        // 0 — все случаи прошли
+        int run() {
+            std::vector<size_t> selected;
+            for (size_t i = 0; i < cases_.size(); i++) {
+                if (filter_.empty() || cases_[i].name.find(filter_) != std::string::npos) {
+                    selected.push_back(i);
+                }
+            }
+            results_.assign(selected.size(), Result());
+            done_.assign(selected.size(), false);
+            printed_ = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            if (fork_) {
+                runForked(selected);
+            } else {
+                for (size_t i = 0; i < selected.size(); i++) runInProcess(i, cases_[selected[i]]);
+            }
+
+            size_t failed = 0;
+            for (size_t i = 0; i < results_.size(); i++) {
+                if (!results_[i].passed) failed++;
+            }
+            double ms = elapsedMs(start);
+            std::cout << "\n" << results_.size() - failed << " passed, " << failed << " failed in "
+                      << ms << " ms";
+            if (fork_) std::cout << " (" << jobs_ << " jobs)";
+            std::cout << std::endl;
+            return failed ? 1 : 0;
+        }
+
+        const std::vector<Result> &results() const { return results_; }
+        // false — --no-fork: случаи меняли состояние этого процесса
+        bool isolated() const { return fork_; }
+
+    private:
+        struct Case {
+            std::string name;
+            std::function<void()> fn;
+        };
+
+        struct Child {
+            size_t index;
+            pid_t pid;
+            int fd;
+            std::chrono::steady_clock::time_point start;
+            bool killed;
+        };
+
+        static int defaultJobs() {
+            long cores = sysconf(_SC_NPROCESSORS_ONLN);
+            return cores > 0 ? static_cast<int>(cores) : 1;
+        }
+
+        static double elapsedMs(std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                .count();
+        }
+
+        // Случай в дочернем процессе: вывод — в канал, итог — кодом выхода
+        static void runChild(const Case &c, int fd) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+            // Без буфера: assert и сигнал не дадут его сбросить
+            setvbuf(stdout, nullptr, _IONBF, 0);
+            int code = 0;
+            try {
+                c.fn();
+            } catch (const std::exception &e) {
+                std::cerr << "exception: " << e.what() << std::endl;
+                code = 1;
+            } catch (...) {
+                std::cerr << "unknown exception" << std::endl;
+                code = 1;
+            }
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(nullptr);
+            // Без деструкторов статических объектов: они принадлежат фикстурам родителя
+            _exit(code);
+        }
+
+        void runForked(const std::vector<size_t> &selected) {
+            std::vector<Child> running;
+            size_t next = 0;
+            while (next < selected.size() || !running.empty()) {
+                while (next < selected.size() && running.size() < static_cast<size_t>(jobs_)) {
+                    running.push_back(start(next, cases_[selected[next]]));
+                    next++;
+                }
+                drain(running);
+            }
+        }
+
+        Child start(size_t index, const Case &c) {
+            results_[index].name = c.name;
+            // Буферы вывода сбрасываются до fork(), иначе их напечатают оба процесса
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(nullptr);
+            int fds[2];
+            Child child = {index, -1, -1, std::chrono::steady_clock::now(), false};
+            if (pipe(fds) != 0) {
+                fail(index, "pipe() failed");
+                return child;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                runChild(c, fds[1]);
+            }
+            close(fds[1]);
+            if (pid < 0) {
+                close(fds[0]);
+                fail(index, "fork() failed");
+                return child;
+            }
+            child.pid = pid;
+            child.fd = fds[0];
+            return child;
+        }
+
+        // Читает вывод всех запущенных случаев; закончившиеся убирает
+        void drain(std::vector<Child> &running) {
+            std::vector<pollfd> fds(running.size());
+            int wait_ms = -1;
+            for (size_t i = 0; i < running.size(); i++) {
+                fds[i].fd = running[i].fd;
+                fds[i].events = POLLIN;
+                fds[i].revents = 0;
+                if (running[i].fd < 0) {
+                    wait_ms = 0;    // Не запустился: убрать без ожидания
+                } else if (!running[i].killed && wait_ms != 0) {
+                    double left = timeout_s_ * 1000 - elapsedMs(running[i].start);
+                    int ms = left > 0 ? static_cast<int>(left) + 1 : 0;
+                    if (wait_ms < 0 || ms < wait_ms) wait_ms = ms;
+                }
+            }
+            poll(fds.data(), fds.size(), wait_ms);
+
+            for (size_t i = 0; i < running.size();) {
+                Child &child = running[i];
+                bool finished = child.fd < 0;
+                if (!finished && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    char buffer[4096];
+                    ssize_t n = read(child.fd, buffer, sizeof(buffer));
+                    if (n > 0) {
+                        results_[child.index].output.append(buffer, static_cast<size_t>(n));
+                    } else {
+                        finished = true;
+                    }
+                }
+                if (!finished && !child.killed && elapsedMs(child.start) > timeout_s_ * 1000) {
+                    kill(child.pid, SIGKILL);
+                    child.killed = true;
+                }
+                if (finished) {
+                    reap(child);
+                    fds.erase(fds.begin() + i);
+                    running.erase(running.begin() + i);
+                } else {
+                    i++;
+                }
+            }
+        }
+
+        void reap(const Child &child) {
+            Result &r = results_[child.index];
+            if (child.pid > 0) {
+                close(child.fd);
+                int status = 0;
+                waitpid(child.pid, &status, 0);
+                r.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+                r.signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+                r.timed_out = child.killed;
+                r.passed = r.exit_code == 0;
+                r.ms = elapsedMs(child.start);
+            }
+            finish(child.index);
+        }
+
+        void runInProcess(size_t index, const Case &c) {
+            Result &r = results_[index];
+            r.name = c.name;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            r.passed = true;
+            try {
+                c.fn();
+            } catch (const std::exception &e) {
+                r.output = std::string("exception: ") + e.what() + "\n";
+                r.passed = false;
+                r.exit_code = 1;
+            }
+            r.ms = elapsedMs(start);
+            finish(index);
+        }
+
+        void fail(size_t index, const char *why) {
+            results_[index].output = std::string(why) + "\n";
+            results_[index].exit_code = 1;
+        }
+
+        // Печать по порядку add(): результат ждёт, пока напечатаны предыдущие
+        void finish(size_t index) {
+            done_[index] = true;
+            while (printed_ < results_.size() && done_[printed_]) print(results_[printed_++]);
+        }
+
+        void print(const Result &r) {
+            if (r.passed && quiet_) return;
+            if (r.passed) {
+                std::cout << "✓ " << r.name << " (" << r.ms << " ms)" << std::endl;
+            } else {
+                std::cout << "✗ " << r.name << ": ";
+                if (r.timed_out) {
+                    std::cout << "timed out after " << timeout_s_ << " s";
+                } else if (r.signal) {
+                    std::cout << "signal " << r.signal << " (" << strsignal(r.signal) << ")";
+                } else {
+                    std::cout << "exit code " << r.exit_code;
+                }
+                std::cout << std::endl;
+            }
+            if ((!r.passed || verbose_) && !r.output.empty()) {
+                std::cout << r.output;
+                if (r.output[r.output.size() - 1] != '\n') std::cout << std::endl;
+            }
+        }
+
+        std::vector<Case> cases_;
+        std::vector<Result> results_;
+        std::vector<bool> done_;
+        size_t printed_;
+        std::string filter_;
+        int jobs_;
+        double timeout_s_;
+        bool fork_;
+        bool verbose_;
+        bool quiet_;
+    };
+
+} // namespace fork_runner
+
+#endif // FORK_RUNNER_H
@@ -0,0 +1,129 @@
+#include <cassert>
+#include <iostream>
+#include "arduino_compat.h"
+
+void test_allocator() {
+    std::cout << "Testing avr-libc allocation strategy...\n";
+    AvrHeap &heap = AvrHeap::instance();
+    heap.begin(256);
+
+    size_t a = heap.malloc(10);
+    size_t b = heap.malloc(20);
+    size_t c = heap.malloc(10);
+    assert(a == 0 && b == 12 && c == 34);
+    assert(heap.stats().used == 46 && heap.stats().brk == 46);
+
+    // Дыра на месте b; блок 6 байт берётся из её верхней части
+    heap.free(b);
+    size_t d = heap.malloc(6);
+    assert(d == 12 + 20 - 6);
+    // Точное совпадение предпочтительнее
+    heap.free(d);
+    size_t e = heap.malloc(20);
+    assert(e == b);
+    std::cout << "✓ exact fit, best fit and top split\n";
+
+    // Освобождение верхнего блока опускает вершину кучи
+    heap.free(c);
+    assert(heap.stats().brk == 34);
+    heap.free(e);
+    heap.free(a);
+    assert(heap.stats().brk == 0 && heap.stats().used == 0);
+    std::cout << "✓ neighbours merge, top returns to brk\n";
+
+    // Последний блок растёт на месте, остальные переезжают
+    a = heap.malloc(4);
+    size_t grown = heap.realloc(a, 40);
+    assert(grown == a && heap.stats().brk == 42);
+    b = heap.malloc(4);
+    grown = heap.realloc(a, 50);
+    assert(grown != a && heap.blockSize(grown) == 50);
+    assert(heap.malloc(1000) == AvrHeap::kNull);
+    assert(heap.stats().failed == 1 && heap.stats().last_failed_size == 1000);
+    heap.end();
+    std::cout << "✓ realloc grows at the top or moves\n";
+}
+
+void test_string_growth() {
+    std::cout << "Testing String growth policy...\n";
+    AvrHeap &heap = AvrHeap::instance();
+    heap.begin(1024);
+    {
+        String s;
+        assert(heap.blockCount() == 1);
+        for (int i = 0; i < 50; i++) s += 'x';
+        // Как в WString: realloc на каждый символ, без запаса
+        assert(heap.stats().reallocations == 50);
+        assert(heap.stats().used == 51 + 2);
+
+        String reserved;
+        assert(reserved.reserve(50));
+        uint32_t before = heap.stats().reallocations;
+        for (int i = 0; i < 50; i++) reserved += 'x';
+        assert(heap.stats().reallocations == before);
+        std::cout << "✓ reserve() avoids reallocations\n";
+    }
+    assert(heap.stats().used == 0 && heap.blockCount() == 0);
+    std::cout << "✓ destructors free their blocks\n";
+
+    // Временные строки между долгоживущими оставляют дыры
+    {
+        String keep[8];
+        String tmp[8];
+        for (int i = 0; i < 8; i++) {
+            keep[i] = String("value ") + String(i);
+            tmp[i] = String("temporary string number ") + String(i);
+        }
+        for (int i = 0; i < 8; i++) tmp[i] = String();
+        assert(heap.stats().fragmentation() > 0);
+        heap.printStats(std::cout);
+    }
+    heap.end();
+    std::cout << "✓ fragmentation is reported\n";
+}
+
+void test_out_of_memory() {
+    std::cout << "Testing failed allocations...\n";
+    AvrHeap &heap = AvrHeap::instance();
+    heap.begin(64);
+
+    String ok("short");
+    assert(ok);
+    String big("this string is far too long to fit into a sixty-four byte heap");
+    assert(!big);
+    assert(big.length() == 0);
+    assert(heap.stats().failed == 1);
+    std::cout << "✓ copy that doesn't fit leaves the String invalid\n";
+
+    String copy = big;
+    assert(!copy);
+
+    // Неудачная конкатенация оставляет строку как была
+    String line("abc");
+    line += "this suffix does not fit into the remaining heap space at all";
+    assert(line && line == "abc");
+    assert(heap.stats().failed == 2);
+    std::cout << "✓ failed concat keeps the old value\n";
+
+    // Освободившаяся память снова доступна
+    ok = "";
+    line = "";
+    String retry("now it fits again!");
+    assert(retry);
+    heap.end();
+
+    // Без симуляции память не ограничена
+    String unlimited(big);
+    unlimited = "this string is far too long to fit into a sixty-four byte heap";
+    assert(unlimited);
+    std::cout << "✓ heap can be turned off\n";
+}
+
+int main() {
+    std::cout << "=== AVR Heap Tests ===\n\n";
+    test_allocator();
+    test_string_growth();
+    test_out_of_memory();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "fake_serial.h"
+#include "fork_runner.h"
+#include "littlefs_stub.h"
+
+FakeSerial Serial(false);
+
+static unsigned long fixtureMillis;
+
+static String readFile(const char *path) {
+    File f = LittleFS.open(path, "r");
+    String text = f ? f.readString() : String();
+    f.close();
+    return text;
+}
+
+// Каждый случай сначала видит фикстуры, а потом портит их
+static void expectFixtures() {
+    // Первым: readString() тоже смотрит на часы
+    assert(millis() == fixtureMillis + 100);
+    assert(Serial.getOutput() == "boot\n");
+    assert(readFile("/config.txt") == "mode=eco");
+    assert(!LittleFS.exists("/log.txt"));
+}
+
+void test_serial_case() {
+    expectFixtures();
+    Serial.println("case output");
+    assert(Serial.getOutput() == "boot\ncase output\n");
+}
+
+void test_fs_case() {
+    expectFixtures();
+    assert(LittleFS.remove("/config.txt"));
+    File log = LittleFS.open("/log.txt", "w");
+    log.print("written by a case");
+    log.close();
+    assert(LittleFS.exists("/log.txt"));
+}
+
+void test_clock_case() {
+    expectFixtures();
+    for (int i = 0; i < 1000; i++) millis();
+    assert(millis() > fixtureMillis + 100000);
+}
+
+void test_failures() {
+    std::cout << "Testing failure reporting (failures below are expected)...\n";
+    fork_runner::Runner runner;
+    runner.setTimeout(0.3);
+    runner.add("pass", []() { std::cout << "quiet on success\n"; });
+    runner.add("assert", []() {
+        std::cout << "before the assert\n";
+        assert(1 + 1 == 3);
+    });
+    runner.add("exception", []() { throw std::runtime_error("broken fixture"); });
+    runner.add("exit", []() { exit(3); });
+    runner.add("hang", []() { for (;;) pause(); });
+    assert(runner.run() == 1);
+
+    const std::vector<fork_runner::Result> &r = runner.results();
+    assert(r.size() == 5);
+    assert(r[0].passed && r[0].output == "quiet on success\n");
+    assert(!r[1].passed && r[1].signal == SIGABRT);
+    assert(r[1].output.find("before the assert") == 0);
+    assert(r[1].output.find("Assertion") != std::string::npos);
+    assert(!r[2].passed && r[2].exit_code == 1);
+    assert(r[2].output == "exception: broken fixture\n");
+    assert(!r[3].passed && r[3].exit_code == 3 && r[3].signal == 0);
+    assert(!r[4].passed && r[4].timed_out && r[4].signal == SIGKILL);
+    std::cout << "✓ Asserts, exceptions, exit codes and hangs are reported per case\n\n";
+}
+
+void test_many_cases() {
+    std::cout << "Testing reset cost...\n";
+    const int kCases = 200;
+    fork_runner::Runner runner;
+    for (int i = 0; i < kCases; i++) runner.add("case", []() { expectFixtures(); Serial.print("x"); });
+    runner.setQuiet(true);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    assert(runner.run() == 0);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    assert(runner.results().size() == kCases);
+    std::cout << "  " << kCases << " cases in " << ms << " ms, " << ms * 1000 / kCases
+              << " us per case\n";
+    std::cout << "✓ Every case starts from the fixtures\n\n";
+}
+
+int main(int argc, char **argv) {
+    std::cout << "=== Fork Runner Tests ===\n\n";
+    test_failures();
+
+    // Фикстуры: вывод порта, том в памяти, часы
+    system("rm -rf /tmp/arduinostub_fork_runner");
+    assert(LittleFS.begin(true, "/tmp/arduinostub_fork_runner"));
+    File config = LittleFS.open("/config.txt", "w");
+    config.print("mode=eco");
+    config.close();
+    std::vector<uint8_t> image;
+    assert(LittleFS.exportImage(image));
+    assert(LittleFS.mountImage(image.data(), image.size()));
+    Serial.println("boot");
+    for (int i = 0; i < 10; i++) fixtureMillis = millis();
+
+    test_many_cases();
+
+    fork_runner::Runner runner(argc, argv);
+    runner.add("serial/output", test_serial_case);
+    runner.add("fs/remove_and_write", test_fs_case);
+    runner.add("fs/remove_and_write_again", test_fs_case);
+    runner.add("clock/advance", test_clock_case);
+    int failed = runner.run();
+
+    // Родитель фикстуры не потерял
+    if (runner.isolated()) expectFixtures();
+    if (failed) return failed;
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "littlefs_stub.h"
+#include <fstream>
 #include <iostream>
 
 #include "littlefs_stub.h"
@@ -0,0 +1,105 @@
+#include <cassert>
+#include <iostream>
+#include <set>
+#include "littlefs_stub.h"
+
+static void makeTree() {
+    File f = LittleFS.open("/assets/app.js", "w");
+    f.print("console.log(1);");
+    f.close();
+    f = LittleFS.open("/assets/style.css", "w");
+    f.print("body{}");
+    f.close();
+    assert(LittleFS.mkdir("/assets/img"));
+}
+
+static void checkNames(File &dir) {
+    std::set<std::string> names;
+    bool isDir = true;
+    String name;
+    while ((name = dir.getNextFileName(&isDir)).length() > 0) {
+        names.insert(name.c_str());
+        assert(isDir == (name == "/assets/img"));
+    }
+    assert(names.size() == 3);
+    assert(names.count("/assets/app.js"));
+    assert(names.count("/assets/style.css"));
+    assert(names.count("/assets/img"));
+    // Конец каталога не сбрасывает итерацию
+    assert(dir.getNextFileName().length() == 0);
+    assert(!dir.openNextFile());
+}
+
+void test_next_file_name(const char *volume) {
+    std::cout << "Testing getNextFileName() on " << volume << "...\n";
+    File dir = LittleFS.open("/assets");
+    assert(dir.isDirectory());
+    checkNames(dir);
+    assert(LittleFS.openFiles() == 0);
+    std::cout << "✓ full paths and types without opening files\n";
+
+    dir.rewindDirectory();
+    checkNames(dir);
+    std::cout << "✓ rewindDirectory() restarts iteration\n";
+
+    File root = LittleFS.open("/");
+    bool isDir = false;
+    assert(root.getNextFileName(&isDir) == "/assets" && isDir);
+}
+
+void test_open_next_file(const char *volume) {
+    std::cout << "Testing openNextFile() on " << volume << "...\n";
+    File dir = LittleFS.open("/assets");
+    int files = 0;
+    int dirs = 0;
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+        if (entry.isDirectory()) {
+            assert(std::string(entry.name()) == "img");
+            dirs++;
+            continue;
+        }
+        files++;
+        std::string name = entry.name();
+        uint8_t buf[32];
+        size_t n = entry.read(buf, sizeof(buf));
+        std::string content(reinterpret_cast<char *>(buf), n);
+        if (name == "app.js") {
+            assert(entry.size() == 15 && content == "console.log(1);");
+        } else {
+            assert(name == "style.css");
+            assert(entry.size() == 6 && content == "body{}");
+        }
+        assert(!entry.available());
+    }
+    assert(files == 2 && dirs == 1);
+    assert(LittleFS.openFiles() == 0);
+    std::cout << "✓ entries read lazily\n";
+
+    // Записи из openNextFile() занимают слоты, как на устройстве
+    dir.rewindDirectory();
+    std::vector<File> held;
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+        held.push_back(entry);
+    }
+    assert(LittleFS.openFiles() == 2);
+    held.clear();
+    assert(LittleFS.openFiles() == 0);
+    std::cout << "✓ entries count against maxOpenFiles\n";
+}
+
+int main() {
+    std::cout << "=== LittleFS Directory Tests ===\n\n";
+    system("rm -rf /tmp/littlefs_dir_test");
+    assert(LittleFS.begin(false, "/tmp/littlefs_dir_test"));
+    makeTree();
+    test_next_file_name("disk");
+    test_open_next_file("disk");
+
+    std::vector<uint8_t> image;
+    assert(LittleFS.exportImage(image));
+    assert(LittleFS.mountImage(image.data(), image.size()));
+    test_next_file_name("image");
+    test_open_next_file("image");
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
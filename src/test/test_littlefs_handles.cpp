@@ -0,0 +1,158 @@
+#include <cassert>
+#include <iostream>
+#include "littlefs_stub.h"
+
+static std::string readAll(const char *path) {
+    File f = LittleFS.open(path, "r");
+    std::string result;
+    if (!f) return result;
+    int c;
+    while ((c = f.read()) >= 0) {
+        result += static_cast<char>(c);
+    }
+    return result;
+}
+
+void test_limit() {
+    std::cout << "Testing maxOpenFiles limit...\n";
+    system("rm -rf /tmp/littlefs_handles_test");
+    assert(LittleFS.begin(false, "/tmp/littlefs_handles_test", 3));
+
+    File a = LittleFS.open("/a.txt", "w");
+    File b = LittleFS.open("/b.txt", "w");
+    File c = LittleFS.open("/c.txt", "w");
+    assert(a && b && c);
+    assert(LittleFS.openFiles() == 3);
+
+    File d = LittleFS.open("/d.txt", "w");
+    assert(!d);
+    // Неудачное открытие не создаёт файл
+    assert(!LittleFS.exists("/d.txt"));
+    std::cout << "✓ open beyond the limit fails\n";
+
+    // Каталоги в лимит не входят
+    assert(LittleFS.mkdir("/dir"));
+    File dir = LittleFS.open("/dir");
+    assert(dir && dir.isDirectory());
+    std::cout << "✓ directories don't count\n";
+
+    b.close();
+    assert(LittleFS.openFiles() == 2);
+    d = LittleFS.open("/d.txt", "w");
+    assert(d);
+    std::cout << "✓ closed slot is reused\n";
+
+    a.close();
+    c.close();
+    d.close();
+    assert(LittleFS.openFiles() == 0);
+}
+
+void test_handles() {
+    std::cout << "Testing handle semantics...\n";
+    File f = LittleFS.open("/shared.txt", "w");
+    File copy = f;
+    assert(LittleFS.openFiles() == 1);
+    copy.print("hello");
+    f.print(" world");
+    assert(f.position() == 11 && copy.position() == 11);
+
+    f.close();
+    assert(!f && !copy);
+    assert(copy.write('x') == 0);
+    assert(LittleFS.openFiles() == 0);
+    assert(readAll("/shared.txt") == "hello world");
+    std::cout << "✓ copies share one slot, close() invalidates all\n";
+
+    // Новый файл в том же слоте не доступен через старый File
+    File stale = LittleFS.open("/shared.txt", "r");
+    File old = stale;
+    stale.close();
+    File other = LittleFS.open("/a.txt", "r");
+    assert(other);
+    assert(!old && old.read() == -1);
+    other.close();
+    std::cout << "✓ stale handle doesn't reach the recycled slot\n";
+
+    {
+        File scoped = LittleFS.open("/scoped.txt", "w");
+        File second = scoped;
+        assert(LittleFS.openFiles() == 1);
+    }
+    assert(LittleFS.openFiles() == 0);
+    std::cout << "✓ last copy closes the file\n";
+}
+
+void test_buffered_io() {
+    std::cout << "Testing buffered reads and writes...\n";
+    std::string big;
+    for (int i = 0; i < 3000; i++) big += static_cast<char>('a' + i % 26);
+
+    File f = LittleFS.open("/big.txt", "w");
+    for (size_t i = 0; i < big.size(); i += 7) {
+        f.write(reinterpret_cast<const uint8_t *>(big.data() + i),
+                std::min<size_t>(7, big.size() - i));
+    }
+    f.close();
+    assert(readAll("/big.txt") == big);
+
+    // Перезапись в середине и чтение того же места
+    f = LittleFS.open("/big.txt", "r+");
+    assert(f.size() == big.size());
+    uint8_t buf[4];
+    assert(f.read(buf, 4) == 4 && memcmp(buf, "abcd", 4) == 0);
+    f.seek(1000);
+    f.print("XYZ");
+    f.seek(998);
+    assert(f.read(buf, 4) == 4 && memcmp(buf, "klXY", 4) == 0);
+    f.seek(0, SeekEnd);
+    f.print("!");
+    f.close();
+    big.replace(1000, 3, "XYZ");
+    big += "!";
+    assert(readAll("/big.txt") == big);
+
+    f = LittleFS.open("/big.txt", "a");
+    f.print("?");
+    f.close();
+    assert(readAll("/big.txt") == big + "?");
+
+    // Режим "w" без '+' не читает
+    f = LittleFS.open("/big.txt", "w");
+    assert(f.read() == -1);
+    f.close();
+    assert(LittleFS.openFiles() == 0);
+    std::cout << "✓ reads see buffered writes\n";
+}
+
+void test_limit_in_memory() {
+    std::cout << "Testing limit on mounted image...\n";
+    std::vector<uint8_t> image;
+    assert(LittleFS.exportImage(image));
+    assert(LittleFS.mountImage(image.data(), image.size()));
+
+    File a = LittleFS.open("/m1.txt", "w");
+    File b = LittleFS.open("/m2.txt", "w");
+    File c = LittleFS.open("/m3.txt", "w");
+    assert(a && b && c);
+    assert(!LittleFS.open("/m4.txt", "w"));
+    assert(!LittleFS.exists("/m4.txt"));
+    c.close();
+    assert(LittleFS.open("/m4.txt", "w"));
+    std::cout << "✓ image volume shares the limit\n";
+
+    LittleFS.end();
+    assert(!a && !b);
+    assert(LittleFS.openFiles() == 0);
+    std::cout << "✓ end() closes open files\n";
+}
+
+int main() {
+    std::cout << "=== LittleFS Handle Tests ===\n\n";
+    test_limit();
+    test_handles();
+    test_buffered_io();
+    test_limit_in_memory();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
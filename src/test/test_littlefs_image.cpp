@@ -0,0 +1,198 @@
+#include <cassert>
+#include <iostream>
+#include "littlefs_stub.h"
+
+static std::string readAll(const char *path) {
+    File f = LittleFS.open(path, "r");
+    std::string result;
+    if (!f) return result;
+    uint8_t buf[256];
+    size_t n;
+    while ((n = f.read(buf, sizeof(buf))) > 0) {
+        result.append(reinterpret_cast<char *>(buf), n);
+    }
+    return result;
+}
+
+static std::string pattern(size_t size) {
+    std::string s(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        s[i] = static_cast<char>((i * 131 + i / 7) & 0xff);
+    }
+    return s;
+}
+
+// Собираем том на диске и сериализуем его в образ
+static std::vector<uint8_t> buildImage() {
+    system("rm -rf /tmp/littlefs_image_test");
+    assert(LittleFS.begin(false, "/tmp/littlefs_image_test"));
+
+    File f = LittleFS.open("/config.json", "w");
+    f.print("{\"mode\":1}");
+    f.close();
+
+    std::string big = pattern(20000);  // Несколько блоков CTZ
+    f = LittleFS.open("/data/big.bin", "w");
+    f.write(reinterpret_cast<const uint8_t *>(big.data()), big.size());
+    f.close();
+
+    f = LittleFS.open("/data/empty.txt", "w");
+    f.close();
+
+    // Каталог, не помещающийся в одну пару метаданных
+    for (int i = 0; i < 60; i++) {
+        String name = String("/many/file_") + String(i) + ".txt";
+        f = LittleFS.open(name, "w");
+        f.print(name);
+        f.close();
+    }
+
+    std::vector<uint8_t> image;
+    assert(LittleFS.exportImage(image));
+    assert(image.size() == 4096u * 256u);
+    LittleFS.end();
+    return image;
+}
+
+void test_roundtrip() {
+    std::cout << "Testing image export/mount roundtrip...\n";
+    std::vector<uint8_t> image = buildImage();
+
+    assert(LittleFS.mountImage(image.data(), image.size()));
+    assert(LittleFS.inMemory());
+    assert(readAll("/config.json") == "{\"mode\":1}");
+    assert(readAll("/data/big.bin") == pattern(20000));
+    assert(LittleFS.exists("/data/empty.txt"));
+    assert(readAll("/data/empty.txt").empty());
+    for (int i = 0; i < 60; i++) {
+        String name = String("/many/file_") + String(i) + ".txt";
+        assert(readAll(name.c_str()) == name.c_str());
+    }
+    assert(LittleFS.totalBytes() == 4096u * 256u);
+    std::cout << "✓ contents survive export and mount\n";
+}
+
+void test_read_write_in_memory() {
+    std::cout << "Testing read-write access to mounted image...\n";
+    File f = LittleFS.open("/config.json", "a");
+    assert(f);
+    f.print(",appended");
+    f.close();
+    assert(readAll("/config.json") == "{\"mode\":1},appended");
+
+    assert(LittleFS.rename("/data/big.bin", "/archive/big.bin"));
+    assert(!LittleFS.exists("/data/big.bin"));
+    assert(LittleFS.remove("/many"));
+    assert(!LittleFS.exists("/many/file_1.txt"));
+    assert(LittleFS.mkdir("/logs/2024"));
+
+    File dir = LittleFS.open("/data");
+    assert(dir && dir.isDirectory());
+    int count = 0;
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+        assert(std::string(entry.name()) == "empty.txt");
+        count++;
+    }
+    assert(count == 1);
+
+    // Ничего не записано на диск
+    assert(access("/tmp/littlefs_image_test/archive", F_OK) != 0);
+    std::cout << "✓ modifications stay in memory\n";
+
+    std::vector<uint8_t> image;
+    assert(LittleFS.exportImage(image));
+    assert(LittleFS.mountImage(image.data(), image.size()));
+    assert(readAll("/config.json") == "{\"mode\":1},appended");
+    assert(readAll("/archive/big.bin") == pattern(20000));
+    assert(LittleFS.exists("/logs/2024"));
+    assert(!LittleFS.exists("/many"));
+    std::cout << "✓ modified volume re-exports\n";
+}
+
+void test_save_and_load_file() {
+    std::cout << "Testing saveImage()/mountImage(path)...\n";
+    assert(LittleFS.saveImage("/tmp/littlefs_image_test.bin"));
+    LittleFS.format();
+    assert(!LittleFS.exists("/config.json"));
+    assert(LittleFS.mountImage("/tmp/littlefs_image_test.bin"));
+    assert(readAll("/config.json") == "{\"mode\":1},appended");
+    std::cout << "✓ image file roundtrip\n";
+}
+
+static uint32_t le32(const std::vector<uint8_t> &b, size_t off) {
+    return b[off] | (b[off + 1] << 8) | (b[off + 2] << 16) | (static_cast<uint32_t>(b[off + 3]) << 24);
+}
+
+static uint32_t be32(const std::vector<uint8_t> &b, size_t off) {
+    return (static_cast<uint32_t>(b[off]) << 24) | (b[off + 1] << 16) | (b[off + 2] << 8) | b[off + 3];
+}
+
+// Суперблок — первые теги блока 0, как после lfs_format (SPEC.md):
+// ревизия, "littlefs" и inline-структура с версией и геометрией
+void test_superblock_bytes() {
+    std::cout << "Testing exported superblock...\n";
+    std::vector<uint8_t> image = buildImage();
+    uint32_t tag = be32(image, 4) ^ 0xffffffff;
+    assert(tag == 0x0ff00008);  // SUPERBLOCK, id 0, 8 байт
+    assert(std::string(image.begin() + 8, image.begin() + 16) == "littlefs");
+    assert((be32(image, 16) ^ tag) == 0x20100018);  // INLINESTRUCT, id 0, 24 байта
+    assert(le32(image, 20) == 0x00020000);
+    assert(le32(image, 24) == 4096);
+    assert(le32(image, 28) == 256);
+    std::cout << "✓ magic, disk version 2.0 and geometry\n";
+}
+
+// Образ, собранный не кодировщиком заглушки (src/test/fixtures,
+// make_littlefs_fixture.py): несколько коммитов в блоке, сдвиги id,
+// CTZ-файл, вложенные каталоги
+void test_reference_image() {
+    std::cout << "Testing reference image...\n";
+    assert(LittleFS.mountImage("src/test/fixtures/littlefs_512x64.bin"));
+    assert(LittleFS.totalBytes() == 512u * 64u);
+    assert(readAll("/readme.txt") == "hello from littlefs\n");
+    assert(readAll("/config.json") == "{\"mode\":2}");
+    assert(!LittleFS.exists("/old.txt"));
+    assert(LittleFS.exists("/data/empty.txt"));
+    assert(readAll("/data/empty.txt").empty());
+    assert(readAll("/data/nested/deep/note.txt") == "deep");
+
+    std::string log = readAll("/data/log.bin");
+    assert(log.size() == 3000);
+    for (size_t i = 0; i < log.size(); i++) {
+        assert(static_cast<uint8_t>(log[i]) == ((i * 7 + 3) & 0xff));
+    }
+
+    File etc = LittleFS.open("/etc");
+    assert(etc && etc.isDirectory());
+    assert(!etc.openNextFile());
+    std::string names;
+    File root = LittleFS.open("/");
+    for (File entry = root.openNextFile(); entry; entry = root.openNextFile()) {
+        names += std::string(entry.name()) + (entry.isDirectory() ? "/ " : " ");
+    }
+    assert(names == "config.json data/ etc/ readme.txt ");
+    std::cout << "✓ files and directories match the reference tree\n";
+}
+
+void test_corrupted_image() {
+    std::cout << "Testing corrupted image...\n";
+    std::vector<uint8_t> image = buildImage();
+    // Портим корневую пару: CRC коммита больше не сходится
+    image[20] ^= 0x55;
+    assert(!LittleFS.mountImage(image.data(), image.size()));
+    std::vector<uint8_t> blank(4096 * 4, 0xff);
+    assert(!LittleFS.mountImage(blank.data(), blank.size()));
+    std::cout << "✓ corrupted images are rejected\n";
+}
+
+int main() {
+    std::cout << "=== LittleFS Image Tests ===\n\n";
+    test_roundtrip();
+    test_read_write_in_memory();
+    test_save_and_load_file();
+    test_superblock_bytes();
+    test_reference_image();
+    test_corrupted_image();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
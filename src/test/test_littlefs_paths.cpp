@@ -0,0 +1,105 @@
+#include <cassert>
+#include <iostream>
+#include "littlefs_stub.h"
+
+void test_normalize() {
+    std::cout << "Testing path normalization...\n";
+    assert(fs::PathTable::normalize("/") == "");
+    assert(fs::PathTable::normalize("") == "");
+    assert(fs::PathTable::normalize("/a/b.txt") == "a/b.txt");
+    assert(fs::PathTable::normalize("a//b/") == "a/b");
+    assert(fs::PathTable::normalize("/./a/./b") == "a/b");
+    assert(fs::PathTable::normalize("/a/c/../b") == "a/b");
+    assert(fs::PathTable::normalize("/../../a") == "a");
+    std::cout << "✓ normalize\n";
+}
+
+void test_interning() {
+    std::cout << "Testing interned path table...\n";
+    fs::PathTable table;
+    table.reset("/base");
+    const fs::PathEntry &a = table.resolve("/dir/file.txt");
+    assert(a.rel == "dir/file.txt");
+    assert(a.host == "/base/dir/file.txt");
+    assert(a.host_dir == "/base/dir");
+    assert(std::string(a.name()) == "file.txt");
+
+    // Повторный запрос и другое написание дают ту же запись
+    assert(&table.resolve("/dir/file.txt") == &a);
+    assert(&table.resolve("dir//file.txt") == &a);
+    assert(&table.resolve("/dir/x/../file.txt") == &a);
+    assert(table.size() == 1);
+
+    // Рост таблицы не двигает записи
+    for (int i = 0; i < 1000; i++) {
+        table.resolve(String(String("/f") + String(i)).c_str());
+    }
+    assert(&table.resolve("/dir/file.txt") == &a);
+    assert(table.resolve("/").isRoot());
+    assert(table.resolve("/").host == "/base");
+    std::cout << "✓ interning\n";
+}
+
+void test_bounded() {
+    std::cout << "Testing path table limit...\n";
+    fs::PathTable table;
+    table.reset("/base");
+    // Уникальные имена не копятся, предыдущая запись переживает смену поколения
+    const fs::PathEntry *prev = &table.resolve("/file0");
+    for (size_t i = 1; i < fs::PathTable::kMaxPaths * 3; i++) {
+        std::string path = "/file" + std::to_string(i);
+        const fs::PathEntry &entry = table.resolve(path.c_str());
+        assert(entry.rel == path.substr(1));
+        assert(prev->rel == "file" + std::to_string(i - 1));
+        assert(table.size() <= fs::PathTable::kMaxPaths);
+        prev = &entry;
+    }
+    assert(table.resolve("/dir/../file1").host == "/base/file1");
+    std::cout << "✓ " << fs::PathTable::kMaxPaths * 3 << " unique paths, at most "
+              << fs::PathTable::kMaxPaths << " kept\n";
+}
+
+// Все точки входа LittleFSClass понимают путь одинаково
+static void check_consistency() {
+    File f = LittleFS.open("/test//data.txt", "w");
+    assert(f);
+    f.print("data");
+    f.close();
+
+    assert(LittleFS.exists("/test/data.txt"));
+    assert(LittleFS.exists("test/./data.txt"));
+    assert(LittleFS.exists("/test/sub/../data.txt/"));
+    assert(LittleFS.mkdir("//logs//2024/"));
+    assert(LittleFS.exists("/logs/2024"));
+    assert(LittleFS.rename("test//data.txt", "/logs/./2024/data.txt"));
+    assert(LittleFS.exists("/logs/2024/data.txt"));
+    assert(!LittleFS.remove("/"));
+    assert(!LittleFS.remove("/logs/.."));
+    assert(LittleFS.remove("/logs//2024/data.txt/"));
+    assert(!LittleFS.exists("/logs/2024/data.txt"));
+}
+
+void test_entry_points() {
+    std::cout << "Testing consistent semantics of entry points...\n";
+    system("rm -rf /tmp/littlefs_paths_test");
+    assert(LittleFS.begin(false, "/tmp/littlefs_paths_test"));
+    check_consistency();
+    std::cout << "✓ on-disk volume\n";
+
+    std::vector<uint8_t> image;
+    assert(LittleFS.exportImage(image));
+    assert(LittleFS.mountImage(image.data(), image.size()));
+    LittleFS.format();
+    check_consistency();
+    std::cout << "✓ in-memory volume\n";
+}
+
+int main() {
+    std::cout << "=== LittleFS Path Tests ===\n\n";
+    test_normalize();
+    test_interning();
+    test_bounded();
+    test_entry_points();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
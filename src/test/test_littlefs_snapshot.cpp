@@ -0,0 +1,133 @@
+#include <cassert>
+#include <iostream>
+#include "littlefs_stub.h"
+
+static std::string readAll(const char *path) {
+    File f = LittleFS.open(path, "r");
+    std::string result;
+    if (!f) return result;
+    int c;
+    while ((c = f.read()) >= 0) {
+        result += static_cast<char>(c);
+    }
+    return result;
+}
+
+static void writeAll(const char *path, const char *text) {
+    File f = LittleFS.open(path, "w");
+    assert(f);
+    f.print(text);
+    f.close();
+}
+
+// Сценарий одинаков для тома на диске и образа в памяти
+static void check_snapshots() {
+    writeAll("/fixture/a.txt", "A");
+    writeAll("/fixture/b.txt", "B");
+    int base = LittleFS.snapshot();
+    assert(base >= 0);
+
+    // Типичный тест: меняет, удаляет и создаёт файлы
+    writeAll("/fixture/a.txt", "changed");
+    assert(LittleFS.remove("/fixture/b.txt"));
+    writeAll("/new/deep/c.txt", "C");
+    int second = LittleFS.snapshot();
+
+    assert(LittleFS.restore(base));
+    assert(readAll("/fixture/a.txt") == "A");
+    assert(readAll("/fixture/b.txt") == "B");
+    assert(!LittleFS.exists("/new"));
+    std::cout << "✓ restore to fixture state\n";
+
+    // Снимок остаётся пригодным для повторных откатов
+    LittleFS.rename("/fixture/a.txt", "/fixture/moved.txt");
+    assert(LittleFS.restore(base));
+    assert(LittleFS.exists("/fixture/a.txt"));
+    assert(!LittleFS.exists("/fixture/moved.txt"));
+
+    assert(LittleFS.restore(second));
+    assert(readAll("/fixture/a.txt") == "changed");
+    assert(!LittleFS.exists("/fixture/b.txt"));
+    assert(readAll("/new/deep/c.txt") == "C");
+    std::cout << "✓ switching between snapshots\n";
+
+    LittleFS.clearAll();
+    assert(!LittleFS.exists("/fixture"));
+    assert(LittleFS.restore(base));
+    assert(readAll("/fixture/b.txt") == "B");
+    std::cout << "✓ restore after clearAll()\n";
+
+    LittleFS.dropSnapshot(second);
+    assert(!LittleFS.restore(second));
+
+    // "r+" тоже меняет файл
+    writeAll("/a.txt", "AAAA");
+    int before_edit = LittleFS.snapshot();
+    File f = LittleFS.open("/a.txt", "r+");
+    assert(f);
+    f.print("ZZ");
+    f.close();
+    assert(readAll("/a.txt") == "ZZAA");
+    assert(LittleFS.restore(before_edit));
+    assert(readAll("/a.txt") == "AAAA");
+    std::cout << "✓ restore after \"r+\" writes\n";
+
+    // Запись через файл, открытый до снимка
+    f = LittleFS.open("/a.txt", "w");
+    f.print("hello");
+    f.flush();
+    int open_file = LittleFS.snapshot();
+    f.print(" world");
+    f.close();
+    assert(readAll("/a.txt") == "hello world");
+    assert(LittleFS.restore(open_file));
+    assert(readAll("/a.txt") == "hello");
+    std::cout << "✓ restore after writes through a file opened before the snapshot\n";
+
+    // Снимок берёт и данные из буфера открытого файла
+    f = LittleFS.open("/a.txt", "w");
+    f.print("hello");
+    int buffered = LittleFS.snapshot();
+    f.close();
+    assert(LittleFS.remove("/a.txt"));
+    assert(LittleFS.restore(buffered));
+    assert(readAll("/a.txt") == "hello");
+    std::cout << "✓ snapshot includes unflushed writes of open files\n";
+
+    // Файл, открытый во время отката, закрывается, запись через него — нет
+    writeAll("/a.txt", "base");
+    f = LittleFS.open("/a.txt", "a");
+    File copy = f;
+    int appended = LittleFS.snapshot();
+    f.print("-after");
+    assert(LittleFS.restore(appended));
+    assert(!f && !copy);
+    assert(f.print("-more") == 0);
+    f.close();
+    assert(readAll("/a.txt") == "base");
+    std::cout << "✓ restore closes open files\n";
+}
+
+void test_disk_snapshots() {
+    std::cout << "Testing snapshots of on-disk volume...\n";
+    system("rm -rf /tmp/littlefs_snapshot_test");
+    assert(LittleFS.begin(false, "/tmp/littlefs_snapshot_test"));
+    check_snapshots();
+}
+
+void test_memory_snapshots() {
+    std::cout << "Testing snapshots of in-memory volume...\n";
+    std::vector<uint8_t> image;
+    LittleFS.clearAll();
+    assert(LittleFS.exportImage(image));
+    assert(LittleFS.mountImage(image.data(), image.size()));
+    check_snapshots();
+}
+
+int main() {
+    std::cout << "=== LittleFS Snapshot Tests ===\n\n";
+    test_disk_snapshots();
+    test_memory_snapshots();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
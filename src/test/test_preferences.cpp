@@ -0,0 +1,254 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include "arduino_compat.h"
+#include "preferences_stub.h"
+#include "stub_device.h"
+
+// Отдельный раздел на время теста
+class PartitionScope {
+public:
+    explicit PartitionScope(stub_nvs::Partition &partition) : prev_(stub_nvs::currentPtr()) {
+        stub_nvs::currentPtr() = &partition;
+    }
+    ~PartitionScope() { stub_nvs::currentPtr() = prev_; }
+
+private:
+    stub_nvs::Partition *prev_;
+};
+
+void test_types() {
+    std::cout << "Testing typed values...\n";
+    stub_nvs::Partition partition;
+    PartitionScope scope(partition);
+    Preferences prefs;
+    assert(prefs.begin("calib"));
+
+    assert(prefs.putChar("i8", -5) == 1);
+    assert(prefs.putUShort("u16", 65000) == 2);
+    assert(prefs.putInt("i32", -123456) == 4);
+    assert(prefs.putULong64("u64", 0x123456789ABCULL) == 8);
+    assert(prefs.putFloat("offset", 0.25f) == 4);
+    assert(prefs.putDouble("gain", 1.5) == 8);
+    assert(prefs.putBool("enabled", true) == 1);
+    assert(prefs.putString("name", "sensor-7") == 8);
+
+    assert(prefs.getChar("i8") == -5);
+    assert(prefs.getUShort("u16") == 65000);
+    assert(prefs.getInt("i32") == -123456);
+    assert(prefs.getULong64("u64") == 0x123456789ABCULL);
+    assert(prefs.getFloat("offset") == 0.25f);
+    assert(prefs.getDouble("gain") == 1.5);
+    assert(prefs.getBool("enabled"));
+    assert(prefs.getString("name") == "sensor-7");
+
+    // Нет ключа или другой тип — значение по умолчанию
+    assert(prefs.getInt("missing", 42) == 42);
+    assert(prefs.getInt("u16", 7) == 7);
+    assert(prefs.getType("u16") == PT_U16);
+    assert(prefs.getType("offset") == PT_BLOB);
+    assert(prefs.getType("name") == PT_STR);
+    assert(prefs.getType("missing") == PT_INVALID);
+    assert(prefs.isKey("i32") && !prefs.isKey("missing"));
+
+    char buffer[16];
+    assert(prefs.getString("name", buffer, sizeof(buffer)) == 9);
+    assert(strcmp(buffer, "sensor-7") == 0);
+    assert(prefs.getString("name", buffer, 4) == 0);
+
+    // Ключ длиннее 15 символов NVS не принимает
+    assert(prefs.putInt("a_very_long_key_name", 1) == 0);
+    std::cout << "✓ put/get for every type, defaults on mismatch\n";
+}
+
+void test_namespaces() {
+    std::cout << "Testing namespaces...\n";
+    stub_nvs::Partition partition;
+    PartitionScope scope(partition);
+    Preferences wifi, calib;
+    assert(!wifi.begin("wifi", true));       // Только чтение: пространства ещё нет
+    assert(wifi.begin("wifi"));
+    assert(calib.begin("calib"));
+    wifi.putString("ssid", "home");
+    calib.putString("ssid", "other");
+    calib.putInt("zero", 12);
+    assert(wifi.getString("ssid") == "home");
+    assert(calib.getString("ssid") == "other");
+
+    assert(calib.remove("zero"));
+    assert(!calib.remove("zero"));
+    assert(!calib.isKey("zero"));
+    assert(calib.clear());
+    assert(!calib.isKey("ssid"));
+    assert(wifi.getString("ssid") == "home");
+
+    Preferences readOnly;
+    assert(readOnly.begin("wifi", true));
+    assert(readOnly.getString("ssid") == "home");
+    assert(readOnly.putInt("x", 1) == 0);
+    assert(!readOnly.clear());
+    std::cout << "✓ Namespaces are isolated, read-only mode refuses writes\n";
+}
+
+void test_entry_sizes() {
+    std::cout << "Testing entry sizes...\n";
+    stub_nvs::Partition partition;
+    PartitionScope scope(partition);
+    Preferences prefs;
+    prefs.begin("blobs");
+    size_t used = partition.usedEntries();
+    size_t free = prefs.freeEntries();
+
+    // Число — одна запись, 100 байт — заголовок и 4 записи данных
+    prefs.putInt("n", 1);
+    assert(partition.usedEntries() == used + 1);
+    uint8_t blob[100];
+    for (size_t i = 0; i < sizeof(blob); i++) blob[i] = static_cast<uint8_t>(i);
+    assert(prefs.putBytes("table", blob, sizeof(blob)) == sizeof(blob));
+    assert(partition.usedEntries() == used + 6);
+    assert(prefs.freeEntries() == free - 6);
+
+    uint8_t back[100] = {0};
+    assert(prefs.getBytesLength("table") == 100);
+    assert(prefs.getBytes("table", back, 50) == 0);
+    assert(prefs.getBytes("table", back, sizeof(back)) == 100);
+    assert(memcmp(blob, back, sizeof(blob)) == 0);
+
+    // Новое значение — новая запись, старая стёрта, но место ещё занято
+    prefs.putInt("n", 2);
+    assert(partition.usedEntries() == used + 6);
+    assert(prefs.freeEntries() == free - 7);
+
+    // То же значение не пишется
+    uint64_t entries = partition.stats().entries;
+    prefs.putInt("n", 2);
+    prefs.putBytes("table", blob, sizeof(blob));
+    assert(partition.stats().entries == entries);
+    assert(partition.stats().skipped == 2);
+
+    // Значение больше страницы не помещается
+    static uint8_t huge[5000];
+    assert(prefs.putBytes("huge", huge, sizeof(huge)) == 0);
+    std::cout << "✓ Entries per value match NVS, unchanged values are skipped\n";
+}
+
+void test_compaction() {
+    std::cout << "Testing compaction...\n";
+    stub_nvs::Partition partition(3);
+    PartitionScope scope(partition);
+    Preferences prefs;
+    prefs.begin("counter");
+    prefs.putString("label", "boot counter");
+
+    const uint32_t kWrites = 10000;
+    for (uint32_t i = 1; i <= kWrites; i++) {
+        assert(prefs.putUInt("boots", i) == 4);
+        assert(prefs.getUInt("boots") == i);
+    }
+    assert(prefs.getString("label") == "boot counter");
+
+    // Страница на 126 записей стирается примерно раз на 126 сохранений
+    uint64_t erases = partition.eraseCount();
+    assert(erases >= kWrites / stub_nvs::Partition::kEntriesPerPage - 2);
+    assert(erases <= kWrites / stub_nvs::Partition::kEntriesPerPage + 2);
+    assert(partition.stats().relocated > 0);
+    std::cout << "  " << kWrites << " saves: " << erases << " page erases, "
+              << partition.stats().relocated << " entries relocated\n";
+    std::cout << "✓ Old pages are compacted and erased\n";
+}
+
+void test_full_partition() {
+    std::cout << "Testing full partition...\n";
+    stub_nvs::Partition partition(3);
+    PartitionScope scope(partition);
+    Preferences prefs;
+    prefs.begin("fill");
+    int stored = 0;
+    char key[16];
+    for (;;) {
+        snprintf(key, sizeof(key), "k%d", stored);
+        if (prefs.putInt(key, stored) == 0) break;
+        stored++;
+    }
+    // Две рабочие страницы минус запись пространства имён
+    assert(stored == 2 * 126 - 1);
+    assert(prefs.freeEntries() == 0);
+
+    // Удалённое освобождается сборкой мусора
+    for (int i = 0; i < 10; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        prefs.remove(key);
+    }
+    assert(prefs.putInt("again", 1) == 4);
+    assert(prefs.getInt("again") == 1);
+    snprintf(key, sizeof(key), "k%d", stored - 1);
+    assert(prefs.getInt(key) == stored - 1);
+    std::cout << "✓ Full partition refuses writes until space is freed\n";
+}
+
+void test_remount() {
+    std::cout << "Testing remount...\n";
+    stub_nvs::Partition partition(4);
+    {
+        PartitionScope scope(partition);
+        Preferences prefs;
+        prefs.begin("state");
+        for (int i = 0; i < 500; i++) prefs.putInt("value", i);
+        prefs.putString("mode", "eco");
+        prefs.remove("mode");
+        prefs.putString("mode", "turbo");
+    }
+
+    // Перезагрузка: тот же флеш в новом разделе, индекс по страницам
+    stub_nvs::Partition rebooted(4);
+    rebooted.load(partition.image());
+    PartitionScope scope(rebooted);
+    Preferences prefs;
+    assert(prefs.begin("state", true));
+    assert(prefs.getInt("value") == 499);
+    assert(prefs.getString("mode") == "turbo");
+    assert(rebooted.usedEntries() == partition.usedEntries());
+    assert(rebooted.freeEntries() == partition.freeEntries());
+
+    prefs.end();
+    prefs.begin("state");
+    prefs.putInt("value", 500);
+    assert(prefs.getInt("value") == 500);
+    std::cout << "✓ Values survive a remount from the flash image\n";
+}
+
+void test_devices() {
+    std::cout << "Testing per-device partitions...\n";
+    stub_device::Device a(1), b(2);
+    {
+        stub_device::Scope scope(a);
+        Preferences prefs;
+        prefs.begin("id");
+        prefs.putUInt("serial", 1001);
+    }
+    {
+        stub_device::Scope scope(b);
+        Preferences prefs;
+        assert(!prefs.begin("id", true));
+        prefs.begin("id");
+        prefs.putUInt("serial", 2002);
+    }
+    Preferences prefs;
+    stub_device::Scope scope(a);
+    prefs.begin("id", true);
+    assert(prefs.getUInt("serial") == 1001);
+    std::cout << "✓ Each device has its own NVS\n";
+}
+
+int main() {
+    std::cout << "=== Preferences Tests ===\n\n";
+    test_types();
+    test_namespaces();
+    test_entry_sizes();
+    test_compaction();
+    test_full_partition();
+    test_remount();
+    test_devices();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
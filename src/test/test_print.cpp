@@ -0,0 +1,131 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "fake_serial.h"
+#include "littlefs_stub.h"
+
+FakeSerial Serial(false);
+
+// Вывод в строку со счётчиком вызовов write()
+class CapturePrint : public Print {
+public:
+    CapturePrint() : writes(0) {}
+
+    size_t write(const uint8_t *buffer, size_t size) override {
+        out.append(reinterpret_cast<const char *>(buffer), size);
+        writes++;
+        return size;
+    }
+    using Print::write;
+
+    std::string out;
+    int writes;
+};
+
+void test_formatting() {
+    std::cout << "Testing number formatting...\n";
+    CapturePrint p;
+    p.print(255, HEX);
+    p.print(' ');
+    p.print(5, BIN);
+    p.print(' ');
+    p.print(8, OCT);
+    p.print(' ');
+    p.print(-42);
+    p.print(' ');
+    p.print(0);
+    p.print(' ');
+    p.print(35, 36);
+    assert(p.out == "FF 101 10 -42 0 Z");
+
+    p.out.clear();
+    p.print(-1L, HEX);  // Как на Arduino: беззнаковое той же ширины
+    assert(p.out == std::string(sizeof(long) * 2, 'F'));
+
+    p.out.clear();
+    p.print(-1, HEX);
+    p.print(' ');
+    p.println(-2, BIN);
+    assert(p.out == "FFFFFFFF " + std::string(31, '1') + "0\n");
+
+    p.out.clear();
+    p.print(static_cast<long long>(-9223372036854775807LL - 1));
+    p.print(' ');
+    p.print(18446744073709551615ULL);
+    assert(p.out == "-9223372036854775808 18446744073709551615");
+
+    p.out.clear();
+    p.print(65, 0);  // Основание 0 — сам байт
+    p.print(3.14159, 3);
+    p.print(' ');
+    p.print(2.5);
+    p.print(' ');
+    p.print(NAN);
+    p.print(' ');
+    p.print(INFINITY);
+    p.print(' ');
+    p.print(5e9);
+    assert(p.out == "A3.142 2.50 nan inf ovf");
+    std::cout << "✓ output matches the Arduino core\n";
+}
+
+void test_single_write() {
+    std::cout << "Testing one write per call...\n";
+    CapturePrint p;
+    p.println(12345);
+    p.println(-7, DEC);
+    p.println(0xBEEF, HEX);
+    p.println(1.5, 1);
+    p.println("text");
+    p.println(String("string"));
+    p.println('c');
+    p.printf("%s=%d", "x", 10);
+    assert(p.out == "12345\n-7\nBEEF\n1.5\ntext\nstring\nc\nx=10");
+    assert(p.writes == 8);
+
+    // Длинный printf не помещается в буфер на стеке
+    p.out.clear();
+    std::string longText(300, 'z');
+    p.printf("[%s]", longText.c_str());
+    assert(p.out == "[" + longText + "]");
+    std::cout << "✓ each print, println and printf is a single write\n";
+}
+
+static void printSample(Print &out) {
+    out.print("v=");
+    out.println(-10, BIN);
+    out.println(255, HEX);
+    out.printf("%05.1f|", 3.25);
+    out.println(42UL);
+}
+
+void test_sinks_agree() {
+    std::cout << "Testing Serial and File output...\n";
+    Serial.clearOutput();
+    printSample(Serial);
+
+    system("rm -rf /tmp/arduinostub_print");
+    assert(LittleFS.begin(true, "/tmp/arduinostub_print"));
+    File f = LittleFS.open("/out.txt", "w");
+    printSample(f);
+    f.close();
+    f = LittleFS.open("/out.txt", "r");
+    String fromFile = f.readString();
+    f.close();
+
+    assert(Serial.getOutput() == fromFile.c_str());
+    assert(Serial.getOutput().compare(0, 3, "v=1") == 0);
+    system("rm -rf /tmp/arduinostub_print");
+    std::cout << "✓ Serial and File print the same bytes\n";
+}
+
+int main() {
+    std::cout << "=== Print Tests ===\n\n";
+    test_formatting();
+    test_single_write();
+    test_sinks_agree();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include "arduino_compat.h"
+#include "arduino_print_stub.h"
+
+// Бюджет строк во флеше для этого файла
+static const size_t kLiteralBudget = 512;
+
+const uint16_t kCurve[] PROGMEM = {0, 120, 480, 1080, 1920};
+const char kGreeting[] PROGMEM = "hello from flash";
+const char *const kNames[] PROGMEM = {kGreeting};
+
+class CapturePrint : public Print {
+public:
+    size_t write(const uint8_t *buffer, size_t size) override {
+        out.append(reinterpret_cast<const char *>(buffer), size);
+        return size;
+    }
+    using Print::write;
+
+    std::string out;
+};
+
+// Ни разу не вызывается до проверки реестра: строки регистрируются
+// при статической инициализации, а не при выполнении
+static void printBanner(Print &out) {
+    out.println(F("=== weather station v2 ==="));
+}
+
+static size_t literalsFromThisFile() {
+    size_t count = 0;
+    for (const stub_progmem::Literal &literal : stub_progmem::literals()) {
+        if (std::string(literal.file) == __FILE__) count++;
+    }
+    return count;
+}
+
+void test_registry() {
+    std::cout << "Testing literal registry...\n";
+    // Все F() и PSTR() этого файла известны до первого вызова
+    assert(literalsFromThisFile() >= 10);
+    bool banner = false;
+    for (const stub_progmem::Literal &literal : stub_progmem::literals()) {
+        if (strcmp(literal.text, "=== weather station v2 ===") == 0) {
+            banner = true;
+            assert(literal.size == 27);
+            assert(literal.line == 30);
+        }
+    }
+    assert(banner);
+
+    assert(stub_progmem::progmemBytes() >= sizeof(kCurve) + sizeof(kGreeting) + sizeof(kNames));
+    assert(stub_progmem::literalBytes() <= kLiteralBudget);
+
+    std::ostringstream report;
+    stub_progmem::report(report, 3);
+    assert(report.str().find("Flash strings: ") == 0);
+    assert(report.str().find("test_progmem.cpp:30") != std::string::npos);
+    std::cout << "  " << stub_progmem::literals().size() << " literals, "
+              << stub_progmem::literalBytes() << " bytes of " << kLiteralBudget << " budget\n";
+    std::cout << "✓ F() literals are registered before main()\n";
+}
+
+void test_flash_type() {
+    std::cout << "Testing __FlashStringHelper overloads...\n";
+    auto flash = F("x");
+    static_assert(std::is_same<decltype(flash), const __FlashStringHelper *>::value,
+                  "F() must produce a flash string");
+    CapturePrint out;
+    printBanner(out);
+    out.print(F("t="));
+    out.println(21);
+    assert(out.out == "=== weather station v2 ===\nt=21\n");
+
+    String s = F("temp");
+    s += F(": ");
+    assert(s.concat(F("21")));
+    assert(s == "temp: 21");
+    s = F("reset");
+    assert(s == "reset");
+    assert(String(FPSTR(kGreeting)) == "hello from flash");
+
+    // Каждый F() — отдельный массив, как у avr-gcc
+    const char *a = reinterpret_cast<const char *>(F("same"));
+    const char *b = reinterpret_cast<const char *>(F("same"));
+    assert(a != b && strcmp(a, b) == 0);
+    assert(stub_progmem::isFlash(a) && stub_progmem::isFlash(a + 4));
+    std::cout << "✓ print(), String, += and concat() take F() strings\n";
+}
+
+void test_pgm_read() {
+    std::cout << "Testing pgm_read and *_P...\n";
+    assert(pgm_read_word(&kCurve[3]) == 1080);
+    assert(pgm_read_byte(kGreeting) == 'h');
+    assert(pgm_read_ptr(&kNames[0]) == kGreeting);
+
+    char buffer[32];
+    strcpy_P(buffer, kGreeting);
+    assert(strcmp(buffer, "hello from flash") == 0);
+    assert(strlen_P(PSTR("abc")) == 3);
+    assert(strcmp_P("hello from flash", kGreeting) == 0);
+    strcat_P(buffer, PSTR("!"));
+    assert(strcmp(buffer, "hello from flash!") == 0);
+    uint16_t curve[5];
+    memcpy_P(curve, kCurve, sizeof(curve));
+    assert(curve[4] == 1920);
+    std::cout << "✓ pgm_read_* and *_P read PROGMEM data\n";
+}
+
+void test_strict() {
+    std::cout << "Testing strict mode...\n";
+    char ram[] = "ram string";
+    const uint16_t ramCurve[] = {1, 2};
+    assert(!stub_progmem::isFlash(ram));
+    assert(stub_progmem::isFlash(kCurve) && stub_progmem::isFlash(kGreeting));
+
+    // Без строгого режима строки из ОЗУ проходят молча
+    stub_progmem::resetViolations();
+    char buffer[32];
+    strcpy_P(buffer, ram);
+    assert(stub_progmem::violations() == 0);
+
+    stub_progmem::setStrict(true);
+    CapturePrint out;
+    out.print(F("ok "));
+    strcpy_P(buffer, kGreeting);
+    assert(pgm_read_word(&kCurve[1]) == 120);
+    assert(stub_progmem::violations() == 0);
+
+    // Строка из ОЗУ там, где ждут флеш: на AVR прочитался бы мусор
+    assert(pgm_read_word(&ramCurve[1]) == 2);
+    assert(stub_progmem::violations() == 1);
+    assert(stub_progmem::firstViolation().find("pgm_read_word") == 0);
+    out.print(FPSTR(ram));
+    strcpy_P(buffer, ram);
+    String s = FPSTR(ram);
+    assert(stub_progmem::violations() == 4);
+    assert(stub_progmem::firstViolation().find("pgm_read_word") == 0);
+
+    stub_progmem::setStrict(false);
+    stub_progmem::resetViolations();
+    assert(stub_progmem::firstViolation().empty());
+    std::cout << "✓ Strict mode flags RAM pointers passed to PROGMEM APIs\n";
+}
+
+int main() {
+    std::cout << "=== PROGMEM Tests ===\n\n";
+    test_registry();
+    test_flash_type();
+    test_pgm_read();
+    test_strict();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
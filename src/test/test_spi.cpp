@@ -0,0 +1,205 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "arduino_compat.h"
+#include "spi_stub.h"
+
+static const uint8_t kDisplayCs = 5;
+static const uint8_t kCardCs = 4;
+static const uint8_t kFlashCs = 15;
+
+static unsigned long boardMicros() {
+    stub_board::Board &board = stub_board::current();
+    return board.clock * 1000 + board.micros;
+}
+
+// Флеш-память: на команду 0x9F отвечает JEDEC ID, команда — первый
+// байт после опускания CS
+class FakeFlash : public stub_spi::Device {
+public:
+    FakeFlash() : position_(0), deselects_(0) {}
+    int deselects() const { return deselects_; }
+
+    void select() override { position_ = 0; }
+    void deselect() override { deselects_++; }
+
+    void exchange(const uint8_t *out, uint8_t *in, size_t len) override {
+        for (size_t i = 0; i < len; i++) {
+            uint8_t reply = 0xFF;
+            if (position_ == 0) command_ = out[i];
+            else if (command_ == 0x9F && position_ <= 3) reply = kJedecId[position_ - 1];
+            position_++;
+            if (in) in[i] = reply;
+        }
+    }
+
+private:
+    static const uint8_t kJedecId[3];
+    size_t position_;
+    uint8_t command_;
+    int deselects_;
+};
+
+const uint8_t FakeFlash::kJedecId[3] = {0xEF, 0x40, 0x18};
+
+void test_single_bytes() {
+    std::cout << "Testing byte transfers...\n";
+    stub_spi::Capture card;
+    // Пока идёт команда, карта молчит; R1 приходит со второго байта ожидания
+    const uint8_t r1[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+    card.respond(r1, sizeof(r1));
+    pinMode(kCardCs, OUTPUT);
+    digitalWrite(kCardCs, HIGH);
+    SPI.begin();
+    SPI.attach(kCardCs, &card);
+
+    // CMD0 карты SD: шесть байт команды, потом ожидание R1
+    const uint8_t cmd0[] = {0x40, 0, 0, 0, 0, 0x95};
+    SPI.beginTransaction(SPISettings(400000, MSBFIRST, SPI_MODE0));
+    digitalWrite(kCardCs, LOW);
+    for (size_t i = 0; i < sizeof(cmd0); i++) SPI.transfer(cmd0[i]);
+    assert(SPI.transfer(0xFF) == 0xFF);
+    assert(SPI.transfer(0xFF) == 0x01);
+    digitalWrite(kCardCs, HIGH);
+    SPI.endTransaction();
+    assert(card.data().size() == 8);
+    assert(memcmp(card.data().data(), cmd0, sizeof(cmd0)) == 0);
+    assert(card.selects() == 1);
+
+    // Ответ дан только на первые байты: дальше 0xFF
+    card.clear();
+    card.respond(r1 + 7, 1);
+    digitalWrite(kCardCs, LOW);
+    assert(SPI.transfer(0xFF) == 0x01);
+    assert(SPI.transfer(0xFF) == 0xFF);
+    digitalWrite(kCardCs, HIGH);
+    SPI.detach(kCardCs);
+    std::cout << "✓ SD-style command and R1 response\n";
+}
+
+void test_transfer16() {
+    std::cout << "Testing transfer16...\n";
+    stub_spi::Capture dev;
+    const uint8_t reply[] = {0x12, 0x34, 0x12, 0x34};
+    dev.respond(reply, sizeof(reply));
+    SPI.attach(kCardCs, &dev);
+    digitalWrite(kCardCs, LOW);
+    SPI.beginTransaction(SPISettings(1000000, MSBFIRST, SPI_MODE0));
+    assert(SPI.transfer16(0xABCD) == 0x1234);
+    SPI.setBitOrder(LSBFIRST);
+    assert(SPI.transfer16(0xABCD) == 0x3412);
+    SPI.endTransaction();
+    digitalWrite(kCardCs, HIGH);
+    const uint8_t expected[] = {0xAB, 0xCD, 0xCD, 0xAB};
+    assert(memcmp(dev.data().data(), expected, 4) == 0);
+    SPI.detach(kCardCs);
+    std::cout << "✓ Byte order follows bitOrder\n";
+}
+
+void test_framebuffer() {
+    std::cout << "Testing frame buffer push...\n";
+    stub_spi::Capture display;
+    const size_t kFrame = 240 * 320 * 2;
+    display.reserve(2 * kFrame);
+    digitalWrite(kDisplayCs, HIGH);
+    SPI.attach(kDisplayCs, &display);
+
+    std::vector<uint8_t> frame(kFrame);
+    for (size_t i = 0; i < kFrame; i++) frame[i] = static_cast<uint8_t>(i * 7);
+
+    SPI.bus().resetStats();
+    unsigned long start = boardMicros();
+    SPI.beginTransaction(SPISettings(40000000, MSBFIRST, SPI_MODE0));
+    digitalWrite(kDisplayCs, LOW);
+    SPI.writeBytes(frame.data(), frame.size());
+    std::vector<uint8_t> copy(frame);
+    SPI.transfer(copy.data(), copy.size());
+    digitalWrite(kDisplayCs, HIGH);
+    SPI.endTransaction();
+
+    assert(display.data().size() == 2 * kFrame);
+    assert(memcmp(display.data().data(), frame.data(), kFrame) == 0);
+    assert(memcmp(display.data().data() + kFrame, frame.data(), kFrame) == 0);
+    // Ответа нет: на месте буфера — 0xFF
+    assert(copy[0] == 0xFF && copy[kFrame - 1] == 0xFF);
+
+    // Два кадра по 153600 байт на 40 МГц: 2 * 30720 мкс
+    assert(boardMicros() - start == 61440);
+    assert(SPI.bus().stats().transfers == 2);
+    assert(SPI.bus().stats().bytes == 2 * kFrame);
+    SPI.detach(kDisplayCs);
+    std::cout << "✓ 300 KB pushed in two calls, bus time on the board clock\n";
+}
+
+void test_chip_select() {
+    std::cout << "Testing chip select...\n";
+    stub_spi::Capture display;
+    FakeFlash flash;
+    digitalWrite(kDisplayCs, HIGH);
+    digitalWrite(kFlashCs, HIGH);
+    SPI.attach(kDisplayCs, &display);
+    SPI.attach(kFlashCs, &flash);
+    assert(SPI.bus().deviceCount() == 2);
+
+    SPI.bus().resetStats();
+    SPI.beginTransaction(SPISettings());
+    assert(SPI.transfer(0x9F) == 0xFF);       // Никто не выбран
+    assert(SPI.bus().stats().idle_bytes == 1);
+
+    digitalWrite(kFlashCs, LOW);
+    uint8_t cmd[] = {0x9F, 0, 0, 0};
+    SPI.transfer(cmd, sizeof(cmd));
+    digitalWrite(kFlashCs, HIGH);
+    SPI.endTransaction();
+    assert(cmd[1] == 0xEF && cmd[2] == 0x40 && cmd[3] == 0x18);
+    assert(flash.deselects() == 1);
+    assert(display.data().empty());
+
+    // Байт по одному через виртуальный exchange тоже работает
+    SPI.beginTransaction(SPISettings());
+    digitalWrite(kFlashCs, LOW);
+    SPI.transfer(0x9F);
+    assert(SPI.transfer(0) == 0xEF);
+    digitalWrite(kFlashCs, HIGH);
+    digitalWrite(kDisplayCs, LOW);
+    SPI.write(0x2C);
+    digitalWrite(kDisplayCs, HIGH);
+    SPI.endTransaction();
+    assert(flash.deselects() == 2);
+    assert(display.data().size() == 1 && display.data()[0] == 0x2C);
+    assert(display.selects() == 1);
+
+    SPI.detach(kDisplayCs);
+    SPI.detach(kFlashCs);
+    assert(SPI.bus().deviceCount() == 0);
+    std::cout << "✓ CS pins route transfers to their devices\n";
+}
+
+void test_timing() {
+    std::cout << "Testing bus timing...\n";
+    // Без устройства время всё равно идёт: 8 тактов на байт
+    SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+    unsigned long start = boardMicros();
+    for (int i = 0; i < 1000; i++) SPI.transfer(0);
+    assert(boardMicros() - start == 1000);
+
+    // Доли микросекунды не теряются между байтами
+    SPI.setFrequency(40000000);
+    start = boardMicros();
+    for (int i = 0; i < 1000; i++) SPI.transfer(0);
+    assert(boardMicros() - start == 200);
+    SPI.endTransaction();
+    std::cout << "✓ Bus time at 8 and 40 MHz\n";
+}
+
+int main() {
+    std::cout << "=== SPI Tests ===\n\n";
+    test_single_bytes();
+    test_transfer16();
+    test_framebuffer();
+    test_chip_select();
+    test_timing();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "fake_serial.h"
+#include "littlefs_stub.h"
+
+FakeSerial Serial(false);
+
+void test_read_until() {
+    std::cout << "Testing readBytesUntil / readStringUntil...\n";
+    Serial.pushInput("GET /status\nPOST /reset\nrest");
+    char buf[32] = {0};
+    size_t n = Serial.readBytesUntil('\n', buf, sizeof(buf));
+    assert(n == 11 && std::string(buf, n) == "GET /status");
+    assert(Serial.readStringUntil('\n') == "POST /reset");
+    // Короткий буфер: терминатор остаётся во входе
+    n = Serial.readBytesUntil('\n', buf, 2);
+    assert(n == 2 && buf[0] == 'r' && buf[1] == 'e');
+    assert(Serial.readString() == "st");
+    assert(Serial.available() == 0);
+
+    uint8_t bytes[4];
+    Serial.pushInput("\x01\x02\x03", 3);
+    Serial.setTimeout(10);
+    assert(Serial.readBytes(bytes, 4) == 3);
+    assert(bytes[0] == 1 && bytes[2] == 3);
+    Serial.setTimeout(1000);
+    std::cout << "✓ strings and bytes are read up to the terminator\n";
+}
+
+void test_parse() {
+    std::cout << "Testing parseInt / parseFloat...\n";
+    Serial.pushInput("temp=-42;hum=55.25 x 1,234,567\n 7 z9");
+    assert(Serial.parseInt() == -42);
+    assert(Serial.parseFloat() == 55.25f);
+    assert(Serial.parseInt(SKIP_ALL, ',') == 1234567);
+    assert(Serial.parseInt(SKIP_WHITESPACE) == 7);
+    assert(Serial.parseInt(SKIP_WHITESPACE) == 0);  // 'z' не пропускается
+    assert(Serial.read() == 'z');
+    assert(Serial.parseInt(SKIP_NONE) == 9);
+    std::cout << "✓ numbers are parsed as in the Arduino core\n";
+}
+
+void test_find() {
+    std::cout << "Testing find / findUntil...\n";
+    // Частичные совпадения, на которых наивный поиск теряет позицию
+    Serial.pushInput("aaaab OK+CSQ: 17,0\r\n");
+    assert(Serial.find("aaab"));
+    assert(Serial.find("+CSQ: "));
+    assert(Serial.parseInt() == 17);
+    assert(Serial.readStringUntil('\n') == ",0\r");
+
+    Serial.pushInput("ERROR\r\nOK\r\n");
+    assert(!Serial.findUntil("OK", "ERROR"));
+    assert(Serial.findUntil("OK", "ERROR"));
+    assert(Serial.readString() == "\r\n");
+    std::cout << "✓ find matches in linear time and respects the terminator\n";
+}
+
+void test_timeout_uses_board_clock() {
+    std::cout << "Testing timeouts...\n";
+    Serial.setTimeout(500);
+    unsigned long before = millis();
+    Serial.pushInput("abc");
+    assert(Serial.readString() == "abc");
+    unsigned long after = millis();
+    // Один таймаут ожидания плюс шаг millis(), без реального ожидания
+    assert(after - before == 500 + 100);
+    assert(!Serial.find("never"));
+    assert(millis() - after == 500 + 100);
+    Serial.setTimeout(1000);
+    std::cout << "✓ waiting for input advances the simulated clock\n";
+}
+
+static void checkFile(const char *label) {
+    File f = LittleFS.open("/proto.txt", "w");
+    f.print("id=12\nname=node-7\nvalues=1.5,2.5\n");
+    f.close();
+
+    f = LittleFS.open("/proto.txt", "r");
+    assert(f.available() == 33);
+    assert(f.peek() == 'i');
+    assert(f.find("id="));
+    assert(f.parseInt() == 12);
+    assert(f.find("name="));
+    assert(f.readStringUntil('\n') == "node-7");
+    assert(f.find("values="));
+    assert(f.parseFloat() == 1.5f);
+    assert(f.read() == ',');
+    char buf[8];
+    size_t n = f.readBytesUntil('\n', buf, sizeof(buf));
+    assert(n == 3 && std::string(buf, n) == "2.5");
+    assert(f.available() == 0 && f.peek() == -1);
+    f.close();
+    std::cout << "✓ File supports the Stream API (" << label << ")\n";
+}
+
+void test_file_stream() {
+    std::cout << "Testing File as Stream...\n";
+    system("rm -rf /tmp/arduinostub_stream");
+    assert(LittleFS.begin(true, "/tmp/arduinostub_stream"));
+    checkFile("disk");
+    std::vector<uint8_t> image;
+    assert(LittleFS.exportImage(image));
+    assert(LittleFS.mountImage(image.data(), image.size()));
+    checkFile("image");
+    system("rm -rf /tmp/arduinostub_stream");
+}
+
+int main() {
+    std::cout << "=== Stream Tests ===\n\n";
+    test_read_until();
+    test_parse();
+    test_find();
+    test_timeout_uses_board_clock();
+    test_file_stream();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <cassert>
+#include <iostream>
+#include "arduino_compat.h"
+
+void test_frame_allocations() {
+    std::cout << "Testing arena frames...\n";
+    assert(StringArenaFrame::current() == nullptr);
+    {
+        StringArenaFrame frame;
+        assert(StringArenaFrame::current() == &frame);
+
+        // Короткие строки живут в буфере SSO и арену не трогают
+        String shortValue("abc");
+        assert(frame.allocations() == 0);
+
+        String longValue("this string does not fit into the inline buffer");
+        assert(frame.allocations() == 1);
+        String joined = longValue + " and neither does this one";
+        assert(frame.allocations() >= 2);
+        assert(joined == "this string does not fit into the inline buffer and neither does this one");
+        assert(joined.substring(5, 11) == "string");
+        std::cout << "✓ long strings allocate from the frame\n";
+
+        {
+            StringArenaFrame inner;
+            assert(StringArenaFrame::current() == &inner);
+            String nested("allocated from the innermost frame only");
+            assert(inner.allocations() == 1);
+        }
+        assert(StringArenaFrame::current() == &frame);
+        std::cout << "✓ nested frames restore the outer one\n";
+    }
+    assert(StringArenaFrame::current() == nullptr);
+}
+
+void test_string_outlives_frame() {
+    std::cout << "Testing strings that outlive their frame...\n";
+    String kept;
+    {
+        StringArenaFrame frame;
+        String temp = String("value of a long temporary #") + String(42);
+        kept = temp;
+        assert(frame.allocations() >= 2);
+    }
+    // Блок кадра не отдан в пул, пока жива строка
+    {
+        StringArenaFrame frame;
+        String other("overwrites pooled memory if the chunk was reused");
+        assert(kept == "value of a long temporary #42");
+    }
+    kept += " still usable after the frame";
+    assert(kept == "value of a long temporary #42 still usable after the frame");
+    std::cout << "✓ string stays valid after its frame is gone\n";
+}
+
+void test_hot_loop() {
+    std::cout << "Testing frame per loop iteration...\n";
+    String line("set_threshold_temperature 42.5 celsius");
+    size_t total = 0;
+    for (int i = 0; i < 1000; i++) {
+        StringArenaFrame frame;
+        String command = line.substring(0, 25);
+        String reply = String("response for ") + command + ": " + String(i);
+        total += reply.length();
+        assert(reply.startsWith("response for set_threshold_temperature: "));
+    }
+    assert(total > 0);
+    std::cout << "✓ temporaries are released in bulk\n";
+}
+
+int main() {
+    std::cout << "=== String Arena Tests ===\n\n";
+    test_frame_allocations();
+    test_string_outlives_frame();
+    test_hot_loop();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "arduino_compat.h"
+#include "arduino_string_stub.h"
+
+using string_hash::StringKey;
+
+void test_hash_consistency() {
+    std::cout << "Testing hash of different string kinds...\n";
+    string_hash::Hash hash;
+    const char *samples[] = {"", "a", "1234567", "12345678", "123456789",
+                             "/api/v1/device/17/state", "home/garden/soil/moisture"};
+    for (const char *sample : samples) {
+        size_t expected = string_hash::hashBytes(sample);
+        assert(std::hash<String>()(String(sample)) == expected);
+        assert(hash(sample) == expected);
+        assert(hash(std::string(sample)) == expected);
+        assert(hash(String(sample)) == expected);
+        assert(StringKey(sample).hash() == expected);
+        assert(StringKey::ref(sample).hash() == expected);
+    }
+
+    // Хвост короче 8 байт и нули внутри строки различаются
+    assert(string_hash::hashBytes("ab", 2) != string_hash::hashBytes("ab\0", 3));
+    assert(string_hash::hashBytes("12345678a") != string_hash::hashBytes("12345678b"));
+    std::cout << "✓ String, const char*, std::string and StringKey hash alike\n";
+}
+
+void test_distribution() {
+    std::cout << "Testing hash distribution...\n";
+    const int kKeys = 10000;
+    std::unordered_set<size_t> hashes;
+    std::unordered_set<size_t> buckets;
+    char key[32];
+    for (int i = 0; i < kKeys; i++) {
+        snprintf(key, sizeof(key), "sensor/%d/value", i);
+        size_t h = string_hash::hashBytes(key);
+        hashes.insert(h);
+        buckets.insert(h & 16383);
+    }
+    assert(hashes.size() == kKeys);
+    // Случайная раскладка 10000 ключей по 16384 корзинам занимает ~7300
+    assert(buckets.size() > 7000);
+    std::cout << "✓ " << kKeys << " similar keys: no collisions, " << buckets.size()
+              << " of 16384 low-bit buckets used\n";
+}
+
+void test_string_map() {
+    std::cout << "Testing unordered_map<String, int>...\n";
+    std::unordered_map<String, int> counts;
+    counts["temp"] = 1;
+    counts[String("humidity")] = 2;
+    counts["temp"]++;
+    assert(counts.size() == 2);
+    assert(counts.at("temp") == 2);
+    assert(counts.find("pressure") == counts.end());
+    std::cout << "✓ String works as a std::unordered_map key\n";
+}
+
+void test_string_key() {
+    std::cout << "Testing StringKey lookup...\n";
+    std::unordered_map<StringKey, int> routes;
+    routes["/api/state"] = 1;
+    routes[String("/api/config")] = 2;
+
+    // Поиск по чужому буферу: ключ ссылается на него, а не копирует
+    char request[] = "GET /api/state HTTP/1.1";
+    StringKey path = StringKey::ref(request + 4, 10);
+    assert(path.data() == request + 4);
+    assert(routes.find(path) != routes.end());
+    assert(routes.find(path)->second == 1);
+    assert(routes.count(StringKey::ref(String("/api/config"))) == 1);
+    assert(routes.count(StringKey::ref("/api/missing")) == 0);
+
+    // Копия ссылочного ключа владеет строкой: буфер можно менять
+    routes[path] = 3;
+    StringKey copy = path;
+    assert(copy.data() != request + 4);
+    request[5] = 'X';
+    assert(copy.toString() == "/api/state");
+    assert(routes.find(StringKey::ref("/api/state"))->second == 3);
+    for (const auto &route : routes) {
+        assert(route.first.data() != request + 4);
+    }
+
+    StringKey empty;
+    assert(empty.length() == 0 && empty == StringKey(""));
+    assert(StringKey("a") != StringKey("b"));
+    std::cout << "✓ Borrowed keys find entries, stored keys own their bytes\n";
+}
+
+void test_transparent() {
+    std::cout << "Testing transparent Hash/Equal...\n";
+    string_hash::Equal equal;
+    assert(equal(String("topic"), "topic"));
+    assert(equal("topic", std::string("topic")));
+    assert(!equal(String("topic"), "topic2"));
+    assert(equal(StringKey::ref("x"), String("x")));
+
+    std::unordered_map<String, int, string_hash::Hash, string_hash::Equal> table;
+    table["topic"] = 7;
+    assert(table.find(String("topic"))->second == 7);
+#if __cplusplus >= 202002L
+    // C++20: поиск по const char* без временного String
+    assert(table.find("topic")->second == 7);
+    assert(table.contains(std::string("topic")));
+    std::cout << "  heterogeneous find checked (C++20)\n";
+#endif
+    std::cout << "✓ Hash and Equal accept any string kind\n";
+}
+
+int main() {
+    std::cout << "=== String Hash Tests ===\n\n";
+    test_hash_consistency();
+    test_distribution();
+    test_string_map();
+    test_string_key();
+    test_transparent();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
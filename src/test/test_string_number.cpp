@@ -0,0 +1,112 @@
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "arduino_compat.h"
+
+// Сравнение с strtol/strtod/strtof: результат должен совпадать бит в бит
+static bool sameDouble(double a, double b) {
+    if (std::isnan(a) && std::isnan(b)) return true;
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static bool sameFloat(float a, float b) {
+    if (std::isnan(a) && std::isnan(b)) return true;
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static void check(const std::string &text) {
+    String s(text.c_str());
+    long expected_long = std::strtol(text.c_str(), nullptr, 10);
+    double expected_double = std::strtod(text.c_str(), nullptr);
+    float expected_float = std::strtof(text.c_str(), nullptr);
+    bool ok = s.toInt() == expected_long && sameDouble(s.toDouble(), expected_double) &&
+              sameFloat(s.toFloat(), expected_float);
+    if (!ok) {
+        printf("Mismatch for \"%s\": toInt %ld/%ld, toDouble %.17g/%.17g, toFloat %.9g/%.9g\n",
+               text.c_str(), s.toInt(), expected_long, s.toDouble(), expected_double,
+               s.toFloat(), expected_float);
+    }
+    assert(ok);
+}
+
+void test_arduino_semantics() {
+    std::cout << "Testing Arduino parsing rules...\n";
+    assert(String("  42abc").toInt() == 42);
+    assert(String("\t-17").toInt() == -17);
+    assert(String("+8").toInt() == 8);
+    assert(String("abc").toInt() == 0);
+    assert(String("").toInt() == 0);
+    assert(String("3.9").toInt() == 3);
+    assert(String("99999999999999999999").toInt() == LONG_MAX);
+    assert(String("-99999999999999999999").toInt() == LONG_MIN);
+    std::cout << "✓ toInt skips spaces, stops at the first invalid char\n";
+
+    assert(String("23.5").toFloat() == 23.5f);
+    assert(String(" -0.25;next").toDouble() == -0.25);
+    assert(String("1e3").toDouble() == 1000.0);
+    assert(String("1e").toDouble() == 1.0);
+    assert(String(".5").toDouble() == 0.5);
+    assert(String("-").toDouble() == 0.0 && !std::signbit(String("-").toDouble()));
+    assert(std::signbit(String("-0.0").toDouble()));
+    assert(std::isinf(String("inf").toFloat()));
+    assert(String("0x10").toDouble() == 16.0);
+    std::cout << "✓ toFloat/toDouble match atof\n";
+}
+
+void test_differential_fuzz() {
+    std::cout << "Testing against strtol/strtod/strtof...\n";
+    std::mt19937 rng(20240611);
+    const char alphabet[] = " \t+-.0123456789eE0123456789xXinfaN;,";
+    char buf[64];
+    int checked = 0;
+
+    // Случайные строки из символов, встречающихся в числах
+    for (int i = 0; i < 200000; i++) {
+        std::string text;
+        size_t len = rng() % 24;
+        for (size_t j = 0; j < len; j++) text += alphabet[rng() % (sizeof(alphabet) - 1)];
+        check(text);
+        checked++;
+    }
+
+    // Правильно записанные числа разной длины и точности
+    for (int i = 0; i < 200000; i++) {
+        switch (rng() % 4) {
+        case 0:
+            snprintf(buf, sizeof(buf), "%ld", static_cast<long>(rng()) * (rng() % 2 ? 1 : -1)
+                                                  * static_cast<long>(rng() % 100000));
+            break;
+        case 1:
+            snprintf(buf, sizeof(buf), "%.*f", static_cast<int>(rng() % 8),
+                     (static_cast<double>(rng()) - 2147483648.0) / (1 << (rng() % 24)));
+            break;
+        case 2: {
+            double bits;
+            uint64_t raw = (static_cast<uint64_t>(rng()) << 32) | rng();
+            memcpy(&bits, &raw, sizeof(bits));
+            snprintf(buf, sizeof(buf), "%.*g", static_cast<int>(1 + rng() % 18), bits);
+            break;
+        }
+        default:
+            snprintf(buf, sizeof(buf), "%s%u.%ue%d", rng() % 2 ? "-" : "",
+                     static_cast<unsigned>(rng() % 100000), static_cast<unsigned>(rng()),
+                     static_cast<int>(rng() % 80) - 40);
+            break;
+        }
+        check(buf);
+        checked++;
+    }
+    std::cout << "✓ " << checked << " random inputs match the C library\n";
+}
+
+int main() {
+    std::cout << "=== String Number Parsing Tests ===\n\n";
+    test_arduino_semantics();
+    test_differential_fuzz();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
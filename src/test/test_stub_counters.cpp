@@ -0,0 +1,106 @@
+// Собирается с -DARDUINOSTUB_COUNTERS (см. Makefile)
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "fake_serial.h"
+#include "littlefs_stub.h"
+
+FakeSerial Serial(false);
+FakeSerial Serial1(false);
+
+void test_serial_ports() {
+    std::cout << "Testing Serial counters...\n";
+    stub_counters::reset();
+    Serial1.setPortName("GPS");
+    Serial.print("hello");
+    Serial.println(42);
+    Serial1.write("$GPGGA", 6);
+
+    stub_counters::Snapshot s = stub_counters::snapshot();
+    assert(s.port_names.size() == 2);
+    assert(s.port_names[0] == "Serial" && s.port_names[1] == "GPS");
+    // println — одна запись вместе с переводом строки
+    assert(s.serial[0].bytes_written == 5 + 2 + 1 && s.serial[0].writes == 2);
+    assert(s.serial[1].bytes_written == 6 && s.serial[1].writes == 1);
+    std::cout << "✓ bytes are counted per port\n";
+}
+
+void test_string() {
+    std::cout << "Testing String counters...\n";
+    stub_counters::reset();
+    {
+        String shortValue("abc");
+        String longValue("a string that does not fit into the inline buffer");
+        longValue += "!";
+    }
+    stub_counters::Snapshot s = stub_counters::snapshot();
+    assert(s.string.allocations >= 1);
+    assert(s.string.bytes_allocated > 49);
+    assert(s.string.copies == 3);
+    assert(s.string.bytes_copied == 3 + 49 + 1);
+    std::cout << "✓ allocations and copies are counted\n";
+}
+
+void test_littlefs() {
+    std::cout << "Testing LittleFS counters...\n";
+    system("rm -rf /tmp/arduinostub_counters");
+    assert(LittleFS.begin(false, "/tmp/arduinostub_counters"));
+    stub_counters::reset();
+
+    File f = LittleFS.open("/logs/today.txt", "w");
+    f.print("0123456789");
+    f.close();
+    f = LittleFS.open("logs//today.txt", "r");
+    char buf[16];
+    assert(f.read(reinterpret_cast<uint8_t *>(buf), sizeof(buf)) == 10);
+    f.close();
+    assert(LittleFS.exists("/config.json") == false);
+
+    stub_counters::Snapshot s = stub_counters::snapshot();
+    const stub_counters::FsStats &log = s.paths["logs/today.txt"];
+    assert(log.opens == 2);
+    assert(log.bytes_written == 10 && log.bytes_read == 10);
+    // stat + open + pwrite + close при записи, stat + open + pread + close при чтении
+    assert(log.syscalls == 8);
+    assert(s.paths["config.json"].syscalls == 1);
+    assert(s.littlefs.opens == 2 && s.littlefs.syscalls > log.syscalls);
+    s.dump(std::cout);
+    std::cout << "✓ opens, syscalls and bytes are counted per path\n";
+    system("rm -rf /tmp/arduinostub_counters");
+}
+
+void test_threads() {
+    std::cout << "Testing per-thread counters...\n";
+    stub_counters::reset();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([]() {
+            for (int i = 0; i < 1000; i++) stub_counters::serialWrite(0, 2);
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    stub_counters::serialWrite(0, 1);
+
+    // Счётчики завершившихся потоков сохраняются
+    stub_counters::Snapshot s = stub_counters::snapshot();
+    assert(s.serial[0].writes == 4001);
+    assert(s.serial[0].bytes_written == 8001);
+    assert(alignof(stub_counters::SerialCounters) == stub_counters::kCacheLine);
+    std::cout << "✓ counters of finished threads are kept\n";
+
+    stub_counters::reset();
+    assert(stub_counters::snapshot().serial[0].writes == 0);
+    std::cout << "✓ reset clears all threads\n";
+}
+
+int main() {
+    std::cout << "=== Stub Counters Tests ===\n\n";
+    assert(stub_counters::kEnabled);
+    test_serial_ports();
+    test_string();
+    test_littlefs();
+    test_threads();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Собирается с -DARDUINOSTUB_DEVICES (см. Makefile): Serial и LittleFS —
+// порты и раздел устройства текущего потока
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "stub_device.h"
+
+// «Прошивка» узла: счётчик пробуждений в EEPROM, журнал в LittleFS,
+// светодиод на 13 пине, отчёт в Serial
+static void setup() {
+    Serial.begin(115200);
+    LittleFS.begin(true);
+    EEPROM_write<uint32_t>(0, 0);
+}
+
+static void loop() {
+    uint32_t wakeups = EEPROM_read<uint32_t>(0) + 1;
+    EEPROM_write(0, wakeups);
+    digitalWrite(13, wakeups % 2);
+    long jitter = random(1000);
+    File f = LittleFS.open("/log.csv", "a");
+    f.print(millis());
+    f.print(",");
+    f.println(jitter);
+    f.close();
+    Serial.println(jitter);
+}
+
+static size_t lines(fs::LittleFSClass &fs, const char *path) {
+    File f = fs.open(path, "r");
+    size_t n = 0;
+    int c;
+    while ((c = f.read()) >= 0) n += c == '\n';
+    return n;
+}
+
+void test_isolation() {
+    std::cout << "Testing device isolation...\n";
+    stub_device::Device a(1), b(2);
+    {
+        stub_device::Scope scope(a);
+        setup();
+        for (int i = 0; i < 3; i++) loop();
+        assert(&Serial == &a.serial());
+        assert(&LittleFS == &a.fs());
+    }
+    {
+        stub_device::Scope scope(b);
+        setup();
+        loop();
+        assert(millis() == 200);  // Часы b не видят трёх итераций a
+    }
+    assert(a.board().clock == 300 && b.board().clock == 200);
+    assert(a.board().digital[13] == HIGH && b.board().digital[13] == HIGH);
+    assert(lines(a.fs(), "/log.csv") == 3 && lines(b.fs(), "/log.csv") == 1);
+    assert(a.serial().getLines().size() == 3 && b.serial().getLines().size() == 1);
+    // У устройств разные потоки random()
+    assert(a.serial().getLines()[0] != b.serial().getLines()[0]);
+
+    // Раздел переживает перезагрузку, а чужой — не виден
+    {
+        stub_device::Scope scope(a);
+        LittleFS.end();
+        assert(LittleFS.begin());
+        assert(LittleFS.exists("/log.csv"));
+        uint32_t wakeups = EEPROM_read<uint32_t>(0);
+        assert(wakeups == 3);
+    }
+    stub_device::Device c(3);
+    {
+        stub_device::Scope scope(c);
+        assert(LittleFS.begin());
+        assert(!LittleFS.exists("/log.csv"));
+        assert(EEPROM_read<uint8_t>(0) == 0xFF);
+    }
+    // Вне устройств — плата по умолчанию
+    assert(stub_board::currentPtr() == nullptr);
+    std::cout << "✓ each device has its own clock, pins, EEPROM, Serial and LittleFS\n";
+}
+
+static std::vector<std::string> runFleet(unsigned threads, size_t devices,
+                                         uint64_t iterations, uint64_t &steals) {
+    std::vector<stub_device::Device *> fleet;
+    for (size_t i = 0; i < devices; i++) {
+        fleet.push_back(new stub_device::Device(static_cast<uint32_t>(i)));
+    }
+    stub_device::Pool pool(threads);
+    pool.run(fleet, setup, loop, iterations, 16);
+    steals = pool.steals();
+
+    std::vector<std::string> outputs;
+    for (size_t i = 0; i < fleet.size(); i++) {
+        stub_device::Device &d = *fleet[i];
+        assert(d.board().clock == iterations * 100);
+        assert(lines(d.fs(), "/log.csv") == iterations);
+        {
+            stub_device::Scope scope(d);
+            assert(EEPROM_read<uint32_t>(0) == iterations);
+        }
+        outputs.push_back(d.serial().getOutput());
+        delete fleet[i];
+    }
+    return outputs;
+}
+
+void test_fleet() {
+    std::cout << "Testing a fleet of 1000 devices...\n";
+    uint64_t steals = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::string> parallel = runFleet(4, 1000, 100, steals);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    uint64_t serialSteals = 0;
+    std::vector<std::string> serial = runFleet(1, 1000, 100, serialSteals);
+    assert(serialSteals == 0);
+    // Результат не зависит от числа потоков и порядка выполнения
+    assert(parallel == serial);
+    std::cout << "✓ 1000 devices x 100 loops in " << ms << " ms on 4 threads, "
+              << steals << " steals\n";
+}
+
+int main() {
+    std::cout << "=== Stub Device Tests ===\n\n";
+    test_isolation();
+    test_fleet();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "arduino_compat.h"
+
+// Эталон avr-libc: x * 16807 mod (2^31 - 1) в 64-битной арифметике
+static uint32_t parkMiller(uint32_t &x) {
+    x = static_cast<uint32_t>(static_cast<uint64_t>(x) * 16807 % 2147483647);
+    return x;
+}
+
+void test_avr_sequence() {
+    std::cout << "Testing AVR-compatible sequence...\n";
+    stub_random::Generator gen(1, stub_random::kAvr);
+    const uint32_t expected[] = {16807, 282475249, 1622650073, 984943658, 1144108930};
+    for (size_t i = 0; i < 5; i++) assert(gen.next() == expected[i]);
+
+    stub_random::Scope scope(gen);
+    randomSeed(12345);
+    uint32_t x = 12345;
+    for (int i = 0; i < 1000; i++) {
+        assert(random(100) == static_cast<long>(parkMiller(x) % 100));
+        assert(random(-50, 50) == static_cast<long>(parkMiller(x) % 100) - 50);
+        // Отрицательная граница: остаток со знаком делимого
+        assert(random(-7) == static_cast<long>(parkMiller(x) % 7));
+    }
+    assert(random(0) == 0);
+    std::cout << "✓ random() matches avr-libc, including modulo bias\n";
+}
+
+void test_seed_determinism() {
+    std::cout << "Testing seeds...\n";
+    stub_random::Generator a(42), b(42), c(43);
+    bool differs = false;
+    for (int i = 0; i < 100; i++) {
+        uint32_t va = a.next();
+        assert(va == b.next());
+        if (va != c.next()) differs = true;
+    }
+    assert(differs);
+
+    stub_random::Generator gen(7);
+    stub_random::Scope scope(gen);
+    randomSeed(99);
+    long first = random(1000000);
+    randomSeed(0);  // Как на Arduino: не сбрасывает последовательность
+    randomSeed(99);
+    assert(random(1000000) == first);
+    std::cout << "✓ the same seed gives the same sequence\n";
+}
+
+void test_ranges() {
+    std::cout << "Testing ranges...\n";
+    stub_random::Generator gen(3);
+    stub_random::Scope scope(gen);
+    int counts[6] = {0};
+    for (int i = 0; i < 60000; i++) {
+        long v = random(6);
+        assert(v >= 0 && v < 6);
+        counts[v]++;
+    }
+    for (int i = 0; i < 6; i++) assert(counts[i] > 9000 && counts[i] < 11000);
+    for (int i = 0; i < 1000; i++) {
+        long v = random(-3, 3);
+        assert(v >= -3 && v < 3);
+    }
+    assert(random(0) == 0 && random(-5) == 0);
+    assert(random(5, 5) == 5 && random(7, 2) == 7);
+    std::cout << "✓ values stay in range and are evenly spread\n";
+}
+
+void test_threads_and_scopes() {
+    std::cout << "Testing per-thread streams...\n";
+    // Эталон: симуляция в одном потоке
+    std::vector<long> reference;
+    {
+        stub_random::Generator gen(2024);
+        stub_random::Scope scope(gen);
+        for (int i = 0; i < 1000; i++) reference.push_back(random(1000));
+    }
+
+    // Параллельные симуляции с тем же seed не мешают друг другу
+    std::vector<std::vector<long> > results(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < results.size(); t++) {
+        threads.push_back(std::thread([&results, t]() {
+            stub_random::Generator gen(2024);
+            stub_random::Scope scope(gen);
+            for (int i = 0; i < 1000; i++) results[t].push_back(random(1000));
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    for (size_t t = 0; t < results.size(); t++) assert(results[t] == reference);
+
+    // Без Scope каждый поток стартует с одного состояния, как плата после сброса
+    long first = 0, second = 1;
+    std::thread([&first]() { first = random(1000000); }).join();
+    std::thread([&second]() { second = random(1000000); }).join();
+    assert(first == second);
+
+    // Scope восстанавливает предыдущий генератор
+    stub_random::Generator outer(1), inner(2);
+    stub_random::Scope outerScope(outer);
+    {
+        stub_random::Scope innerScope(inner);
+        assert(&stub_random::current() == &inner);
+    }
+    assert(&stub_random::current() == &outer);
+    std::cout << "✓ each simulation owns a reproducible stream\n";
+}
+
+int main() {
+    std::cout << "=== Stub Random Tests ===\n\n";
+    test_avr_sequence();
+    test_seed_determinism();
+    test_ranges();
+    test_threads_and_scopes();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "fake_serial.h"
+#include "littlefs_stub.h"
+
+FakeSerial Serial(false);
+
+static const char *kLog = "/tmp/arduinostub_replay.bin";
+static const char *kBase = "/tmp/arduinostub_replay";
+
+// «Прошивка»: команды из Serial, показания в файл, ответы в Serial.
+// version 2 меняет ответ, version 3 — формат записи в файл.
+static int version = 1;
+static String line;
+
+static void handle(const String &cmd) {
+    unsigned long now = millis();
+    if (cmd.startsWith("log ")) {
+        File f = LittleFS.open("/log.csv", "a");
+        f.print(now);
+        f.print(version == 3 ? "," : ";");
+        f.println(cmd.substring(4));
+        f.close();
+        Serial.println(version == 2 ? "OK" : "ok");
+    } else if (cmd == "status") {
+        File cfg = LittleFS.open("/config.txt", "r");
+        char buf[32] = {0};
+        cfg.read(reinterpret_cast<uint8_t *>(buf), sizeof(buf) - 1);
+        Serial.print("config=");
+        Serial.print(buf);
+        Serial.print(" button=");
+        Serial.println(digitalRead(2));
+    }
+}
+
+static void sketchLoop() {
+    while (Serial.available()) {
+        char c = static_cast<char>(Serial.read());
+        if (c == '\n') {
+            handle(line);
+            line = "";
+        } else {
+            line += c;
+        }
+    }
+}
+
+static void runSession() {
+    for (int i = 0; i < 5; i++) sketchLoop();
+    Serial.pushInput("log 21.5\n");
+    for (int i = 0; i < 5; i++) sketchLoop();
+    Serial.pushInput("log 22.0\nsta");
+    sketchLoop();
+    Serial.pushInput("tus\n");
+    for (int i = 0; i < 5; i++) sketchLoop();
+}
+
+static std::vector<uint8_t> image;
+static std::string recordedOutput;
+
+static stub_replay::Report replay(int v) {
+    version = v;
+    line = "";
+    Serial.clearOutput();
+    assert(stub_replay::startReplay(kLog));
+    assert(LittleFS.mountImage(stub_replay::image().data(), stub_replay::image().size()));
+    runSession();
+    return stub_replay::finishReplay();
+}
+
+void test_record() {
+    std::cout << "Testing recording...\n";
+    system("rm -rf /tmp/arduinostub_replay");
+    assert(LittleFS.begin(true, kBase));
+    File cfg = LittleFS.open("/config.txt", "w");
+    cfg.print("v1");
+    cfg.close();
+    assert(LittleFS.exportImage(image));
+
+    assert(stub_replay::startRecording(kLog, &image));
+    assert(stub_replay::recording());
+    runSession();
+    assert(stub_replay::stopRecording());
+    recordedOutput = Serial.getOutput();
+    assert(recordedOutput == "ok\nok\nconfig=v1 button=0\n");
+    std::cout << "✓ serial input is read by the sketch and logged\n";
+}
+
+void test_replay_matches() {
+    std::cout << "Testing replay...\n";
+    stub_replay::Report r = replay(1);
+    std::cout << r.describe();
+    assert(!r.diverged && !r.inputs_exhausted);
+    assert(r.records > 0);
+    assert(Serial.getOutput() == recordedOutput);
+    // Файл писался в образ в памяти, а не на диск
+    File f = LittleFS.open("/log.csv", "r");
+    assert(f && f.size() > 0);
+    f.close();
+    std::cout << "✓ the same firmware replays without divergence\n";
+}
+
+void test_serial_divergence() {
+    std::cout << "Testing serial divergence...\n";
+    stub_replay::Report r = replay(2);
+    std::cout << r.describe();
+    assert(r.diverged);
+    assert(r.what == "serial 0");
+    assert(r.expected.compare(0, 3, "\"ok") == 0);
+    assert(r.actual.compare(0, 3, "\"OK") == 0);
+    std::cout << "✓ the first differing output byte is reported\n";
+}
+
+void test_littlefs_divergence() {
+    std::cout << "Testing LittleFS divergence...\n";
+    stub_replay::Report r = replay(3);
+    std::cout << r.describe();
+    assert(r.diverged);
+    assert(r.what == "littlefs");
+    assert(r.expected.compare(0, 15, "write log.csv -") == 0);
+    std::cout << "✓ a different file write is reported\n";
+}
+
+void test_faster_than_real_time() {
+    std::cout << "Testing replay speed...\n";
+    // Скетч «час» ждёт по millis(): при воспроизведении время идёт по журналу
+    assert(stub_replay::startRecording(kLog));
+    unsigned long start = millis();
+    while (millis() - start < 3600000UL) delay(10);
+    assert(stub_replay::stopRecording());
+
+    auto t0 = std::chrono::steady_clock::now();
+    assert(stub_replay::startReplay(kLog));
+    unsigned long replayStart = millis();
+    unsigned long elapsed = 0;
+    while ((elapsed = millis() - replayStart) < 3600000UL) delay(10);
+    stub_replay::Report r = stub_replay::finishReplay();
+    auto wall = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    assert(!r.diverged && !r.inputs_exhausted);
+    assert(elapsed == 3600000UL);
+    assert(wall < 1000);
+
+    // millis пишется разностью: одна запись — два байта
+    FILE *f = fopen(kLog, "rb");
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    assert(size < static_cast<long>(r.records * 2 + 16));
+    std::cout << "✓ one hour of sketch time replays in " << wall << " ms, log "
+              << size << " bytes\n";
+    remove(kLog);
+    system("rm -rf /tmp/arduinostub_replay");
+}
+
+int main() {
+    std::cout << "=== Stub Replay Tests ===\n\n";
+    test_record();
+    test_replay_matches();
+    test_serial_divergence();
+    test_littlefs_divergence();
+    test_faster_than_real_time();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
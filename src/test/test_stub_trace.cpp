@@ -0,0 +1,209 @@
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "fake_serial.h"
+#include "littlefs_stub.h"
+
+FakeSerial Serial(false);
+
+static size_t countEvents(const std::vector<stub_trace::Event> &events, int id) {
+    size_t n = 0;
+    for (size_t i = 0; i < events.size(); i++) n += events[i].id == id;
+    return n;
+}
+
+void test_disabled_by_default() {
+    std::cout << "Testing disabled tracer...\n";
+    stub_trace::clear();
+    Serial.print("not traced");
+    String s("a string that does not fit into the inline buffer");
+    assert(stub_trace::buffer().recorded() == 0);
+    std::cout << "✓ nothing is recorded until a subsystem is enabled\n";
+}
+
+void test_littlefs_timeline() {
+    std::cout << "Testing LittleFS events...\n";
+    system("rm -rf /tmp/arduinostub_trace");
+    stub_trace::clear();
+    stub_trace::enable(stub_trace::kLittleFS);
+
+    // begin() больше ничего не печатает, монтирование видно в трассе
+    assert(LittleFS.begin(false, "/tmp/arduinostub_trace"));
+    File f = LittleFS.open("/logs/2024/06/11/sensor_data.csv", "w");
+    f.print("23.5;41\n");
+    f.close();
+    assert(!LittleFS.open("/missing.txt", "r"));
+    Serial.print("serial is not enabled");
+
+    std::vector<stub_trace::Event> events = stub_trace::buffer().events();
+    assert(countEvents(events, stub_trace::kFsBegin) == 1);
+    assert(countEvents(events, stub_trace::kFsOpen) == 2);
+    assert(countEvents(events, stub_trace::kFsWrite) == 1);
+    assert(countEvents(events, stub_trace::kFsClose) == 1);
+    assert(countEvents(events, stub_trace::kSerialWrite) == 0);
+
+    for (size_t i = 0; i < events.size(); i++) {
+        const stub_trace::Event &e = events[i];
+        if (e.id == stub_trace::kFsOpen && e.args[1] == 1) {
+            // Длинный путь сохраняет конец
+            assert(std::string(e.text, e.text_len) == "24/06/11/sensor_data.csv");
+            assert(e.args[0] == 1 && e.complete);
+        }
+        if (e.id == stub_trace::kFsWrite) assert(e.args[0] == 8);
+    }
+    std::cout << "✓ open, write and close are recorded with their arguments\n";
+
+    stub_trace::disable(stub_trace::kLittleFS);
+    system("rm -rf /tmp/arduinostub_trace");
+}
+
+// Минимальная проверка JSON (RFC 8259): строки только из ASCII и
+// корректных последовательностей UTF-8
+static bool parseValue(const std::string &s, size_t &i);
+
+static void skipSpace(const std::string &s, size_t &i) {
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\n' || s[i] == '\r' || s[i] == '\t')) i++;
+}
+
+static bool parseString(const std::string &s, size_t &i) {
+    if (s[i++] != '"') return false;
+    while (i < s.size()) {
+        unsigned char c = static_cast<unsigned char>(s[i++]);
+        if (c == '"') return true;
+        if (c < 0x20) return false;
+        if (c == '\\') {
+            if (i >= s.size()) return false;
+            char e = s[i++];
+            if (e == 'u') {
+                for (int k = 0; k < 4; k++, i++) {
+                    if (i >= s.size() || !isxdigit(static_cast<unsigned char>(s[i]))) return false;
+                }
+            } else if (!strchr("\"\\/bfnrt", e)) {
+                return false;
+            }
+        } else if (c >= 0x80) {
+            int extra = c >= 0xF0 && c < 0xF5 ? 3 : c >= 0xE0 ? 2 : c >= 0xC2 && c < 0xE0 ? 1 : -1;
+            if (extra < 0 || c >= 0xF5) return false;
+            for (int k = 0; k < extra; k++, i++) {
+                if (i >= s.size() || (static_cast<unsigned char>(s[i]) & 0xC0) != 0x80) return false;
+            }
+        }
+    }
+    return false;
+}
+
+static bool parseValue(const std::string &s, size_t &i) {
+    skipSpace(s, i);
+    if (i >= s.size()) return false;
+    if (s[i] == '"') return parseString(s, i);
+    if (s[i] == '{' || s[i] == '[') {
+        char close = s[i] == '{' ? '}' : ']';
+        bool object = close == '}';
+        i++;
+        skipSpace(s, i);
+        if (i < s.size() && s[i] == close) return ++i, true;
+        for (;;) {
+            if (object) {
+                skipSpace(s, i);
+                if (i >= s.size() || !parseString(s, i)) return false;
+                skipSpace(s, i);
+                if (i >= s.size() || s[i++] != ':') return false;
+            }
+            if (!parseValue(s, i)) return false;
+            skipSpace(s, i);
+            if (i >= s.size()) return false;
+            if (s[i] == close) return ++i, true;
+            if (s[i++] != ',') return false;
+        }
+    }
+    size_t start = i;
+    while (i < s.size() && strchr("+-.0123456789eEtruefalsn", s[i])) i++;
+    return i > start;
+}
+
+static bool isValidJson(const std::string &s) {
+    size_t i = 0;
+    if (!parseValue(s, i)) return false;
+    skipSpace(s, i);
+    return i == s.size();
+}
+
+void test_chrome_json() {
+    std::cout << "Testing Chrome trace export...\n";
+    stub_trace::clear();
+    stub_trace::enable(stub_trace::kSerial | stub_trace::kSketch);
+    stub_trace::mark("loop start", 1);
+    Serial.print("say \"hi\"\n");
+    stub_trace::disable(stub_trace::kAll);
+
+    std::ostringstream out;
+    stub_trace::writeChromeJson(out);
+    std::string json = out.str();
+    assert(json.find("{\"traceEvents\": [") == 0);
+    assert(json.find("\"name\": \"mark\", \"cat\": \"sketch\", \"ph\": \"i\"") != std::string::npos);
+    assert(json.find("\"text\": \"loop start\", \"a\": 1, \"b\": 0") != std::string::npos);
+    assert(json.find("\"data\": \"say \\\"hi\\\"\\u000a\", \"port\": 0, \"bytes\": 9") !=
+           std::string::npos);
+    assert(isValidJson(json));
+    std::cout << "✓ events are exported as trace-event JSON\n";
+
+    // Двоичные данные и UTF-8, обрезанный по kTextSize посреди символа
+    stub_trace::clear();
+    stub_trace::enable(stub_trace::kSerial);
+    const uint8_t binary[] = {0xFF, 0x00, 0x80, 'A'};
+    Serial.write(binary, sizeof(binary));
+    std::string text;
+    while (text.size() < stub_trace::kTextSize * 2) text += "\xD0\xAF";  // "Я"
+    Serial.print(text.c_str() + 1);
+    stub_trace::disable(stub_trace::kAll);
+    out.str("");
+    stub_trace::writeChromeJson(out);
+    json = out.str();
+    assert(isValidJson(json));
+    assert(json.find("\"data\": \"\\u00ff\\u0000\\u0080A\"") != std::string::npos);
+    assert(json.find("\\u00d0\\u00af") != std::string::npos);
+    std::cout << "✓ non-ASCII bytes are escaped\n";
+}
+
+void test_ring_buffer() {
+    std::cout << "Testing ring buffer...\n";
+    stub_trace::clear(5);
+    assert(stub_trace::buffer().capacity() == 8);
+    stub_trace::enable(stub_trace::kSketch);
+    for (int i = 0; i < 20; i++) stub_trace::mark("tick", i);
+    stub_trace::disable(stub_trace::kAll);
+
+    std::vector<stub_trace::Event> events = stub_trace::buffer().events();
+    assert(stub_trace::buffer().recorded() == 20);
+    assert(events.size() == 8);
+    assert(events.front().args[0] == 12 && events.back().args[0] == 19);
+    stub_trace::clear();
+    std::cout << "✓ oldest events are overwritten\n";
+}
+
+void test_environment() {
+    std::cout << "Testing ARDUINOSTUB_TRACE...\n";
+    setenv("ARDUINOSTUB_TRACE", "serial,littlefs", 1);
+    uint32_t mask = stub_trace::enableFromEnvironment();
+    assert(mask == (stub_trace::kSerial | stub_trace::kLittleFS));
+    assert(stub_trace::enabled(stub_trace::kSerial));
+    assert(!stub_trace::enabled(stub_trace::kString));
+    stub_trace::disable(stub_trace::kAll);
+    unsetenv("ARDUINOSTUB_TRACE");
+    std::cout << "✓ subsystems are enabled from the environment\n";
+}
+
+int main() {
+    std::cout << "=== Stub Trace Tests ===\n\n";
+    test_disabled_by_default();
+    test_littlefs_timeline();
+    test_chrome_json();
+    test_ring_buffer();
+    test_environment();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "arduino_compat.h"
+#include "wifi_stub.h"
+
+// Данные по localhost приходят почти сразу, но не в тот же вызов
+template <typename Condition>
+static bool waitFor(Condition condition) {
+    for (int i = 0; i < 500; i++) {
+        if (condition()) return true;
+        stub_net::poll(10);
+    }
+    return condition();
+}
+
+static WiFiClient acceptOne(WiFiServer &server) {
+    WiFiClient client;
+    waitFor([&]() { client = server.accept(); return static_cast<bool>(client); });
+    return client;
+}
+
+void test_wifi_and_ip() {
+    std::cout << "Testing WiFi and IPAddress...\n";
+    assert(WiFi.status() == WL_IDLE_STATUS);
+    WiFi.begin("ssid", "password");
+    assert(WiFi.status() == WL_CONNECTED);
+    assert(WiFi.localIP() == IPAddress(127, 0, 0, 1));
+
+    IPAddress ip;
+    assert(ip.fromString("192.168.1.42"));
+    assert(ip[0] == 192 && ip[3] == 42);
+    assert(ip.toString() == "192.168.1.42");
+    assert(static_cast<uint32_t>(ip) == 0x2A01A8C0);
+    assert(!ip.fromString("300.1.1.1"));
+    assert(!ip.fromString("1.2.3"));
+    std::cout << "✓ WiFi connects at once, IPAddress parses and prints\n";
+}
+
+void test_echo() {
+    std::cout << "Testing client and server...\n";
+    WiFiServer broker(0);
+    broker.begin();
+    assert(broker);
+    stub_net::mapPort(1883, broker.port());
+
+    WiFiClient client;
+    assert(client.connect("mqtt.example.com", 1883) == 1);
+    assert(client.connected());
+    assert(client.remotePort() == broker.port());
+    client.print("PING ");
+    client.println(42);
+
+    WiFiClient peer = acceptOne(broker);
+    assert(peer);
+    assert(peer.remotePort() == client.localPort());
+    assert(waitFor([&]() { return peer.available() >= 8; }));
+    assert(peer.readStringUntil('\n') == "PING 42");
+
+    peer.println("PONG");
+    assert(waitFor([&]() { return client.available() >= 5; }));
+    assert(client.readStringUntil('\n') == "PONG");
+
+    // Сервер закрыл соединение: клиент дочитывает хвост и видит закрытие
+    peer.print("bye");
+    peer.stop();
+    assert(!peer.connected());
+    assert(waitFor([&]() { return client.available() == 3; }));
+    assert(client.connected());
+    char tail[4] = {0};
+    assert(client.read(reinterpret_cast<uint8_t *>(tail), 3) == 3);
+    assert(String(tail) == "bye");
+    assert(waitFor([&]() { return !client.connected(); }));
+    assert(client.read() == -1);
+    assert(client.write('x') == 0);
+
+    stub_net::mapPort(1883, 0);
+    std::cout << "✓ Echo through a stand-in broker, close seen after the data\n";
+}
+
+void test_refused() {
+    std::cout << "Testing refused connection...\n";
+    uint16_t port;
+    {
+        WiFiServer server(0);
+        server.begin();
+        port = server.port();
+    }
+    WiFiClient client;
+    assert(client.connect(IPAddress(10, 0, 0, 1), port) == 0);
+    assert(!client.connected());
+    assert(client.available() == 0);
+    std::cout << "✓ connect() returns 0 when nobody listens\n";
+}
+
+void test_many_clients() {
+    std::cout << "Testing many clients in one thread...\n";
+    const size_t kClients = 2000;
+    WiFiServer broker(0);
+    broker.begin();
+    stub_net::resetStats();
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<WiFiClient> clients(kClients);
+    for (size_t i = 0; i < kClients; i++) {
+        assert(clients[i].connect("broker", broker.port()) == 1);
+        clients[i].println(static_cast<unsigned long>(i));
+    }
+
+    // Брокер: принимает всех и отвечает каждому его же номером
+    std::vector<WiFiClient> sessions;
+    size_t answered = 0;
+    waitFor([&]() {
+        for (WiFiClient session = broker.accept(); session; session = broker.accept()) {
+            sessions.push_back(session);
+        }
+        for (size_t i = 0; i < sessions.size(); i++) {
+            if (!sessions[i].available()) continue;
+            String line = sessions[i].readStringUntil('\n');
+            sessions[i].print("ack ");
+            sessions[i].println(line);
+            answered++;
+        }
+        return answered == kClients;
+    });
+    assert(sessions.size() == kClients);
+    assert(answered == kClients);
+
+    for (size_t i = 0; i < kClients; i++) {
+        assert(waitFor([&]() { return clients[i].available() > 0; }));
+        String expected = "ack " + String(static_cast<unsigned long>(i));
+        assert(clients[i].readStringUntil('\n') == expected);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    stub_net::Stats stats = stub_net::stats();
+    assert(stats.connects == kClients);
+    assert(stats.accepts == kClients);
+    assert(stats.bytes_received == stats.bytes_sent);
+    std::cout << "  " << kClients << " round trips in " << ms << " ms, "
+              << stats.polls << " polls\n";
+    std::cout << "✓ " << kClients << " clients and the broker share one reactor\n";
+}
+
+void test_udp() {
+    std::cout << "Testing UDP...\n";
+    WiFiUDP sender, receiver;
+    assert(receiver.begin(0) == 1);
+    assert(receiver.parsePacket() == 0);
+
+    assert(sender.beginPacket("ntp.example.com", receiver.localPort()) == 1);
+    sender.print("time?");
+    assert(sender.endPacket() == 1);
+
+    int size = 0;
+    assert(waitFor([&]() { size = receiver.parsePacket(); return size > 0; }));
+    assert(size == 5);
+    assert(receiver.available() == 5);
+    assert(receiver.readString() == "time?");
+    assert(receiver.remotePort() == sender.localPort());
+    assert(receiver.remoteIP() == IPAddress(127, 0, 0, 1));
+
+    // Ответ на адрес отправителя
+    receiver.beginPacket(receiver.remoteIP(), receiver.remotePort());
+    uint8_t reply[48] = {0x24};
+    receiver.write(reply, sizeof(reply));
+    receiver.endPacket();
+    assert(waitFor([&]() { return sender.parsePacket() == 48; }));
+    assert(sender.read() == 0x24);
+    std::cout << "✓ Datagrams between two WiFiUDP sockets\n";
+
+    // Пустая датаграмма вычитывается и не задерживает следующую
+    sender.beginPacket(IPAddress(127, 0, 0, 1), receiver.localPort());
+    assert(sender.endPacket() == 1);
+    sender.beginPacket(IPAddress(127, 0, 0, 1), receiver.localPort());
+    sender.print("hi");
+    assert(sender.endPacket() == 1);
+    assert(waitFor([&]() { size = receiver.parsePacket(); return size > 0; }));
+    assert(size == 2);
+    assert(receiver.readString() == "hi");
+    std::cout << "✓ Empty datagrams do not block the socket\n";
+}
+
+int main() {
+    std::cout << "=== WiFi Tests ===\n\n";
+    test_wifi_and_ip();
+    test_echo();
+    test_refused();
+    test_many_clients();
+    test_udp();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}
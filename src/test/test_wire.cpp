@@ -0,0 +1,206 @@
+#include <cassert>
+#include <iostream>
+#include "arduino_compat.h"
+#include "wire_stub.h"
+
+// Время на шине в микросекундах по часам платы
+static unsigned long boardMicros() {
+    stub_board::Board &board = stub_board::current();
+    return board.clock * 1000 + board.micros;
+}
+
+static uint8_t readRegister8(uint8_t address, uint8_t reg) {
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+    Wire.endTransmission(false);
+    Wire.requestFrom(address, 1);
+    return static_cast<uint8_t>(Wire.read());
+}
+
+// Часы реального времени: секунды растут при каждом чтении
+class FakeRtc : public stub_i2c::RegisterDevice {
+public:
+    FakeRtc() : RegisterDevice(8), reads_(0) {}
+    int reads() const { return reads_; }
+
+protected:
+    void onRead(uint8_t reg) override {
+        reads_++;
+        if (reg == 0) set8(0, static_cast<uint8_t>(get8(0) + 1));
+    }
+
+private:
+    int reads_;
+};
+
+void test_register_read() {
+    std::cout << "Testing register reads...\n";
+    stub_i2c::RegisterDevice bme(256);
+    bme.set8(0xD0, 0x60);
+    Wire.begin();
+    Wire.bus().attach(0x76, &bme);
+
+    assert(readRegister8(0x76, 0xD0) == 0x60);
+    assert(bme.pointer() == 0xD0);
+    assert(Wire.available() == 0);
+    assert(Wire.read() == -1);
+
+    // Калибровка читается подряд одним запросом
+    for (uint8_t i = 0; i < 24; i++) bme.set8(0x88 + i, i * 3);
+    Wire.beginTransmission(0x76);
+    Wire.write(0x88);
+    assert(Wire.endTransmission() == 0);
+    assert(Wire.requestFrom(0x76, 24) == 24);
+    uint8_t calib[24];
+    assert(Wire.readBytes(calib, 24) == 24);
+    for (uint8_t i = 0; i < 24; i++) assert(calib[i] == i * 3);
+
+    // Запись в регистр конфигурации
+    Wire.beginTransmission(0x76);
+    Wire.write(0xF4);
+    Wire.write(0x27);
+    assert(Wire.endTransmission() == 0);
+    assert(bme.get8(0xF4) == 0x27);
+    Wire.bus().detach(0x76);
+    std::cout << "✓ BME280-style chip id, burst and config register\n";
+}
+
+void test_wide_registers() {
+    std::cout << "Testing 16-bit registers...\n";
+    stub_i2c::RegisterDevice ina(6, 2, false);
+    ina.set16(2, 0x1F40);
+    Wire.bus().attach(0x40, &ina);
+
+    Wire.beginTransmission(0x40);
+    Wire.write(2);
+    Wire.endTransmission();
+    assert(Wire.requestFrom(0x40, 2) == 2);
+    uint16_t bus = static_cast<uint16_t>(Wire.read() << 8);
+    bus |= static_cast<uint16_t>(Wire.read());
+    assert(bus == 0x1F40);
+
+    // Без автоинкремента чтение остаётся в пределах регистра
+    Wire.requestFrom(0x40, 4);
+    assert(Wire.read() == 0x1F && Wire.read() == 0x40);
+    assert(Wire.read() == 0x1F && Wire.read() == 0x40);
+
+    uint8_t calibration[] = {5, 0x10, 0x00};
+    Wire.beginTransmission(0x40);
+    Wire.write(calibration, sizeof(calibration));
+    assert(Wire.endTransmission() == 0);
+    assert(ina.get16(5) == 0x1000);
+    Wire.bus().detach(0x40);
+    std::cout << "✓ INA219-style big-endian registers\n";
+}
+
+// Устройство, которое не принимает данные
+class Busy : public stub_i2c::Device {
+public:
+    bool receive(const uint8_t *data, size_t len) override { (void)data; return len == 0; }
+    size_t transmit(uint8_t *data, size_t len) override { (void)data; (void)len; return 0; }
+};
+
+void test_errors() {
+    std::cout << "Testing error codes...\n";
+    Wire.bus().resetStats();
+    Wire.beginTransmission(0x55);
+    Wire.write(0);
+    assert(Wire.endTransmission() == 2);
+    assert(Wire.requestFrom(0x55, 4) == 0);
+    assert(Wire.available() == 0);
+
+    Busy busy;
+    Wire.bus().attach(0x55, &busy);
+    Wire.beginTransmission(0x55);
+    assert(Wire.endTransmission() == 0);     // Сканер шины: пустая запись
+    Wire.beginTransmission(0x55);
+    Wire.write(1);
+    assert(Wire.endTransmission() == 3);
+    assert(Wire.bus().stats().nacks == 3);
+
+    // Запись вне транзакции и переполнение буфера
+    assert(Wire.write(1) == 0);
+    Wire.beginTransmission(0x55);
+    uint8_t big[TwoWire::kBufferLength + 10] = {0};
+    assert(Wire.write(big, sizeof(big)) == TwoWire::kBufferLength);
+    assert(Wire.endTransmission() == 1);
+    assert(Wire.getWriteError() == 0);
+    Wire.bus().detach(0x55);
+    std::cout << "✓ NACK on address and data, buffer overflow\n";
+}
+
+void test_timing() {
+    std::cout << "Testing bus timing...\n";
+    stub_i2c::RegisterDevice dev(256);
+    Wire.bus().attach(0x76, &dev);
+
+    // Запись указателя и чтение байта: по 1 + 9 * 2 + 1 = 20 тактов
+    Wire.setClock(100000);
+    unsigned long start = boardMicros();
+    readRegister8(0x76, 0xD0);
+    assert(boardMicros() - start == 400);
+
+    Wire.setClock(400000);
+    assert(Wire.getClock() == 400000);
+    start = boardMicros();
+    readRegister8(0x76, 0xD0);
+    assert(boardMicros() - start == 100);
+
+    // Время копится в millis()
+    start = boardMicros();
+    for (int i = 0; i < 100; i++) readRegister8(0x76, 0xD0);
+    assert(boardMicros() - start == 10000);
+    assert(Wire.bus().stats().busy_us >= 10000);
+    Wire.setClock(100000);
+    Wire.bus().detach(0x76);
+    std::cout << "✓ Transactions advance the board clock by bus time\n";
+}
+
+void test_many_devices() {
+    std::cout << "Testing many devices...\n";
+    stub_i2c::RegisterDevice sensors[48];
+    for (uint8_t i = 0; i < 48; i++) {
+        sensors[i].set8(0, 0x80 + i);
+        Wire.bus().attach(0x20 + i, &sensors[i]);
+    }
+    assert(Wire.bus().deviceCount() == 48);
+
+    // Сканер шины находит все устройства
+    int found = 0;
+    for (uint8_t address = 1; address < 127; address++) {
+        Wire.beginTransmission(address);
+        if (Wire.endTransmission() == 0) found++;
+    }
+    assert(found == 48);
+
+    for (int round = 0; round < 100; round++) {
+        for (uint8_t i = 0; i < 48; i++) assert(readRegister8(0x20 + i, 0) == 0x80 + i);
+    }
+    for (uint8_t i = 0; i < 48; i++) Wire.bus().detach(0x20 + i);
+    assert(Wire.bus().deviceCount() == 0);
+    std::cout << "✓ 48 devices on one bus\n";
+}
+
+void test_custom_model() {
+    std::cout << "Testing custom device model...\n";
+    FakeRtc rtc;
+    Wire.bus().attach(0x68, &rtc);
+    assert(readRegister8(0x68, 0) == 1);
+    assert(readRegister8(0x68, 0) == 2);
+    assert(readRegister8(0x68, 3) == 0);
+    assert(rtc.reads() == 3);
+    Wire.bus().detach(0x68);
+    std::cout << "✓ onRead() updates registers before each read\n";
+}
+
+int main() {
+    std::cout << "=== Wire Tests ===\n\n";
+    test_register_read();
+    test_wide_registers();
+    test_errors();
+    test_timing();
+    test_many_devices();
+    test_custom_model();
+    std::cout << "\n=== All tests passed successfully! ===\n";
+    return 0;
+}